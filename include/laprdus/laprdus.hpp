@@ -145,6 +145,13 @@ public:
      */
     bool inflectionEnabled() const;
 
+    /**
+     * Set sample rate of output audio (resampled from the voice's rate).
+     * @param rate Sample rate in Hz, one of OUTPUT_RATES.
+     * @return false if the rate is not supported.
+     */
+    bool setOutputRate(uint32_t rate);
+
     /**
      * Get sample rate of output audio.
      * @return Sample rate in Hz.
@@ -138,6 +138,33 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_init_from_memory(
     size_t key_size
 );
 
+/**
+ * Initialize the engine from a caller-owned memory buffer without copying it.
+ * Phonemes of an unencrypted, uncompressed pack are read straight from the
+ * buffer, so a pack compiled into the application or mapped from a file
+ * costs no extra memory. Encrypted or compressed packs are decoded as by
+ * laprdus_init_from_memory() (with lazy loading, from this buffer).
+ *
+ * Lifetime: the buffer must stay valid and unchanged until the engine is
+ * destroyed or loads other voice data (laprdus_set_voice() with another
+ * voice, laprdus_init_*), and synthesis on other threads (asynchronous
+ * speech, background warm-up) may read it at any time until then.
+ *
+ * @param handle Engine handle.
+ * @param data Pointer to packed phoneme data, owned by the caller.
+ * @param data_size Size of data in bytes.
+ * @param decryption_key Optional decryption key (NULL if not encrypted).
+ * @param key_size Size of decryption key in bytes (0 if not encrypted).
+ * @return LAPRDUS_OK on success, error code on failure.
+ */
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_init_from_memory_nocopy(
+    LaprdusHandle handle,
+    const uint8_t* data,
+    size_t data_size,
+    const uint8_t* decryption_key,
+    size_t key_size
+);
+
 /**
  * Initialize from individual WAV files in a directory (development mode).
  * @param handle Engine handle.
@@ -149,6 +176,35 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_init_from_directory(
     const char* phoneme_dir
 );
 
+/**
+ * Decode packed phoneme data on first use instead of at load time.
+ * Loading then only validates the pack's header and index and keeps the
+ * pack in memory; each phoneme is decoded (and decrypted) the first time
+ * an utterance needs it. laprdus_warmup() decodes the rest. Applies to
+ * voice data loaded afterwards by laprdus_set_voice() or laprdus_init_*.
+ * @param handle Engine handle.
+ * @param enabled Non-zero for lazy decoding (default 0).
+ * @return LAPRDUS_OK on success, error code on failure.
+ */
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_lazy_loading(
+    LaprdusHandle handle,
+    int enabled
+);
+
+/**
+ * Verify the CRC32 stored in packed voice data when it is loaded.
+ * Voice data whose checksum does not match then fails to load with
+ * LAPRDUS_ERROR_LOAD_FAILED. Applies to voice data loaded afterwards by
+ * laprdus_set_voice() or laprdus_init_*.
+ * @param handle Engine handle.
+ * @param enabled Non-zero to verify checksums (default 0).
+ * @return LAPRDUS_OK on success, error code on failure.
+ */
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_checksum_verification(
+    LaprdusHandle handle,
+    int enabled
+);
+
 /**
  * Check if the engine is initialized and ready for synthesis.
  * @param handle Engine handle.
@@ -243,6 +299,29 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_inflection_enabled(
     int enabled
 );
 
+/**
+ * Set the sample rate of synthesized audio.
+ * The voices are recorded at 22050 Hz; other rates are produced by a
+ * polyphase resampler inside the engine, so audio can be handed to a
+ * sound server (PipeWire usually runs at 48000 Hz) or a telephony
+ * channel (8000 or 16000 Hz) without another conversion. Every
+ * synthesis function reports the rate in its LaprdusAudioFormat.
+ * @param handle Engine handle.
+ * @param sample_rate 8000, 11025, 16000, 22050, 24000, 32000, 44100 or 48000.
+ * @return LAPRDUS_OK on success, LAPRDUS_ERROR_INVALID_PARAMETER for other rates.
+ */
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_output_rate(
+    LaprdusHandle handle,
+    uint32_t sample_rate
+);
+
+/**
+ * Get the sample rate of synthesized audio.
+ * @param handle Engine handle.
+ * @return Output rate in Hz (22050 unless changed), or 0 for an invalid handle.
+ */
+LAPRDUS_API uint32_t LAPRDUS_CALL laprdus_get_output_rate(LaprdusHandle handle);
+
 // =============================================================================
 // Voice Selection
 // =============================================================================
@@ -279,6 +358,9 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_get_voice_info_by_id(
  * Set the active voice for synthesis.
  * For physical voices, this loads the voice's phoneme data.
  * For derived voices, this loads the base voice's data and applies pitch offset.
+ * A library built with a voice pack compiled in (scons --embed-voice) uses
+ * that pack for its voice and the voices derived from it, without reading
+ * data_directory.
  * @param handle Engine handle.
  * @param voice_id Voice ID to activate.
  * @param data_directory Directory containing voice .bin files.
@@ -325,8 +407,10 @@ LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize(
  * @param buffer_size Size of buffer in samples.
  * @param out_format Pointer to receive audio format information.
  * @return Number of samples written on success, negative error code on failure.
- *         If buffer is too small, returns required size as positive number
- *         and sets *out_format but doesn't write audio.
+ *         If buffer is NULL or too small, returns the required size as a
+ *         positive number and sets *out_format; the buffer contents are then
+ *         unspecified. Use laprdus_synthesize_to_sink() when the size is not
+ *         known in advance, rather than synthesizing twice.
  */
 LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize_to_buffer(
     LaprdusHandle handle,
@@ -337,17 +421,284 @@ LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize_to_buffer(
 );
 
 /**
- * Free a buffer allocated by laprdus_synthesize().
+ * Write callback receiving audio from laprdus_synthesize_to_sink().
+ * Called on the synthesizing thread, in text order.
+ * @param samples Samples to write, only valid during the callback.
+ * @param num_samples Number of samples.
+ * @param user_data Pointer passed to laprdus_synthesize_to_sink().
+ * @return Non-zero to continue, zero to stop synthesis.
+ */
+typedef int (LAPRDUS_CALL *LaprdusWriteCallback)(
+    const int16_t* samples,
+    size_t num_samples,
+    void* user_data
+);
+
+/**
+ * Synthesize text and pass the audio to a write callback.
+ * The engine writes each finished sentence straight from its working
+ * buffers, so no buffer holding the whole utterance is allocated or
+ * copied. The written samples are identical to laprdus_synthesize().
+ * @param handle Engine handle.
+ * @param text UTF-8 encoded text to synthesize.
+ * @param write Callback receiving the audio.
+ * @param user_data Pointer passed to every callback.
+ * @param out_format Pointer to receive audio format information (may be NULL).
+ * @return Total number of samples written on success, negative error code
+ *         on failure (LAPRDUS_ERROR_CANCELLED if the callback returned zero).
+ */
+LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize_to_sink(
+    LaprdusHandle handle,
+    const char* text,
+    LaprdusWriteCallback write,
+    void* user_data,
+    LaprdusAudioFormat* out_format
+);
+
+/*
+ * Inline marks: LAPRDUS_MARK_BEGIN name LAPRDUS_MARK_END anywhere in the
+ * text is not spoken; it reports the name together with the position of
+ * the audio that follows it. The speech around it is unchanged; inside a
+ * sentence part the position is that of the next phoneme.
+ * Example: "Prva " LAPRDUS_MARK_BEGIN "w2" LAPRDUS_MARK_END "riječ."
+ */
+#define LAPRDUS_MARK_BEGIN "\x1E"
+#define LAPRDUS_MARK_END "\x1F"
+
+/**
+ * Mark callback for laprdus_synthesize_to_sink_with_marks().
+ * Called on the synthesizing thread, just before the audio the mark
+ * precedes is written, so marks and audio arrive in order.
+ * @param name Mark name (UTF-8), only valid during the callback.
+ * @param sample_offset Sample position of the mark in the written audio.
+ * @param user_data Pointer passed to laprdus_synthesize_to_sink_with_marks().
+ * @return Non-zero to continue, zero to stop synthesis.
+ */
+typedef int (LAPRDUS_CALL *LaprdusMarkCallback)(
+    const char* name,
+    uint64_t sample_offset,
+    void* user_data
+);
+
+/**
+ * Synthesize text with inline marks and pass audio and marks to callbacks.
+ * Same as laprdus_synthesize_to_sink(); marks at the end of the text are
+ * reported after the last audio, at the total sample count.
+ * @param handle Engine handle.
+ * @param text UTF-8 encoded text, may contain inline marks.
+ * @param write Callback receiving the audio.
+ * @param mark Callback receiving the marks (may be NULL).
+ * @param user_data Pointer passed to every callback.
+ * @param out_format Pointer to receive audio format information (may be NULL).
+ * @return Total number of samples written on success, negative error code
+ *         on failure (LAPRDUS_ERROR_CANCELLED if a callback returned zero).
+ */
+LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize_to_sink_with_marks(
+    LaprdusHandle handle,
+    const char* text,
+    LaprdusWriteCallback write,
+    LaprdusMarkCallback mark,
+    void* user_data,
+    LaprdusAudioFormat* out_format
+);
+
+/**
+ * Read the text of all synthesis calls as SSML (disabled by default).
+ * Supported: <break time|strength>, <prosody rate|pitch|volume>,
+ * <say-as interpret-as="characters">, <mark name>, <sub alias>, <p> and
+ * <s>; other elements are ignored and their text spoken. Marks are
+ * reported like inline marks. Batch and spelling calls use only the text.
+ * @param handle Engine handle.
+ * @param enabled Non-zero to parse SSML, zero for plain text.
+ * @return LAPRDUS_OK on success, error code on failure.
+ */
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_ssml_enabled(
+    LaprdusHandle handle,
+    int enabled
+);
+
+/**
+ * Byte formats for encoded output.
+ */
+typedef enum LaprdusEncoding {
+    LAPRDUS_ENCODING_PCM16 = 0,      // 16-bit little-endian PCM (2 bytes per sample)
+    LAPRDUS_ENCODING_MULAW = 1,      // G.711 mu-law (1 byte per sample)
+    LAPRDUS_ENCODING_ALAW = 2,       // G.711 A-law (1 byte per sample)
+    LAPRDUS_ENCODING_IMA_ADPCM = 3   // IMA-ADPCM, WAV format 0x11 mono blocks
+} LaprdusEncoding;
+
+// IMA-ADPCM block layout: each block starts with the first sample (16-bit
+// little-endian), the step index and a zero byte, followed by two 4-bit
+// codes per byte, low nibble first
+#define LAPRDUS_IMA_ADPCM_BLOCK_BYTES 512
+#define LAPRDUS_IMA_ADPCM_BLOCK_SAMPLES 1017
+
+/**
+ * Write callback receiving encoded audio.
+ * Called on the synthesizing thread, in text order.
+ * @param data Bytes to write, only valid during the callback.
+ * @param size Number of bytes.
+ * @param user_data Pointer passed to laprdus_synthesize_encoded_to_sink().
+ * @return Non-zero to continue, zero to stop synthesis.
+ */
+typedef int (LAPRDUS_CALL *LaprdusByteWriteCallback)(
+    const uint8_t* data,
+    size_t size,
+    void* user_data
+);
+
+/**
+ * Synthesize text and pass the audio to a write callback in a compact
+ * encoding. Each sentence is encoded as it is synthesized, so the
+ * utterance is never held as PCM. IMA-ADPCM is written in whole blocks of
+ * LAPRDUS_IMA_ADPCM_BLOCK_BYTES; the last block is padded by repeating the
+ * final sample, and the returned sample count says where the audio ends.
+ * @param handle Engine handle.
+ * @param text UTF-8 encoded text to synthesize.
+ * @param encoding Byte format to write.
+ * @param write Callback receiving the encoded audio.
+ * @param user_data Pointer passed to every callback.
+ * @param out_format Pointer to receive audio format information (may be NULL);
+ *                   bits_per_sample is 16, 8 or 4 depending on the encoding.
+ * @return Total number of samples encoded on success, negative error code
+ *         on failure (LAPRDUS_ERROR_CANCELLED if the callback returned zero).
+ */
+LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize_encoded_to_sink(
+    LaprdusHandle handle,
+    const char* text,
+    LaprdusEncoding encoding,
+    LaprdusByteWriteCallback write,
+    void* user_data,
+    LaprdusAudioFormat* out_format
+);
+
+/**
+ * Synthesize text to a buffer in a compact encoding.
+ * @param handle Engine handle.
+ * @param text UTF-8 encoded text to synthesize.
+ * @param encoding Byte format to produce.
+ * @param out_data Pointer to receive the allocated bytes (NULL if there are
+ *                 none). Caller must free with laprdus_free_encoded().
+ * @param out_size Pointer to receive the number of bytes.
+ * @param out_format Pointer to receive audio format information (may be NULL).
+ * @return Number of samples encoded on success, negative error code on failure.
+ */
+LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize_encoded(
+    LaprdusHandle handle,
+    const char* text,
+    LaprdusEncoding encoding,
+    uint8_t** out_data,
+    size_t* out_size,
+    LaprdusAudioFormat* out_format
+);
+
+/**
+ * Free a buffer returned by laprdus_synthesize_encoded().
+ * @param data Buffer to free.
+ */
+LAPRDUS_API void LAPRDUS_CALL laprdus_free_encoded(uint8_t* data);
+
+/**
+ * Free a buffer returned by laprdus_synthesize() or
+ * laprdus_synthesize_spelled().
  * @param buffer Buffer to free.
  */
 LAPRDUS_API void LAPRDUS_CALL laprdus_free_buffer(int16_t* buffer);
 
 /**
  * Cancel any ongoing synthesis operation.
+ * Stops the utterance being spoken by laprdus_speak_async() and discards
+ * all queued ones. A synchronous synthesis call running on another thread
+ * returns LAPRDUS_ERROR_CANCELLED. Safe to call from any thread and
+ * from a sink callback.
  * @param handle Engine handle.
  */
 LAPRDUS_API void LAPRDUS_CALL laprdus_cancel(LaprdusHandle handle);
 
+typedef enum LaprdusParam {
+    LAPRDUS_PARAM_SPEED = 0,       // As laprdus_set_speed()
+    LAPRDUS_PARAM_USER_PITCH = 1,  // As laprdus_set_user_pitch()
+    LAPRDUS_PARAM_VOLUME = 2       // As laprdus_set_volume()
+} LaprdusParam;
+
+/**
+ * Change a voice parameter without waiting for the synthesis in progress.
+ * The running utterance (synchronous, streamed or from laprdus_speak_async())
+ * switches to the new value at its next phrase, so a rate change during a
+ * long read needs no cancel and restart; later utterances use it throughout.
+ * Safe to call from any thread and from a sink callback. Calls rendering
+ * phrases in parallel (laprdus_set_render_threads()) apply it to the next
+ * utterance only.
+ * @param handle Engine handle.
+ * @param param Parameter to change.
+ * @param value New value, in the range of the matching laprdus_set_ function.
+ * @return LAPRDUS_OK on success, error code on failure.
+ */
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_post_param(
+    LaprdusHandle handle,
+    LaprdusParam param,
+    float value
+);
+
+/**
+ * Set the number of threads used to render sentences of one text.
+ * With more than one thread, laprdus_synthesize() and
+ * laprdus_synthesize_to_buffer() render the sentences of a text in
+ * parallel. The audio is identical to single-threaded rendering.
+ * Streaming and asynchronous speech always render on one thread.
+ * @param handle Engine handle.
+ * @param threads Thread count; 1 renders on the calling thread only
+ *                (default), 0 uses one thread per CPU core.
+ * @return LAPRDUS_OK on success, error code on failure.
+ */
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_render_threads(
+    LaprdusHandle handle,
+    uint32_t threads
+);
+
+/**
+ * Callback receiving one result of laprdus_synthesize_batch().
+ * Called concurrently from the render threads, in no particular order,
+ * exactly once per text. The callback must not call engine functions
+ * other than laprdus_cancel().
+ * @param index Position of the text in the batch.
+ * @param status LAPRDUS_OK, LAPRDUS_ERROR_CANCELLED or
+ *               LAPRDUS_ERROR_SYNTHESIS_FAILED.
+ * @param samples Audio samples, only valid during the callback (NULL if none).
+ * @param num_samples Number of samples.
+ * @param user_data Pointer passed to laprdus_synthesize_batch().
+ */
+typedef void (LAPRDUS_CALL *LaprdusBatchCallback)(
+    size_t index,
+    LaprdusError status,
+    const int16_t* samples,
+    size_t num_samples,
+    void* user_data
+);
+
+/**
+ * Synthesize many independent texts, spread over the render threads
+ * set with laprdus_set_render_threads(). Workers share the loaded voice
+ * and dictionaries and keep their working state between batches. Each
+ * text's audio is identical to laprdus_synthesize().
+ * @param handle Engine handle.
+ * @param texts Array of UTF-8 encoded texts.
+ * @param count Number of texts.
+ * @param callback Function receiving each result.
+ * @param user_data Pointer passed to every callback.
+ * @param out_format Pointer to receive audio format information (may be NULL).
+ * @return LAPRDUS_OK if every text was synthesized, otherwise
+ *         LAPRDUS_ERROR_CANCELLED or LAPRDUS_ERROR_SYNTHESIS_FAILED.
+ */
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_synthesize_batch(
+    LaprdusHandle handle,
+    const char* const* texts,
+    size_t count,
+    LaprdusBatchCallback callback,
+    void* user_data,
+    LaprdusAudioFormat* out_format
+);
+
 // =============================================================================
 // Streaming Synthesis
 // =============================================================================
@@ -396,6 +747,235 @@ LAPRDUS_API int LAPRDUS_CALL laprdus_stream_is_complete(LaprdusStreamHandle stre
  */
 LAPRDUS_API void LAPRDUS_CALL laprdus_stream_destroy(LaprdusStreamHandle stream);
 
+// =============================================================================
+// Asynchronous Speech
+// =============================================================================
+
+/**
+ * Event kinds delivered to a sink callback.
+ */
+typedef enum LaprdusEventType {
+    LAPRDUS_EVENT_BEGIN = 0,    // Utterance started synthesizing
+    LAPRDUS_EVENT_AUDIO = 1,    // Chunk of audio (samples, num_samples, format)
+    LAPRDUS_EVENT_END = 2,      // Utterance finished (status)
+    LAPRDUS_EVENT_MARK = 3      // Inline mark reached (mark_name, mark_offset)
+} LaprdusEventType;
+
+/**
+ * Event passed to a sink callback. Only valid during the callback.
+ */
+typedef struct LaprdusEvent {
+    LaprdusEventType type;
+    uint32_t utterance_id;      // ID returned by laprdus_speak_async()
+    const int16_t* samples;     // AUDIO: chunk samples, otherwise NULL
+    size_t num_samples;         // AUDIO: number of samples, otherwise 0
+    LaprdusAudioFormat format;  // Audio format of the utterance
+    LaprdusError status;        // END: LAPRDUS_OK, LAPRDUS_ERROR_CANCELLED or
+                                // LAPRDUS_ERROR_SYNTHESIS_FAILED
+    const char* mark_name;      // MARK: mark name, otherwise NULL
+    uint64_t mark_offset;       // MARK: sample offset in the utterance's audio
+    // END: when the utterance was queued, when its first audio was passed to
+    // the sink (0 if none was) and when it finished, in microseconds on a
+    // monotonic clock; only differences between them are meaningful
+    uint64_t submitted_us;
+    uint64_t first_audio_us;
+    uint64_t finished_us;
+} LaprdusEvent;
+
+/**
+ * Sink callback receiving utterance events.
+ * Called on the engine's worker thread. Every accepted utterance gets
+ * exactly one END event; utterances cancelled before they started get
+ * no BEGIN event. The callback must not call engine functions other
+ * than laprdus_cancel().
+ * @param event Event data.
+ * @param user_data Pointer passed to laprdus_speak_async().
+ * @return Non-zero to continue, zero to stop this utterance.
+ */
+typedef int (LAPRDUS_CALL *LaprdusSinkCallback)(const LaprdusEvent* event, void* user_data);
+
+/**
+ * Priority classes of asynchronous utterances.
+ * A new utterance interrupts the current and queued utterances of lower
+ * classes (apart from notifications): the current one stops at its next
+ * audio chunk and ends with LAPRDUS_ERROR_CANCELLED. Queued utterances
+ * are spoken highest class first, in order within a class.
+ */
+typedef enum LaprdusPriority {
+    LAPRDUS_PRIORITY_NOTIFICATION = 0,  // Waits for all other speech; never interrupts
+                                        // and is never interrupted
+    LAPRDUS_PRIORITY_PROGRESS = 1,      // Progress updates
+    LAPRDUS_PRIORITY_TEXT = 2,          // Text (SPD_MSGTYPE_TEXT); laprdus_speak_async()
+    LAPRDUS_PRIORITY_KEY = 3            // Key and character echo (SPD_MSGTYPE_KEY,
+                                        // SPD_MSGTYPE_CHAR)
+} LaprdusPriority;
+
+/**
+ * Queue text to be spoken on the engine's worker thread.
+ * Returns immediately; audio is delivered to the sink in chunks as
+ * each text segment is synthesized. Utterances are spoken in order,
+ * with LAPRDUS_PRIORITY_TEXT.
+ * @param handle Engine handle.
+ * @param text UTF-8 encoded text to synthesize.
+ * @param sink Callback receiving the utterance's events.
+ * @param user_data Pointer passed to every callback.
+ * @return Utterance ID (positive) on success, negative error code on failure.
+ */
+LAPRDUS_API int32_t LAPRDUS_CALL laprdus_speak_async(
+    LaprdusHandle handle,
+    const char* text,
+    LaprdusSinkCallback sink,
+    void* user_data
+);
+
+/**
+ * Queue text to be spoken with a priority class.
+ * Same as laprdus_speak_async(), but the utterance interrupts and
+ * overtakes speech of lower classes (see LaprdusPriority).
+ * @param handle Engine handle.
+ * @param text UTF-8 encoded text to synthesize.
+ * @param priority Priority class of the utterance.
+ * @param sink Callback receiving the utterance's events.
+ * @param user_data Pointer passed to every callback.
+ * @return Utterance ID (positive) on success, negative error code on failure.
+ */
+LAPRDUS_API int32_t LAPRDUS_CALL laprdus_speak_async_with_priority(
+    LaprdusHandle handle,
+    const char* text,
+    LaprdusPriority priority,
+    LaprdusSinkCallback sink,
+    void* user_data
+);
+
+/**
+ * Wait until all queued utterances have finished.
+ * Must not be called from a sink callback.
+ * @param handle Engine handle.
+ * @return LAPRDUS_OK on success, error code on failure.
+ */
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_flush(LaprdusHandle handle);
+
+// =============================================================================
+// Warm-up
+// =============================================================================
+
+/**
+ * Automatic warm-up after a voice is loaded.
+ */
+typedef enum LaprdusWarmupMode {
+    LAPRDUS_WARMUP_NONE = 0,        // No automatic warm-up (default)
+    LAPRDUS_WARMUP_BLOCKING = 1,    // Warm up before the loading call returns
+    LAPRDUS_WARMUP_BACKGROUND = 2   // Warm up on the speech queue thread
+} LaprdusWarmupMode;
+
+/**
+ * Prepare the engine so the next utterance runs at full speed.
+ * Synthesizes representative text at the current and at shifted voice
+ * settings, discarding the audio, so every lazily created part (DSP state
+ * and presets, render threads, working buffers) is in place and in cache.
+ * Voice parameters and statistics are left as they were, and later output
+ * is identical to an engine that was not warmed up. Stops early when
+ * laprdus_cancel() is called.
+ * @param handle Engine handle.
+ * @return LAPRDUS_OK on success, LAPRDUS_ERROR_CANCELLED if cancelled,
+ *         error code on failure.
+ */
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_warmup(LaprdusHandle handle);
+
+/**
+ * Warm up automatically whenever voice data is loaded by
+ * laprdus_set_voice() or one of the laprdus_init_* functions.
+ * In background mode the warm-up is queued like an utterance:
+ * laprdus_flush() waits for it and laprdus_cancel() abandons it. A
+ * synthesis call or laprdus_speak_async() made meanwhile stops it at the
+ * next segment instead of waiting for it; other calls wait for it to finish.
+ * @param handle Engine handle.
+ * @param mode Warm-up mode (LAPRDUS_WARMUP_NONE by default).
+ * @return LAPRDUS_OK on success, error code on failure.
+ */
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_auto_warmup(
+    LaprdusHandle handle,
+    LaprdusWarmupMode mode
+);
+
+// =============================================================================
+// Synthesis Statistics
+// =============================================================================
+
+/**
+ * Statistics of the most recent synthesis call on an engine.
+ * Times are wall-clock milliseconds. With parallel rendering (see
+ * laprdus_set_render_threads()) the concatenate, DSP and inflection
+ * times are summed over all render threads.
+ */
+typedef struct LaprdusStats {
+    double preprocess_ms;        // Emoji, dictionary and number expansion
+    double segment_ms;           // Punctuation segmentation
+    double map_ms;               // Text to phoneme mapping
+    double concatenate_ms;       // Phoneme concatenation with crossfade
+    double dsp_ms;               // Volume, rate, pitch, user pitch and output rate
+    double inflection_ms;        // Punctuation pitch contours
+    double total_ms;             // Wall time of the whole call
+    double first_chunk_ms;       // Time to first chunk (streaming and sink only, else 0)
+    uint32_t segment_count;      // Text segments after punctuation split
+    uint32_t phoneme_count;      // Phoneme tokens synthesized
+    uint64_t output_samples;     // Samples returned or streamed
+    uint64_t peak_buffer_bytes;  // Largest audio working set held at once
+} LaprdusStats;
+
+/**
+ * Enable or disable statistics collection for synthesis calls.
+ * Disabled by default; collection adds negligible overhead when disabled.
+ * @param handle Engine handle.
+ * @param enabled Non-zero to enable, zero to disable.
+ * @return LAPRDUS_OK on success, error code on failure.
+ */
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_stats_enabled(
+    LaprdusHandle handle,
+    int enabled
+);
+
+/**
+ * Get statistics of the most recent synthesis call.
+ * All fields are zero if collection was disabled during that call.
+ * @param handle Engine handle.
+ * @param out_stats Pointer to structure to receive statistics.
+ * @return LAPRDUS_OK on success, error code on failure.
+ */
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_get_last_stats(
+    LaprdusHandle handle,
+    LaprdusStats* out_stats
+);
+
+// =============================================================================
+// Tracing
+// =============================================================================
+
+/**
+ * Write pipeline trace events to a file in Chrome trace JSON format.
+ * The file can be opened in chrome://tracing or ui.perfetto.dev.
+ * Tracing is process-wide and covers every engine. It can also be enabled
+ * by setting the LAPRDUS_TRACE_FILE environment variable before the
+ * first engine is created.
+ * @param path Output file path, or NULL to finish and close the current trace.
+ * @return LAPRDUS_OK on success, error code on failure.
+ */
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_trace_file(const char* path);
+
+/**
+ * Begin a host event in the current trace (no-op when tracing is off).
+ * Lets applications show their own work, such as audio output, next to
+ * the engine stages. Must be paired with laprdus_trace_end() on the same thread.
+ * @param name Event name (copied into the trace immediately).
+ */
+LAPRDUS_API void LAPRDUS_CALL laprdus_trace_begin(const char* name);
+
+/**
+ * End a host event started with laprdus_trace_begin().
+ * @param name Event name, same as passed to laprdus_trace_begin().
+ */
+LAPRDUS_API void LAPRDUS_CALL laprdus_trace_end(const char* name);
+
 // =============================================================================
 // Utility Functions
 // =============================================================================
@@ -414,7 +994,7 @@ LAPRDUS_API const char* LAPRDUS_CALL laprdus_get_error_message(LaprdusHandle han
 LAPRDUS_API const char* LAPRDUS_CALL laprdus_get_version(void);
 
 /**
- * Get the default audio format.
+ * Get the default audio format (before laprdus_set_output_rate()).
  * @param out_format Pointer to receive format information.
  */
 LAPRDUS_API void LAPRDUS_CALL laprdus_get_default_format(LaprdusAudioFormat* out_format);
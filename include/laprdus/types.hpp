@@ -59,6 +59,18 @@ constexpr uint16_t BITS_PER_SAMPLE = 16;
 constexpr uint16_t NUM_CHANNELS = 1;
 constexpr uint16_t BYTES_PER_SAMPLE = BITS_PER_SAMPLE / 8;
 
+// Output sample rates the engine can convert to (VoiceParams::output_rate)
+constexpr uint32_t OUTPUT_RATES[] = {8000, 11025, 16000, 22050, 24000, 32000, 44100, 48000};
+
+constexpr bool is_output_rate(uint32_t rate) {
+    for (uint32_t supported : OUTPUT_RATES) {
+        if (rate == supported) {
+            return true;
+        }
+    }
+    return false;
+}
+
 // =============================================================================
 // Phoneme Definitions
 // =============================================================================
@@ -260,23 +272,57 @@ struct VoiceParams {
     bool emoji_enabled = false;      // Enable emoji to text conversion (disabled by default)
     NumberMode number_mode = NumberMode::WholeNumbers;  // Number processing mode
     PauseSettings pause_settings;    // Pause duration settings
+    uint32_t output_rate = SAMPLE_RATE;  // Output sample rate (one of OUTPUT_RATES)
 
     void clamp() {
         speed = std::clamp(speed, 0.5f, 4.0f);  // 4.0x max for NVDA rate boost
         pitch = std::clamp(pitch, 0.25f, 4.0f);       // Voice character - wider range
         user_pitch = std::clamp(user_pitch, 0.5f, 2.0f);  // User preference - moderate range
         volume = std::clamp(volume, 0.0f, 1.0f);
+        if (!is_output_rate(output_rate)) {
+            output_rate = SAMPLE_RATE;
+        }
         pause_settings.clamp();
     }
 };
 
+// Voice parameters that can change while an utterance is being rendered
+// (TTSEngine::post_param); they take effect at the next segment
+enum class LiveParam : uint8_t {
+    Speed = 0,      // VoiceParams::speed
+    Pitch = 1,      // VoiceParams::pitch
+    UserPitch = 2,  // VoiceParams::user_pitch
+    Volume = 3,     // VoiceParams::volume
+};
+
+constexpr size_t LIVE_PARAM_COUNT = 4;
+
 // =============================================================================
 // Synthesis Result
 // =============================================================================
 
+// Inline marks: MARK_BEGIN, the mark name, MARK_END. Hosts put them in the
+// text where they need to know the audio position (index commands); they
+// are never spoken and leave the segment and its audio unchanged.
+constexpr char MARK_BEGIN = '\x1E';  // ASCII record separator
+constexpr char MARK_END = '\x1F';    // ASCII unit separator
+
+// SSML controls left in the text by the SSML parser; they split the text
+// into segments, and their values are kept beside it in order
+constexpr char SSML_BREAK = '\x1D';    // ASCII group separator: silence
+constexpr char SSML_PROSODY = '\x1C';  // ASCII file separator: next prosody
+
+// Position of an inline mark in the synthesized audio
+struct MarkEvent {
+    std::string name;
+    uint64_t sample_offset = 0;  // Samples (at the output rate) before the mark
+};
+
 struct SynthesisResult {
     AudioBuffer audio;
+    std::vector<MarkEvent> marks;  // Inline marks in text order
     bool success = false;
+    bool cancelled = false;     // Stopped by TTSEngine::cancel()
     std::string error_message;
 
     [[nodiscard]] explicit operator bool() const {
@@ -284,6 +330,26 @@ struct SynthesisResult {
     }
 };
 
+// =============================================================================
+// Synthesis Statistics
+// =============================================================================
+
+// Per-call statistics, collected only while enabled on the engine
+struct SynthesisStats {
+    double preprocess_ms = 0.0;      // Emoji, dictionary and number expansion
+    double segment_ms = 0.0;         // Punctuation segmentation
+    double map_ms = 0.0;             // Text to phoneme mapping
+    double concatenate_ms = 0.0;     // Phoneme concatenation with crossfade
+    double dsp_ms = 0.0;             // Volume, rate, pitch, user pitch and output rate
+    double inflection_ms = 0.0;      // Punctuation pitch contours
+    double total_ms = 0.0;           // Wall time of the whole call
+    double first_chunk_ms = 0.0;     // Time to first chunk (streaming and sink only)
+    uint32_t segment_count = 0;      // Text segments after punctuation split
+    uint32_t phoneme_count = 0;      // Phoneme tokens synthesized
+    uint64_t output_samples = 0;     // Samples returned or streamed
+    uint64_t peak_buffer_bytes = 0;  // Largest audio working set held at once
+};
+
 // =============================================================================
 // Phoneme Token (output from phoneme mapper)
 // =============================================================================
@@ -292,6 +358,7 @@ struct PhonemeToken {
     Phoneme phoneme = Phoneme::UNKNOWN;
     uint32_t max_bytes = 0;     // 0 = no limit, otherwise truncate
     float pitch_modifier = 1.0f; // Applied by inflection system
+    bool mark = false;          // Position of an inline mark (no audio)
 
     PhonemeToken() = default;
     explicit PhonemeToken(Phoneme p) : phoneme(p) {
@@ -310,6 +377,9 @@ struct TextSegment {
     Punctuation trailing_punct = Punctuation::NONE;
     InflectionType inflection = InflectionType::NEUTRAL;
     bool is_end_of_sentence = false;
+    uint32_t marks = 0;                 // Inline marks (MARK_BEGIN) in the text
+    uint32_t break_ms = 0;              // SSML break silence after the text
+    uint32_t prosody = 0;               // SSML prosody in effect (0 = voice settings)
 };
 
 // =============================================================================
@@ -56,6 +56,11 @@ ln -s liblaprdus.so.1 %{buildroot}%{_libdir}/liblaprdus.so
 # Install CLI
 install -D -m 755 build/linux-x64-release/laprdus \
     %{buildroot}%{_bindir}/laprdus
+%{_bindir}/laprdus-server
+
+# Install synthesis server
+install -D -m 755 build/linux-x64-release/laprdus-server \
+    %{buildroot}%{_bindir}/laprdus-server
 
 # Install voice data
 install -D -m 644 build/linux-x64-release/Josip.bin \
@@ -174,6 +179,7 @@ fi
 %doc readme.md
 %{_libdir}/liblaprdus.so.1*
 %{_bindir}/laprdus
+%{_bindir}/laprdus-server
 %{_datadir}/laprdus/
 %{_libdir}/speech-dispatcher-modules/sd_laprdus
 %config(noreplace) %{_sysconfdir}/speech-dispatcher/modules/laprdus.conf
@@ -48,8 +48,9 @@ ln -sf "liblaprdus.so.${VERSION}" "liblaprdus.so.1"
 ln -sf "liblaprdus.so.1" "liblaprdus.so"
 cd "${PROJECT_ROOT}"
 
-# CLI
+# CLI and synthesis server
 cp build/linux-x64-release/laprdus "${PKG}/bin/"
+cp build/linux-x64-release/laprdus-server "${PKG}/bin/"
 
 # Voice data
 cp build/linux-x64-release/Josip.bin "${PKG}/share/laprdus/"
@@ -234,6 +235,7 @@ fi
 
 # Remove files
 rm -fv "${PREFIX}/bin/laprdus"
+rm -fv "${PREFIX}/bin/laprdus-server"
 
 # Remove library from all possible locations
 rm -fv "${PREFIX}/lib/liblaprdus.so"*
@@ -441,6 +443,7 @@ fi
 
 # Remove files
 rm -fv "${PREFIX}/bin/laprdus"
+rm -fv "${PREFIX}/bin/laprdus-server"
 
 # Remove library from all possible locations
 rm -fv "${PREFIX}/lib/liblaprdus.so"*
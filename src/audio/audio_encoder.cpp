@@ -0,0 +1,238 @@
+// -*- coding: utf-8 -*-
+// audio_encoder.cpp - Streaming G.711 and IMA-ADPCM output encoders implementation
+
+#include "audio_encoder.hpp"
+#include <algorithm>
+
+namespace laprdus {
+
+namespace {
+
+// =============================================================================
+// G.711 Tables
+// =============================================================================
+
+// Segment end points of the 14-bit (mu-law) and 13-bit (A-law) magnitudes
+constexpr int MULAW_SEGMENT_END[8] = {0x3F, 0x7F, 0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF, 0x1FFF};
+constexpr int ALAW_SEGMENT_END[8] = {0x1F, 0x3F, 0x7F, 0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF};
+constexpr int MULAW_BIAS = 0x84 >> 2;
+constexpr int MULAW_CLIP = 8159;
+
+int segment(int value, const int (&ends)[8]) {
+    int seg = 0;
+    while (seg < 8 && value > ends[seg]) {
+        ++seg;
+    }
+    return seg;
+}
+
+// =============================================================================
+// IMA-ADPCM Tables
+// =============================================================================
+
+constexpr int16_t IMA_STEPS[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767
+};
+
+constexpr int8_t IMA_INDEX_STEP[16] = {-1, -1, -1, -1, 2, 4, 6, 8,
+                                       -1, -1, -1, -1, 2, 4, 6, 8};
+
+// Quantize one difference to a 4-bit code and advance the decoder model,
+// exactly as the decoder will, so the encoder never drifts from it
+uint8_t adpcm_code(int sample, int& predictor, int& step_index) {
+    int step = IMA_STEPS[step_index];
+    int diff = sample - predictor;
+    uint8_t code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+
+    int delta = step >> 3;
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 2;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 1;
+        delta += step;
+    }
+
+    predictor += (code & 8) ? -delta : delta;
+    predictor = std::clamp(predictor, -32768, 32767);
+    step_index = std::clamp(step_index + IMA_INDEX_STEP[code], 0, 88);
+    return code;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// G.711
+// =============================================================================
+
+uint8_t encode_mulaw(AudioSample sample) {
+    int value = static_cast<int>(sample) >> 2;
+    int mask = 0xFF;
+    if (value < 0) {
+        value = -value;
+        mask = 0x7F;
+    }
+    value = std::min(value, MULAW_CLIP) + MULAW_BIAS;
+
+    int seg = segment(value, MULAW_SEGMENT_END);
+    if (seg >= 8) {
+        return static_cast<uint8_t>(0x7F ^ mask);
+    }
+    int code = (seg << 4) | ((value >> (seg + 1)) & 0x0F);
+    return static_cast<uint8_t>(code ^ mask);
+}
+
+uint8_t encode_alaw(AudioSample sample) {
+    int value = static_cast<int>(sample) >> 3;
+    int mask = 0xD5;
+    if (value < 0) {
+        value = -value - 1;
+        mask = 0x55;
+    }
+
+    int seg = segment(value, ALAW_SEGMENT_END);
+    if (seg >= 8) {
+        return static_cast<uint8_t>(0x7F ^ mask);
+    }
+    int code = seg << 4;
+    code |= (seg < 2) ? ((value >> 1) & 0x0F) : ((value >> seg) & 0x0F);
+    return static_cast<uint8_t>(code ^ mask);
+}
+
+// =============================================================================
+// Stream Encoder
+// =============================================================================
+
+AudioEncoder::AudioEncoder(OutputEncoding encoding)
+    : m_encoding(encoding)
+{
+}
+
+void AudioEncoder::reset(OutputEncoding encoding) {
+    m_encoding = encoding;
+    m_samples = 0;
+    m_block.clear();
+    m_step_index = 0;
+}
+
+void AudioEncoder::encode(const AudioSample* samples, size_t count, std::vector<uint8_t>& out) {
+    m_samples += count;
+
+    switch (m_encoding) {
+        case OutputEncoding::PCM16: {
+            size_t offset = out.size();
+            out.resize(offset + count * 2);
+            uint8_t* bytes = out.data() + offset;
+            for (size_t i = 0; i < count; ++i) {
+                uint16_t value = static_cast<uint16_t>(samples[i]);
+                bytes[2 * i] = static_cast<uint8_t>(value & 0xFF);
+                bytes[2 * i + 1] = static_cast<uint8_t>(value >> 8);
+            }
+            break;
+        }
+
+        case OutputEncoding::MuLaw:
+            for (size_t i = 0; i < count; ++i) {
+                out.push_back(encode_mulaw(samples[i]));
+            }
+            break;
+
+        case OutputEncoding::ALaw:
+            for (size_t i = 0; i < count; ++i) {
+                out.push_back(encode_alaw(samples[i]));
+            }
+            break;
+
+        case OutputEncoding::ImaAdpcm: {
+            // Whole blocks straight from the input, the rest kept for later
+            size_t i = 0;
+            if (!m_block.empty()) {
+                size_t take = std::min(count, IMA_ADPCM_BLOCK_SAMPLES - m_block.size());
+                m_block.insert(m_block.end(), samples, samples + take);
+                i = take;
+                if (m_block.size() < IMA_ADPCM_BLOCK_SAMPLES) {
+                    break;
+                }
+                encode_adpcm_block(m_block.data(), out);
+                m_block.clear();
+            }
+            for (; i + IMA_ADPCM_BLOCK_SAMPLES <= count; i += IMA_ADPCM_BLOCK_SAMPLES) {
+                encode_adpcm_block(samples + i, out);
+            }
+            m_block.insert(m_block.end(), samples + i, samples + count);
+            break;
+        }
+    }
+}
+
+void AudioEncoder::flush(std::vector<uint8_t>& out) {
+    if (m_encoding == OutputEncoding::ImaAdpcm && !m_block.empty()) {
+        // Holding the last sample decodes to a flat tail; the sample count
+        // (a WAV file's fact chunk) tells players where the audio ends
+        m_block.resize(IMA_ADPCM_BLOCK_SAMPLES, m_block.back());
+        encode_adpcm_block(m_block.data(), out);
+    }
+    reset();
+}
+
+void AudioEncoder::encode_adpcm_block(const AudioSample* samples, std::vector<uint8_t>& out) {
+    // The header holds the first sample exactly and the current step index
+    int predictor = samples[0];
+    uint16_t first = static_cast<uint16_t>(samples[0]);
+    out.push_back(static_cast<uint8_t>(first & 0xFF));
+    out.push_back(static_cast<uint8_t>(first >> 8));
+    out.push_back(static_cast<uint8_t>(m_step_index));
+    out.push_back(0);
+
+    for (size_t i = 1; i < IMA_ADPCM_BLOCK_SAMPLES; i += 2) {
+        uint8_t low = adpcm_code(samples[i], predictor, m_step_index);
+        uint8_t high = adpcm_code(samples[i + 1], predictor, m_step_index);
+        out.push_back(static_cast<uint8_t>(low | (high << 4)));
+    }
+}
+
+uint16_t AudioEncoder::bits_per_sample(OutputEncoding encoding) {
+    switch (encoding) {
+        case OutputEncoding::MuLaw:
+        case OutputEncoding::ALaw:
+            return 8;
+        case OutputEncoding::ImaAdpcm:
+            return 4;
+        default:
+            return 16;
+    }
+}
+
+size_t AudioEncoder::encoded_size(OutputEncoding encoding, size_t sample_count) {
+    switch (encoding) {
+        case OutputEncoding::MuLaw:
+        case OutputEncoding::ALaw:
+            return sample_count;
+        case OutputEncoding::ImaAdpcm:
+            return (sample_count + IMA_ADPCM_BLOCK_SAMPLES - 1) / IMA_ADPCM_BLOCK_SAMPLES *
+                   IMA_ADPCM_BLOCK_BYTES;
+        default:
+            return sample_count * 2;
+    }
+}
+
+} // namespace laprdus
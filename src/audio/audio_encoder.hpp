@@ -0,0 +1,99 @@
+// -*- coding: utf-8 -*-
+// audio_encoder.hpp - Streaming G.711 and IMA-ADPCM output encoders
+
+#ifndef LAPRDUS_AUDIO_ENCODER_HPP
+#define LAPRDUS_AUDIO_ENCODER_HPP
+
+#include "laprdus/types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace laprdus {
+
+/**
+ * Byte formats synthesized audio can be delivered in.
+ */
+enum class OutputEncoding : uint8_t {
+    PCM16 = 0,     // 16-bit little-endian PCM, 2 bytes per sample
+    MuLaw = 1,     // G.711 mu-law, 1 byte per sample
+    ALaw = 2,      // G.711 A-law, 1 byte per sample
+    ImaAdpcm = 3,  // IMA-ADPCM in WAV blocks (format 0x11), about 4 bits per sample
+};
+
+// IMA-ADPCM block layout (mono): the first sample and step index in a
+// 4-byte header, then two 4-bit codes per byte, low nibble first
+constexpr size_t IMA_ADPCM_BLOCK_BYTES = 512;
+constexpr size_t IMA_ADPCM_BLOCK_SAMPLES = 1 + (IMA_ADPCM_BLOCK_BYTES - 4) * 2;  // 1017
+
+/**
+ * Encode one sample as G.711 mu-law.
+ */
+uint8_t encode_mulaw(AudioSample sample);
+
+/**
+ * Encode one sample as G.711 A-law.
+ */
+uint8_t encode_alaw(AudioSample sample);
+
+/*
+ * Encodes a stream of samples chunk by chunk. G.711 and PCM bytes are
+ * produced as samples arrive; IMA-ADPCM is produced one block at a time,
+ * and flush() pads the last block by repeating the final sample.
+ */
+class AudioEncoder {
+public:
+    explicit AudioEncoder(OutputEncoding encoding = OutputEncoding::PCM16);
+
+    /**
+     * Start a new stream, optionally switching the encoding.
+     */
+    void reset(OutputEncoding encoding);
+    void reset() { reset(m_encoding); }
+
+    OutputEncoding encoding() const { return m_encoding; }
+
+    /**
+     * Encode the next chunk of the stream, appending bytes to out.
+     * @param samples Input samples.
+     * @param count Number of samples.
+     * @param out Receives the encoded bytes.
+     */
+    void encode(const AudioSample* samples, size_t count, std::vector<uint8_t>& out);
+
+    /**
+     * End the stream: append the last, partial ADPCM block (if any).
+     * Resets the stream.
+     */
+    void flush(std::vector<uint8_t>& out);
+
+    /**
+     * Samples passed to encode() since the stream started.
+     */
+    uint64_t samples_encoded() const { return m_samples; }
+
+    /**
+     * Bits per sample reported for an encoding (16, 8 or 4).
+     */
+    static uint16_t bits_per_sample(OutputEncoding encoding);
+
+    /**
+     * Bytes a stream of sample_count samples encodes to, including flush().
+     */
+    static size_t encoded_size(OutputEncoding encoding, size_t sample_count);
+
+private:
+    void encode_adpcm_block(const AudioSample* samples, std::vector<uint8_t>& out);
+
+    OutputEncoding m_encoding;
+    uint64_t m_samples = 0;
+
+    // IMA-ADPCM state: samples of the unfinished block, and the step index
+    // carried from block to block
+    std::vector<AudioSample> m_block;
+    int m_step_index = 0;
+};
+
+} // namespace laprdus
+
+#endif // LAPRDUS_AUDIO_ENCODER_HPP
@@ -2,10 +2,12 @@
 // audio_synthesizer.cpp - Phoneme concatenation implementation
 
 #include "audio_synthesizer.hpp"
-#include "sonic_processor.hpp"
-#include "formant_pitch.hpp"
+#include "dsp_kernels.hpp"
+#include "../core/stage_timer.hpp"
+#include "../core/trace.hpp"
 #include <algorithm>
 #include <cmath>
+#include <utility>
 
 namespace laprdus {
 
@@ -17,6 +19,7 @@ AudioSynthesizer::AudioSynthesizer(const PhonemeData& phoneme_data)
     : m_phoneme_data(phoneme_data)
 {
     // Default voice parameters are already set in VoiceParams
+    m_short_silence = generate_silence(50).samples;
 }
 
 // =============================================================================
@@ -25,91 +28,119 @@ AudioSynthesizer::AudioSynthesizer(const PhonemeData& phoneme_data)
 
 AudioBuffer AudioSynthesizer::synthesize(const std::vector<PhonemeToken>& tokens) {
     AudioBuffer result;
+    synthesize(tokens, result);
+    return result;
+}
+
+void AudioSynthesizer::synthesize(const std::vector<PhonemeToken>& tokens,
+                                  AudioBuffer& result) {
+    render(tokens, result);
+
+    StageTimer output_timer(m_stats ? &m_stats->dsp_ms : nullptr);
+    quantize_output(result, m_voice_params.volume);
+    output_timer.stop();
+
+    // Flush remaining samples if streaming
+    if (m_stream_callback && !result.samples.empty()) {
+        emit_chunk(result);
+        result.samples.clear();
+    }
+}
+
+// =============================================================================
+// Render Phonemes
+// =============================================================================
+
+void AudioSynthesizer::render(const std::vector<PhonemeToken>& tokens,
+                              AudioBuffer& result) {
     result.sample_rate = SAMPLE_RATE;
     result.bits_per_sample = BITS_PER_SAMPLE;
     result.channels = NUM_CHANNELS;
+    result.samples.clear();
+    m_mark_offsets.clear();
 
     if (tokens.empty()) {
-        return result;
+        return;
     }
 
+    StageTimer concat_timer(m_stats ? &m_stats->concatenate_ms : nullptr);
+    trace::Scope concat_trace("synth", "concatenate");
+    concat_trace.set_arg("phonemes", static_cast<int64_t>(tokens.size()));
+
     // Estimate total size for efficiency
     size_t estimated_samples = 0;
     for (const auto& token : tokens) {
-        auto samples = m_phoneme_data.get_phoneme(token.phoneme);
-        estimated_samples += samples.size();
+        if (!token.mark) {
+            estimated_samples += m_phoneme_data.get_phoneme(token.phoneme).size();
+        }
     }
     result.samples.reserve(estimated_samples);
 
     // Crossfade settings
     constexpr size_t CROSSFADE_SAMPLES = 64;  // ~3ms at 22050Hz
 
-    AudioBuffer prev_phoneme;
+    bool have_prev_phoneme = false;
+    size_t emitted = 0;  // Samples already passed to the stream callback
 
     for (const auto& token : tokens) {
-        // Get audio for this phoneme
-        AudioBuffer phoneme_audio = get_phoneme_audio(token.phoneme);
+        if (token.mark) {
+            m_mark_offsets.push_back(emitted + result.samples.size());
+            continue;
+        }
+
+        // Get audio for this phoneme (a view into the loaded phoneme data)
+        span<const AudioSample> phoneme_audio = get_phoneme_samples(token.phoneme);
 
         if (phoneme_audio.empty()) {
             continue;
         }
 
         // Apply crossfade with previous phoneme
-        if (!prev_phoneme.empty() && !result.samples.empty()) {
-            apply_crossfade(result, phoneme_audio, CROSSFADE_SAMPLES);
+        if (have_prev_phoneme && !result.samples.empty()) {
+            apply_crossfade(result.samples, phoneme_audio, CROSSFADE_SAMPLES);
         } else {
             // First phoneme or no crossfade needed
             result.samples.insert(result.samples.end(),
-                                 phoneme_audio.samples.begin(),
-                                 phoneme_audio.samples.end());
+                                 phoneme_audio.begin(),
+                                 phoneme_audio.end());
         }
 
-        prev_phoneme = std::move(phoneme_audio);
+        have_prev_phoneme = true;
 
         // Emit chunk if streaming
         if (m_stream_callback && m_stream_chunk_samples > 0) {
             while (result.samples.size() >= m_stream_chunk_samples) {
-                AudioBuffer chunk;
-                chunk.sample_rate = result.sample_rate;
-                chunk.bits_per_sample = result.bits_per_sample;
-                chunk.channels = result.channels;
-                chunk.samples.assign(result.samples.begin(),
-                                    result.samples.begin() + m_stream_chunk_samples);
+                m_chunk.sample_rate = result.sample_rate;
+                m_chunk.bits_per_sample = result.bits_per_sample;
+                m_chunk.channels = result.channels;
+                m_chunk.samples.assign(result.samples.begin(),
+                                      result.samples.begin() + m_stream_chunk_samples);
 
-                emit_chunk(chunk);
+                emit_chunk(m_chunk);
 
                 result.samples.erase(result.samples.begin(),
                                     result.samples.begin() + m_stream_chunk_samples);
+                emitted += m_stream_chunk_samples;
             }
         }
     }
 
-    // Apply global voice parameters
-    if (std::abs(m_voice_params.volume - 1.0f) > 0.01f) {
-        result = apply_volume(result, m_voice_params.volume);
-    }
-
-    if (std::abs(m_voice_params.speed - 1.0f) > 0.01f) {
-        result = apply_rate(result, m_voice_params.speed);
-    }
+    concat_timer.stop();
+    concat_trace.stop();
+    StageTimer dsp_timer(m_stats ? &m_stats->dsp_ms : nullptr);
 
-    if (std::abs(m_voice_params.pitch - 1.0f) > 0.01f) {
-        result = apply_pitch(result, m_voice_params.pitch);
-    }
+    // Apply rate and voice character pitch; volume and user pitch are
+    // applied by quantize_output()
+    size_t concatenated = result.samples.size();
+    apply_rate_and_pitch(result, m_voice_params.speed, m_voice_params.pitch);
 
-    // Apply user pitch preference (formant-preserving)
-    // This is separate from voice character pitch (above) which shifts formants
-    if (std::abs(m_voice_params.user_pitch - 1.0f) > 0.01f) {
-        result = apply_user_pitch(result, m_voice_params.user_pitch);
-    }
-
-    // Flush remaining samples if streaming
-    if (m_stream_callback && !result.samples.empty()) {
-        emit_chunk(result);
-        result.samples.clear();
+    // Marks move with the time stretch
+    if (!m_mark_offsets.empty() && concatenated > 0 &&
+        result.samples.size() != concatenated) {
+        for (size_t& offset : m_mark_offsets) {
+            offset = std::min(offset, concatenated) * result.samples.size() / concatenated;
+        }
     }
-
-    return result;
 }
 
 // =============================================================================
@@ -120,34 +151,45 @@ AudioBuffer AudioSynthesizer::synthesize_segment(
     const TextSegment& segment,
     const std::vector<PhonemeToken>& tokens) {
 
-    // First, synthesize raw audio
-    AudioBuffer raw_audio = synthesize(tokens);
+    AudioBuffer result;
+    synthesize_segment(segment, tokens, result);
+    return result;
+}
+
+void AudioSynthesizer::synthesize_segment(
+    const TextSegment& segment,
+    const std::vector<PhonemeToken>& tokens,
+    AudioBuffer& output) {
 
-    if (raw_audio.empty()) {
-        return raw_audio;
+    // First, render raw audio (rate and voice pitch applied)
+    render(tokens, m_raw);
+
+    if (m_raw.empty()) {
+        output = m_raw;
+        return;
     }
 
-    // Apply inflection based on segment punctuation
-    AudioBuffer inflected = m_inflection.apply_inflection(
-        raw_audio,
-        segment.inflection,
-        tokens.size()
-    );
+    // Apply the inflection contour based on segment punctuation
+    trace::Scope trace_scope("synth", "synthesize_segment");
+    StageTimer inflection_timer(m_stats ? &m_stats->inflection_ms : nullptr);
+    m_inflection.apply_contour(m_raw, segment.inflection, output);
+    inflection_timer.stop();
+
+    // User pitch, volume and inflection emphasis in one conversion
+    StageTimer output_timer(m_stats ? &m_stats->dsp_ms : nullptr);
+    float emphasis = get_inflection_params(segment.inflection).emphasis;
+    quantize_output(output, m_voice_params.volume * emphasis);
+    output_timer.stop();
 
     // Add pause after segment if needed
     if (segment.trailing_punct != Punctuation::NONE) {
         uint32_t pause_ms = m_inflection.get_pause_duration(segment.trailing_punct);
 
         if (pause_ms > 0) {
-            AudioBuffer pause = generate_silence(pause_ms);
-
-            inflected.samples.insert(inflected.samples.end(),
-                                    pause.samples.begin(),
-                                    pause.samples.end());
+            size_t pause_samples = (static_cast<size_t>(SAMPLE_RATE) * pause_ms) / 1000;
+            output.samples.resize(output.samples.size() + pause_samples, 0);
         }
     }
-
-    return inflected;
 }
 
 // =============================================================================
@@ -199,6 +241,7 @@ void AudioSynthesizer::clear_stream_callback() {
 
 void AudioSynthesizer::emit_chunk(const AudioBuffer& chunk) {
     if (m_stream_callback && !chunk.empty()) {
+        trace::Scope trace_scope("synth", "emit_chunk");
         m_stream_callback(chunk);
     }
 }
@@ -235,40 +278,23 @@ uint32_t AudioSynthesizer::get_truncation_limit(Phoneme phoneme) {
 }
 
 // =============================================================================
-// Get Phoneme Audio
+// Get Phoneme Samples
 // =============================================================================
 
-AudioBuffer AudioSynthesizer::get_phoneme_audio(Phoneme phoneme) const {
-    AudioBuffer result;
-    result.sample_rate = SAMPLE_RATE;
-    result.bits_per_sample = BITS_PER_SAMPLE;
-    result.channels = NUM_CHANNELS;
-
-    // Handle silence specially
+span<const AudioSample> AudioSynthesizer::get_phoneme_samples(Phoneme phoneme) const {
+    // Handle silence specially (a short 50ms pause)
     if (phoneme == Phoneme::SILENCE) {
-        // Generate a short silence (50ms)
-        return generate_silence(50);
+        return span<const AudioSample>(m_short_silence.data(), m_short_silence.size());
     }
 
     // Get truncation limit
     uint32_t max_bytes = get_truncation_limit(phoneme);
 
     // Get phoneme samples
-    span<const AudioSample> samples;
     if (max_bytes > 0) {
-        samples = m_phoneme_data.get_phoneme_truncated(phoneme, max_bytes);
-    } else {
-        samples = m_phoneme_data.get_phoneme(phoneme);
+        return m_phoneme_data.get_phoneme_truncated(phoneme, max_bytes);
     }
-
-    if (samples.empty()) {
-        return result;
-    }
-
-    // Copy to result buffer
-    result.samples.assign(samples.begin(), samples.end());
-
-    return result;
+    return m_phoneme_data.get_phoneme(phoneme);
 }
 
 // =============================================================================
@@ -276,129 +302,80 @@ AudioBuffer AudioSynthesizer::get_phoneme_audio(Phoneme phoneme) const {
 // =============================================================================
 
 void AudioSynthesizer::apply_crossfade(
-    AudioBuffer& dest,
-    const AudioBuffer& src,
+    AudioSamples& dest,
+    span<const AudioSample> src,
     size_t overlap_samples) const {
 
-    if (dest.empty() || src.empty()) {
-        dest.samples.insert(dest.samples.end(),
-                          src.samples.begin(),
-                          src.samples.end());
-        return;
-    }
-
     // Determine actual overlap
     size_t actual_overlap = std::min({
         overlap_samples,
-        dest.samples.size(),
-        src.samples.size()
+        dest.size(),
+        src.size()
     });
 
     if (actual_overlap == 0) {
-        dest.samples.insert(dest.samples.end(),
-                          src.samples.begin(),
-                          src.samples.end());
+        dest.insert(dest.end(), src.begin(), src.end());
         return;
     }
 
     // Crossfade the overlapping region
-    size_t dest_start = dest.samples.size() - actual_overlap;
-
-    for (size_t i = 0; i < actual_overlap; ++i) {
-        // Linear crossfade
-        float t = static_cast<float>(i) / static_cast<float>(actual_overlap);
-
-        float dest_sample = static_cast<float>(dest.samples[dest_start + i]);
-        float src_sample = static_cast<float>(src.samples[i]);
-
-        // Blend: fade out dest, fade in src
-        float blended = dest_sample * (1.0f - t) + src_sample * t;
-
-        // Clamp and store
-        blended = std::clamp(blended, -32768.0f, 32767.0f);
-        dest.samples[dest_start + i] = static_cast<AudioSample>(std::round(blended));
-    }
+    // Linear crossfade: fade out dest, fade in src
+    size_t dest_start = dest.size() - actual_overlap;
+    dsp::crossfade(dest.data() + dest_start, src.data(), actual_overlap);
 
     // Append remaining source samples (after overlap)
-    if (src.samples.size() > actual_overlap) {
-        dest.samples.insert(dest.samples.end(),
-                          src.samples.begin() + actual_overlap,
-                          src.samples.end());
+    if (src.size() > actual_overlap) {
+        dest.insert(dest.end(), src.begin() + actual_overlap, src.end());
     }
 }
 
 // =============================================================================
-// Apply Volume
+// Apply Rate and Pitch (Sonic)
 // =============================================================================
 
-AudioBuffer AudioSynthesizer::apply_volume(
-    const AudioBuffer& samples,
-    float volume) const {
-
-    AudioBuffer result = samples;
-
-    for (auto& sample : result.samples) {
-        float adjusted = static_cast<float>(sample) * volume;
-        adjusted = std::clamp(adjusted, -32768.0f, 32767.0f);
-        sample = static_cast<AudioSample>(std::round(adjusted));
-    }
-
-    return result;
-}
-
-// =============================================================================
-// Apply Rate (Sonic Time-Stretching)
-// =============================================================================
-
-AudioBuffer AudioSynthesizer::apply_rate(
-    const AudioBuffer& samples,
-    float rate) const {
-
-    if (samples.empty() || std::abs(rate - 1.0f) < 0.01f) {
-        return samples;
+void AudioSynthesizer::apply_rate_and_pitch(AudioBuffer& audio, float rate, float pitch) {
+    bool change_rate = std::abs(rate - 1.0f) > 0.01f;
+    bool change_pitch = std::abs(pitch - 1.0f) > 0.01f;
+    if (audio.empty() || (!change_rate && !change_pitch)) {
+        return;
     }
 
-    // Use Sonic for time-stretching: changes speed WITHOUT changing pitch
-    // Rate > 1.0 = faster speech, same pitch
-    // Rate < 1.0 = slower speech, same pitch
-    return sonic::change_speed(samples, rate);
+    // One Sonic pass for both, so the audio is only quantized once:
+    // rate changes speed WITHOUT changing pitch (> 1.0 = faster speech),
+    // pitch changes pitch WITHOUT changing duration (> 1.0 = higher).
+    // Note: the pitch also shifts formants (chipmunk effect) - used for voice character
+    m_sonic.process(audio,
+                    change_rate ? std::clamp(rate, 0.05f, 20.0f) : 1.0f,
+                    change_pitch ? std::clamp(pitch, 0.05f, 20.0f) : 1.0f,
+                    m_scratch);
+    std::swap(audio.samples, m_scratch.samples);
 }
 
 // =============================================================================
-// Apply Pitch (Sonic Pitch-Shifting)
+// Output Quantization
 // =============================================================================
 
-AudioBuffer AudioSynthesizer::apply_pitch(
-    const AudioBuffer& samples,
-    float pitch) const {
-
-    if (samples.empty() || std::abs(pitch - 1.0f) < 0.01f) {
-        return samples;
+void AudioSynthesizer::quantize_output(AudioBuffer& audio, float gain) {
+    if (audio.empty()) {
+        return;
     }
 
-    // Use Sonic for pitch-shifting: changes pitch WITHOUT changing duration
-    // Higher pitch (>1.0) = higher frequency, same duration
-    // Lower pitch (<1.0) = lower frequency, same duration
-    // Note: This also shifts formants (chipmunk effect) - used for voice character
-    return sonic::change_pitch(samples, pitch);
-}
-
-// =============================================================================
-// Apply User Pitch (Formant-Preserving)
-// =============================================================================
-
-AudioBuffer AudioSynthesizer::apply_user_pitch(
-    const AudioBuffer& samples,
-    float pitch) const {
-
-    if (samples.empty() || std::abs(pitch - 1.0f) < 0.01f) {
-        return samples;
+    trace::Scope trace_scope("synth", "quantize_output");
+
+    bool change_gain = std::abs(gain - 1.0f) > 0.01f;
+    float user_pitch = m_voice_params.user_pitch;
+
+    if (std::abs(user_pitch - 1.0f) > 0.01f) {
+        // Formant-preserving user pitch: changes pitch WITHOUT shifting
+        // formants (no chipmunk effect). Its float output is converted once,
+        // with the gain folded in.
+        m_pitch_shifter.process(audio, user_pitch, m_float);
+        audio.samples.resize(m_float.size());
+        dsp::quantize(m_float.data(), audio.samples.data(), m_float.size(),
+                      change_gain ? gain : 1.0f);
+    } else if (change_gain) {
+        dsp::apply_gain(audio.samples.data(), audio.samples.size(), gain);
     }
-
-    // Use formant-preserving pitch shifting for user preference
-    // This changes pitch WITHOUT shifting formants (no chipmunk effect)
-    // Voice character stays the same, just the pitch changes
-    return formant::change_pitch_preserve_formants(samples, pitch);
 }
 
 } // namespace laprdus
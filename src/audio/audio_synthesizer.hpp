@@ -7,6 +7,8 @@
 
 #include "laprdus/types.hpp"
 #include "phoneme_data.hpp"
+#include "sonic_processor.hpp"
+#include "formant_pitch.hpp"
 #include "../core/inflection.hpp"
 #include <vector>
 #include <string>
@@ -46,6 +48,14 @@ public:
      */
     AudioBuffer synthesize(const std::vector<PhonemeToken>& tokens);
 
+    /**
+     * Synthesize audio from phoneme tokens into a caller-owned buffer.
+     * Once the buffers have grown to the working size, this does not allocate.
+     * @param tokens Sequence of phoneme tokens with timing info.
+     * @param output Receives the combined audio (storage is reused).
+     */
+    void synthesize(const std::vector<PhonemeToken>& tokens, AudioBuffer& output);
+
     /**
      * Synthesize a single text segment with inflection.
      * @param segment Text segment with inflection markers.
@@ -55,6 +65,16 @@ public:
     AudioBuffer synthesize_segment(const TextSegment& segment,
                                    const std::vector<PhonemeToken>& tokens);
 
+    /**
+     * Synthesize a single text segment with inflection into a caller-owned buffer.
+     * @param segment Text segment with inflection markers.
+     * @param tokens Phonemes for this segment.
+     * @param output Receives the processed audio (storage is reused).
+     */
+    void synthesize_segment(const TextSegment& segment,
+                            const std::vector<PhonemeToken>& tokens,
+                            AudioBuffer& output);
+
     /**
      * Generate silence of specified duration.
      * @param duration_ms Duration in milliseconds.
@@ -74,6 +94,14 @@ public:
      */
     const VoiceParams& voice_params() const { return m_voice_params; }
 
+    /**
+     * Positions of the mark tokens of the last synthesize() or
+     * synthesize_segment() call, in samples from the start of its audio:
+     * where the next phoneme joins, scaled with the speaking rate.
+     * @return One offset per mark token, in token order.
+     */
+    const std::vector<size_t>& mark_offsets() const { return m_mark_offsets; }
+
     /**
      * Set streaming callback for real-time output.
      * @param callback Function to receive audio chunks.
@@ -87,6 +115,12 @@ public:
      */
     void clear_stream_callback();
 
+    /**
+     * Set statistics sink for stage timings.
+     * @param stats Statistics to accumulate into, or nullptr to disable.
+     */
+    void set_stats(SynthesisStats* stats) { m_stats = stats; }
+
 private:
     const PhonemeData& m_phoneme_data;
     VoiceParams m_voice_params{};
@@ -95,19 +129,34 @@ private:
     std::function<void(const AudioBuffer&)> m_stream_callback;
     uint32_t m_stream_chunk_samples = 0;
 
+    SynthesisStats* m_stats = nullptr;
+
+    // Working storage reused across calls, so warm synthesis does not allocate
+    AudioSamples m_short_silence;     // Audio for Phoneme::SILENCE
+    AudioBuffer m_raw;                // Segment audio before inflection
+    AudioBuffer m_scratch;            // Ping-pong buffer for DSP stages
+    AudioBuffer m_chunk;              // Streaming chunk
+    std::vector<size_t> m_mark_offsets;  // Mark tokens of the last segment
+    std::vector<float> m_float;       // User pitch output before quantization
+    sonic::Processor m_sonic;
+    formant::PitchShifter m_pitch_shifter;
+
     // Phonemes that should be truncated (long consonants)
     static constexpr uint32_t TRUNCATION_BYTES = 2000;
     static bool should_truncate(Phoneme phoneme);
     static uint32_t get_truncation_limit(Phoneme phoneme);
 
-    // Audio processing helpers
-    AudioBuffer get_phoneme_audio(Phoneme phoneme) const;
-    void apply_crossfade(AudioBuffer& dest, const AudioBuffer& src,
+    // Concatenate phonemes and apply rate and voice pitch. The result is
+    // still intermediate: gains and the user pitch shift are left to
+    // quantize_output(), so only that step rounds and saturates them.
+    void render(const std::vector<PhonemeToken>& tokens, AudioBuffer& result);
+
+    // Audio processing helpers (DSP stages work in place)
+    span<const AudioSample> get_phoneme_samples(Phoneme phoneme) const;
+    void apply_crossfade(AudioSamples& dest, span<const AudioSample> src,
                         size_t overlap_samples) const;
-    AudioBuffer apply_volume(const AudioBuffer& samples, float volume) const;
-    AudioBuffer apply_rate(const AudioBuffer& samples, float rate) const;
-    AudioBuffer apply_pitch(const AudioBuffer& samples, float pitch) const;
-    AudioBuffer apply_user_pitch(const AudioBuffer& samples, float pitch) const;
+    void apply_rate_and_pitch(AudioBuffer& audio, float rate, float pitch);
+    void quantize_output(AudioBuffer& audio, float gain);
 
     // Streaming support
     void emit_chunk(const AudioBuffer& chunk);
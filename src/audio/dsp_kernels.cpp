@@ -0,0 +1,721 @@
+// -*- coding: utf-8 -*-
+// dsp_kernels.cpp - Vectorized sample kernels with runtime dispatch
+
+#include "dsp_kernels.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || \
+    ((defined(__i386__) || defined(_M_IX86)) && \
+     (defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)))
+#define LAPRDUS_DSP_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define LAPRDUS_TARGET_AVX2
+#else
+#define LAPRDUS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define LAPRDUS_DSP_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Every kernel rounds each product before adding, which keeps the sets
+// bit-identical. GCC (-ffp-contract=fast by default) and clang (=on) may
+// fuse a * b + c * d into one rounding on FMA targets such as 64-bit ARM or
+// -march=native x86: in the scalar code, and for GCC also in the multiply
+// and add intrinsic pairs. These mark the kernel sections compiled as with
+// -ffp-contract=off; dispatch and the public functions keep the build
+// flags. MSVC contracts only under /fp:fast or /fp:contract, and its pragma
+// holds to the end of the file.
+#if defined(__clang__)
+#define LAPRDUS_NO_FP_CONTRACT_BEGIN \
+    _Pragma("float_control(push)") _Pragma("clang fp contract(off)")
+#define LAPRDUS_NO_FP_CONTRACT_END _Pragma("float_control(pop)")
+#elif defined(__GNUC__)
+#define LAPRDUS_NO_FP_CONTRACT_BEGIN \
+    _Pragma("GCC push_options") _Pragma("GCC optimize(\"fp-contract=off\")")
+#define LAPRDUS_NO_FP_CONTRACT_END _Pragma("GCC pop_options")
+#elif defined(_MSC_VER)
+#define LAPRDUS_NO_FP_CONTRACT_BEGIN __pragma(fp_contract(off))
+#define LAPRDUS_NO_FP_CONTRACT_END
+#else
+#define LAPRDUS_NO_FP_CONTRACT_BEGIN
+#define LAPRDUS_NO_FP_CONTRACT_END
+#endif
+
+namespace laprdus {
+namespace dsp {
+
+namespace {
+
+constexpr float SAMPLE_MIN = -32768.0f;
+constexpr float SAMPLE_MAX = 32767.0f;
+constexpr float TO_FLOAT_SCALE = 1.0f / 32768.0f;  // Exact: a power of two
+constexpr float FROM_FLOAT_SCALE = 32768.0f;
+constexpr float HALF_PI = 1.57079632679489661923f;
+
+// Equal-power gains are computed in blocks of this many samples
+constexpr size_t GAIN_BLOCK = 64;
+
+struct Kernels {
+    Isa isa;
+    void (*gain_nearest)(AudioSample* samples, size_t count, float gain);
+    void (*gain_toward_zero)(AudioSample* samples, size_t count, float gain);
+    void (*linear_fade)(AudioSample* dest, const AudioSample* src, size_t count);
+    void (*blend)(AudioSample* dest, const AudioSample* src,
+                  const float* out_gain, const float* in_gain, size_t count);
+    void (*to_float)(const AudioSample* in, float* out, size_t count);
+    void (*from_float)(const float* in, AudioSample* out, size_t count);
+    void (*quantize_gain)(const float* in, AudioSample* out, size_t count, float scale);
+};
+
+// =============================================================================
+// Scalar Reference
+// =============================================================================
+
+// Kernels from here to the dispatch code are compiled without contraction
+LAPRDUS_NO_FP_CONTRACT_BEGIN
+
+template <Rounding R>
+inline AudioSample quantize(float value) {
+    value = std::clamp(value, SAMPLE_MIN, SAMPLE_MAX);
+    return static_cast<AudioSample>(R == Rounding::Nearest ? std::round(value) : value);
+}
+
+// The vector kernels finish their tails with these, starting at begin
+template <Rounding R>
+void gain_tail(AudioSample* samples, size_t begin, size_t count, float gain) {
+    for (size_t i = begin; i < count; ++i) {
+        samples[i] = quantize<R>(static_cast<float>(samples[i]) * gain);
+    }
+}
+
+void linear_fade_tail(AudioSample* dest, const AudioSample* src, size_t begin, size_t count) {
+    for (size_t i = begin; i < count; ++i) {
+        float t = static_cast<float>(i) / static_cast<float>(count);
+        float blended = static_cast<float>(dest[i]) * (1.0f - t) +
+                        static_cast<float>(src[i]) * t;
+        dest[i] = quantize<Rounding::Nearest>(blended);
+    }
+}
+
+void blend_tail(AudioSample* dest, const AudioSample* src, const float* out_gain,
+                const float* in_gain, size_t begin, size_t count) {
+    for (size_t i = begin; i < count; ++i) {
+        float blended = static_cast<float>(dest[i]) * out_gain[i] +
+                        static_cast<float>(src[i]) * in_gain[i];
+        dest[i] = quantize<Rounding::Nearest>(blended);
+    }
+}
+
+void to_float_tail(const AudioSample* in, float* out, size_t begin, size_t count) {
+    for (size_t i = begin; i < count; ++i) {
+        out[i] = static_cast<float>(in[i]) * TO_FLOAT_SCALE;
+    }
+}
+
+void from_float_tail(const float* in, AudioSample* out, size_t begin, size_t count) {
+    for (size_t i = begin; i < count; ++i) {
+        out[i] = quantize<Rounding::TowardZero>(in[i] * FROM_FLOAT_SCALE);
+    }
+}
+
+void quantize_gain_tail(const float* in, AudioSample* out, size_t begin, size_t count,
+                        float scale) {
+    for (size_t i = begin; i < count; ++i) {
+        out[i] = quantize<Rounding::Nearest>(in[i] * scale);
+    }
+}
+
+template <Rounding R>
+void gain_scalar(AudioSample* samples, size_t count, float gain) {
+    gain_tail<R>(samples, 0, count, gain);
+}
+
+void linear_fade_scalar(AudioSample* dest, const AudioSample* src, size_t count) {
+    linear_fade_tail(dest, src, 0, count);
+}
+
+void blend_scalar(AudioSample* dest, const AudioSample* src,
+                  const float* out_gain, const float* in_gain, size_t count) {
+    blend_tail(dest, src, out_gain, in_gain, 0, count);
+}
+
+void to_float_scalar(const AudioSample* in, float* out, size_t count) {
+    to_float_tail(in, out, 0, count);
+}
+
+void from_float_scalar(const float* in, AudioSample* out, size_t count) {
+    from_float_tail(in, out, 0, count);
+}
+
+void quantize_gain_scalar(const float* in, AudioSample* out, size_t count, float scale) {
+    quantize_gain_tail(in, out, 0, count, scale);
+}
+
+const Kernels SCALAR_KERNELS = {
+    Isa::Scalar,
+    gain_scalar<Rounding::Nearest>,
+    gain_scalar<Rounding::TowardZero>,
+    linear_fade_scalar,
+    blend_scalar,
+    to_float_scalar,
+    from_float_scalar,
+    quantize_gain_scalar,
+};
+
+#if defined(LAPRDUS_DSP_X86)
+
+// =============================================================================
+// SSE2 (4 floats per vector)
+// =============================================================================
+
+// Clamp to the sample range and round as quantize() does. Truncation plus
+// a correction of one away from zero when the fraction reaches one half
+// reproduces std::round exactly for values this small.
+template <Rounding R>
+inline __m128i quantize_sse2(__m128 value) {
+    value = _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(SAMPLE_MIN)), _mm_set1_ps(SAMPLE_MAX));
+    __m128i truncated = _mm_cvttps_epi32(value);
+    if (R == Rounding::TowardZero) {
+        return truncated;
+    }
+    __m128 fraction = _mm_sub_ps(value, _mm_cvtepi32_ps(truncated));
+    __m128 magnitude = _mm_andnot_ps(_mm_set1_ps(-0.0f), fraction);
+    __m128 away = _mm_cmpge_ps(magnitude, _mm_set1_ps(0.5f));
+    // -1 for negative values, +1 otherwise
+    __m128i sign = _mm_or_si128(_mm_srai_epi32(_mm_castps_si128(value), 31), _mm_set1_epi32(1));
+    return _mm_add_epi32(truncated, _mm_and_si128(_mm_castps_si128(away), sign));
+}
+
+inline void widen_sse2(__m128i samples, __m128& lo, __m128& hi) {
+    lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16));
+    hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16));
+}
+
+inline __m128i load8_sse2(const AudioSample* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+inline void store8_sse2(AudioSample* p, __m128i lo, __m128i hi) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_packs_epi32(lo, hi));
+}
+
+template <Rounding R>
+void gain_sse2(AudioSample* samples, size_t count, float gain) {
+    const __m128 g = _mm_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128 lo, hi;
+        widen_sse2(load8_sse2(samples + i), lo, hi);
+        store8_sse2(samples + i, quantize_sse2<R>(_mm_mul_ps(lo, g)),
+                    quantize_sse2<R>(_mm_mul_ps(hi, g)));
+    }
+    gain_tail<R>(samples, i, count, gain);
+}
+
+inline __m128 fade_sse2(__m128 d, __m128 s, __m128 out_gain, __m128 in_gain) {
+    return _mm_add_ps(_mm_mul_ps(d, out_gain), _mm_mul_ps(s, in_gain));
+}
+
+void linear_fade_sse2(AudioSample* dest, const AudioSample* src, size_t count) {
+    const __m128 n = _mm_set1_ps(static_cast<float>(count));
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128 t_lo = _mm_div_ps(_mm_cvtepi32_ps(index), n);
+        index = _mm_add_epi32(index, _mm_set1_epi32(4));
+        __m128 t_hi = _mm_div_ps(_mm_cvtepi32_ps(index), n);
+        index = _mm_add_epi32(index, _mm_set1_epi32(4));
+
+        __m128 d_lo, d_hi, s_lo, s_hi;
+        widen_sse2(load8_sse2(dest + i), d_lo, d_hi);
+        widen_sse2(load8_sse2(src + i), s_lo, s_hi);
+        store8_sse2(dest + i,
+                    quantize_sse2<Rounding::Nearest>(
+                        fade_sse2(d_lo, s_lo, _mm_sub_ps(one, t_lo), t_lo)),
+                    quantize_sse2<Rounding::Nearest>(
+                        fade_sse2(d_hi, s_hi, _mm_sub_ps(one, t_hi), t_hi)));
+    }
+    linear_fade_tail(dest, src, i, count);
+}
+
+void blend_sse2(AudioSample* dest, const AudioSample* src,
+                const float* out_gain, const float* in_gain, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128 d_lo, d_hi, s_lo, s_hi;
+        widen_sse2(load8_sse2(dest + i), d_lo, d_hi);
+        widen_sse2(load8_sse2(src + i), s_lo, s_hi);
+        store8_sse2(dest + i,
+                    quantize_sse2<Rounding::Nearest>(fade_sse2(
+                        d_lo, s_lo, _mm_loadu_ps(out_gain + i), _mm_loadu_ps(in_gain + i))),
+                    quantize_sse2<Rounding::Nearest>(fade_sse2(
+                        d_hi, s_hi, _mm_loadu_ps(out_gain + i + 4), _mm_loadu_ps(in_gain + i + 4))));
+    }
+    blend_tail(dest, src, out_gain, in_gain, i, count);
+}
+
+void to_float_sse2(const AudioSample* in, float* out, size_t count) {
+    const __m128 scale = _mm_set1_ps(TO_FLOAT_SCALE);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128 lo, hi;
+        widen_sse2(load8_sse2(in + i), lo, hi);
+        _mm_storeu_ps(out + i, _mm_mul_ps(lo, scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(hi, scale));
+    }
+    to_float_tail(in, out, i, count);
+}
+
+void from_float_sse2(const float* in, AudioSample* out, size_t count) {
+    const __m128 scale = _mm_set1_ps(FROM_FLOAT_SCALE);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128 lo = _mm_mul_ps(_mm_loadu_ps(in + i), scale);
+        __m128 hi = _mm_mul_ps(_mm_loadu_ps(in + i + 4), scale);
+        store8_sse2(out + i, quantize_sse2<Rounding::TowardZero>(lo),
+                    quantize_sse2<Rounding::TowardZero>(hi));
+    }
+    from_float_tail(in, out, i, count);
+}
+
+void quantize_gain_sse2(const float* in, AudioSample* out, size_t count, float scale) {
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128 lo = _mm_mul_ps(_mm_loadu_ps(in + i), s);
+        __m128 hi = _mm_mul_ps(_mm_loadu_ps(in + i + 4), s);
+        store8_sse2(out + i, quantize_sse2<Rounding::Nearest>(lo),
+                    quantize_sse2<Rounding::Nearest>(hi));
+    }
+    quantize_gain_tail(in, out, i, count, scale);
+}
+
+const Kernels SSE2_KERNELS = {
+    Isa::SSE2,
+    gain_sse2<Rounding::Nearest>,
+    gain_sse2<Rounding::TowardZero>,
+    linear_fade_sse2,
+    blend_sse2,
+    to_float_sse2,
+    from_float_sse2,
+    quantize_gain_sse2,
+};
+
+// =============================================================================
+// AVX2 (8 floats per vector)
+// =============================================================================
+
+template <Rounding R>
+LAPRDUS_TARGET_AVX2 inline __m256i quantize_avx2(__m256 value) {
+    value = _mm256_min_ps(_mm256_max_ps(value, _mm256_set1_ps(SAMPLE_MIN)),
+                          _mm256_set1_ps(SAMPLE_MAX));
+    __m256i truncated = _mm256_cvttps_epi32(value);
+    if (R == Rounding::TowardZero) {
+        return truncated;
+    }
+    __m256 fraction = _mm256_sub_ps(value, _mm256_cvtepi32_ps(truncated));
+    __m256 magnitude = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), fraction);
+    __m256 away = _mm256_cmp_ps(magnitude, _mm256_set1_ps(0.5f), _CMP_GE_OQ);
+    __m256i sign = _mm256_or_si256(_mm256_srai_epi32(_mm256_castps_si256(value), 31),
+                                   _mm256_set1_epi32(1));
+    return _mm256_add_epi32(truncated, _mm256_and_si256(_mm256_castps_si256(away), sign));
+}
+
+LAPRDUS_TARGET_AVX2 inline void widen_avx2(const AudioSample* p, __m256& lo, __m256& hi) {
+    lo = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+    hi = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8))));
+}
+
+LAPRDUS_TARGET_AVX2 inline void store16_avx2(AudioSample* p, __m256i lo, __m256i hi) {
+    // packs works within 128-bit lanes; restore sample order afterwards
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), packed);
+}
+
+template <Rounding R>
+LAPRDUS_TARGET_AVX2 void gain_avx2(AudioSample* samples, size_t count, float gain) {
+    const __m256 g = _mm256_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256 lo, hi;
+        widen_avx2(samples + i, lo, hi);
+        store16_avx2(samples + i, quantize_avx2<R>(_mm256_mul_ps(lo, g)),
+                     quantize_avx2<R>(_mm256_mul_ps(hi, g)));
+    }
+    gain_tail<R>(samples, i, count, gain);
+}
+
+LAPRDUS_TARGET_AVX2 inline __m256 fade_avx2(__m256 d, __m256 s, __m256 out_gain, __m256 in_gain) {
+    return _mm256_add_ps(_mm256_mul_ps(d, out_gain), _mm256_mul_ps(s, in_gain));
+}
+
+LAPRDUS_TARGET_AVX2 void linear_fade_avx2(AudioSample* dest, const AudioSample* src, size_t count) {
+    const __m256 n = _mm256_set1_ps(static_cast<float>(count));
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256 t_lo = _mm256_div_ps(_mm256_cvtepi32_ps(index), n);
+        index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+        __m256 t_hi = _mm256_div_ps(_mm256_cvtepi32_ps(index), n);
+        index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+
+        __m256 d_lo, d_hi, s_lo, s_hi;
+        widen_avx2(dest + i, d_lo, d_hi);
+        widen_avx2(src + i, s_lo, s_hi);
+        store16_avx2(dest + i,
+                     quantize_avx2<Rounding::Nearest>(
+                         fade_avx2(d_lo, s_lo, _mm256_sub_ps(one, t_lo), t_lo)),
+                     quantize_avx2<Rounding::Nearest>(
+                         fade_avx2(d_hi, s_hi, _mm256_sub_ps(one, t_hi), t_hi)));
+    }
+    linear_fade_tail(dest, src, i, count);
+}
+
+LAPRDUS_TARGET_AVX2 void blend_avx2(AudioSample* dest, const AudioSample* src,
+                                    const float* out_gain, const float* in_gain, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256 d_lo, d_hi, s_lo, s_hi;
+        widen_avx2(dest + i, d_lo, d_hi);
+        widen_avx2(src + i, s_lo, s_hi);
+        store16_avx2(dest + i,
+                     quantize_avx2<Rounding::Nearest>(fade_avx2(
+                         d_lo, s_lo, _mm256_loadu_ps(out_gain + i), _mm256_loadu_ps(in_gain + i))),
+                     quantize_avx2<Rounding::Nearest>(fade_avx2(
+                         d_hi, s_hi, _mm256_loadu_ps(out_gain + i + 8),
+                         _mm256_loadu_ps(in_gain + i + 8))));
+    }
+    blend_tail(dest, src, out_gain, in_gain, i, count);
+}
+
+LAPRDUS_TARGET_AVX2 void to_float_avx2(const AudioSample* in, float* out, size_t count) {
+    const __m256 scale = _mm256_set1_ps(TO_FLOAT_SCALE);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256 lo, hi;
+        widen_avx2(in + i, lo, hi);
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(lo, scale));
+        _mm256_storeu_ps(out + i + 8, _mm256_mul_ps(hi, scale));
+    }
+    to_float_tail(in, out, i, count);
+}
+
+LAPRDUS_TARGET_AVX2 void from_float_avx2(const float* in, AudioSample* out, size_t count) {
+    const __m256 scale = _mm256_set1_ps(FROM_FLOAT_SCALE);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256 lo = _mm256_mul_ps(_mm256_loadu_ps(in + i), scale);
+        __m256 hi = _mm256_mul_ps(_mm256_loadu_ps(in + i + 8), scale);
+        store16_avx2(out + i, quantize_avx2<Rounding::TowardZero>(lo),
+                     quantize_avx2<Rounding::TowardZero>(hi));
+    }
+    from_float_tail(in, out, i, count);
+}
+
+LAPRDUS_TARGET_AVX2 void quantize_gain_avx2(const float* in, AudioSample* out, size_t count,
+                                            float scale) {
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256 lo = _mm256_mul_ps(_mm256_loadu_ps(in + i), s);
+        __m256 hi = _mm256_mul_ps(_mm256_loadu_ps(in + i + 8), s);
+        store16_avx2(out + i, quantize_avx2<Rounding::Nearest>(lo),
+                     quantize_avx2<Rounding::Nearest>(hi));
+    }
+    quantize_gain_tail(in, out, i, count, scale);
+}
+
+const Kernels AVX2_KERNELS = {
+    Isa::AVX2,
+    gain_avx2<Rounding::Nearest>,
+    gain_avx2<Rounding::TowardZero>,
+    linear_fade_avx2,
+    blend_avx2,
+    to_float_avx2,
+    from_float_avx2,
+    quantize_gain_avx2,
+};
+
+bool cpu_has_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;  // The OS does not save the YMM registers
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // LAPRDUS_DSP_X86
+
+#if defined(LAPRDUS_DSP_NEON)
+
+// =============================================================================
+// NEON (4 floats per vector)
+// =============================================================================
+
+template <Rounding R>
+inline int32x4_t quantize_neon(float32x4_t value) {
+    value = vminq_f32(vmaxq_f32(value, vdupq_n_f32(SAMPLE_MIN)), vdupq_n_f32(SAMPLE_MAX));
+    // vcvtaq rounds halfway cases away from zero, like std::round
+    return R == Rounding::Nearest ? vcvtaq_s32_f32(value) : vcvtq_s32_f32(value);
+}
+
+inline void widen_neon(const AudioSample* p, float32x4_t& lo, float32x4_t& hi) {
+    int16x8_t samples = vld1q_s16(p);
+    lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples)));
+    hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(samples)));
+}
+
+inline void store8_neon(AudioSample* p, int32x4_t lo, int32x4_t hi) {
+    vst1q_s16(p, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+}
+
+template <Rounding R>
+void gain_neon(AudioSample* samples, size_t count, float gain) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t lo, hi;
+        widen_neon(samples + i, lo, hi);
+        store8_neon(samples + i, quantize_neon<R>(vmulq_n_f32(lo, gain)),
+                    quantize_neon<R>(vmulq_n_f32(hi, gain)));
+    }
+    gain_tail<R>(samples, i, count, gain);
+}
+
+inline float32x4_t fade_neon(float32x4_t d, float32x4_t s,
+                             float32x4_t out_gain, float32x4_t in_gain) {
+    return vaddq_f32(vmulq_f32(d, out_gain), vmulq_f32(s, in_gain));
+}
+
+void linear_fade_neon(AudioSample* dest, const AudioSample* src, size_t count) {
+    const float32x4_t n = vdupq_n_f32(static_cast<float>(count));
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    static const int32_t first[4] = {0, 1, 2, 3};
+    int32x4_t index = vld1q_s32(first);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t t_lo = vdivq_f32(vcvtq_f32_s32(index), n);
+        index = vaddq_s32(index, vdupq_n_s32(4));
+        float32x4_t t_hi = vdivq_f32(vcvtq_f32_s32(index), n);
+        index = vaddq_s32(index, vdupq_n_s32(4));
+
+        float32x4_t d_lo, d_hi, s_lo, s_hi;
+        widen_neon(dest + i, d_lo, d_hi);
+        widen_neon(src + i, s_lo, s_hi);
+        store8_neon(dest + i,
+                    quantize_neon<Rounding::Nearest>(
+                        fade_neon(d_lo, s_lo, vsubq_f32(one, t_lo), t_lo)),
+                    quantize_neon<Rounding::Nearest>(
+                        fade_neon(d_hi, s_hi, vsubq_f32(one, t_hi), t_hi)));
+    }
+    linear_fade_tail(dest, src, i, count);
+}
+
+void blend_neon(AudioSample* dest, const AudioSample* src,
+                const float* out_gain, const float* in_gain, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t d_lo, d_hi, s_lo, s_hi;
+        widen_neon(dest + i, d_lo, d_hi);
+        widen_neon(src + i, s_lo, s_hi);
+        store8_neon(dest + i,
+                    quantize_neon<Rounding::Nearest>(fade_neon(
+                        d_lo, s_lo, vld1q_f32(out_gain + i), vld1q_f32(in_gain + i))),
+                    quantize_neon<Rounding::Nearest>(fade_neon(
+                        d_hi, s_hi, vld1q_f32(out_gain + i + 4), vld1q_f32(in_gain + i + 4))));
+    }
+    blend_tail(dest, src, out_gain, in_gain, i, count);
+}
+
+void to_float_neon(const AudioSample* in, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t lo, hi;
+        widen_neon(in + i, lo, hi);
+        vst1q_f32(out + i, vmulq_n_f32(lo, TO_FLOAT_SCALE));
+        vst1q_f32(out + i + 4, vmulq_n_f32(hi, TO_FLOAT_SCALE));
+    }
+    to_float_tail(in, out, i, count);
+}
+
+void from_float_neon(const float* in, AudioSample* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t lo = vmulq_n_f32(vld1q_f32(in + i), FROM_FLOAT_SCALE);
+        float32x4_t hi = vmulq_n_f32(vld1q_f32(in + i + 4), FROM_FLOAT_SCALE);
+        store8_neon(out + i, quantize_neon<Rounding::TowardZero>(lo),
+                    quantize_neon<Rounding::TowardZero>(hi));
+    }
+    from_float_tail(in, out, i, count);
+}
+
+void quantize_gain_neon(const float* in, AudioSample* out, size_t count, float scale) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t lo = vmulq_n_f32(vld1q_f32(in + i), scale);
+        float32x4_t hi = vmulq_n_f32(vld1q_f32(in + i + 4), scale);
+        store8_neon(out + i, quantize_neon<Rounding::Nearest>(lo),
+                    quantize_neon<Rounding::Nearest>(hi));
+    }
+    quantize_gain_tail(in, out, i, count, scale);
+}
+
+const Kernels NEON_KERNELS = {
+    Isa::NEON,
+    gain_neon<Rounding::Nearest>,
+    gain_neon<Rounding::TowardZero>,
+    linear_fade_neon,
+    blend_neon,
+    to_float_neon,
+    from_float_neon,
+    quantize_gain_neon,
+};
+
+#endif // LAPRDUS_DSP_NEON
+
+LAPRDUS_NO_FP_CONTRACT_END
+
+// =============================================================================
+// Dispatch
+// =============================================================================
+
+const Kernels* kernels_for(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar:
+            return &SCALAR_KERNELS;
+#if defined(LAPRDUS_DSP_X86)
+        case Isa::SSE2:
+            return &SSE2_KERNELS;
+        case Isa::AVX2: {
+            static const bool supported = cpu_has_avx2();
+            return supported ? &AVX2_KERNELS : nullptr;
+        }
+#endif
+#if defined(LAPRDUS_DSP_NEON)
+        case Isa::NEON:
+            return &NEON_KERNELS;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+const Kernels* best_kernels() {
+    for (Isa isa : {Isa::AVX2, Isa::SSE2, Isa::NEON}) {
+        if (const Kernels* k = kernels_for(isa)) {
+            return k;
+        }
+    }
+    return &SCALAR_KERNELS;
+}
+
+std::atomic<const Kernels*> g_kernels{nullptr};
+
+const Kernels& kernels() {
+    const Kernels* k = g_kernels.load(std::memory_order_acquire);
+    if (!k) {
+        // Racing first calls all pick the same set
+        k = best_kernels();
+        g_kernels.store(k, std::memory_order_release);
+    }
+    return *k;
+}
+
+} // anonymous namespace
+
+Isa active_isa() {
+    return kernels().isa;
+}
+
+bool isa_supported(Isa isa) {
+    return kernels_for(isa) != nullptr;
+}
+
+bool set_isa(Isa isa) {
+    const Kernels* k = kernels_for(isa);
+    if (!k) {
+        return false;
+    }
+    g_kernels.store(k, std::memory_order_release);
+    return true;
+}
+
+const char* isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::SSE2:   return "sse2";
+        case Isa::AVX2:   return "avx2";
+        case Isa::NEON:   return "neon";
+    }
+    return "unknown";
+}
+
+// =============================================================================
+// Kernels
+// =============================================================================
+
+void apply_gain(AudioSample* samples, size_t count, float gain, Rounding rounding) {
+    if (rounding == Rounding::Nearest) {
+        kernels().gain_nearest(samples, count, gain);
+    } else {
+        kernels().gain_toward_zero(samples, count, gain);
+    }
+}
+
+void crossfade(AudioSample* dest, const AudioSample* src, size_t count, FadeCurve curve) {
+    if (curve == FadeCurve::Linear) {
+        kernels().linear_fade(dest, src, count);
+        return;
+    }
+
+    // Gains come from the same scalar code for every instruction set
+    float out_gain[GAIN_BLOCK];
+    float in_gain[GAIN_BLOCK];
+    for (size_t start = 0; start < count; start += GAIN_BLOCK) {
+        size_t n = std::min(GAIN_BLOCK, count - start);
+        for (size_t i = 0; i < n; ++i) {
+            float angle = static_cast<float>(start + i) / static_cast<float>(count) * HALF_PI;
+            out_gain[i] = std::cos(angle);
+            in_gain[i] = std::sin(angle);
+        }
+        kernels().blend(dest + start, src + start, out_gain, in_gain, n);
+    }
+}
+
+void to_float(const AudioSample* in, float* out, size_t count) {
+    kernels().to_float(in, out, count);
+}
+
+void from_float(const float* in, AudioSample* out, size_t count) {
+    kernels().from_float(in, out, count);
+}
+
+void quantize(const float* in, AudioSample* out, size_t count, float gain) {
+    // One multiply per sample; gain * 32768 is computed once
+    kernels().quantize_gain(in, out, count, gain * FROM_FLOAT_SCALE);
+}
+
+} // namespace dsp
+} // namespace laprdus
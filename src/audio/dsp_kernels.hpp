@@ -0,0 +1,108 @@
+// -*- coding: utf-8 -*-
+// dsp_kernels.hpp - Vectorized sample kernels with runtime dispatch
+
+#ifndef LAPRDUS_DSP_KERNELS_HPP
+#define LAPRDUS_DSP_KERNELS_HPP
+
+#include "laprdus/types.hpp"
+#include <cstddef>
+
+namespace laprdus {
+namespace dsp {
+
+/*
+ * Every kernel has a scalar reference and SIMD versions (SSE2 and AVX2 on
+ * x86, NEON on ARM). The fastest supported set is picked on first use, by
+ * CPU detection on x86; all sets produce bit-identical output.
+ */
+enum class Isa {
+    Scalar,
+    SSE2,
+    AVX2,
+    NEON,
+};
+
+/**
+ * Instruction set the kernels currently use.
+ */
+Isa active_isa();
+
+/**
+ * Check if an instruction set is compiled in and supported by this CPU.
+ */
+bool isa_supported(Isa isa);
+
+/**
+ * Switch kernels to another instruction set (for tests and benchmarks).
+ * @param isa Instruction set to use.
+ * @return false if the instruction set is not supported.
+ */
+bool set_isa(Isa isa);
+
+/**
+ * Get a display name ("scalar", "sse2", "avx2", "neon").
+ */
+const char* isa_name(Isa isa);
+
+/**
+ * How float results are turned back into samples.
+ */
+enum class Rounding {
+    Nearest,     // Halfway cases away from zero, as std::round
+    TowardZero,  // Truncation, as static_cast
+};
+
+/**
+ * Crossfade gain curves.
+ */
+enum class FadeCurve {
+    Linear,      // Gains 1 - t and t
+    EqualPower,  // Gains cos and sin of t * pi / 2
+};
+
+/**
+ * Multiply samples by a gain, saturating to the 16-bit range.
+ * @param samples Samples to scale in place.
+ * @param count Number of samples.
+ * @param gain Gain factor.
+ * @param rounding Conversion of the scaled values.
+ */
+void apply_gain(AudioSample* samples, size_t count, float gain,
+                Rounding rounding = Rounding::Nearest);
+
+/**
+ * Crossfade src into dest over count samples, rounding to nearest.
+ * Sample i is weighted with t = i / count: dest fades out, src fades in.
+ * @param dest Fading-out samples, overwritten with the result.
+ * @param src Fading-in samples.
+ * @param count Number of samples.
+ * @param curve Gain curve.
+ */
+void crossfade(AudioSample* dest, const AudioSample* src, size_t count,
+               FadeCurve curve = FadeCurve::Linear);
+
+/**
+ * Convert samples to float in [-1, 1) (sample / 32768).
+ */
+void to_float(const AudioSample* in, float* out, size_t count);
+
+/**
+ * Convert float samples back (value * 32768), saturating and truncating.
+ */
+void from_float(const float* in, AudioSample* out, size_t count);
+
+/**
+ * Convert float samples to output samples with a gain: value * gain * 32768,
+ * saturating and rounding to nearest. This is the pipeline's final
+ * quantization, so the gain is applied without an extra pass.
+ * @param in Float samples in [-1, 1).
+ * @param out Output samples.
+ * @param count Number of samples.
+ * @param gain Gain factor.
+ */
+void quantize(const float* in, AudioSample* out, size_t count, float gain = 1.0f);
+
+} // namespace dsp
+} // namespace laprdus
+
+#endif // LAPRDUS_DSP_KERNELS_HPP
@@ -0,0 +1,41 @@
+// -*- coding: utf-8 -*-
+// embedded_voice.hpp - Voice pack compiled into the library
+
+#ifndef LAPRDUS_EMBEDDED_VOICE_HPP
+#define LAPRDUS_EMBEDDED_VOICE_HPP
+
+#include "laprdus/types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace laprdus {
+
+#ifdef LAPRDUS_EMBEDDED_VOICE
+// Defined in embedded_voice.cpp, which scons --embed-voice generates from
+// the packed voice. The pack is const data, so it lands in a read-only
+// section and is paged in from the library image on first use.
+extern const uint8_t EMBEDDED_VOICE_DATA[];
+extern const size_t EMBEDDED_VOICE_SIZE;
+extern const char EMBEDDED_VOICE_FILE[];  // Voice data file name, e.g. "Josip.bin"
+#endif
+
+/**
+ * Get the voice pack compiled into the library.
+ * @param filename Voice data file name (e.g. "Josip.bin").
+ * @return The pack, or an empty span if that voice is not embedded.
+ */
+inline span<const uint8_t> embedded_voice_pack(const char* filename) {
+#ifdef LAPRDUS_EMBEDDED_VOICE
+    if (filename && std::strcmp(filename, EMBEDDED_VOICE_FILE) == 0) {
+        return span<const uint8_t>(EMBEDDED_VOICE_DATA, EMBEDDED_VOICE_SIZE);
+    }
+#else
+    (void)filename;
+#endif
+    return {};
+}
+
+} // namespace laprdus
+
+#endif // LAPRDUS_EMBEDDED_VOICE_HPP
@@ -5,7 +5,9 @@
 // Falls back to Sonic for short audio segments where Signalsmith would produce artifacts.
 
 #include "formant_pitch.hpp"
+#include "dsp_kernels.hpp"
 #include "sonic_processor.hpp"
+#include "../core/trace.hpp"
 #include <algorithm>
 #include <cmath>
 #include <cstring>
@@ -15,33 +17,98 @@
 namespace laprdus {
 namespace formant {
 
-AudioBuffer change_pitch_preserve_formants(const AudioBuffer& input, float pitch_factor, float /*quefrency_ms*/) {
-    if (input.empty()) return input;
-    if (std::abs(pitch_factor - 1.0f) < 0.01f) return input;
+// =============================================================================
+// PitchShifter
+// =============================================================================
+
+struct PitchShifter::Impl {
+    signalsmith::stretch::SignalsmithStretch<float> stretch;
+    float configured_rate = 0.0f;     // Sample rate the preset was built for
+    std::vector<float> input_float;
+    std::vector<float> output_float;
+    sonic::Processor sonic;           // Fallback for short segments
+    sonic::PitchEnvelopeProcessor envelope;  // Contour fallback for short segments
+    AudioBuffer fallback;             // Sonic output before conversion
+
+    // Use the library's default preset - it's been optimized by the authors.
+    // Configuring allocates the STFT buffers, so only do it when the rate changes.
+    void configure(float sample_rate) {
+        if (configured_rate != sample_rate) {
+            stretch.presetDefault(1, sample_rate);
+            configured_rate = sample_rate;
+        }
+    }
+};
+
+namespace {
+
+// Signalsmith-stretch needs minimum audio length to work properly
+// Default preset uses ~120ms blocks, so we need at least that much
+constexpr float MIN_DURATION = 0.15f;  // 150ms minimum
+
+} // anonymous namespace
+
+PitchShifter::PitchShifter()
+    : m_impl(std::make_unique<Impl>())
+{
+}
+
+PitchShifter::~PitchShifter() = default;
+
+void PitchShifter::process(const AudioBuffer& input, float pitch_factor, AudioBuffer& output) {
+    output.sample_rate = input.sample_rate;
+    output.bits_per_sample = input.bits_per_sample;
+    output.channels = input.channels;
+
+    if (input.empty() || std::abs(pitch_factor - 1.0f) < 0.01f) {
+        output.samples = input.samples;
+        return;
+    }
+
+    // Convert back to int16
+    std::vector<float>& output_float = m_impl->output_float;
+    process(input, pitch_factor, output_float);
+    output.samples.resize(output_float.size());
+    dsp::from_float(output_float.data(), output.samples.data(), output_float.size());
+}
+
+void PitchShifter::process(const AudioBuffer& input, float pitch_factor,
+                           std::vector<float>& output) {
+    const size_t count = input.samples.size();
+    output.resize(count);
+
+    if (input.empty() || std::abs(pitch_factor - 1.0f) < 0.01f) {
+        dsp::to_float(input.samples.data(), output.data(), count);
+        return;
+    }
 
     pitch_factor = std::clamp(pitch_factor, 0.5f, 2.0f);
 
-    const int N = static_cast<int>(input.samples.size());
+    const int N = static_cast<int>(count);
     const float sample_rate = static_cast<float>(input.sample_rate);
 
-    // Signalsmith-stretch needs minimum audio length to work properly
-    // Default preset uses ~120ms blocks, so we need at least that much
     // For very short segments, use Sonic as fallback (it works on short audio)
-    const int MIN_SAMPLES = static_cast<int>(sample_rate * 0.15f);  // 150ms minimum
+    const int MIN_SAMPLES = static_cast<int>(sample_rate * MIN_DURATION);
 
     if (N < MIN_SAMPLES) {
         // Use Sonic for short segments - it works well on short audio
         // Sonic shifts formants (not ideal) but better than no pitch change
-        AudioBuffer result = sonic::change_pitch(input, pitch_factor);
+        AudioBuffer& fallback = m_impl->fallback;
+        m_impl->sonic.process(input, 1.0f, pitch_factor, fallback);
         // Safety: if Sonic returned empty, return original
-        if (result.samples.empty()) return input;
-        return result;
+        const AudioSamples& shifted = fallback.samples.empty() ? input.samples : fallback.samples;
+        output.resize(shifted.size());
+        dsp::to_float(shifted.data(), output.data(), shifted.size());
+        return;
     }
 
-    signalsmith::stretch::SignalsmithStretch<float> stretch;
+    trace::Scope trace_scope("formant", "signalsmith_stretch");
+    trace_scope.set_arg("samples", N);
+
+    auto& stretch = m_impl->stretch;
 
-    // Use the library's default preset - it's been optimized by the authors
-    stretch.presetDefault(1, sample_rate);
+    // exact() resets the processing state itself
+    m_impl->configure(sample_rate);
 
     // Set pitch shift
     float semitones = 12.0f * std::log2(pitch_factor);
@@ -51,32 +118,113 @@ AudioBuffer change_pitch_preserve_formants(const AudioBuffer& input, float pitch
     stretch.setFormantFactor(1.0f, true);
 
     // Convert input to float
-    std::vector<float> input_float(N);
-    for (int i = 0; i < N; i++) {
-        input_float[i] = input.samples[i] / 32768.0f;
-    }
+    std::vector<float>& input_float = m_impl->input_float;
+    input_float.resize(count);
+    dsp::to_float(input.samples.data(), input_float.data(), count);
 
     const float* input_ptr = input_float.data();
-    std::vector<float> output_float(N);
-    float* output_ptr = output_float.data();
+    float* output_ptr = output.data();
 
     stretch.exact(&input_ptr, N, &output_ptr, N);
+}
 
-    // Convert back to int16
-    AudioBuffer result;
-    result.sample_rate = input.sample_rate;
-    result.bits_per_sample = input.bits_per_sample;
-    result.channels = input.channels;
-    result.samples.resize(N);
-
-    // Convert output and check if valid
-    for (int i = 0; i < N; i++) {
-        float val = output_float[i] * 32768.0f;
-        result.samples[i] = static_cast<int16_t>(
-            std::clamp(val, -32768.0f, 32767.0f));
+void PitchShifter::process(const AudioBuffer& input, const std::vector<float>& envelope,
+                           AudioBuffer& output) {
+    output.sample_rate = input.sample_rate;
+    output.bits_per_sample = input.bits_per_sample;
+    output.channels = input.channels;
+
+    const size_t count = input.samples.size();
+    if (input.empty() || envelope.empty()) {
+        output.samples = input.samples;
+        return;
+    }
+
+    auto pitch_at = [&](size_t i) {
+        return std::clamp(envelope[std::min(i, envelope.size() - 1)], 0.5f, 2.0f);
+    };
+
+    // Samples before the contour starts are copied untouched
+    size_t onset = 0;
+    while (onset < count && std::abs(pitch_at(onset) - 1.0f) < 0.001f) {
+        ++onset;
+    }
+    if (onset == count) {
+        output.samples = input.samples;
+        return;
     }
 
-    return result;
+    auto& stretch = m_impl->stretch;
+    const float sample_rate = static_cast<float>(input.sample_rate);
+    m_impl->configure(sample_rate);
+
+    // Input needed to align the first output with the first input sample
+    const size_t seek = static_cast<size_t>(stretch.outputSeekLength(1.0f));
+    const size_t min_samples = std::max(static_cast<size_t>(sample_rate * MIN_DURATION), seek);
+    if (count < min_samples) {
+        // Sonic shifts formants (not ideal) but better than no contour
+        m_impl->envelope.process(input, envelope, output);
+        return;
+    }
+
+    trace::Scope trace_scope("formant", "pitch_envelope");
+    trace_scope.set_arg("samples", static_cast<int64_t>(count));
+
+    // The transposition is updated once per block (~6ms at 22050Hz), and
+    // the processed region starts a crossfade before the contour
+    constexpr size_t BLOCK_SIZE = 128;
+    constexpr size_t CROSSFADE = 256;
+    const size_t start = std::min(onset > CROSSFADE ? onset - CROSSFADE : 0,
+                                  count - min_samples);
+    const size_t length = count - start;
+
+    // Zeros after the region stand in for flush(), so the last outputs are
+    // produced block by block at the contour's final pitch
+    std::vector<float>& input_float = m_impl->input_float;
+    input_float.resize(length + seek);
+    dsp::to_float(input.samples.data() + start, input_float.data(), length);
+    std::fill(input_float.begin() + length, input_float.end(), 0.0f);
+
+    std::vector<float>& output_float = m_impl->output_float;
+    output_float.resize(length);
+
+    stretch.setTransposeFactor(pitch_at(start));
+    stretch.setFormantFactor(1.0f, true);
+    const float* input_ptr = input_float.data();
+    stretch.outputSeek(&input_ptr, static_cast<int>(seek));
+
+    // A spectrum computed at output position t is heard about
+    // outputLatency() later, so look the pitch up that far ahead
+    const size_t lead = static_cast<size_t>(stretch.outputLatency());
+    for (size_t pos = 0; pos < length; pos += BLOCK_SIZE) {
+        size_t len = std::min(BLOCK_SIZE, length - pos);
+        stretch.setTransposeFactor(pitch_at(start + pos + lead + len / 2));
+        input_ptr = input_float.data() + seek + pos;
+        float* output_ptr = output_float.data() + pos;
+        stretch.process(&input_ptr, static_cast<int>(len), &output_ptr, static_cast<int>(len));
+    }
+
+    // Fade from the untouched audio into the processed region
+    const size_t fade = std::min(CROSSFADE, onset - start);
+    for (size_t i = 0; i < fade; ++i) {
+        float t = static_cast<float>(i) / static_cast<float>(fade);
+        output_float[i] = input_float[i] * (1.0f - t) + output_float[i] * t;
+    }
+
+    output.samples.resize(count);
+    std::copy(input.samples.begin(), input.samples.begin() + start, output.samples.begin());
+    dsp::from_float(output_float.data(), output.samples.data() + start, length);
+}
+
+// =============================================================================
+// One-shot Interface
+// =============================================================================
+
+AudioBuffer change_pitch_preserve_formants(const AudioBuffer& input, float pitch_factor, float /*quefrency_ms*/) {
+    PitchShifter shifter;
+    AudioBuffer output;
+    shifter.process(input, pitch_factor, output);
+    return output;
 }
 
 } // namespace formant
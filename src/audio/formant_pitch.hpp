@@ -6,6 +6,8 @@
 #define LAPRDUS_FORMANT_PITCH_HPP
 
 #include "laprdus/types.hpp"
+#include <memory>
+#include <vector>
 
 namespace laprdus {
 namespace formant {
@@ -31,6 +33,56 @@ AudioBuffer change_pitch_preserve_formants(
     float pitch,
     float quefrency_ms = 1.0f);
 
+/**
+ * PitchShifter - Reusable formant-preserving pitch shifter.
+ *
+ * Produces the same output as change_pitch_preserve_formants(), but keeps
+ * the configured Signalsmith instance, its conversion buffers and the Sonic
+ * fallback stream between calls, so repeated use does not reallocate.
+ */
+class PitchShifter {
+public:
+    PitchShifter();
+    ~PitchShifter();
+
+    PitchShifter(const PitchShifter&) = delete;
+    PitchShifter& operator=(const PitchShifter&) = delete;
+
+    /**
+     * Pitch-shift audio while preserving formants.
+     * @param input Audio buffer to process.
+     * @param pitch Pitch factor (0.5 to 2.0).
+     * @param output Receives the processed audio (storage is reused).
+     */
+    void process(const AudioBuffer& input, float pitch, AudioBuffer& output);
+
+    /**
+     * Pitch-shift audio and leave the result in float, for a caller that
+     * quantizes it later (sample / 32768 scale, not clamped).
+     * @param input Audio buffer to process.
+     * @param pitch Pitch factor (0.5 to 2.0).
+     * @param output Receives one float per input sample (storage is reused).
+     */
+    void process(const AudioBuffer& input, float pitch, std::vector<float>& output);
+
+    /**
+     * Apply a time-varying pitch contour while preserving formants, in one
+     * streaming pass. The transposition follows the envelope block by block;
+     * samples before the contour leaves 1.0 are copied unchanged. Audio too
+     * short for the STFT goes through sonic::PitchEnvelopeProcessor instead,
+     * which shifts formants with the pitch.
+     * @param input Audio buffer to process.
+     * @param envelope Pitch factor for each sample position (0.5 to 2.0).
+     * @param output Receives the processed audio, the same length as input.
+     */
+    void process(const AudioBuffer& input, const std::vector<float>& envelope,
+                 AudioBuffer& output);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
 } // namespace formant
 } // namespace laprdus
 
@@ -0,0 +1,661 @@
+// -*- coding: utf-8 -*-
+// phoneme_codec.cpp - Linear prediction and Rice coding of phoneme audio
+
+#include "phoneme_codec.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace laprdus {
+
+namespace {
+
+constexpr uint32_t KIND_VERBATIM = 0;
+constexpr uint32_t KIND_FIXED = 1;
+constexpr uint32_t KIND_LPC = 2;
+
+constexpr int MAX_FIXED_ORDER = 4;
+constexpr int MAX_LPC_ORDER = 32;          // Format limit (5-bit field)
+constexpr int ENCODER_LPC_ORDER = 12;      // Highest order the encoder tries
+constexpr int LPC_PRECISIONS[] = {12, 15};  // Coefficient bits the encoder tries
+constexpr int MAX_LPC_SHIFT = 31;
+
+constexpr uint32_t RICE_ESCAPE = 31;
+constexpr uint32_t MAX_RICE_PARAM = 30;
+
+constexpr uint32_t zigzag(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+constexpr int32_t unzigzag(uint32_t value) {
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+constexpr uint32_t low_bits(int bits) {
+    return bits >= 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+}
+
+int count_leading_zeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(value);
+#else
+    int zeros = 0;
+    while (!(value & 0xFF00000000000000ull)) {
+        value <<= 8;
+        zeros += 8;
+    }
+    while (!(value & 0x8000000000000000ull)) {
+        value <<= 1;
+        ++zeros;
+    }
+    return zeros;
+#endif
+}
+
+uint64_t from_big_endian(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return __builtin_bswap64(value);
+#else
+    return value;
+#endif
+#else
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    uint64_t result = 0;
+    for (int i = 0; i < 8; ++i) {
+        result = (result << 8) | bytes[i];
+    }
+    return result;
+#endif
+}
+
+// =============================================================================
+// Bit Streams
+// =============================================================================
+
+class BitWriter {
+public:
+    // Append the low bits of value, MSB first (bits <= 32)
+    void write(uint32_t value, int bits) {
+        m_acc = (m_acc << bits) | (value & low_bits(bits));
+        m_count += bits;
+        while (m_count >= 8) {
+            m_count -= 8;
+            m_bytes.push_back(static_cast<uint8_t>(m_acc >> m_count));
+        }
+    }
+
+    void write_signed(int32_t value, int bits) {
+        write(static_cast<uint32_t>(value), bits);
+    }
+
+    // q zero bits followed by a one bit
+    void write_unary(uint32_t q) {
+        for (; q >= 32; q -= 32) {
+            write(0, 32);
+        }
+        write(1, static_cast<int>(q) + 1);
+    }
+
+    std::vector<uint8_t> finish() {
+        if (m_count > 0) {
+            m_bytes.push_back(static_cast<uint8_t>(m_acc << (8 - m_count)));
+            m_count = 0;
+        }
+        return std::move(m_bytes);
+    }
+
+private:
+    std::vector<uint8_t> m_bytes;
+    uint64_t m_acc = 0;
+    int m_count = 0;  // Bits in m_acc not yet flushed to m_bytes
+};
+
+// Reads past the end return zero bits; exhausted() tells whether any did
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+    // Read bits (<= 32) as an unsigned value
+    uint32_t read(int bits) {
+        if (bits == 0) {
+            return 0;
+        }
+        refill();
+        uint32_t value = static_cast<uint32_t>(m_cache >> (64 - bits));
+        m_cache <<= bits;
+        m_bits -= bits;
+        return value;
+    }
+
+    // Read bits (1-32) as a two's complement value
+    int32_t read_signed(int bits) {
+        uint32_t value = read(bits);
+        if (bits < 32 && (value >> (bits - 1)) != 0) {
+            value |= ~low_bits(bits);
+        }
+        return static_cast<int32_t>(value);
+    }
+
+    // Decode count Rice-coded, zigzag-mapped values with parameter k.
+    // Works on local copies of the reader state so the stores to values
+    // do not force it back to memory.
+    bool read_rice(int32_t* values, size_t count, int k) {
+        uint64_t cache = m_cache;
+        int bits = m_bits;
+        size_t pos = m_pos;
+        bool ok = true;
+
+        for (size_t i = 0; i < count && ok; ++i) {
+            if (bits < 32) {
+                refill(cache, bits, pos);
+            }
+            uint32_t q = 0;
+            int zeros = cache ? count_leading_zeros(cache) : 64;
+            while (zeros >= bits) {
+                // No one bit among the cached bits: drop them and reload
+                q += static_cast<uint32_t>(bits);
+                cache = 0;
+                bits = 0;
+                if (pos >= m_size) {
+                    ok = false;
+                    break;
+                }
+                refill(cache, bits, pos);
+                zeros = cache ? count_leading_zeros(cache) : 64;
+            }
+            q += static_cast<uint32_t>(zeros);
+            if (!ok || q > (0xFFFFFFFFu >> k)) {
+                ok = false;
+                break;
+            }
+            cache = (cache << zeros) << 1;
+            bits -= zeros + 1;
+
+            if (bits < k) {
+                refill(cache, bits, pos);
+            }
+            uint32_t remainder = static_cast<uint32_t>((cache >> 32) >> (32 - k));  // 0 for k = 0
+            cache <<= k;
+            bits -= k;
+            values[i] = unzigzag((q << k) | remainder);
+        }
+
+        m_cache = cache;
+        m_bits = bits;
+        m_pos = pos;
+        return ok;
+    }
+
+    bool exhausted() const {
+        return m_pos * 8 - static_cast<size_t>(m_bits) > m_size * 8;
+    }
+
+private:
+    void refill() {
+        refill(m_cache, m_bits, m_pos);
+    }
+
+    // Top up the cache to at least 56 bits. Away from the end of the data
+    // this is branch-free: a whole word is ORed in below the valid bits and
+    // only the complete bytes are counted. Bits below the valid ones may
+    // thus already hold the start of the next byte; loading it again ORs
+    // in the same values.
+    void refill(uint64_t& cache, int& bits, size_t& pos) const {
+        if (pos + 8 <= m_size) {
+            uint64_t word;
+            std::memcpy(&word, m_data + pos, sizeof(word));
+            cache |= from_big_endian(word) >> bits;
+            pos += static_cast<size_t>((63 - bits) >> 3);
+            bits |= 56;
+            return;
+        }
+        while (bits < 56) {
+            uint64_t byte = pos < m_size ? m_data[pos] : 0;
+            cache |= byte << (56 - bits);
+            ++pos;
+            bits += 8;
+        }
+    }
+
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_pos = 0;      // Next byte to load
+    uint64_t m_cache = 0;  // Unread bits, MSB aligned
+    int m_bits = 0;        // Valid bits in m_cache
+};
+
+// =============================================================================
+// Residuals
+// =============================================================================
+
+// Cheapest coding of one partition: Rice parameter or escape width
+struct PartitionCoding {
+    uint32_t param = 0;
+    int width = 0;
+    uint64_t bits = 0;
+};
+
+PartitionCoding choose_partition_coding(const uint32_t* values, size_t count) {
+    std::array<uint64_t, MAX_RICE_PARAM + 1> quotients{};
+    uint32_t largest = 0;
+    for (size_t i = 0; i < count; ++i) {
+        for (uint32_t k = 0; k <= MAX_RICE_PARAM; ++k) {
+            quotients[k] += values[i] >> k;
+        }
+        largest = std::max(largest, values[i]);
+    }
+
+    PartitionCoding best;
+    best.bits = std::numeric_limits<uint64_t>::max();
+    for (uint32_t k = 0; k <= MAX_RICE_PARAM; ++k) {
+        uint64_t bits = 5 + count * (k + 1) + quotients[k];
+        if (bits < best.bits) {
+            best.param = k;
+            best.bits = bits;
+        }
+    }
+
+    int width = largest ? 64 - count_leading_zeros(largest) : 0;
+    if (width <= 31) {
+        uint64_t bits = 10 + count * static_cast<uint64_t>(width);
+        if (bits < best.bits) {
+            best.param = RICE_ESCAPE;
+            best.width = width;
+            best.bits = bits;
+        }
+    }
+    return best;
+}
+
+uint64_t residual_bits(const std::vector<uint32_t>& residual) {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < residual.size(); i += PHONEME_CODEC_PARTITION) {
+        size_t count = std::min(PHONEME_CODEC_PARTITION, residual.size() - i);
+        bits += choose_partition_coding(residual.data() + i, count).bits;
+    }
+    return bits;
+}
+
+void write_residual(BitWriter& writer, const std::vector<uint32_t>& residual) {
+    for (size_t i = 0; i < residual.size(); i += PHONEME_CODEC_PARTITION) {
+        size_t count = std::min(PHONEME_CODEC_PARTITION, residual.size() - i);
+        const uint32_t* values = residual.data() + i;
+        PartitionCoding coding = choose_partition_coding(values, count);
+
+        writer.write(coding.param, 5);
+        if (coding.param == RICE_ESCAPE) {
+            writer.write(static_cast<uint32_t>(coding.width), 5);
+            for (size_t j = 0; j < count; ++j) {
+                writer.write(values[j], coding.width);
+            }
+            continue;
+        }
+        int k = static_cast<int>(coding.param);
+        for (size_t j = 0; j < count; ++j) {
+            writer.write_unary(values[j] >> k);
+            writer.write(values[j], k);
+        }
+    }
+}
+
+// Decode residuals for samples [order, count) of a frame
+bool read_residual(BitReader& reader, int32_t* residual, size_t order, size_t count) {
+    for (size_t i = order; i < count;) {
+        size_t end = std::min(count, i + PHONEME_CODEC_PARTITION);
+        uint32_t param = reader.read(5);
+        if (param == RICE_ESCAPE) {
+            int width = static_cast<int>(reader.read(5));
+            for (; i < end; ++i) {
+                residual[i] = unzigzag(reader.read(width));
+            }
+            continue;
+        }
+        if (!reader.read_rice(residual + i, end - i, static_cast<int>(param))) {
+            return false;
+        }
+        i = end;
+    }
+    return true;
+}
+
+// =============================================================================
+// Prediction
+// =============================================================================
+
+int64_t fixed_prediction(const int32_t* x, int order) {
+    switch (order) {
+    case 1: return x[-1];
+    case 2: return 2 * int64_t{x[-1]} - x[-2];
+    case 3: return 3 * (int64_t{x[-1]} - x[-2]) + x[-3];
+    case 4: return 4 * (int64_t{x[-1]} + x[-3]) - 6 * int64_t{x[-2]} - x[-4];
+    default: return 0;
+    }
+}
+
+int64_t lpc_prediction(const int32_t* x, const int32_t* coefs, int order, int shift) {
+    int64_t sum = 0;
+    for (int j = 0; j < order; ++j) {
+        sum += int64_t{coefs[j]} * x[-1 - j];
+    }
+    return sum >> shift;
+}
+
+// Rebuild samples [Order, count) in place; x holds residuals on entry.
+// Out-of-range samples are flagged once at the end so the loop stays
+// branch-free; until then they only feed bounded garbage forward.
+template <int Order>
+bool restore_fixed(int32_t* x, size_t count) {
+    bool in_range = true;
+    for (size_t i = Order; i < count; ++i) {
+        int64_t value = fixed_prediction(x + i, Order) + x[i];
+        in_range &= value == static_cast<AudioSample>(value);
+        x[i] = static_cast<int32_t>(value);
+    }
+    return in_range;
+}
+
+// Dot product unrolled at compile time; a plain loop over a constant
+// order is not unrolled at -O2 and costs more than the multiplies
+template <size_t... J>
+int64_t lpc_sum(const int32_t* x, const int32_t* coefs, std::index_sequence<J...>) {
+    return (int64_t{0} + ... + (int64_t{coefs[J]} * x[-1 - static_cast<ptrdiff_t>(J)]));
+}
+
+template <int Order>
+bool restore_lpc(int32_t* x, size_t count, const int32_t* coefs, int shift) {
+    bool in_range = true;
+    for (size_t i = Order; i < count; ++i) {
+        int64_t prediction = lpc_sum(x + i, coefs, std::make_index_sequence<Order>()) >> shift;
+        int64_t value = prediction + x[i];
+        in_range &= value == static_cast<AudioSample>(value);
+        x[i] = static_cast<int32_t>(value);
+    }
+    return in_range;
+}
+
+// Generic fallback for orders the encoder does not produce
+bool restore_lpc(int32_t* x, size_t count, const int32_t* coefs, int order, int shift) {
+    bool in_range = true;
+    for (size_t i = order; i < count; ++i) {
+        int64_t value = lpc_prediction(x + i, coefs, order, shift) + x[i];
+        in_range &= value == static_cast<AudioSample>(value);
+        x[i] = static_cast<int32_t>(value);
+    }
+    return in_range;
+}
+
+bool restore(int32_t* x, size_t count, uint32_t kind,
+             const int32_t* coefs, int order, int shift) {
+    if (kind == KIND_FIXED) {
+        switch (order) {
+        case 0: return restore_fixed<0>(x, count);
+        case 1: return restore_fixed<1>(x, count);
+        case 2: return restore_fixed<2>(x, count);
+        case 3: return restore_fixed<3>(x, count);
+        default: return restore_fixed<4>(x, count);
+        }
+    }
+    switch (order) {
+    case 1: return restore_lpc<1>(x, count, coefs, shift);
+    case 2: return restore_lpc<2>(x, count, coefs, shift);
+    case 3: return restore_lpc<3>(x, count, coefs, shift);
+    case 4: return restore_lpc<4>(x, count, coefs, shift);
+    case 5: return restore_lpc<5>(x, count, coefs, shift);
+    case 6: return restore_lpc<6>(x, count, coefs, shift);
+    case 7: return restore_lpc<7>(x, count, coefs, shift);
+    case 8: return restore_lpc<8>(x, count, coefs, shift);
+    case 9: return restore_lpc<9>(x, count, coefs, shift);
+    case 10: return restore_lpc<10>(x, count, coefs, shift);
+    case 11: return restore_lpc<11>(x, count, coefs, shift);
+    case 12: return restore_lpc<12>(x, count, coefs, shift);
+    default: return restore_lpc(x, count, coefs, order, shift);
+    }
+}
+
+// Largest residual a frame may carry (its zigzag value must fit 32 bits)
+bool residual_fits(int64_t value) {
+    return value >= std::numeric_limits<int32_t>::min() &&
+           value <= std::numeric_limits<int32_t>::max();
+}
+
+// Levinson-Durbin recursion; lpc[m] holds the predictor of order m + 1.
+// Returns the highest order solved.
+int solve_lpc(const double* autocorr, int max_order,
+              std::array<std::array<double, ENCODER_LPC_ORDER>, ENCODER_LPC_ORDER>& lpc) {
+    std::array<double, ENCODER_LPC_ORDER> current{};
+    double error = autocorr[0];
+    for (int m = 0; m < max_order; ++m) {
+        if (error <= 0.0) {
+            return m;
+        }
+        double acc = autocorr[m + 1];
+        for (int j = 0; j < m; ++j) {
+            acc -= current[j] * autocorr[m - j];
+        }
+        double reflection = acc / error;
+
+        std::array<double, ENCODER_LPC_ORDER> next{};
+        for (int j = 0; j < m; ++j) {
+            next[j] = current[j] - reflection * current[m - 1 - j];
+        }
+        next[m] = reflection;
+        current = next;
+        lpc[m] = current;
+        error *= 1.0 - reflection * reflection;
+    }
+    return max_order;
+}
+
+// Quantize coefficients with error feedback, FLAC style
+bool quantize_lpc(const double* lpc, int order, int precision,
+                  int32_t* coefs, int& shift) {
+    double largest = 0.0;
+    for (int j = 0; j < order; ++j) {
+        largest = std::max(largest, std::fabs(lpc[j]));
+    }
+    if (largest <= 0.0) {
+        return false;
+    }
+
+    int exponent;
+    std::frexp(largest, &exponent);
+    shift = std::min(precision - 1 - exponent, MAX_LPC_SHIFT);
+    if (shift < 0) {
+        return false;
+    }
+
+    int32_t limit = (1 << (precision - 1)) - 1;
+    double error = 0.0;
+    for (int j = 0; j < order; ++j) {
+        error += std::ldexp(lpc[j], shift);
+        int32_t q = static_cast<int32_t>(std::lround(error));
+        q = std::clamp(q, -limit - 1, limit);
+        coefs[j] = q;
+        error -= q;
+    }
+    return true;
+}
+
+// =============================================================================
+// Frames
+// =============================================================================
+
+struct FrameCoding {
+    uint32_t kind = KIND_VERBATIM;
+    int order = 0;
+    int precision = 0;
+    int shift = 0;
+    std::array<int32_t, MAX_LPC_ORDER> coefs{};
+    std::vector<uint32_t> residual;
+    uint64_t bits = std::numeric_limits<uint64_t>::max();
+};
+
+// Keep the candidate if it codes the frame in fewer bits than best
+void consider(FrameCoding& candidate, uint64_t header_bits, FrameCoding& best) {
+    candidate.bits = header_bits + residual_bits(candidate.residual);
+    if (candidate.bits < best.bits) {
+        std::swap(candidate, best);
+    }
+}
+
+void encode_frame(BitWriter& writer, const AudioSample* samples, size_t count) {
+    std::vector<int32_t> x(samples, samples + count);
+    const int32_t* data = x.data();
+
+    FrameCoding best;
+    best.bits = 2 + 16 * static_cast<uint64_t>(count);
+    FrameCoding candidate;
+
+    // Fixed polynomial predictors
+    for (int order = 0; order <= MAX_FIXED_ORDER && static_cast<size_t>(order) <= count; ++order) {
+        candidate.kind = KIND_FIXED;
+        candidate.order = order;
+        candidate.residual.clear();
+        for (size_t i = order; i < count; ++i) {
+            candidate.residual.push_back(
+                zigzag(static_cast<int32_t>(data[i] - fixed_prediction(data + i, order))));
+        }
+        consider(candidate, 5 + 16 * static_cast<uint64_t>(order), best);
+    }
+
+    // Linear prediction from the windowed autocorrelation
+    int max_order = static_cast<int>(std::min<size_t>(ENCODER_LPC_ORDER, count > 0 ? count - 1 : 0));
+    if (max_order > 0) {
+        std::vector<double> windowed(count);
+        for (size_t i = 0; i < count; ++i) {
+            double t = 2.0 * (i + 0.5) / count - 1.0;
+            windowed[i] = data[i] * (1.0 - t * t);  // Welch window
+        }
+        std::array<double, ENCODER_LPC_ORDER + 1> autocorr{};
+        for (int lag = 0; lag <= max_order; ++lag) {
+            for (size_t i = lag; i < count; ++i) {
+                autocorr[lag] += windowed[i] * windowed[i - lag];
+            }
+        }
+
+        std::array<std::array<double, ENCODER_LPC_ORDER>, ENCODER_LPC_ORDER> lpc{};
+        int solved = autocorr[0] > 0.0 ? solve_lpc(autocorr.data(), max_order, lpc) : 0;
+
+        for (int order = 1; order <= solved; ++order) {
+            for (int precision : LPC_PRECISIONS) {
+                candidate.kind = KIND_LPC;
+                candidate.order = order;
+                candidate.precision = precision;
+                if (!quantize_lpc(lpc[order - 1].data(), order, precision,
+                                  candidate.coefs.data(), candidate.shift)) {
+                    continue;
+                }
+                candidate.residual.clear();
+                bool fits = true;
+                for (size_t i = order; i < count && fits; ++i) {
+                    int64_t r = data[i] - lpc_prediction(data + i, candidate.coefs.data(),
+                                                         order, candidate.shift);
+                    fits = residual_fits(r);
+                    candidate.residual.push_back(zigzag(static_cast<int32_t>(r)));
+                }
+                if (fits) {
+                    consider(candidate, 16 + (precision + 16) * static_cast<uint64_t>(order), best);
+                }
+            }
+        }
+    }
+
+    writer.write(best.kind, 2);
+    if (best.kind == KIND_VERBATIM) {
+        for (size_t i = 0; i < count; ++i) {
+            writer.write_signed(data[i], 16);
+        }
+        return;
+    }
+    if (best.kind == KIND_FIXED) {
+        writer.write(static_cast<uint32_t>(best.order), 3);
+    } else {
+        writer.write(static_cast<uint32_t>(best.order - 1), 5);
+        writer.write(static_cast<uint32_t>(best.precision - 1), 4);
+        writer.write(static_cast<uint32_t>(best.shift), 5);
+        for (int j = 0; j < best.order; ++j) {
+            writer.write_signed(best.coefs[j], best.precision);
+        }
+    }
+    for (int i = 0; i < best.order; ++i) {
+        writer.write_signed(data[i], 16);
+    }
+    write_residual(writer, best.residual);
+}
+
+bool decode_frame(BitReader& reader, AudioSample* samples, size_t count) {
+    uint32_t kind = reader.read(2);
+    if (kind == KIND_VERBATIM) {
+        for (size_t i = 0; i < count; ++i) {
+            samples[i] = static_cast<AudioSample>(reader.read_signed(16));
+        }
+        return true;
+    }
+
+    int order;
+    int shift = 0;
+    std::array<int32_t, MAX_LPC_ORDER> coefs;
+    if (kind == KIND_FIXED) {
+        order = static_cast<int>(reader.read(3));
+        if (order > MAX_FIXED_ORDER) {
+            return false;
+        }
+    } else if (kind == KIND_LPC) {
+        order = static_cast<int>(reader.read(5)) + 1;
+        int precision = static_cast<int>(reader.read(4)) + 1;
+        shift = static_cast<int>(reader.read(5));
+        for (int j = 0; j < order; ++j) {
+            coefs[j] = reader.read_signed(precision);
+        }
+    } else {
+        return false;
+    }
+    if (static_cast<size_t>(order) > count) {
+        return false;
+    }
+
+    // Warm-up samples, then residuals turned into samples in place
+    std::array<int32_t, PHONEME_CODEC_FRAME> x;
+    for (int i = 0; i < order; ++i) {
+        x[i] = reader.read_signed(16);
+    }
+    if (!read_residual(reader, x.data(), static_cast<size_t>(order), count) ||
+        !restore(x.data(), count, kind, coefs.data(), order, shift)) {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        samples[i] = static_cast<AudioSample>(x[i]);
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Public Interface
+// =============================================================================
+
+std::vector<uint8_t> compress_phoneme(const AudioSample* samples, size_t count) {
+    BitWriter writer;
+    for (size_t start = 0; start < count; start += PHONEME_CODEC_FRAME) {
+        encode_frame(writer, samples + start, std::min(PHONEME_CODEC_FRAME, count - start));
+    }
+    return writer.finish();
+}
+
+bool decompress_phoneme(const uint8_t* data, size_t size,
+                        AudioSample* samples, size_t count) {
+    BitReader reader(data, size);
+    for (size_t start = 0; start < count; start += PHONEME_CODEC_FRAME) {
+        if (!decode_frame(reader, samples + start, std::min(PHONEME_CODEC_FRAME, count - start))) {
+            return false;
+        }
+    }
+    return !reader.exhausted();
+}
+
+} // namespace laprdus
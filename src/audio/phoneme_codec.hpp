@@ -0,0 +1,59 @@
+// -*- coding: utf-8 -*-
+// phoneme_codec.hpp - Lossless compression of phoneme audio
+
+#ifndef LAPRDUS_PHONEME_CODEC_HPP
+#define LAPRDUS_PHONEME_CODEC_HPP
+
+#include "laprdus/types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace laprdus {
+
+/*
+ * Compressed phoneme layout (used when a pack has PACKED_FLAG_COMPRESSED).
+ *
+ * The samples are split into frames of PHONEME_CODEC_FRAME samples (the
+ * last frame may be shorter). Each frame is coded FLAC-style as a
+ * predictor plus Rice-coded residuals, written MSB first with no padding
+ * between frames:
+ *
+ *   kind (2 bits)  0 = verbatim, 1 = fixed polynomial, 2 = linear prediction
+ *   verbatim:      every sample as 16 bits
+ *   fixed:         order (3 bits, 0-4), warm-up samples (16 bits each),
+ *                  residuals
+ *   lpc:           order - 1 (5 bits), precision - 1 (4 bits), shift
+ *                  (5 bits), coefficients (precision bits each, signed),
+ *                  warm-up samples (16 bits each), residuals
+ *
+ * Residuals are zigzag mapped and stored in partitions of
+ * PHONEME_CODEC_PARTITION values, each with its own Rice parameter
+ * (5 bits). Parameter 31 is an escape: a 5-bit width follows and the
+ * partition's values are stored in that many bits without Rice coding.
+ */
+constexpr size_t PHONEME_CODEC_FRAME = 1024;
+constexpr size_t PHONEME_CODEC_PARTITION = 128;
+
+/**
+ * Compress phoneme audio losslessly.
+ * @param samples 16-bit PCM samples.
+ * @param count Number of samples.
+ * @return Compressed bytes.
+ */
+std::vector<uint8_t> compress_phoneme(const AudioSample* samples, size_t count);
+
+/**
+ * Decompress audio written by compress_phoneme().
+ * @param data Compressed bytes.
+ * @param size Number of compressed bytes.
+ * @param samples Output buffer for exactly count samples.
+ * @param count Number of samples the data decodes to.
+ * @return false if the data is malformed or shorter than count samples.
+ */
+bool decompress_phoneme(const uint8_t* data, size_t size,
+                        AudioSample* samples, size_t count);
+
+} // namespace laprdus
+
+#endif // LAPRDUS_PHONEME_CODEC_HPP
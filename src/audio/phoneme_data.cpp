@@ -2,10 +2,13 @@
 // phoneme_data.cpp - Phoneme audio data loader implementation
 
 #include "phoneme_data.hpp"
+#include "phoneme_codec.hpp"
 #include "../core/phoneme_mapper.hpp"
 #include <fstream>
 #include <cstring>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -18,6 +21,78 @@
 
 namespace laprdus {
 
+namespace {
+
+// =============================================================================
+// CRC32
+// =============================================================================
+
+// Slice-by-8 tables for the zlib polynomial used by the packer. Hardware
+// CRC instructions (SSE4.2, ARMv8 CRC32C) use a different polynomial.
+using Crc32Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+constexpr Crc32Tables make_crc32_tables() {
+    Crc32Tables tables{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320u : 0u);
+        }
+        tables[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+        for (size_t t = 1; t < tables.size(); ++t) {
+            uint32_t prev = tables[t - 1][i];
+            tables[t][i] = (prev >> 8) ^ tables[0][prev & 0xFF];
+        }
+    }
+    return tables;
+}
+
+constexpr Crc32Tables CRC32_TABLES = make_crc32_tables();
+
+uint32_t load_le32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+uint32_t crc32(const uint8_t* data, size_t size) {
+    const auto& t = CRC32_TABLES;
+    uint32_t crc = 0xFFFFFFFF;
+
+    // Eight bytes per step, one table lookup each
+    for (; size >= 8; data += 8, size -= 8) {
+        uint32_t lo = load_le32(data) ^ crc;
+        uint32_t hi = load_le32(data + 4);
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^
+              t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^
+              t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+    }
+    for (; size > 0; ++data, --size) {
+        crc = t[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Lazy Source
+// =============================================================================
+
+struct PhonemeData::LazySource {
+    std::vector<uint8_t> pack;       // Whole packed file, audio still encoded
+    std::vector<uint8_t> key;
+    const uint8_t* audio = nullptr;  // Data section, in pack or borrowed
+
+    // A slot is written once under the mutex, then published through ready;
+    // readers that see ready never lock
+    std::array<std::vector<AudioSample>, static_cast<size_t>(Phoneme::COUNT)> samples;
+    std::array<std::atomic<bool>, static_cast<size_t>(Phoneme::COUNT)> ready{};
+    std::mutex mutex;
+};
+
 // =============================================================================
 // Constructor / Destructor
 // =============================================================================
@@ -51,7 +126,13 @@ bool PhonemeData::load_from_file(const std::string& path,
         return false;
     }
 
-    return load_from_memory(data.data(), data.size(), key);
+    clear();
+    if (m_lazy_enabled) {
+        // Keeps the buffer just read
+        const uint8_t* pack = data.data();
+        return load_lazily(pack, file_size, key, std::move(data));
+    }
+    return parse_packed_data(data.data(), data.size(), key);
 }
 
 // =============================================================================
@@ -61,15 +142,82 @@ bool PhonemeData::load_from_file(const std::string& path,
 bool PhonemeData::load_from_memory(const uint8_t* data, size_t size,
                                     span<const uint8_t> key) {
     clear();
+    if (!data) {
+        return false;
+    }
+    if (m_lazy_enabled) {
+        std::vector<uint8_t> pack(data, data + size);
+        const uint8_t* copy = pack.data();
+        return load_lazily(copy, size, key, std::move(pack));
+    }
     return parse_packed_data(data, size, key);
 }
 
+bool PhonemeData::load_from_memory_nocopy(const uint8_t* data, size_t size,
+                                          span<const uint8_t> key) {
+    clear();
+    if (!data) {
+        return false;
+    }
+
+    size_t audio_offset = 0;
+    if (!parse_index(data, size, key, audio_offset)) {
+        return false;
+    }
+
+    // Stored samples can be used in place unless they need decoding
+    const uint8_t* audio = data + audio_offset;
+    bool in_place = key.empty();
+    for (const auto& phoneme : m_phonemes) {
+        in_place = in_place && !phoneme.compressed;
+    }
+    if (!in_place && m_lazy_enabled) {
+        return load_lazily(data, size, key);
+    }
+
+    for (auto& phoneme : m_phonemes) {
+        if (!phoneme.loaded) {
+            continue;
+        }
+        const uint8_t* stored = audio + phoneme.data_offset;
+        if (in_place && reinterpret_cast<uintptr_t>(stored) % alignof(AudioSample) == 0) {
+            phoneme.borrowed = reinterpret_cast<const AudioSample*>(stored);
+        } else if (!decode_phoneme(audio, phoneme, key, phoneme.samples)) {
+            clear();
+            return false;
+        }
+    }
+
+    m_loaded = true;
+    return true;
+}
+
 // =============================================================================
 // Parse Packed Data
 // =============================================================================
 
 bool PhonemeData::parse_packed_data(const uint8_t* data, size_t size,
                                      span<const uint8_t> key) {
+    size_t audio_offset = 0;
+    if (!parse_index(data, size, key, audio_offset)) {
+        return false;
+    }
+
+    // Decode every phoneme now, decrypting each as it is copied
+    const uint8_t* audio = data + audio_offset;
+    for (auto& phoneme : m_phonemes) {
+        if (phoneme.loaded && !decode_phoneme(audio, phoneme, key, phoneme.samples)) {
+            clear();
+            return false;
+        }
+    }
+
+    m_loaded = true;
+    return true;
+}
+
+bool PhonemeData::parse_index(const uint8_t* data, size_t size,
+                               span<const uint8_t> key, size_t& audio_offset) {
     // Validate minimum size
     if (size < sizeof(PackedFileHeader)) {
         return false;
@@ -88,8 +236,11 @@ bool PhonemeData::parse_packed_data(const uint8_t* data, size_t size,
         return false;
     }
 
-    // Validate size
-    if (header->total_size > size) {
+    // Validate size, and that the index and data sections lie within it
+    if (header->total_size > size ||
+        header->data_offset > header->total_size ||
+        header->index_offset > size ||
+        header->phoneme_count > (size - header->index_offset) / sizeof(PhonemeIndexEntry)) {
         return false;
     }
 
@@ -98,6 +249,14 @@ bool PhonemeData::parse_packed_data(const uint8_t* data, size_t size,
     if (encrypted && key.empty()) {
         return false;  // Need key but none provided
     }
+    bool compressed = (header->flags & PACKED_FLAG_COMPRESSED) != 0;
+
+    // The checksum covers the data section as stored, before decryption
+    if (m_verify_checksum &&
+        crc32(data + header->data_offset, header->total_size - header->data_offset) !=
+            header->checksum) {
+        return false;
+    }
 
     // Store format info
     m_sample_rate = header->sample_rate;
@@ -107,18 +266,9 @@ bool PhonemeData::parse_packed_data(const uint8_t* data, size_t size,
     // Get pointers to index and data sections
     const auto* index = reinterpret_cast<const PhonemeIndexEntry*>(
         data + header->index_offset);
-    const uint8_t* audio_data = data + header->data_offset;
     size_t audio_size = size - header->data_offset;
 
-    // Decrypt audio data if needed
-    std::vector<uint8_t> decrypted_audio;
-    if (encrypted) {
-        decrypted_audio.assign(audio_data, audio_data + audio_size);
-        xor_decrypt(decrypted_audio, key);
-        audio_data = decrypted_audio.data();
-    }
-
-    // Load each phoneme
+    // Record where each phoneme lives
     for (uint32_t i = 0; i < header->phoneme_count; ++i) {
         const auto& entry = index[i];
 
@@ -128,32 +278,103 @@ bool PhonemeData::parse_packed_data(const uint8_t* data, size_t size,
         }
 
         // Validate offset and size
-        if (entry.data_offset + entry.original_size > audio_size) {
+        uint32_t packed_size = compressed ? entry.compressed_size : entry.original_size;
+        if (static_cast<uint64_t>(entry.data_offset) + packed_size > audio_size) {
             continue;
         }
 
-        // Get raw audio bytes
-        const uint8_t* phoneme_data = audio_data + entry.data_offset;
-        size_t byte_count = entry.original_size;
+        // 16-bit PCM samples
+        auto& phoneme = m_phonemes[entry.phoneme_id];
+        phoneme.data_offset = entry.data_offset;
+        phoneme.data_size = entry.original_size;
+        phoneme.packed_size = packed_size;
+        phoneme.compressed = compressed;
+        phoneme.duration_samples = entry.original_size / sizeof(AudioSample);
+        phoneme.loaded = true;
+    }
 
-        // Convert bytes to samples (16-bit PCM)
-        size_t sample_count = byte_count / sizeof(AudioSample);
+    audio_offset = header->data_offset;
+    return true;
+}
 
-        auto& phoneme = m_phonemes[entry.phoneme_id];
-        phoneme.samples.resize(sample_count);
+bool PhonemeData::decode_phoneme(const uint8_t* audio, const PhonemeEntry& entry,
+                                 span<const uint8_t> key,
+                                 std::vector<AudioSample>& samples) {
+    size_t sample_count = entry.data_size / sizeof(AudioSample);
+    size_t byte_count = sample_count * sizeof(AudioSample);
+    samples.resize(sample_count);
+    const uint8_t* packed = audio + entry.data_offset;
+
+    if (!entry.compressed) {
+        // Decrypt while copying from little-endian storage
+        xor_decrypt(reinterpret_cast<uint8_t*>(samples.data()), packed, byte_count,
+                    entry.data_offset, key);
+        return true;
+    }
 
-        // Copy and convert from little-endian
-        const auto* src = reinterpret_cast<const AudioSample*>(phoneme_data);
-        std::copy(src, src + sample_count, phoneme.samples.begin());
+    // The packer encrypts after compressing
+    std::vector<uint8_t> decrypted;
+    if (!key.empty()) {
+        decrypted.resize(entry.packed_size);
+        xor_decrypt(decrypted.data(), packed, decrypted.size(), entry.data_offset, key);
+        packed = decrypted.data();
+    }
+    if (!decompress_phoneme(packed, entry.packed_size, samples.data(), sample_count)) {
+        samples.clear();
+        return false;
+    }
+    return true;
+}
 
-        phoneme.duration_samples = static_cast<uint32_t>(sample_count);
-        phoneme.loaded = true;
+// =============================================================================
+// Lazy Decoding
+// =============================================================================
+
+bool PhonemeData::load_lazily(const uint8_t* data, size_t size, span<const uint8_t> key,
+                              std::vector<uint8_t> pack) {
+    size_t audio_offset = 0;
+    if (!parse_index(data, size, key, audio_offset)) {
+        return false;
     }
 
+    // Moving the vector keeps its buffer, so data stays valid
+    m_lazy = std::make_unique<LazySource>();
+    m_lazy->pack = std::move(pack);
+    m_lazy->key.assign(key.begin(), key.end());
+    m_lazy->audio = data + audio_offset;
+
     m_loaded = true;
     return true;
 }
 
+span<const AudioSample> PhonemeData::decode_lazily(size_t index) const {
+    LazySource& lazy = *m_lazy;
+    std::vector<AudioSample>& samples = lazy.samples[index];
+
+    if (!lazy.ready[index].load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(lazy.mutex);
+        if (!lazy.ready[index].load(std::memory_order_relaxed)) {
+            // Corrupt phonemes stay empty, as if missing from the pack
+            span<const uint8_t> key(lazy.key.data(), lazy.key.size());
+            decode_phoneme(lazy.audio, m_phonemes[index], key, samples);
+            lazy.ready[index].store(true, std::memory_order_release);
+        }
+    }
+
+    return span<const AudioSample>(samples.data(), samples.size());
+}
+
+void PhonemeData::decode_all() {
+    if (!m_lazy) {
+        return;
+    }
+    for (size_t i = 0; i < m_phonemes.size(); ++i) {
+        if (m_phonemes[i].loaded) {
+            decode_lazily(i);
+        }
+    }
+}
+
 // =============================================================================
 // Load from Directory (Development Mode)
 // =============================================================================
@@ -268,6 +489,13 @@ span<const AudioSample> PhonemeData::get_phoneme(Phoneme phoneme) const {
     if (idx >= m_phonemes.size() || !m_phonemes[idx].loaded) {
         return {};
     }
+    if (m_lazy) {
+        return decode_lazily(idx);
+    }
+    if (m_phonemes[idx].borrowed) {
+        return span<const AudioSample>(m_phonemes[idx].borrowed,
+                                       m_phonemes[idx].duration_samples);
+    }
     const auto& samples = m_phonemes[idx].samples;
     return span<const AudioSample>(samples.data(), samples.size());
 }
@@ -321,15 +549,28 @@ size_t PhonemeData::memory_usage() const {
     for (const auto& entry : m_phonemes) {
         total += entry.samples.size() * sizeof(AudioSample);
     }
+    if (m_lazy) {
+        std::lock_guard<std::mutex> lock(m_lazy->mutex);
+        total += m_lazy->pack.size();
+        for (const auto& samples : m_lazy->samples) {
+            total += samples.size() * sizeof(AudioSample);
+        }
+    }
     return total;
 }
 
 void PhonemeData::clear() {
     for (auto& entry : m_phonemes) {
         entry.samples.clear();
+        entry.borrowed = nullptr;
         entry.duration_samples = 0;
+        entry.data_offset = 0;
+        entry.data_size = 0;
+        entry.packed_size = 0;
+        entry.compressed = false;
         entry.loaded = false;
     }
+    m_lazy.reset();
     m_loaded = false;
     m_sample_rate = SAMPLE_RATE;
     m_bits_per_sample = BITS_PER_SAMPLE;
@@ -340,12 +581,49 @@ void PhonemeData::clear() {
 // XOR Decryption
 // =============================================================================
 
-void PhonemeData::xor_decrypt(std::vector<uint8_t>& data,
-                               span<const uint8_t> key) {
-    if (key.empty()) return;
+void PhonemeData::xor_decrypt(uint8_t* dst, const uint8_t* src, size_t size,
+                               size_t position, span<const uint8_t> key) {
+    if (key.empty()) {
+        if (dst != src) {
+            std::memcpy(dst, src, size);
+        }
+        return;
+    }
 
-    for (size_t i = 0; i < data.size(); ++i) {
-        data[i] ^= key[i % key.size()];
+    // Repeat the key, starting at position, into a block a whole number of
+    // key lengths long; XORing whole blocks word by word then vectorizes
+    constexpr size_t MAX_BLOCK = 256;
+    size_t block_size = MAX_BLOCK - MAX_BLOCK % key.size();
+    if (block_size < sizeof(uint64_t) * 4) {
+        for (size_t i = 0; i < size; ++i) {
+            dst[i] = src[i] ^ key[(position + i) % key.size()];
+        }
+        return;
+    }
+
+    alignas(16) uint8_t keystream[MAX_BLOCK];
+    size_t start = position % key.size();
+    std::memcpy(keystream, key.data() + start, key.size() - start);
+    std::memcpy(keystream + key.size() - start, key.data(), start);
+    for (size_t filled = key.size(); filled < block_size; filled *= 2) {
+        std::memcpy(keystream + filled, keystream, std::min(filled, block_size - filled));
+    }
+
+    size_t done = 0;
+    while (done < size) {
+        size_t n = std::min(block_size, size - done);
+        size_t words = n / sizeof(uint64_t);
+        for (size_t w = 0; w < words; ++w) {
+            uint64_t a, k;
+            std::memcpy(&a, src + done + w * sizeof(uint64_t), sizeof(a));
+            std::memcpy(&k, keystream + w * sizeof(uint64_t), sizeof(k));
+            a ^= k;
+            std::memcpy(dst + done + w * sizeof(uint64_t), &a, sizeof(a));
+        }
+        for (size_t i = words * sizeof(uint64_t); i < n; ++i) {
+            dst[done + i] = src[done + i] ^ keystream[i];
+        }
+        done += n;
     }
 }
 
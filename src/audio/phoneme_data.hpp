@@ -9,6 +9,7 @@
 #include <array>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace laprdus {
 
@@ -20,7 +21,14 @@ namespace laprdus {
  * - Individual WAV files (development mode)
  * - Memory buffer (embedded resources)
  *
- * Optionally decrypts data using XOR key.
+ * Optionally decrypts data using XOR key and verifies the pack's CRC32.
+ * Packs with PACKED_FLAG_COMPRESSED store each phoneme losslessly
+ * compressed (see phoneme_codec.hpp).
+ *
+ * Packed data is decoded either at load time (default) or, in lazy mode,
+ * one phoneme at a time on first access. Lazy loading only validates the
+ * header and index, keeping the pack in memory until each phoneme is
+ * needed; get_phoneme() may then be called from several threads at once.
  */
 class PhonemeData {
 public:
@@ -52,6 +60,52 @@ public:
     bool load_from_memory(const uint8_t* data, size_t size,
                           span<const uint8_t> key = {});
 
+    /**
+     * Load from a memory buffer without copying it.
+     * Phonemes of an unencrypted, uncompressed pack are served straight
+     * from the buffer; other packs are decoded as by load_from_memory(),
+     * except that lazy mode decodes from the buffer instead of a copy.
+     * The buffer must stay valid and unchanged until clear() or the next
+     * load, and until this object is destroyed.
+     * @param data Pointer to packed data, owned by the caller.
+     * @param size Size of data.
+     * @param key Optional decryption key.
+     * @return true on success.
+     */
+    bool load_from_memory_nocopy(const uint8_t* data, size_t size,
+                                 span<const uint8_t> key = {});
+
+    /**
+     * Decode packed phonemes on first access instead of at load time.
+     * Applies to later load_from_file() and load_from_memory() calls.
+     * @param lazy true for lazy decoding.
+     */
+    void set_lazy(bool lazy) { m_lazy_enabled = lazy; }
+
+    /**
+     * Check if lazy decoding is enabled.
+     * @return true if enabled.
+     */
+    bool is_lazy() const { return m_lazy_enabled; }
+
+    /**
+     * Decode every phoneme not decoded yet (lazy mode only).
+     */
+    void decode_all();
+
+    /**
+     * Verify the header's CRC32 of the data section when loading a pack.
+     * Applies to later load_from_file() and load_from_memory() calls.
+     * @param verify true to reject packs whose checksum does not match.
+     */
+    void set_verify_checksum(bool verify) { m_verify_checksum = verify; }
+
+    /**
+     * Check if checksum verification is enabled.
+     * @return true if enabled.
+     */
+    bool verifies_checksum() const { return m_verify_checksum; }
+
     /**
      * Load from directory of individual WAV files.
      * @param dir_path Path to directory containing PHONEME_*.wav files.
@@ -89,7 +143,8 @@ public:
 
     /**
      * Get total memory usage.
-     * @return Bytes used.
+     * @return Bytes used, including a pack kept for lazy decoding but not
+     *         a buffer borrowed by load_from_memory_nocopy().
      */
     size_t memory_usage() const;
 
@@ -105,25 +160,49 @@ public:
 
 private:
     struct PhonemeEntry {
-        std::vector<AudioSample> samples;
+        std::vector<AudioSample> samples;  // Empty until decoded in lazy mode
+        const AudioSample* borrowed = nullptr;  // Samples in a caller's buffer
         uint32_t duration_samples = 0;
-        bool loaded = false;
+        uint32_t data_offset = 0;          // Packed audio within the data section
+        uint32_t data_size = 0;            // Decoded size in bytes
+        uint32_t packed_size = 0;          // Stored size in bytes
+        bool compressed = false;           // Stored by compress_phoneme()
+        bool loaded = false;               // Present (decoded or decodable)
     };
 
+    // Pack and decoded slots for lazy mode
+    struct LazySource;
+
     std::array<PhonemeEntry, static_cast<size_t>(Phoneme::COUNT)> m_phonemes;
+    std::unique_ptr<LazySource> m_lazy;
     uint32_t m_sample_rate = SAMPLE_RATE;
     uint16_t m_bits_per_sample = BITS_PER_SAMPLE;
     uint16_t m_channels = NUM_CHANNELS;
     bool m_loaded = false;
+    bool m_lazy_enabled = false;
+    bool m_verify_checksum = false;
 
     // Internal loading functions
     bool parse_packed_data(const uint8_t* data, size_t size,
                            span<const uint8_t> key);
+    bool parse_index(const uint8_t* data, size_t size,
+                     span<const uint8_t> key, size_t& audio_offset);
+    // data points into pack, or into a borrowed buffer if pack is empty
+    bool load_lazily(const uint8_t* data, size_t size, span<const uint8_t> key,
+                     std::vector<uint8_t> pack = {});
+    span<const AudioSample> decode_lazily(size_t index) const;
     bool load_wav_file(const std::string& path, Phoneme phoneme);
 
-    // XOR decryption
-    void xor_decrypt(std::vector<uint8_t>& data,
-                     span<const uint8_t> key);
+    // Copy one phoneme out of the data section, decrypting if keyed and
+    // decompressing if compressed. Returns false on corrupt data.
+    static bool decode_phoneme(const uint8_t* audio, const PhonemeEntry& entry,
+                               span<const uint8_t> key,
+                               std::vector<AudioSample>& samples);
+
+    // Copy size bytes from src to dst (which may be equal), XOR decrypting
+    // if keyed; position is the offset of src within the data section
+    static void xor_decrypt(uint8_t* dst, const uint8_t* src, size_t size,
+                            size_t position, span<const uint8_t> key);
 };
 
 } // namespace laprdus
@@ -0,0 +1,239 @@
+// -*- coding: utf-8 -*-
+// resampler.cpp - Streaming polyphase sample rate converter implementation
+
+#include "resampler.hpp"
+#include "dsp_kernels.hpp"
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <numeric>
+
+namespace laprdus {
+
+// =============================================================================
+// Filter Design
+// =============================================================================
+
+struct Resampler::FilterBank {
+    uint32_t up = 1;               // Output phases per input sample
+    uint32_t down = 1;             // Input step per output phase
+    size_t taps = 0;               // Kernel length per phase (a multiple of 4)
+    std::vector<float> coeffs;     // up kernels of taps coefficients
+};
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+constexpr double ZERO_CROSSINGS = 32.0;  // Per side at the cutoff frequency
+constexpr double CUTOFF = 0.92;          // Passband edge, fraction of the lower Nyquist
+constexpr double KAISER_BETA = 8.0;      // About 80 dB stopband attenuation
+
+// Zeroth-order modified Bessel function of the first kind
+double bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    double half = x / 2.0;
+    for (int k = 1; k < 64; ++k) {
+        term *= (half / k) * (half / k);
+        sum += term;
+        if (term < sum * 1e-17) {
+            break;
+        }
+    }
+    return sum;
+}
+
+// Kernel value at distance x (in input samples) from the output time
+double kernel(double x, double cutoff, double half_width) {
+    double ratio = x / half_width;
+    if (std::abs(ratio) >= 1.0) {
+        return 0.0;
+    }
+    double sinc = x == 0.0 ? 1.0 : std::sin(PI * cutoff * x) / (PI * cutoff * x);
+    double window = bessel_i0(KAISER_BETA * std::sqrt(1.0 - ratio * ratio)) / bessel_i0(KAISER_BETA);
+    return cutoff * sinc * window;
+}
+
+} // anonymous namespace
+
+std::shared_ptr<const Resampler::FilterBank> Resampler::bank_for(uint32_t up, uint32_t down) {
+    static std::mutex mutex;
+    static std::vector<std::shared_ptr<const FilterBank>> banks;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& bank : banks) {
+        if (bank->up == up && bank->down == down) {
+            return bank;
+        }
+    }
+
+    // When reducing the rate the cutoff drops to the output Nyquist
+    // frequency, and the kernel widens to keep the same zero crossings
+    double scale = std::min(1.0, static_cast<double>(up) / down);
+    double cutoff = CUTOFF * scale;
+    size_t taps = static_cast<size_t>(std::ceil(2.0 * ZERO_CROSSINGS / scale));
+    taps = (taps + 3) & ~static_cast<size_t>(3);
+    double half_width = static_cast<double>(taps) / 2.0;
+
+    auto bank = std::make_shared<FilterBank>();
+    bank->up = up;
+    bank->down = down;
+    bank->taps = taps;
+    bank->coeffs.resize(static_cast<size_t>(up) * taps);
+
+    // Tap j of phase p weights input sample (first + j) for the output at
+    // first + (taps / 2 - 1) + p / up; each phase is normalized to unity gain
+    std::vector<double> phase(taps);
+    for (uint32_t p = 0; p < up; ++p) {
+        double offset = half_width - 1.0 + static_cast<double>(p) / up;
+        double sum = 0.0;
+        for (size_t j = 0; j < taps; ++j) {
+            phase[j] = kernel(static_cast<double>(j) - offset, cutoff, half_width);
+            sum += phase[j];
+        }
+        float* out = bank->coeffs.data() + static_cast<size_t>(p) * taps;
+        for (size_t j = 0; j < taps; ++j) {
+            out[j] = static_cast<float>(phase[j] / sum);
+        }
+    }
+
+    banks.push_back(bank);
+    return bank;
+}
+
+// =============================================================================
+// Constructor / Destructor
+// =============================================================================
+
+Resampler::Resampler() = default;
+Resampler::~Resampler() = default;
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+bool Resampler::configure(uint32_t input_rate, uint32_t output_rate) {
+    if (!is_output_rate(input_rate) || !is_output_rate(output_rate)) {
+        return false;
+    }
+
+    if (input_rate != m_input_rate || output_rate != m_output_rate) {
+        m_input_rate = input_rate;
+        m_output_rate = output_rate;
+        m_bank.reset();
+        if (input_rate != output_rate) {
+            uint32_t divisor = std::gcd(input_rate, output_rate);
+            m_bank = bank_for(output_rate / divisor, input_rate / divisor);
+        }
+    }
+
+    reset();
+    return true;
+}
+
+void Resampler::reset() {
+    m_next = 0;
+    m_phase = 0;
+    m_consumed = 0;
+    m_produced = 0;
+
+    // Zeros before the stream, so the first output is centered on input 0
+    m_input.assign(m_bank ? m_bank->taps / 2 - 1 : 0, 0.0f);
+}
+
+size_t Resampler::output_length(size_t input_samples) const {
+    if (!m_bank) {
+        return input_samples;
+    }
+    uint64_t scaled = static_cast<uint64_t>(input_samples) * m_bank->up;
+    return static_cast<size_t>((scaled + m_bank->down - 1) / m_bank->down);
+}
+
+size_t Resampler::taps() const {
+    return m_bank ? m_bank->taps : 0;
+}
+
+// =============================================================================
+// Conversion
+// =============================================================================
+
+void Resampler::process(const AudioSample* samples, size_t count, AudioSamples& out) {
+    if (!m_bank) {
+        out.insert(out.end(), samples, samples + count);
+        return;
+    }
+
+    size_t buffered = m_input.size();
+    m_input.resize(buffered + count);
+    dsp::to_float(samples, m_input.data() + buffered, count);
+    m_consumed += count;
+
+    run(out, std::numeric_limits<uint64_t>::max());
+}
+
+void Resampler::flush(AudioSamples& out) {
+    if (!m_bank) {
+        return;
+    }
+
+    // Zeros after the stream let the last outputs see a full kernel
+    m_input.resize(m_input.size() + m_bank->taps / 2, 0.0f);
+    run(out, output_length(static_cast<size_t>(m_consumed)));
+    reset();
+}
+
+void Resampler::convert(AudioBuffer& audio) {
+    audio.sample_rate = m_output_rate;
+    if (!m_bank) {
+        return;
+    }
+
+    // The two sample vectors trade places, so repeated calls reuse both
+    reset();
+    m_converted.clear();
+    m_converted.reserve(output_length(audio.samples.size()));
+    process(audio.samples.data(), audio.samples.size(), m_converted);
+    flush(m_converted);
+    audio.samples.swap(m_converted);
+}
+
+void Resampler::run(AudioSamples& out, uint64_t limit) {
+    const FilterBank& bank = *m_bank;
+    const size_t taps = bank.taps;
+    const float* input = m_input.data();
+
+    m_output.clear();
+    while (m_next + taps <= m_input.size() && m_produced < limit) {
+        const float* x = input + m_next;
+        const float* h = bank.coeffs.data() + static_cast<size_t>(m_phase) * taps;
+
+        // Four partial sums, so the loop is not bound by add latency
+        float acc0 = 0.0f;
+        float acc1 = 0.0f;
+        float acc2 = 0.0f;
+        float acc3 = 0.0f;
+        for (size_t j = 0; j < taps; j += 4) {
+            acc0 += x[j] * h[j];
+            acc1 += x[j + 1] * h[j + 1];
+            acc2 += x[j + 2] * h[j + 2];
+            acc3 += x[j + 3] * h[j + 3];
+        }
+        m_output.push_back((acc0 + acc1) + (acc2 + acc3));
+        ++m_produced;
+
+        m_phase += bank.down;
+        m_next += m_phase / bank.up;
+        m_phase %= bank.up;
+    }
+
+    // Drop input no later output can reach
+    size_t consumed = std::min(m_next, m_input.size());
+    m_input.erase(m_input.begin(), m_input.begin() + consumed);
+    m_next -= consumed;
+
+    size_t written = out.size();
+    out.resize(written + m_output.size());
+    dsp::quantize(m_output.data(), out.data() + written, m_output.size());
+}
+
+} // namespace laprdus
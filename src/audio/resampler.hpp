@@ -0,0 +1,117 @@
+// -*- coding: utf-8 -*-
+// resampler.hpp - Streaming polyphase sample rate converter
+
+#ifndef LAPRDUS_RESAMPLER_HPP
+#define LAPRDUS_RESAMPLER_HPP
+
+#include "laprdus/types.hpp"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace laprdus {
+
+/*
+ * Converts the synthesizer's native rate to one of OUTPUT_RATES with a
+ * polyphase FIR filter: the rate ratio is reduced to up / down, and each of
+ * the `up` output phases has its own Kaiser-windowed sinc kernel. Output
+ * sample n lies at input time n * down / up, so output stays aligned with
+ * the input at any block size.
+ *
+ * The filter banks are computed once per ratio and shared by all
+ * resamplers in the process. The kernels keep about 32 zero crossings of
+ * the cutoff, which passes speech up to about 92% of the lower Nyquist
+ * frequency and attenuates images and aliases by about 80 dB.
+ *
+ * Input is the engine's finished 16-bit output, not the synthesizer's float
+ * samples: a stream spans segments, the pauses between them and spelling
+ * pauses, and its filter state must carry across all of them so chunked
+ * output matches whole-buffer output and mark offsets stay exact. The
+ * synthesizer quantizes each segment on its own before pauses are added,
+ * so it has no float signal for the whole stream. The second rounding adds
+ * at most half a step of noise (about -101 dBFS RMS), below the stopband.
+ */
+class Resampler {
+public:
+    Resampler();
+    ~Resampler();
+
+    Resampler(const Resampler&) = delete;
+    Resampler& operator=(const Resampler&) = delete;
+
+    /**
+     * Select the conversion. Equal rates pass audio through unchanged.
+     * Resets the stream.
+     * @param input_rate Rate of the input samples.
+     * @param output_rate Rate to produce.
+     * @return false if either rate is not one of OUTPUT_RATES.
+     */
+    bool configure(uint32_t input_rate, uint32_t output_rate);
+
+    uint32_t input_rate() const { return m_input_rate; }
+    uint32_t output_rate() const { return m_output_rate; }
+
+    /**
+     * Check if samples are converted (rates differ).
+     */
+    bool active() const { return m_bank != nullptr; }
+
+    /**
+     * Start a new stream: forget buffered input and restart the phase.
+     */
+    void reset();
+
+    /**
+     * Convert the next block of a stream, appending to out. Output lags
+     * the input by half a kernel until flush().
+     * @param samples Input samples.
+     * @param count Number of input samples.
+     * @param out Receives the converted samples.
+     */
+    void process(const AudioSample* samples, size_t count, AudioSamples& out);
+
+    /**
+     * End the stream: append the remaining output, so the stream has
+     * produced exactly output_length() of its total input. Resets the stream.
+     */
+    void flush(AudioSamples& out);
+
+    /**
+     * Convert a complete buffer in place and set its sample rate.
+     * Resets the stream first.
+     */
+    void convert(AudioBuffer& audio);
+
+    /**
+     * Number of samples a stream of input_samples converts to:
+     * ceil(input_samples * output_rate / input_rate).
+     */
+    size_t output_length(size_t input_samples) const;
+
+    /**
+     * Number of kernel taps per output sample (0 when inactive).
+     */
+    size_t taps() const;
+
+private:
+    struct FilterBank;
+
+    static std::shared_ptr<const FilterBank> bank_for(uint32_t up, uint32_t down);
+    void run(AudioSamples& out, uint64_t limit);
+
+    uint32_t m_input_rate = SAMPLE_RATE;
+    uint32_t m_output_rate = SAMPLE_RATE;
+    std::shared_ptr<const FilterBank> m_bank;
+
+    std::vector<float> m_input;   // Buffered input, from the first tap of the next output
+    std::vector<float> m_output;  // Converted block before quantization
+    AudioSamples m_converted;     // Result of convert(), swapped with the buffer
+    size_t m_next = 0;            // Index in m_input of the next output's first tap
+    uint32_t m_phase = 0;         // Phase of the next output (0 .. up - 1)
+    uint64_t m_consumed = 0;      // Input samples since reset()
+    uint64_t m_produced = 0;      // Output samples since reset()
+};
+
+} // namespace laprdus
+
+#endif // LAPRDUS_RESAMPLER_HPP
@@ -217,6 +217,9 @@ struct sonicStreamStruct {
   float timeError;
   int oldRatePosition;
   int newRatePosition;
+  /* Set once the resampler has run since the last flush or reset.  From then
+     on it also runs at rate 1, so its delay and position are kept. */
+  int resampling;
   int quality;
   int numChannels;
   int inputBufferSize;
@@ -275,6 +278,85 @@ static void scaleSamples(short* samples, int numSamples, float volume) {
   }
 }
 
+/* Find the input and output sample rates the resampler uses for a rate,
+   scaled down to help with the integer math. */
+static void getResampleRates(sonicStream stream, float rate,
+                             int* oldSampleRate, int* newSampleRate) {
+  int newRate = stream->sampleRate / rate;
+  int oldRate = stream->sampleRate;
+
+  while (newRate > (1 << 14) || oldRate > (1 << 14)) {
+    newRate >>= 1;
+    oldRate >>= 1;
+  }
+  *oldSampleRate = oldRate;
+  *newSampleRate = newRate;
+}
+
+/* Carry the resampler position over from one rate to another.  The position
+   only matters as the distance from the last input sample to the next output
+   sample, newRatePosition * oldSampleRate - oldRatePosition * newSampleRate
+   (in 1/newSampleRate input samples).  Rescale it to the new rates and find
+   positions that give the same distance, rounded to their GCD. */
+static void rescaleRatePosition(sonicStream stream, float oldRate,
+                                float newRate) {
+  int oldFrom, newFrom, oldTo, newTo;
+  long long phase, a, b, x, y, lastX, lastY, quotient, temp, step, m;
+
+  if (oldRate == newRate) {
+    return;
+  }
+  if (!stream->resampling) {
+    /* Nothing has been resampled yet, so there is no position to keep */
+    stream->oldRatePosition = 0;
+    stream->newRatePosition = 0;
+    return;
+  }
+  /* A resampling stream keeps resampling at rate 1 (see processStreamInput),
+     where both resampler rates are equal and the position is rescaled like
+     any other */
+  getResampleRates(stream, oldRate, &oldFrom, &newFrom);
+  getResampleRates(stream, newRate, &oldTo, &newTo);
+  phase = (long long)stream->newRatePosition * oldFrom -
+          (long long)stream->oldRatePosition * newFrom;
+  if (phase < 0 || newFrom <= 0 || oldTo <= 0 || newTo <= 0) {
+    stream->oldRatePosition = 0;
+    stream->newRatePosition = 0;
+    return;
+  }
+  phase = (phase * newTo + newFrom / 2) / newFrom;
+
+  /* Extended Euclid: oldTo * lastX + newTo * lastY == a == gcd */
+  a = oldTo;
+  b = newTo;
+  x = 0;
+  y = 1;
+  lastX = 1;
+  lastY = 0;
+  while (b != 0) {
+    quotient = a / b;
+    temp = a - quotient * b;
+    a = b;
+    b = temp;
+    temp = lastX - quotient * x;
+    lastX = x;
+    x = temp;
+    temp = lastY - quotient * y;
+    lastY = y;
+    y = temp;
+  }
+  phase = (phase + a / 2) / a;
+
+  /* newRatePosition * oldTo - oldRatePosition * newTo == phase * gcd */
+  step = oldTo / a;
+  m = (-lastY * phase) % step;
+  if (m < 0) {
+    m += step;
+  }
+  stream->oldRatePosition = (int)m;
+  stream->newRatePosition = (int)((phase * a + m * newTo) / oldTo);
+}
+
 /* Get the speed of the stream. */
 float sonicGetSpeed(sonicStream stream) { return stream->speed; }
 
@@ -286,9 +368,17 @@ void sonicSetSpeed(sonicStream stream, float speed) {
 /* Get the pitch of the stream. */
 float sonicGetPitch(sonicStream stream) { return stream->pitch; }
 
-/* Set the pitch of the stream. */
+/* Set the pitch of the stream.  The resampler's fractional position is
+   carried over to the new rate, so the pitch can change while audio is
+   streaming without a discontinuity. */
 void sonicSetPitch(sonicStream stream, float pitch) {
-  stream->pitch = CLAMP(pitch, SONIC_MIN_PITCH_SETTING, SONIC_MAX_PITCH_SETTING);
+  float oldRate = stream->rate * stream->pitch;
+
+  pitch = CLAMP(pitch, SONIC_MIN_PITCH_SETTING, SONIC_MAX_PITCH_SETTING);
+  if (pitch != stream->pitch) {
+    stream->pitch = pitch;
+    rescaleRatePosition(stream, oldRate, stream->rate * pitch);
+  }
 }
 
 /* Get the rate of the stream. */
@@ -407,6 +497,7 @@ static int allocateStreamBuffers(sonicStream stream, int sampleRate,
   stream->numChannels = numChannels;
   stream->oldRatePosition = 0;
   stream->newRatePosition = 0;
+  stream->resampling = 0;
   stream->minPeriod = minPeriod;
   stream->maxPeriod = maxPeriod;
   stream->maxRequired = maxRequired;
@@ -714,9 +805,25 @@ int sonicFlushStream(sonicStream stream) {
   stream->inputPlayTime = 0.0f;
   stream->timeError = 0.0f;
   stream->numPitchSamples = 0;
+  stream->resampling = 0;
   return 1;
 }
 
+/* Discard buffered samples and history, keeping buffers and settings. */
+void sonicResetStream(sonicStream stream) {
+  stream->numInputSamples = 0;
+  stream->numOutputSamples = 0;
+  stream->numPitchSamples = 0;
+  stream->remainingInputToCopy = 0;
+  stream->inputPlayTime = 0.0f;
+  stream->timeError = 0.0f;
+  stream->oldRatePosition = 0;
+  stream->newRatePosition = 0;
+  stream->resampling = 0;
+  stream->prevPeriod = 0;
+  stream->prevMinDiff = 0;
+}
+
 /* Return the number of samples in the output buffer */
 int sonicSamplesAvailable(sonicStream stream) {
   return stream->numOutputSamples;
@@ -971,19 +1078,14 @@ static short interpolate(sonicStream stream, short* in, int oldSampleRate,
 /* Change the rate.  Interpolate with a sinc FIR filter using a Hann window. */
 static int adjustRate(sonicStream stream, float rate,
                       int originalNumOutputSamples) {
-  int newSampleRate = stream->sampleRate / rate;
-  int oldSampleRate = stream->sampleRate;
+  int newSampleRate, oldSampleRate;
   int numChannels = stream->numChannels;
   int position;
   short *in, *out;
   int i;
   int N = SINC_FILTER_POINTS;
 
-  /* Set these values to help with the integer math */
-  while (newSampleRate > (1 << 14) || oldSampleRate > (1 << 14)) {
-    newSampleRate >>= 1;
-    oldSampleRate >>= 1;
-  }
+  getResampleRates(stream, rate, &oldSampleRate, &newSampleRate);
   if (stream->numOutputSamples == originalNumOutputSamples) {
     return 1;
   }
@@ -1162,7 +1264,11 @@ static int processStreamInput(sonicStream stream) {
       return 0;
     }
   }
-  if (rate != 1.0f) {
+  /* Rate 1 skips the resampler, unless it is already running: dropping out
+     of it would lose the samples it holds and its delay, and make the
+     output jump */
+  if (rate != 1.0f || stream->resampling) {
+    stream->resampling = 1;
     if (!adjustRate(stream, rate, originalNumOutputSamples)) {
       return 0;
     }
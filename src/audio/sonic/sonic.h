@@ -81,6 +81,7 @@ extern "C" {
 #define sonicReadShortFromStream sonicIntReadShortFromStream
 #define sonicReadUnsignedCharFromStream sonicIntReadUnsignedCharFromStream
 #define sonicFlushStream sonicIntFlushStream
+#define sonicResetStream sonicIntResetStream
 #define sonicSamplesAvailable sonicIntSamplesAvailable
 #define sonicGetSpeed sonicIntGetSpeed
 #define sonicSetSpeed sonicIntSetSpeed
@@ -176,6 +177,10 @@ int sonicReadUnsignedCharFromStream(sonicStream stream, unsigned char* samples,
    has.  No extra delay will be added to the output, but flushing in the middle
    of words could introduce distortion. */
 int sonicFlushStream(sonicStream stream);
+/* Discard all buffered samples and analysis history so the stream behaves
+   like a newly created one, keeping its buffers and settings.  This lets a
+   caller reuse a stream for unrelated audio without reallocating. */
+void sonicResetStream(sonicStream stream);
 /* Return the number of samples in the output buffer */
 int sonicSamplesAvailable(sonicStream stream);
 /* Get the speed of the stream. */
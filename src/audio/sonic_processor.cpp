@@ -3,6 +3,7 @@
 
 #include "sonic_processor.hpp"
 #include "sonic/sonic.h"
+#include "../core/trace.hpp"
 #include <algorithm>
 #include <cmath>
 
@@ -11,63 +12,11 @@ namespace sonic {
 
 namespace {
 
-// Process audio through Sonic stream with given speed and pitch
+// Process audio through a one-off Sonic stream with given speed and pitch
 AudioBuffer process_with_sonic(const AudioBuffer& input, float speed, float pitch) {
-    if (input.empty()) {
-        return input;
-    }
-
-    // Create Sonic stream
-    sonicStream stream = sonicCreateStream(
-        static_cast<int>(input.sample_rate),
-        static_cast<int>(input.channels)
-    );
-
-    if (!stream) {
-        // Memory allocation failed, return original
-        return input;
-    }
-
-    // Configure processing parameters
-    sonicSetSpeed(stream, speed);
-    sonicSetPitch(stream, pitch);
-
-    // Write input samples
-    int write_result = sonicWriteShortToStream(
-        stream,
-        input.samples.data(),
-        static_cast<int>(input.samples.size())
-    );
-
-    if (write_result == 0) {
-        // Memory allocation failed
-        sonicDestroyStream(stream);
-        return input;
-    }
-
-    // Flush to ensure all output is generated
-    sonicFlushStream(stream);
-
-    // Read output samples
-    int available = sonicSamplesAvailable(stream);
-
+    Processor processor;
     AudioBuffer output;
-    output.sample_rate = input.sample_rate;
-    output.bits_per_sample = input.bits_per_sample;
-    output.channels = input.channels;
-
-    if (available > 0) {
-        output.samples.resize(static_cast<size_t>(available));
-        int read_count = sonicReadShortFromStream(
-            stream,
-            output.samples.data(),
-            available
-        );
-        output.samples.resize(static_cast<size_t>(read_count));
-    }
-
-    sonicDestroyStream(stream);
-
+    processor.process(input, speed, pitch, output);
     return output;
 }
 
@@ -112,61 +61,198 @@ AudioBuffer process(const AudioBuffer& input, float speed, float pitch) {
     return process_with_sonic(input, speed, pitch);
 }
 
-AudioBuffer apply_pitch_envelope(const AudioBuffer& input,
-                                  const std::vector<float>& envelope) {
-    if (input.empty() || envelope.empty()) {
-        return input;
+// =============================================================================
+// Stream
+// =============================================================================
+
+Stream::~Stream() {
+    release();
+}
+
+sonicStreamStruct* Stream::acquire(uint32_t sample_rate, uint16_t channels) {
+    if (m_stream && m_sample_rate == sample_rate && m_channels == channels) {
+        sonicResetStream(m_stream);
+        return m_stream;
+    }
+
+    release();
+    m_stream = sonicCreateStream(static_cast<int>(sample_rate), static_cast<int>(channels));
+    m_sample_rate = sample_rate;
+    m_channels = channels;
+    return m_stream;
+}
+
+void Stream::drain(AudioSamples& out) {
+    int available = sonicSamplesAvailable(m_stream);
+    if (available <= 0) {
+        return;
     }
 
-    // Process in chunks, each with its own pitch factor
-    // Chunk size: ~23ms at 22050Hz (512 samples)
-    constexpr size_t CHUNK_SIZE = 512;
+    size_t offset = out.size();
+    out.resize(offset + static_cast<size_t>(available));
+    int read_count = sonicReadShortFromStream(m_stream, out.data() + offset, available);
+    out.resize(offset + static_cast<size_t>(std::max(read_count, 0)));
+}
+
+void Stream::release() {
+    if (m_stream) {
+        sonicDestroyStream(m_stream);
+        m_stream = nullptr;
+    }
+}
+
+// =============================================================================
+// Processor
+// =============================================================================
+
+void Processor::process(const AudioBuffer& input, float speed, float pitch,
+                        AudioBuffer& output) {
+    trace::Scope trace_scope("sonic", "process");
+    trace_scope.set_arg("samples", static_cast<int64_t>(input.samples.size()));
+
+    output.sample_rate = input.sample_rate;
+    output.bits_per_sample = input.bits_per_sample;
+    output.channels = input.channels;
 
+    if (input.empty()) {
+        output.samples.clear();
+        return;
+    }
+
+    sonicStreamStruct* stream = m_stream.acquire(input.sample_rate, input.channels);
+    if (!stream) {
+        // Memory allocation failed, return original
+        output.samples = input.samples;
+        return;
+    }
+
+    // Configure processing parameters
+    sonicSetSpeed(stream, speed);
+    sonicSetPitch(stream, pitch);
+
+    // Write input samples
+    if (!sonicWriteShortToStream(stream, input.samples.data(),
+                                 static_cast<int>(input.samples.size()))) {
+        // Memory allocation failed
+        m_stream.release();
+        output.samples = input.samples;
+        return;
+    }
+
+    // Flush to ensure all output is generated
+    sonicFlushStream(stream);
+
+    output.samples.clear();
+    m_stream.drain(output.samples);
+}
+
+// =============================================================================
+// PitchEnvelopeProcessor
+// =============================================================================
+
+AudioBuffer PitchEnvelopeProcessor::process(const AudioBuffer& input,
+                                            const std::vector<float>& envelope) {
     AudioBuffer output;
+    process(input, envelope, output);
+    return output;
+}
+
+void PitchEnvelopeProcessor::process(const AudioBuffer& input,
+                                     const std::vector<float>& envelope,
+                                     AudioBuffer& output) {
     output.sample_rate = input.sample_rate;
     output.bits_per_sample = input.bits_per_sample;
     output.channels = input.channels;
-    output.samples.reserve(input.samples.size());
-
-    size_t num_samples = input.samples.size();
-    size_t chunk_count = (num_samples + CHUNK_SIZE - 1) / CHUNK_SIZE;
-
-    for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
-        size_t start = chunk * CHUNK_SIZE;
-        size_t end = std::min(start + CHUNK_SIZE, num_samples);
-        size_t chunk_len = end - start;
-
-        // Get average pitch factor for this chunk (sample at midpoint)
-        size_t mid_sample = start + chunk_len / 2;
-        mid_sample = std::min(mid_sample, envelope.size() - 1);
-        float pitch_factor = envelope[mid_sample];
-
-        // Skip processing if pitch is essentially 1.0
-        if (std::abs(pitch_factor - 1.0f) < 0.01f) {
-            output.samples.insert(output.samples.end(),
-                                  input.samples.begin() + start,
-                                  input.samples.begin() + end);
-            continue;
+
+    if (input.empty() || envelope.empty()) {
+        output.samples = input.samples;
+        return;
+    }
+
+    trace::Scope trace_scope("sonic", "pitch_envelope");
+    trace_scope.set_arg("samples", static_cast<int64_t>(input.samples.size()));
+
+    // Pitch factor is updated once per block (~6ms at 22050Hz)
+    constexpr size_t BLOCK_SIZE = 128;
+
+    const size_t num_samples = input.samples.size();
+    auto pitch_at = [&](size_t i) {
+        return std::clamp(envelope[std::min(i, envelope.size() - 1)], 0.05f, 20.0f);
+    };
+
+    // Samples before the contour starts are passed through untouched
+    size_t onset = 0;
+    while (onset < num_samples && std::abs(pitch_at(onset) - 1.0f) < 0.001f) {
+        ++onset;
+    }
+    if (onset == num_samples) {
+        output.samples = input.samples;
+        return;
+    }
+    size_t first = onset - onset % BLOCK_SIZE;
+
+    // Sonic's 12-point sinc resampler centres its first output sample five
+    // samples into the input, so start feeding it that much earlier to keep
+    // the bypassed head and the processed tail aligned
+    constexpr size_t RESAMPLER_DELAY = 5;
+    size_t feed_start = first > RESAMPLER_DELAY ? first - RESAMPLER_DELAY : 0;
+
+    sonicStreamStruct* stream = m_stream.acquire(input.sample_rate, input.channels);
+    if (!stream) {
+        output.samples = input.samples;
+        return;
+    }
+
+    output.samples.reserve(num_samples + BLOCK_SIZE);
+    output.samples.assign(input.samples.begin(), input.samples.begin() + first);
+
+    sonicSetSpeed(stream, 1.0f);
+
+    for (size_t start = feed_start; start < num_samples; start += BLOCK_SIZE) {
+        size_t len = std::min(BLOCK_SIZE, num_samples - start);
+
+        // Sample the envelope at the block midpoint, but not before the
+        // onset: the first block must engage Sonic's resampler, which then
+        // keeps running (and keeps the delay compensated above) even where
+        // the contour returns to 1.0
+        float pitch = pitch_at(std::max(start + len / 2, onset));
+        sonicSetPitch(stream, pitch);
+
+        if (!sonicWriteShortToStream(stream, input.samples.data() + start,
+                                     static_cast<int>(len))) {
+            // Memory allocation failed; discard partial state
+            m_stream.release();
+            output.samples = input.samples;
+            return;
         }
+        m_stream.drain(output.samples);
+    }
 
-        // Create temporary buffer for this chunk
-        AudioBuffer chunk_buffer;
-        chunk_buffer.samples.assign(input.samples.begin() + start,
-                                    input.samples.begin() + end);
-        chunk_buffer.sample_rate = input.sample_rate;
-        chunk_buffer.bits_per_sample = input.bits_per_sample;
-        chunk_buffer.channels = input.channels;
-
-        // Apply pitch shift to chunk using Sonic
-        AudioBuffer shifted = change_pitch(chunk_buffer, pitch_factor);
-
-        // Append to result
-        output.samples.insert(output.samples.end(),
-                             shifted.samples.begin(),
-                             shifted.samples.end());
+    // Sonic holds back up to two pitch periods and trims its estimate on
+    // flush, so push silence through until the tail has been emitted, then
+    // cut the output back to the input duration
+    static const AudioSample silence[BLOCK_SIZE] = {};
+    constexpr size_t MAX_TAIL_BLOCKS = 32;
+    for (size_t i = 0; i < MAX_TAIL_BLOCKS && output.samples.size() < num_samples; ++i) {
+        if (!sonicWriteShortToStream(stream, silence, static_cast<int>(BLOCK_SIZE))) {
+            break;
+        }
+        m_stream.drain(output.samples);
     }
 
-    return output;
+    sonicFlushStream(stream);
+    m_stream.drain(output.samples);
+    output.samples.resize(num_samples, 0);
+}
+
+// =============================================================================
+// Apply Pitch Envelope
+// =============================================================================
+
+AudioBuffer apply_pitch_envelope(const AudioBuffer& input,
+                                  const std::vector<float>& envelope) {
+    PitchEnvelopeProcessor processor;
+    return processor.process(input, envelope);
 }
 
 } // namespace sonic
@@ -7,6 +7,8 @@
 
 #include "laprdus/types.hpp"
 
+struct sonicStreamStruct;
+
 namespace laprdus {
 namespace sonic {
 
@@ -42,9 +44,113 @@ AudioBuffer change_pitch(const AudioBuffer& input, float pitch);
  */
 AudioBuffer process(const AudioBuffer& input, float speed, float pitch);
 
+/**
+ * Stream - Owns a Sonic stream that is kept alive between calls.
+ *
+ * Sonic grows its internal buffers on demand and never shrinks them, so a
+ * reused stream stops allocating once it has seen the working size.
+ */
+class Stream {
+public:
+    Stream() = default;
+    ~Stream();
+
+    Stream(const Stream&) = delete;
+    Stream& operator=(const Stream&) = delete;
+
+    /**
+     * Get the stream in a freshly reset state for the given format.
+     * Created on first use and recreated only if the format changes.
+     * @param sample_rate Sample rate in Hz.
+     * @param channels Number of channels.
+     * @return Stream handle, or nullptr if allocation failed.
+     */
+    sonicStreamStruct* acquire(uint32_t sample_rate, uint16_t channels);
+
+    /**
+     * Move all available output samples from the stream into out.
+     * @param out Sample vector to append to.
+     */
+    void drain(AudioSamples& out);
+
+    /**
+     * Destroy the stream (after a failed write leaves it inconsistent).
+     */
+    void release();
+
+private:
+    sonicStreamStruct* m_stream = nullptr;
+    uint32_t m_sample_rate = 0;
+    uint16_t m_channels = 0;
+};
+
+/**
+ * Processor - Speed and pitch change through a reusable stream.
+ *
+ * Produces the same output as process(), but writes into a caller-owned
+ * buffer and keeps the Sonic stream between calls.
+ */
+class Processor {
+public:
+    Processor() = default;
+
+    Processor(const Processor&) = delete;
+    Processor& operator=(const Processor&) = delete;
+
+    /**
+     * Change speed and pitch.
+     * @param input Audio buffer to process.
+     * @param speed Speed factor (1.0 = normal).
+     * @param pitch Pitch factor (1.0 = normal).
+     * @param output Receives the processed audio (storage is reused).
+     */
+    void process(const AudioBuffer& input, float speed, float pitch, AudioBuffer& output);
+
+private:
+    Stream m_stream;
+};
+
+/**
+ * PitchEnvelopeProcessor - Applies a continuously varying pitch contour.
+ *
+ * Keeps a single Sonic stream alive and updates its pitch factor every
+ * few milliseconds while the audio is streamed through it, so the
+ * contour is applied in one pass without chunk boundaries or per-chunk
+ * stream setup. Leading samples whose pitch factor is 1.0 bypass Sonic.
+ *
+ * The stream is created lazily and reset, not recreated, between calls.
+ */
+class PitchEnvelopeProcessor {
+public:
+    PitchEnvelopeProcessor() = default;
+
+    PitchEnvelopeProcessor(const PitchEnvelopeProcessor&) = delete;
+    PitchEnvelopeProcessor& operator=(const PitchEnvelopeProcessor&) = delete;
+
+    /**
+     * Apply pitch envelope to audio.
+     * @param input Audio buffer to process.
+     * @param envelope Pitch factor for each sample position.
+     * @return Processed audio with original duration preserved.
+     */
+    AudioBuffer process(const AudioBuffer& input, const std::vector<float>& envelope);
+
+    /**
+     * Apply pitch envelope to audio into a caller-owned buffer.
+     * @param input Audio buffer to process.
+     * @param envelope Pitch factor for each sample position.
+     * @param output Receives the processed audio (storage is reused).
+     */
+    void process(const AudioBuffer& input, const std::vector<float>& envelope,
+                 AudioBuffer& output);
+
+private:
+    Stream m_stream;
+};
+
 /**
  * Apply pitch envelope to audio using Sonic.
- * Processes audio in chunks with varying pitch factors.
+ * Streams the audio through a single PitchEnvelopeProcessor.
  *
  * @param input Audio buffer to process.
  * @param envelope Pitch factor for each sample position.
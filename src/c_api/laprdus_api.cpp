@@ -5,11 +5,17 @@
 #include "../core/tts_engine.hpp"
 #include "../core/voice_registry.hpp"
 #include "../core/user_config.hpp"
+#include "../core/trace.hpp"
+#include "../core/speech_queue.hpp"
+#include "../audio/embedded_voice.hpp"
+#include <atomic>
 #include <cstring>
 #include <new>
 #include <mutex>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 // =============================================================================
 // Internal Structures
@@ -21,11 +27,27 @@ struct LaprdusEngine {
     std::string current_voice_id;     // Currently active voice ID
     std::string data_directory;       // Directory containing voice .bin files
     float voice_base_pitch = 1.0f;    // Base pitch of current voice
+    LaprdusWarmupMode auto_warmup = LAPRDUS_WARMUP_NONE;  // After voice loads
     std::mutex mutex;  // For thread-safe error message access
 
+    // Serializes engine use between API callers and the speech queue worker.
+    // Recursive because API functions call each other (set_voice etc.).
+    std::recursive_mutex engine_mutex;
+
+    // Background warm-up running on the queue worker; a synthesis request
+    // stops it rather than waiting for it (see preempt_warmup)
+    std::mutex warmup_mutex;
+    bool warmup_running = false;
+    std::atomic<bool> warmup_stop{false};
+
+    // Declared last so its worker thread stops before the engine is destroyed
+    laprdus::SpeechQueue queue{engine, engine_mutex};
+
     LaprdusEngine() = default;
 };
 
+using EngineLock = std::lock_guard<std::recursive_mutex>;
+
 struct LaprdusStream {
     laprdus::AudioBuffer audio;
     size_t read_position = 0;
@@ -53,6 +75,80 @@ static void set_error(LaprdusEngine* engine, const std::string& msg) {
     }
 }
 
+// Sample vectors handed to callers without copying, keyed by their data
+// pointer until laprdus_free_buffer() releases them
+static std::mutex g_buffers_mutex;
+static std::unordered_map<const int16_t*, laprdus::AudioSamples> g_buffers;
+
+static int16_t* hand_over_samples(laprdus::AudioSamples&& samples) {
+    int16_t* data = samples.data();
+    std::lock_guard<std::mutex> lock(g_buffers_mutex);
+    g_buffers.emplace(data, std::move(samples));  // Moving keeps the data pointer
+    return data;
+}
+
+// Encoded byte vectors, kept the same way until laprdus_free_encoded()
+static std::unordered_map<const uint8_t*, std::vector<uint8_t>> g_encoded;
+
+static uint8_t* hand_over_bytes(std::vector<uint8_t>&& bytes) {
+    uint8_t* data = bytes.data();
+    std::lock_guard<std::mutex> lock(g_buffers_mutex);
+    g_encoded.emplace(data, std::move(bytes));
+    return data;
+}
+
+static bool is_encoding(LaprdusEncoding encoding) {
+    return encoding >= LAPRDUS_ENCODING_PCM16 && encoding <= LAPRDUS_ENCODING_IMA_ADPCM;
+}
+
+static void set_encoded_format(LaprdusEngine* handle, LaprdusEncoding encoding,
+                               LaprdusAudioFormat* out_format) {
+    if (out_format) {
+        out_format->sample_rate = handle->engine.output_rate();
+        out_format->bits_per_sample = laprdus::AudioEncoder::bits_per_sample(
+            static_cast<laprdus::OutputEncoding>(encoding));
+        out_format->channels = laprdus::NUM_CHANNELS;
+    }
+}
+
+// Automatic warm-up once voice data has been loaded (engine lock held)
+static void warm_up_loaded_voice(LaprdusEngine* handle) {
+    switch (handle->auto_warmup) {
+        case LAPRDUS_WARMUP_BLOCKING:
+            handle->engine.warmup();
+            break;
+        case LAPRDUS_WARMUP_BACKGROUND:
+            try {
+                handle->queue.post([handle] {
+                    {
+                        std::lock_guard<std::mutex> lock(handle->warmup_mutex);
+                        handle->warmup_running = true;
+                        handle->warmup_stop = false;
+                    }
+                    handle->engine.warmup(&handle->warmup_stop);
+                    std::lock_guard<std::mutex> lock(handle->warmup_mutex);
+                    handle->warmup_running = false;
+                });
+            } catch (...) {
+                // Warm-up is optional; the voice is loaded either way
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Stop a background warm-up so a synthesis request does not wait behind it
+// (called before taking the engine lock). The warm-up holds the engine lock
+// while it runs, so cancel() cannot reach any other call.
+static void preempt_warmup(LaprdusEngine* handle) {
+    std::lock_guard<std::mutex> lock(handle->warmup_mutex);
+    if (handle->warmup_running) {
+        handle->warmup_stop = true;
+        handle->engine.cancel();
+    }
+}
+
 // =============================================================================
 // Lifecycle Functions
 // =============================================================================
@@ -85,6 +181,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_init_from_file(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     if (!phoneme_data_path) {
         set_error(handle, "Phoneme data path is NULL");
         return LAPRDUS_ERROR_INVALID_PATH;
@@ -100,6 +198,7 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_init_from_file(
         return LAPRDUS_ERROR_LOAD_FAILED;
     }
 
+    warm_up_loaded_voice(handle);
     return LAPRDUS_OK;
 }
 
@@ -114,6 +213,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_init_from_memory(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     if (!data || data_size == 0) {
         set_error(handle, "Invalid data pointer or size");
         return LAPRDUS_ERROR_INVALID_PARAMETER;
@@ -129,6 +230,39 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_init_from_memory(
         return LAPRDUS_ERROR_LOAD_FAILED;
     }
 
+    warm_up_loaded_voice(handle);
+    return LAPRDUS_OK;
+}
+
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_init_from_memory_nocopy(
+    LaprdusHandle handle,
+    const uint8_t* data,
+    size_t data_size,
+    const uint8_t* decryption_key,
+    size_t key_size) {
+
+    if (!handle) {
+        return LAPRDUS_ERROR_INVALID_HANDLE;
+    }
+
+    EngineLock lock(handle->engine_mutex);
+
+    if (!data || data_size == 0) {
+        set_error(handle, "Invalid data pointer or size");
+        return LAPRDUS_ERROR_INVALID_PARAMETER;
+    }
+
+    laprdus::span<const uint8_t> key;
+    if (decryption_key && key_size > 0) {
+        key = laprdus::span<const uint8_t>(decryption_key, key_size);
+    }
+
+    if (!handle->engine.initialize_from_memory_nocopy(data, data_size, key)) {
+        set_error(handle, "Failed to load phoneme data from memory");
+        return LAPRDUS_ERROR_LOAD_FAILED;
+    }
+
+    warm_up_loaded_voice(handle);
     return LAPRDUS_OK;
 }
 
@@ -140,6 +274,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_init_from_directory(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     if (!phoneme_dir) {
         set_error(handle, "Phoneme directory is NULL");
         return LAPRDUS_ERROR_INVALID_PATH;
@@ -150,6 +286,33 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_init_from_directory(
         return LAPRDUS_ERROR_LOAD_FAILED;
     }
 
+    warm_up_loaded_voice(handle);
+    return LAPRDUS_OK;
+}
+
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_lazy_loading(
+    LaprdusHandle handle,
+    int enabled) {
+
+    if (!handle) {
+        return LAPRDUS_ERROR_INVALID_HANDLE;
+    }
+
+    EngineLock lock(handle->engine_mutex);
+    handle->engine.set_lazy_loading(enabled != 0);
+    return LAPRDUS_OK;
+}
+
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_checksum_verification(
+    LaprdusHandle handle,
+    int enabled) {
+
+    if (!handle) {
+        return LAPRDUS_ERROR_INVALID_HANDLE;
+    }
+
+    EngineLock lock(handle->engine_mutex);
+    handle->engine.set_checksum_verification(enabled != 0);
     return LAPRDUS_OK;
 }
 
@@ -157,6 +320,8 @@ LAPRDUS_API int LAPRDUS_CALL laprdus_is_initialized(LaprdusHandle handle) {
     if (!handle) {
         return 0;
     }
+
+    EngineLock lock(handle->engine_mutex);
     return handle->engine.is_initialized() ? 1 : 0;
 }
 
@@ -172,6 +337,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_voice_params(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     if (!params) {
         set_error(handle, "Voice params is NULL");
         return LAPRDUS_ERROR_INVALID_PARAMETER;
@@ -181,6 +348,7 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_voice_params(
     vp.speed = params->speed;
     vp.pitch = params->pitch;
     vp.volume = params->volume;
+    vp.output_rate = handle->engine.output_rate();  // Not part of LaprdusVoiceParams
 
     handle->engine.set_voice_params(vp);
     return LAPRDUS_OK;
@@ -194,6 +362,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_get_voice_params(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     if (!out_params) {
         set_error(handle, "Output params is NULL");
         return LAPRDUS_ERROR_INVALID_PARAMETER;
@@ -215,6 +385,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_speed(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     laprdus::VoiceParams vp = handle->engine.voice_params();
     vp.speed = speed;
     handle->engine.set_voice_params(vp);
@@ -229,6 +401,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_pitch(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     // Apply effective pitch: voice base pitch * user pitch
     // This allows derived voices (child, grandma, grandpa) to have their
     // own base pitch while still allowing user adjustment
@@ -252,6 +426,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_user_pitch(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     // User pitch preference - formant-preserving pitch shift
     // This does NOT shift formants - voice character stays the same
     // Use this for user-controlled pitch adjustment (NVDA/SAPI5 slider)
@@ -271,6 +447,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_volume(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     laprdus::VoiceParams vp = handle->engine.voice_params();
     vp.volume = volume;
     handle->engine.set_voice_params(vp);
@@ -285,12 +463,40 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_inflection_enabled(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     laprdus::VoiceParams vp = handle->engine.voice_params();
     vp.inflection_enabled = (enabled != 0);
     handle->engine.set_voice_params(vp);
     return LAPRDUS_OK;
 }
 
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_output_rate(
+    LaprdusHandle handle,
+    uint32_t sample_rate) {
+
+    if (!handle) {
+        return LAPRDUS_ERROR_INVALID_HANDLE;
+    }
+
+    EngineLock lock(handle->engine_mutex);
+
+    if (!handle->engine.set_output_rate(sample_rate)) {
+        set_error(handle, "Unsupported output sample rate");
+        return LAPRDUS_ERROR_INVALID_PARAMETER;
+    }
+    return LAPRDUS_OK;
+}
+
+LAPRDUS_API uint32_t LAPRDUS_CALL laprdus_get_output_rate(LaprdusHandle handle) {
+    if (!handle) {
+        return 0;
+    }
+
+    EngineLock lock(handle->engine_mutex);
+    return handle->engine.output_rate();
+}
+
 // =============================================================================
 // Synthesis Functions
 // =============================================================================
@@ -305,6 +511,9 @@ LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize(
         return static_cast<int32_t>(LAPRDUS_ERROR_INVALID_HANDLE);
     }
 
+    preempt_warmup(handle);
+    EngineLock lock(handle->engine_mutex);
+
     if (!handle->engine.is_initialized()) {
         set_error(handle, "Engine not initialized");
         return static_cast<int32_t>(LAPRDUS_ERROR_NOT_INITIALIZED);
@@ -325,46 +534,35 @@ LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize(
 
     if (!result.success) {
         set_error(handle, result.error_message);
-        return static_cast<int32_t>(LAPRDUS_ERROR_SYNTHESIS_FAILED);
+        return static_cast<int32_t>(result.cancelled ? LAPRDUS_ERROR_CANCELLED
+                                                     : LAPRDUS_ERROR_SYNTHESIS_FAILED);
     }
 
-    // Allocate output buffer
     size_t num_samples = result.audio.samples.size();
     if (num_samples == 0) {
         *out_samples = nullptr;
         if (out_format) {
-            out_format->sample_rate = laprdus::SAMPLE_RATE;
+            out_format->sample_rate = handle->engine.output_rate();
             out_format->bits_per_sample = laprdus::BITS_PER_SAMPLE;
             out_format->channels = laprdus::NUM_CHANNELS;
         }
         return 0;
     }
 
-    // Check for integer overflow in size calculation
-    if (num_samples > SIZE_MAX / sizeof(int16_t)) {
-        set_error(handle, "Audio data too large");
-        return static_cast<int32_t>(LAPRDUS_ERROR_OUT_OF_MEMORY);
-    }
-
-    int16_t* buffer = static_cast<int16_t*>(
-        malloc(num_samples * sizeof(int16_t)));
-
-    if (!buffer) {
-        set_error(handle, "Out of memory");
-        return static_cast<int32_t>(LAPRDUS_ERROR_OUT_OF_MEMORY);
-    }
-
-    // Copy samples
-    memcpy(buffer, result.audio.samples.data(), num_samples * sizeof(int16_t));
-
-    *out_samples = buffer;
-
     if (out_format) {
         out_format->sample_rate = result.audio.sample_rate;
         out_format->bits_per_sample = result.audio.bits_per_sample;
         out_format->channels = result.audio.channels;
     }
 
+    // Hand the engine's sample vector to the caller instead of copying it
+    try {
+        *out_samples = hand_over_samples(std::move(result.audio.samples));
+    } catch (const std::bad_alloc&) {
+        set_error(handle, "Out of memory");
+        return static_cast<int32_t>(LAPRDUS_ERROR_OUT_OF_MEMORY);
+    }
+
     return static_cast<int32_t>(num_samples);
 }
 
@@ -379,6 +577,9 @@ LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize_to_buffer(
         return static_cast<int32_t>(LAPRDUS_ERROR_INVALID_HANDLE);
     }
 
+    preempt_warmup(handle);
+    EngineLock lock(handle->engine_mutex);
+
     if (!handle->engine.is_initialized()) {
         set_error(handle, "Engine not initialized");
         return static_cast<int32_t>(LAPRDUS_ERROR_NOT_INITIALIZED);
@@ -389,12 +590,21 @@ LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize_to_buffer(
         return static_cast<int32_t>(LAPRDUS_ERROR_INVALID_PARAMETER);
     }
 
-    // Synthesize
-    laprdus::SynthesisResult result = handle->engine.synthesize(text);
+    // Segments are written straight into the caller's buffer while they
+    // fit; past the end only the required size is counted
+    size_t num_samples = 0;
+    laprdus::SynthesisResult result = handle->engine.synthesize_to_sink(text,
+        [&](const int16_t* samples, size_t count) {
+            if (buffer && num_samples + count <= buffer_size) {
+                memcpy(buffer + num_samples, samples, count * sizeof(int16_t));
+            }
+            num_samples += count;
+        });
 
     if (!result.success) {
         set_error(handle, result.error_message);
-        return static_cast<int32_t>(LAPRDUS_ERROR_SYNTHESIS_FAILED);
+        return static_cast<int32_t>(result.cancelled ? LAPRDUS_ERROR_CANCELLED
+                                                     : LAPRDUS_ERROR_SYNTHESIS_FAILED);
     }
 
     // Set format info
@@ -404,37 +614,516 @@ LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize_to_buffer(
         out_format->channels = result.audio.channels;
     }
 
-    size_t num_samples = result.audio.samples.size();
+    // Required size when buffer is NULL or too small, else samples written
+    return static_cast<int32_t>(num_samples);
+}
 
-    // If buffer is NULL, just return required size
-    if (!buffer) {
-        return static_cast<int32_t>(num_samples);
+LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize_to_sink(
+    LaprdusHandle handle,
+    const char* text,
+    LaprdusWriteCallback write,
+    void* user_data,
+    LaprdusAudioFormat* out_format) {
+
+    return laprdus_synthesize_to_sink_with_marks(handle, text, write, nullptr,
+                                                 user_data, out_format);
+}
+
+LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize_to_sink_with_marks(
+    LaprdusHandle handle,
+    const char* text,
+    LaprdusWriteCallback write,
+    LaprdusMarkCallback mark,
+    void* user_data,
+    LaprdusAudioFormat* out_format) {
+
+    if (!handle) {
+        return static_cast<int32_t>(LAPRDUS_ERROR_INVALID_HANDLE);
     }
 
-    // Check if buffer is large enough
-    if (buffer_size < num_samples) {
-        // Return required size (positive) to indicate buffer too small
-        return static_cast<int32_t>(num_samples);
+    preempt_warmup(handle);
+    EngineLock lock(handle->engine_mutex);
+
+    if (!handle->engine.is_initialized()) {
+        set_error(handle, "Engine not initialized");
+        return static_cast<int32_t>(LAPRDUS_ERROR_NOT_INITIALIZED);
+    }
+
+    if (!text || !write) {
+        set_error(handle, "Text or write callback is NULL");
+        return static_cast<int32_t>(LAPRDUS_ERROR_INVALID_PARAMETER);
+    }
+
+    if (out_format) {
+        out_format->sample_rate = handle->engine.output_rate();
+        out_format->bits_per_sample = laprdus::BITS_PER_SAMPLE;
+        out_format->channels = laprdus::NUM_CHANNELS;
+    }
+
+    size_t num_samples = 0;
+    bool stopped = false;
+    laprdus::TTSEngine& engine = handle->engine;
+
+    laprdus::TTSEngine::MarkSink on_mark;
+    if (mark) {
+        on_mark = [&](const laprdus::MarkEvent& event) {
+            if (!stopped && !mark(event.name.c_str(), event.sample_offset, user_data)) {
+                stopped = true;
+                engine.cancel();
+            }
+        };
+    }
+
+    laprdus::SynthesisResult result = engine.synthesize_to_sink(text,
+        [&](const int16_t* samples, size_t count) {
+            if (stopped) {
+                return;
+            }
+            num_samples += count;
+            if (!write(samples, count, user_data)) {
+                stopped = true;
+                engine.cancel();
+            }
+        }, on_mark);
+
+    if (!result.success) {
+        set_error(handle, result.error_message);
+        return static_cast<int32_t>(result.cancelled ? LAPRDUS_ERROR_CANCELLED
+                                                     : LAPRDUS_ERROR_SYNTHESIS_FAILED);
+    }
+
+    return static_cast<int32_t>(num_samples);
+}
+
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_ssml_enabled(
+    LaprdusHandle handle,
+    int enabled) {
+
+    if (!handle) {
+        return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
-    // Copy samples to buffer
-    if (num_samples > 0) {
-        memcpy(buffer, result.audio.samples.data(), num_samples * sizeof(int16_t));
+    EngineLock lock(handle->engine_mutex);
+    handle->engine.set_ssml_enabled(enabled != 0);
+    return LAPRDUS_OK;
+}
+
+LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize_encoded_to_sink(
+    LaprdusHandle handle,
+    const char* text,
+    LaprdusEncoding encoding,
+    LaprdusByteWriteCallback write,
+    void* user_data,
+    LaprdusAudioFormat* out_format) {
+
+    if (!handle) {
+        return static_cast<int32_t>(LAPRDUS_ERROR_INVALID_HANDLE);
+    }
+
+    preempt_warmup(handle);
+    EngineLock lock(handle->engine_mutex);
+
+    if (!handle->engine.is_initialized()) {
+        set_error(handle, "Engine not initialized");
+        return static_cast<int32_t>(LAPRDUS_ERROR_NOT_INITIALIZED);
+    }
+
+    if (!text || !write || !is_encoding(encoding)) {
+        set_error(handle, "Text or write callback is NULL, or unknown encoding");
+        return static_cast<int32_t>(LAPRDUS_ERROR_INVALID_PARAMETER);
+    }
+
+    set_encoded_format(handle, encoding, out_format);
+
+    uint64_t num_samples = 0;
+    laprdus::TTSEngine& engine = handle->engine;
+    laprdus::SynthesisResult result = engine.synthesize_encoded(text,
+        static_cast<laprdus::OutputEncoding>(encoding),
+        [&](const uint8_t* data, size_t size) {
+            if (!write(data, size, user_data)) {
+                engine.cancel();
+            }
+        },
+        &num_samples);
+
+    if (!result.success) {
+        set_error(handle, result.error_message);
+        return static_cast<int32_t>(result.cancelled ? LAPRDUS_ERROR_CANCELLED
+                                                     : LAPRDUS_ERROR_SYNTHESIS_FAILED);
     }
 
     return static_cast<int32_t>(num_samples);
 }
 
+LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize_encoded(
+    LaprdusHandle handle,
+    const char* text,
+    LaprdusEncoding encoding,
+    uint8_t** out_data,
+    size_t* out_size,
+    LaprdusAudioFormat* out_format) {
+
+    if (!handle) {
+        return static_cast<int32_t>(LAPRDUS_ERROR_INVALID_HANDLE);
+    }
+
+    preempt_warmup(handle);
+    EngineLock lock(handle->engine_mutex);
+
+    if (!handle->engine.is_initialized()) {
+        set_error(handle, "Engine not initialized");
+        return static_cast<int32_t>(LAPRDUS_ERROR_NOT_INITIALIZED);
+    }
+
+    if (!text || !out_data || !out_size || !is_encoding(encoding)) {
+        set_error(handle, "Invalid parameters");
+        return static_cast<int32_t>(LAPRDUS_ERROR_INVALID_PARAMETER);
+    }
+
+    *out_data = nullptr;
+    *out_size = 0;
+    set_encoded_format(handle, encoding, out_format);
+
+    try {
+        std::vector<uint8_t> bytes;
+        uint64_t num_samples = 0;
+        laprdus::SynthesisResult result = handle->engine.synthesize_encoded(text,
+            static_cast<laprdus::OutputEncoding>(encoding),
+            [&bytes](const uint8_t* data, size_t size) {
+                bytes.insert(bytes.end(), data, data + size);
+            },
+            &num_samples);
+
+        if (!result.success) {
+            set_error(handle, result.error_message);
+            return static_cast<int32_t>(result.cancelled ? LAPRDUS_ERROR_CANCELLED
+                                                         : LAPRDUS_ERROR_SYNTHESIS_FAILED);
+        }
+
+        if (!bytes.empty()) {
+            *out_size = bytes.size();
+            *out_data = hand_over_bytes(std::move(bytes));
+        }
+        return static_cast<int32_t>(num_samples);
+    } catch (const std::bad_alloc&) {
+        set_error(handle, "Out of memory");
+        return static_cast<int32_t>(LAPRDUS_ERROR_OUT_OF_MEMORY);
+    }
+}
+
+LAPRDUS_API void LAPRDUS_CALL laprdus_free_encoded(uint8_t* data) {
+    if (data) {
+        std::lock_guard<std::mutex> lock(g_buffers_mutex);
+        g_encoded.erase(data);
+    }
+}
+
 LAPRDUS_API void LAPRDUS_CALL laprdus_free_buffer(int16_t* buffer) {
     if (buffer) {
-        free(buffer);
+        std::lock_guard<std::mutex> lock(g_buffers_mutex);
+        g_buffers.erase(buffer);
     }
 }
 
 LAPRDUS_API void LAPRDUS_CALL laprdus_cancel(LaprdusHandle handle) {
-    // TODO: Implement cancellation support
-    // For now, this is a no-op as synthesis is synchronous
-    (void)handle;
+    // Deliberately lock-free: the engine lock is held for the whole synthesis
+    if (handle) {
+        handle->queue.cancel();
+        handle->engine.cancel();
+    }
+}
+
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_post_param(
+    LaprdusHandle handle,
+    LaprdusParam param,
+    float value) {
+
+    // Lock-free like laprdus_cancel(): the engine picks the value up itself
+    if (!handle) {
+        return LAPRDUS_ERROR_INVALID_HANDLE;
+    }
+
+    switch (param) {
+        case LAPRDUS_PARAM_SPEED:
+            handle->engine.post_param(laprdus::LiveParam::Speed, value);
+            return LAPRDUS_OK;
+        case LAPRDUS_PARAM_USER_PITCH:
+            handle->engine.post_param(laprdus::LiveParam::UserPitch, value);
+            return LAPRDUS_OK;
+        case LAPRDUS_PARAM_VOLUME:
+            handle->engine.post_param(laprdus::LiveParam::Volume, value);
+            return LAPRDUS_OK;
+    }
+    return LAPRDUS_ERROR_INVALID_PARAMETER;
+}
+
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_render_threads(
+    LaprdusHandle handle,
+    uint32_t threads) {
+
+    if (!handle) {
+        return LAPRDUS_ERROR_INVALID_HANDLE;
+    }
+
+    EngineLock lock(handle->engine_mutex);
+    handle->engine.set_render_threads(threads);
+    return LAPRDUS_OK;
+}
+
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_synthesize_batch(
+    LaprdusHandle handle,
+    const char* const* texts,
+    size_t count,
+    LaprdusBatchCallback callback,
+    void* user_data,
+    LaprdusAudioFormat* out_format) {
+
+    if (!handle) {
+        return LAPRDUS_ERROR_INVALID_HANDLE;
+    }
+
+    preempt_warmup(handle);
+    EngineLock lock(handle->engine_mutex);
+
+    if (!handle->engine.is_initialized()) {
+        set_error(handle, "Engine not initialized");
+        return LAPRDUS_ERROR_NOT_INITIALIZED;
+    }
+
+    if ((!texts && count > 0) || !callback) {
+        set_error(handle, "Texts or callback is NULL");
+        return LAPRDUS_ERROR_INVALID_PARAMETER;
+    }
+
+    std::vector<std::string> batch;
+    try {
+        batch.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            batch.emplace_back(texts[i] ? texts[i] : "");
+        }
+    } catch (const std::bad_alloc&) {
+        set_error(handle, "Memory allocation failed");
+        return LAPRDUS_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (out_format) {
+        out_format->sample_rate = handle->engine.output_rate();
+        out_format->bits_per_sample = laprdus::BITS_PER_SAMPLE;
+        out_format->channels = laprdus::NUM_CHANNELS;
+    }
+
+    std::atomic<bool> cancelled{false};
+    bool ok = handle->engine.synthesize_batch(batch,
+        [&](size_t index, const laprdus::SynthesisResult& result) {
+            LaprdusError status = LAPRDUS_OK;
+            if (!result.success) {
+                status = result.cancelled ? LAPRDUS_ERROR_CANCELLED
+                                          : LAPRDUS_ERROR_SYNTHESIS_FAILED;
+                if (result.cancelled) {
+                    cancelled.store(true, std::memory_order_relaxed);
+                }
+            }
+            const laprdus::AudioSamples& samples = result.audio.samples;
+            callback(index, status, samples.empty() ? nullptr : samples.data(),
+                     samples.size(), user_data);
+        });
+
+    if (!ok) {
+        if (cancelled.load(std::memory_order_relaxed)) {
+            set_error(handle, "Synthesis cancelled");
+            return LAPRDUS_ERROR_CANCELLED;
+        }
+        set_error(handle, "Batch synthesis failed");
+        return LAPRDUS_ERROR_SYNTHESIS_FAILED;
+    }
+    return LAPRDUS_OK;
+}
+
+// =============================================================================
+// Asynchronous Speech
+// =============================================================================
+
+LAPRDUS_API int32_t LAPRDUS_CALL laprdus_speak_async(
+    LaprdusHandle handle,
+    const char* text,
+    LaprdusSinkCallback sink,
+    void* user_data) {
+
+    return laprdus_speak_async_with_priority(handle, text, LAPRDUS_PRIORITY_TEXT,
+                                             sink, user_data);
+}
+
+LAPRDUS_API int32_t LAPRDUS_CALL laprdus_speak_async_with_priority(
+    LaprdusHandle handle,
+    const char* text,
+    LaprdusPriority priority,
+    LaprdusSinkCallback sink,
+    void* user_data) {
+
+    if (!handle) {
+        return static_cast<int32_t>(LAPRDUS_ERROR_INVALID_HANDLE);
+    }
+
+    preempt_warmup(handle);
+
+    // Not waiting for the engine lock: the worker holds it while it speaks,
+    // and a higher priority utterance has to be queued right away. The
+    // engine state is checked only when nothing is using the engine.
+    std::unique_lock<std::recursive_mutex> lock(handle->engine_mutex, std::try_to_lock);
+
+    if (lock.owns_lock() && !handle->engine.is_initialized()) {
+        set_error(handle, "Engine not initialized");
+        return static_cast<int32_t>(LAPRDUS_ERROR_NOT_INITIALIZED);
+    }
+
+    if (!text || !sink) {
+        set_error(handle, "Text or sink callback is NULL");
+        return static_cast<int32_t>(LAPRDUS_ERROR_INVALID_PARAMETER);
+    }
+
+    laprdus::UtterancePriority queue_priority;
+    switch (priority) {
+        case LAPRDUS_PRIORITY_NOTIFICATION:
+            queue_priority = laprdus::UtterancePriority::Notification;
+            break;
+        case LAPRDUS_PRIORITY_PROGRESS:
+            queue_priority = laprdus::UtterancePriority::Progress;
+            break;
+        case LAPRDUS_PRIORITY_TEXT:
+            queue_priority = laprdus::UtterancePriority::Text;
+            break;
+        case LAPRDUS_PRIORITY_KEY:
+            queue_priority = laprdus::UtterancePriority::Key;
+            break;
+        default:
+            set_error(handle, "Invalid priority");
+            return static_cast<int32_t>(LAPRDUS_ERROR_INVALID_PARAMETER);
+    }
+
+    // Events are made on the worker thread under the engine lock, so the
+    // format is read there
+    LaprdusEngine* engine = handle;
+    auto make_event = [engine](LaprdusEventType type, uint32_t id) {
+        LaprdusEvent event;
+        event.type = type;
+        event.utterance_id = id;
+        event.samples = nullptr;
+        event.num_samples = 0;
+        event.format.sample_rate = engine->engine.output_rate();
+        event.format.bits_per_sample = laprdus::BITS_PER_SAMPLE;
+        event.format.channels = laprdus::NUM_CHANNELS;
+        event.status = LAPRDUS_OK;
+        event.mark_name = nullptr;
+        event.mark_offset = 0;
+        event.submitted_us = 0;
+        event.first_audio_us = 0;
+        event.finished_us = 0;
+        return event;
+    };
+
+    laprdus::UtteranceCallbacks callbacks;
+    callbacks.begin = [=](uint32_t id) {
+        LaprdusEvent event = make_event(LAPRDUS_EVENT_BEGIN, id);
+        sink(&event, user_data);
+    };
+    callbacks.audio = [=](uint32_t id, const laprdus::AudioBuffer& chunk) {
+        LaprdusEvent event = make_event(LAPRDUS_EVENT_AUDIO, id);
+        event.format.sample_rate = chunk.sample_rate;
+        event.samples = chunk.samples.data();
+        event.num_samples = chunk.samples.size();
+        return sink(&event, user_data) != 0;
+    };
+    callbacks.mark = [=](uint32_t id, const laprdus::MarkEvent& mark) {
+        LaprdusEvent event = make_event(LAPRDUS_EVENT_MARK, id);
+        event.mark_name = mark.name.c_str();
+        event.mark_offset = mark.sample_offset;
+        return sink(&event, user_data) != 0;
+    };
+    callbacks.end = [=](uint32_t id, laprdus::UtteranceStatus status,
+                        const laprdus::UtteranceTimes& times) {
+        LaprdusEvent event = make_event(LAPRDUS_EVENT_END, id);
+        switch (status) {
+            case laprdus::UtteranceStatus::Completed:
+                event.status = LAPRDUS_OK;
+                break;
+            case laprdus::UtteranceStatus::Cancelled:
+                event.status = LAPRDUS_ERROR_CANCELLED;
+                break;
+            case laprdus::UtteranceStatus::Failed:
+                event.status = LAPRDUS_ERROR_SYNTHESIS_FAILED;
+                break;
+        }
+        event.submitted_us = times.submitted_us;
+        event.first_audio_us = times.first_audio_us;
+        event.finished_us = times.finished_us;
+        sink(&event, user_data);
+    };
+
+    try {
+        uint32_t id = handle->queue.enqueue(text, std::move(callbacks), queue_priority);
+        return static_cast<int32_t>(id);
+    } catch (const std::bad_alloc&) {
+        set_error(handle, "Out of memory");
+        return static_cast<int32_t>(LAPRDUS_ERROR_OUT_OF_MEMORY);
+    } catch (const std::exception& e) {
+        set_error(handle, e.what());
+        return static_cast<int32_t>(LAPRDUS_ERROR_SYNTHESIS_FAILED);
+    }
+}
+
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_flush(LaprdusHandle handle) {
+    if (!handle) {
+        return LAPRDUS_ERROR_INVALID_HANDLE;
+    }
+
+    // Not under the engine lock: the worker needs it to finish
+    handle->queue.flush();
+    return LAPRDUS_OK;
+}
+
+// =============================================================================
+// Warm-up
+// =============================================================================
+
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_warmup(LaprdusHandle handle) {
+    if (!handle) {
+        return LAPRDUS_ERROR_INVALID_HANDLE;
+    }
+
+    EngineLock lock(handle->engine_mutex);
+
+    if (!handle->engine.is_initialized()) {
+        set_error(handle, "Engine not initialized");
+        return LAPRDUS_ERROR_NOT_INITIALIZED;
+    }
+
+    laprdus::SynthesisResult result = handle->engine.warmup();
+    if (!result.success) {
+        set_error(handle, result.error_message);
+        return result.cancelled ? LAPRDUS_ERROR_CANCELLED : LAPRDUS_ERROR_SYNTHESIS_FAILED;
+    }
+
+    return LAPRDUS_OK;
+}
+
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_auto_warmup(
+    LaprdusHandle handle,
+    LaprdusWarmupMode mode) {
+
+    if (!handle) {
+        return LAPRDUS_ERROR_INVALID_HANDLE;
+    }
+
+    EngineLock lock(handle->engine_mutex);
+
+    if (mode != LAPRDUS_WARMUP_NONE && mode != LAPRDUS_WARMUP_BLOCKING &&
+        mode != LAPRDUS_WARMUP_BACKGROUND) {
+        set_error(handle, "Invalid warm-up mode");
+        return LAPRDUS_ERROR_INVALID_PARAMETER;
+    }
+
+    handle->auto_warmup = mode;
+    return LAPRDUS_OK;
 }
 
 // =============================================================================
@@ -445,7 +1134,14 @@ LAPRDUS_API LaprdusStreamHandle LAPRDUS_CALL laprdus_stream_begin(
     LaprdusHandle handle,
     const char* text) {
 
-    if (!handle || !handle->engine.is_initialized()) {
+    if (!handle) {
+        return nullptr;
+    }
+
+    preempt_warmup(handle);
+    EngineLock lock(handle->engine_mutex);
+
+    if (!handle->engine.is_initialized()) {
         return nullptr;
     }
 
@@ -538,6 +1234,84 @@ LAPRDUS_API void LAPRDUS_CALL laprdus_stream_destroy(LaprdusStreamHandle stream)
     }
 }
 
+// =============================================================================
+// Synthesis Statistics
+// =============================================================================
+
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_stats_enabled(
+    LaprdusHandle handle,
+    int enabled) {
+
+    if (!handle) {
+        return LAPRDUS_ERROR_INVALID_HANDLE;
+    }
+
+    EngineLock lock(handle->engine_mutex);
+
+    handle->engine.set_stats_enabled(enabled != 0);
+    return LAPRDUS_OK;
+}
+
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_get_last_stats(
+    LaprdusHandle handle,
+    LaprdusStats* out_stats) {
+
+    if (!handle) {
+        return LAPRDUS_ERROR_INVALID_HANDLE;
+    }
+
+    EngineLock lock(handle->engine_mutex);
+
+    if (!out_stats) {
+        return LAPRDUS_ERROR_INVALID_PARAMETER;
+    }
+
+    laprdus::SynthesisStats stats = handle->engine.last_stats();
+    out_stats->preprocess_ms = stats.preprocess_ms;
+    out_stats->segment_ms = stats.segment_ms;
+    out_stats->map_ms = stats.map_ms;
+    out_stats->concatenate_ms = stats.concatenate_ms;
+    out_stats->dsp_ms = stats.dsp_ms;
+    out_stats->inflection_ms = stats.inflection_ms;
+    out_stats->total_ms = stats.total_ms;
+    out_stats->first_chunk_ms = stats.first_chunk_ms;
+    out_stats->segment_count = stats.segment_count;
+    out_stats->phoneme_count = stats.phoneme_count;
+    out_stats->output_samples = stats.output_samples;
+    out_stats->peak_buffer_bytes = stats.peak_buffer_bytes;
+
+    return LAPRDUS_OK;
+}
+
+// =============================================================================
+// Tracing
+// =============================================================================
+
+LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_trace_file(const char* path) {
+    if (!path || !*path) {
+        laprdus::trace::close();
+        return LAPRDUS_OK;
+    }
+
+    if (!laprdus::trace::open(path)) {
+        return LAPRDUS_ERROR_INVALID_PATH;
+    }
+
+    return LAPRDUS_OK;
+}
+
+LAPRDUS_API void LAPRDUS_CALL laprdus_trace_begin(const char* name) {
+    if (name) {
+        laprdus::trace::begin("host", name);
+    }
+}
+
+LAPRDUS_API void LAPRDUS_CALL laprdus_trace_end(const char* name) {
+    if (name) {
+        laprdus::trace::end("host", name);
+    }
+}
+
 // =============================================================================
 // Utility Functions
 // =============================================================================
@@ -665,6 +1439,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_voice(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     if (!voice_id) {
         set_error(handle, "Voice ID is NULL");
         return LAPRDUS_ERROR_INVALID_PARAMETER;
@@ -718,8 +1494,13 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_voice(
         }
         full_path += data_filename;
 
-        // Initialize engine with new phoneme data
-        if (!handle->engine.initialize(full_path)) {
+        // Initialize engine with new phoneme data; a pack compiled into
+        // the library is used in place, without any file I/O
+        laprdus::span<const uint8_t> embedded = laprdus::embedded_voice_pack(data_filename);
+        bool loaded = embedded.empty()
+            ? handle->engine.initialize(full_path)
+            : handle->engine.initialize_from_memory_nocopy(embedded.data(), embedded.size());
+        if (!loaded) {
             set_error(handle, "Failed to load phoneme data: " + full_path);
             return LAPRDUS_ERROR_LOAD_FAILED;
         }
@@ -737,6 +1518,10 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_voice(
     // We store base_pitch separately and apply it in synthesis
     handle->engine.set_voice_params(params);
 
+    if (need_reload) {
+        warm_up_loaded_voice(handle);
+    }
+
     return LAPRDUS_OK;
 }
 
@@ -745,6 +1530,8 @@ LAPRDUS_API const char* LAPRDUS_CALL laprdus_get_current_voice(LaprdusHandle han
         return nullptr;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     if (handle->current_voice_id.empty()) {
         return nullptr;
     }
@@ -764,6 +1551,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_load_dictionary(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     if (!dictionary_path) {
         set_error(handle, "Dictionary path is NULL");
         return LAPRDUS_ERROR_INVALID_PATH;
@@ -786,6 +1575,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_load_dictionary_from_memory(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     if (!json_content) {
         set_error(handle, "Dictionary content is NULL");
         return LAPRDUS_ERROR_INVALID_PARAMETER;
@@ -806,6 +1597,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_append_dictionary(
     if (!handle) {
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
+
+    EngineLock lock(handle->engine_mutex);
     if (!dictionary_path) {
         return LAPRDUS_ERROR_INVALID_PARAMETER;
     }
@@ -819,6 +1612,7 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_append_dictionary(
 
 LAPRDUS_API void LAPRDUS_CALL laprdus_clear_dictionary(LaprdusHandle handle) {
     if (handle) {
+        EngineLock lock(handle->engine_mutex);
         handle->engine.clear_dictionary();
     }
 }
@@ -835,6 +1629,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_load_spelling_dictionary(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     if (!dictionary_path) {
         set_error(handle, "Spelling dictionary path is NULL");
         return LAPRDUS_ERROR_INVALID_PATH;
@@ -857,6 +1653,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_load_spelling_dictionary_from_memo
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     if (!json_content) {
         set_error(handle, "Spelling dictionary content is NULL");
         return LAPRDUS_ERROR_INVALID_PARAMETER;
@@ -877,6 +1675,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_append_spelling_dictionary(
     if (!handle) {
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
+
+    EngineLock lock(handle->engine_mutex);
     if (!dictionary_path) {
         return LAPRDUS_ERROR_INVALID_PARAMETER;
     }
@@ -890,6 +1690,7 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_append_spelling_dictionary(
 
 LAPRDUS_API void LAPRDUS_CALL laprdus_clear_spelling_dictionary(LaprdusHandle handle) {
     if (handle) {
+        EngineLock lock(handle->engine_mutex);
         handle->engine.clear_spelling_dictionary();
     }
 }
@@ -904,6 +1705,9 @@ LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize_spelled(
         return static_cast<int32_t>(LAPRDUS_ERROR_INVALID_HANDLE);
     }
 
+    preempt_warmup(handle);
+    EngineLock lock(handle->engine_mutex);
+
     if (!handle->engine.is_initialized()) {
         set_error(handle, "Engine not initialized");
         return static_cast<int32_t>(LAPRDUS_ERROR_NOT_INITIALIZED);
@@ -924,46 +1728,35 @@ LAPRDUS_API int32_t LAPRDUS_CALL laprdus_synthesize_spelled(
 
     if (!result.success) {
         set_error(handle, result.error_message);
-        return static_cast<int32_t>(LAPRDUS_ERROR_SYNTHESIS_FAILED);
+        return static_cast<int32_t>(result.cancelled ? LAPRDUS_ERROR_CANCELLED
+                                                     : LAPRDUS_ERROR_SYNTHESIS_FAILED);
     }
 
-    // Allocate output buffer
     size_t num_samples = result.audio.samples.size();
     if (num_samples == 0) {
         *out_samples = nullptr;
         if (out_format) {
-            out_format->sample_rate = laprdus::SAMPLE_RATE;
+            out_format->sample_rate = handle->engine.output_rate();
             out_format->bits_per_sample = laprdus::BITS_PER_SAMPLE;
             out_format->channels = laprdus::NUM_CHANNELS;
         }
         return 0;
     }
 
-    // Check for integer overflow in size calculation
-    if (num_samples > SIZE_MAX / sizeof(int16_t)) {
-        set_error(handle, "Audio data too large");
-        return static_cast<int32_t>(LAPRDUS_ERROR_OUT_OF_MEMORY);
-    }
-
-    int16_t* buffer = static_cast<int16_t*>(
-        malloc(num_samples * sizeof(int16_t)));
-
-    if (!buffer) {
-        set_error(handle, "Out of memory");
-        return static_cast<int32_t>(LAPRDUS_ERROR_OUT_OF_MEMORY);
-    }
-
-    // Copy samples
-    memcpy(buffer, result.audio.samples.data(), num_samples * sizeof(int16_t));
-
-    *out_samples = buffer;
-
     if (out_format) {
         out_format->sample_rate = result.audio.sample_rate;
         out_format->bits_per_sample = result.audio.bits_per_sample;
         out_format->channels = result.audio.channels;
     }
 
+    // Hand the engine's sample vector to the caller instead of copying it
+    try {
+        *out_samples = hand_over_samples(std::move(result.audio.samples));
+    } catch (const std::bad_alloc&) {
+        set_error(handle, "Out of memory");
+        return static_cast<int32_t>(LAPRDUS_ERROR_OUT_OF_MEMORY);
+    }
+
     return static_cast<int32_t>(num_samples);
 }
 
@@ -979,6 +1772,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_load_emoji_dictionary(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     if (!dictionary_path) {
         set_error(handle, "Emoji dictionary path is NULL");
         return LAPRDUS_ERROR_INVALID_PATH;
@@ -1001,6 +1796,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_load_emoji_dictionary_from_memory(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     if (!json_content) {
         set_error(handle, "Emoji dictionary content is NULL");
         return LAPRDUS_ERROR_INVALID_PARAMETER;
@@ -1021,6 +1818,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_append_emoji_dictionary(
     if (!handle) {
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
+
+    EngineLock lock(handle->engine_mutex);
     if (!dictionary_path) {
         return LAPRDUS_ERROR_INVALID_PARAMETER;
     }
@@ -1034,6 +1833,7 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_append_emoji_dictionary(
 
 LAPRDUS_API void LAPRDUS_CALL laprdus_clear_emoji_dictionary(LaprdusHandle handle) {
     if (handle) {
+        EngineLock lock(handle->engine_mutex);
         handle->engine.clear_emoji_dictionary();
     }
 }
@@ -1046,6 +1846,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_emoji_enabled(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     handle->engine.set_emoji_enabled(enabled != 0);
     return LAPRDUS_OK;
 }
@@ -1054,6 +1856,8 @@ LAPRDUS_API int LAPRDUS_CALL laprdus_is_emoji_enabled(LaprdusHandle handle) {
     if (!handle) {
         return 0;
     }
+
+    EngineLock lock(handle->engine_mutex);
     return handle->engine.is_emoji_enabled() ? 1 : 0;
 }
 
@@ -1069,6 +1873,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_sentence_pause(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     handle->engine.set_sentence_pause(pause_ms);
     return LAPRDUS_OK;
 }
@@ -1081,6 +1887,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_comma_pause(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     handle->engine.set_comma_pause(pause_ms);
     return LAPRDUS_OK;
 }
@@ -1093,6 +1901,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_newline_pause(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     handle->engine.set_newline_pause(pause_ms);
     return LAPRDUS_OK;
 }
@@ -1101,6 +1911,8 @@ LAPRDUS_API uint32_t LAPRDUS_CALL laprdus_get_sentence_pause(LaprdusHandle handl
     if (!handle) {
         return 100;  // Default
     }
+
+    EngineLock lock(handle->engine_mutex);
     return handle->engine.pause_settings().sentence_pause_ms;
 }
 
@@ -1108,6 +1920,8 @@ LAPRDUS_API uint32_t LAPRDUS_CALL laprdus_get_comma_pause(LaprdusHandle handle)
     if (!handle) {
         return 100;  // Default
     }
+
+    EngineLock lock(handle->engine_mutex);
     return handle->engine.pause_settings().comma_pause_ms;
 }
 
@@ -1115,6 +1929,8 @@ LAPRDUS_API uint32_t LAPRDUS_CALL laprdus_get_newline_pause(LaprdusHandle handle
     if (!handle) {
         return 100;  // Default
     }
+
+    EngineLock lock(handle->engine_mutex);
     return handle->engine.pause_settings().newline_pause_ms;
 }
 
@@ -1126,6 +1942,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_spelling_pause(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     handle->engine.set_spelling_pause(pause_ms);
     return LAPRDUS_OK;
 }
@@ -1134,6 +1952,8 @@ LAPRDUS_API uint32_t LAPRDUS_CALL laprdus_get_spelling_pause(LaprdusHandle handl
     if (!handle) {
         return 200;  // Default
     }
+
+    EngineLock lock(handle->engine_mutex);
     return handle->engine.spelling_pause();
 }
 
@@ -1149,6 +1969,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_set_number_mode(
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     laprdus::NumberMode internal_mode;
     switch (mode) {
         case LAPRDUS_NUMBER_MODE_DIGIT:
@@ -1169,6 +1991,8 @@ LAPRDUS_API LaprdusNumberMode LAPRDUS_CALL laprdus_get_number_mode(LaprdusHandle
         return LAPRDUS_NUMBER_MODE_WHOLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     laprdus::NumberMode mode = handle->engine.number_mode();
     switch (mode) {
         case laprdus::NumberMode::DigitByDigit:
@@ -1209,6 +2033,8 @@ LAPRDUS_API LaprdusError LAPRDUS_CALL laprdus_load_user_config(LaprdusHandle han
         return LAPRDUS_ERROR_INVALID_HANDLE;
     }
 
+    EngineLock lock(handle->engine_mutex);
+
     laprdus::UserConfig config;
     if (!config.load_settings()) {
         set_error(handle, "Failed to load user configuration");
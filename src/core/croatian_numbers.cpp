@@ -396,6 +396,12 @@ std::string CroatianNumbers::number_to_words(std::string_view number_str) {
 std::string CroatianNumbers::convert_numbers_in_text(const std::string& text) {
     std::string result;
     result.reserve(text.size() * 2);  // Estimate - numbers expand to words
+    convert_numbers_in_text(text, result);
+    return result;
+}
+
+void CroatianNumbers::convert_numbers_in_text(const std::string& text, std::string& result) {
+    result.clear();
 
     size_t i = 0;
     size_t length = text.size();
@@ -442,8 +448,6 @@ std::string CroatianNumbers::convert_numbers_in_text(const std::string& text) {
             }
         }
     }
-
-    return result;
 }
 
 // =============================================================================
@@ -461,6 +465,12 @@ std::string CroatianNumbers::digit_to_croatian_word(char digit) {
 std::string CroatianNumbers::convert_digits_in_text(const std::string& text) {
     std::string result;
     result.reserve(text.size() * 4);  // Estimate - each digit becomes a word
+    convert_digits_in_text(text, result);
+    return result;
+}
+
+void CroatianNumbers::convert_digits_in_text(const std::string& text, std::string& result) {
+    result.clear();
 
     size_t i = 0;
     size_t length = text.size();
@@ -490,8 +500,6 @@ std::string CroatianNumbers::convert_digits_in_text(const std::string& text) {
             i++;
         }
     }
-
-    return result;
 }
 
 } // namespace laprdus
@@ -37,6 +37,14 @@ public:
      */
     std::string convert_numbers_in_text(const std::string& text);
 
+    /**
+     * Convert all numbers in text to Croatian words, reusing the output storage.
+     * Text without digits is copied without allocating once result has grown.
+     * @param text Input text possibly containing numbers.
+     * @param result Receives the text with numbers replaced by words.
+     */
+    void convert_numbers_in_text(const std::string& text, std::string& result);
+
     /**
      * Convert all numbers in text to digit-by-digit Croatian words.
      * Example: "123" -> "jedan dva tri"
@@ -45,6 +53,13 @@ public:
      */
     std::string convert_digits_in_text(const std::string& text);
 
+    /**
+     * Convert all numbers in text to digit-by-digit words, reusing the output storage.
+     * @param text Input text possibly containing numbers.
+     * @param result Receives the text with each digit replaced by its word.
+     */
+    void convert_digits_in_text(const std::string& text, std::string& result);
+
     /**
      * Convert a numeric string to Croatian words.
      * @param number_str String containing only digits.
@@ -7,6 +7,7 @@
 #include <sstream>
 #include <algorithm>
 #include <cstring>
+#include <string_view>
 
 namespace laprdus {
 
@@ -18,9 +19,39 @@ struct EmojiDictionary::Impl {
     std::unordered_map<std::string, std::string> entries;
     bool enabled = false;  // Disabled by default
 
+    // Lookup index over the entry keys so replacement can match a slice of
+    // the input without building a std::string for every candidate.
+    // The views point into the keys of entries, whose nodes never move.
+    std::unordered_map<std::string_view, const std::string*> index;
+    size_t max_length = 0;       // Longest key in bytes
+    bool lead_bytes[256] = {};   // First bytes of all keys
+
     // Parse JSON content (clear=true replaces, clear=false appends)
     bool parse_json(const std::string& json, bool clear = true);
 
+    // Add or replace an entry and keep the index in sync
+    void insert(const std::string& emoji, const std::string& text) {
+        auto result = entries.insert_or_assign(emoji, text);
+        const std::string& key = result.first->first;
+        index[std::string_view(key)] = &result.first->second;
+        max_length = std::max(max_length, key.size());
+        lead_bytes[static_cast<unsigned char>(key[0])] = true;
+    }
+
+    // Remove all entries and the index
+    void reset() {
+        index.clear();
+        entries.clear();
+        max_length = 0;
+        std::fill(std::begin(lead_bytes), std::end(lead_bytes), false);
+    }
+
+    // Find the replacement text for an exact key, or nullptr
+    const std::string* find(std::string_view key) const {
+        auto it = index.find(key);
+        return it != index.end() ? it->second : nullptr;
+    }
+
     // Get UTF-8 codepoint length
     static size_t utf8_char_length(unsigned char c) {
         if ((c & 0x80) == 0) return 1;
@@ -55,6 +86,30 @@ struct EmojiDictionary::Impl {
         }
         return result;
     }
+
+    // Variation selector test at position i (see remove_variation_selectors)
+    static bool is_variation_selector(const char* s, size_t i, size_t size) {
+        return i + 2 < size &&
+               static_cast<unsigned char>(s[i]) == 0xEF &&
+               static_cast<unsigned char>(s[i + 1]) == 0xB8 &&
+               (static_cast<unsigned char>(s[i + 2]) == 0x8F ||
+                static_cast<unsigned char>(s[i + 2]) == 0x8E);
+    }
+
+    // Copy candidate without variation selectors into buffer (at least
+    // candidate.size() bytes). Returns the stripped length.
+    static size_t strip_variation_selectors(std::string_view candidate, char* buffer) {
+        size_t length = 0;
+        size_t i = 0;
+        while (i < candidate.size()) {
+            if (is_variation_selector(candidate.data(), i, candidate.size())) {
+                i += 3;
+                continue;
+            }
+            buffer[length++] = candidate[i++];
+        }
+        return length;
+    }
 };
 
 // =============================================================================
@@ -66,7 +121,7 @@ bool EmojiDictionary::Impl::parse_json(const std::string& json, bool clear) {
     // { "version": "1.0", "entries": [ { "emoji": "😀", "text": "nasmijano lice" }, ... ] }
 
     if (clear) {
-        entries.clear();
+        reset();
     }
 
     // Find entries array
@@ -141,7 +196,7 @@ bool EmojiDictionary::Impl::parse_json(const std::string& json, bool clear) {
 
         // Add entry if both fields found
         if (!emoji.empty() && !text.empty()) {
-            entries[emoji] = text;
+            insert(emoji, text);
 
             // Also add a normalized version without variation selectors
             // This ensures matching works whether the emoji is sent with or without
@@ -150,7 +205,7 @@ bool EmojiDictionary::Impl::parse_json(const std::string& json, bool clear) {
             if (normalized != emoji && !normalized.empty()) {
                 // Only add if not already present (don't override explicit entries)
                 if (entries.find(normalized) == entries.end()) {
-                    entries[normalized] = text;
+                    insert(normalized, text);
                 }
             }
         }
@@ -248,91 +303,97 @@ bool EmojiDictionary::append_from_memory(const char* json_content, size_t length
 // =============================================================================
 
 std::string EmojiDictionary::replace_emojis(const std::string& text) const {
+    std::string result;
+    replace_emojis(text, result);
+    return result;
+}
+
+void EmojiDictionary::replace_emojis(const std::string& text, std::string& out) const {
     // If disabled or empty dictionary, return text as-is
     if (!m_impl->enabled || m_impl->entries.empty()) {
-        return text;
+        out = text;
+        return;
     }
 
-    std::string result;
-    result.reserve(text.size() * 2);  // Reserve extra space for replacements
+    // Longest candidate tried at each position. Emojis can be 1-4 UTF-8
+    // chars, some are multi-codepoint sequences, and complex ZWJ sequences
+    // may span 25+ bytes.
+    constexpr size_t MAX_CANDIDATE = 32;
+    char normalized[MAX_CANDIDATE];
 
+    out.clear();
     size_t pos = 0;
     while (pos < text.size()) {
-        bool found = false;
-
-        // Try to match emoji sequences (longest match first)
-        // Emojis can be 1-4 UTF-8 chars, some are multi-codepoint sequences
-        // Some emojis may span up to 25+ bytes for complex ZWJ sequences
-        for (size_t len = 32; len >= 1 && !found; --len) {
-            if (pos + len > text.size()) continue;
-
-            std::string candidate = text.substr(pos, len);
-
-            // First try exact match
-            auto it = m_impl->entries.find(candidate);
-            if (it != m_impl->entries.end()) {
-                // Found match - add space before/after if needed
-                if (!result.empty() && result.back() != ' ') {
-                    result += ' ';
+        const unsigned char lead = static_cast<unsigned char>(text[pos]);
+        const std::string* replacement = nullptr;
+        size_t matched = 0;
+
+        // Try to match emoji sequences (longest match first). A candidate
+        // can only match if its first byte starts some key, or it starts
+        // with a variation selector (EF) that the fallback strips.
+        if (m_impl->lead_bytes[lead] || lead == 0xEF) {
+            const size_t longest = std::min(MAX_CANDIDATE, text.size() - pos);
+            for (size_t len = longest; len >= 1; --len) {
+                std::string_view candidate(text.data() + pos, len);
+
+                // First try exact match
+                if (len <= m_impl->max_length) {
+                    replacement = m_impl->find(candidate);
+                    if (replacement) {
+                        matched = len;
+                        break;
+                    }
                 }
-                result += it->second;
-                result += ' ';
-                pos += len;
-                found = true;
-                break;
-            }
 
-            // If no exact match, try with variation selectors removed from candidate
-            // This handles cases where the input text has variation selectors
-            // but our dictionary entry doesn't (or vice versa - handled during load)
-            std::string normalized = Impl::remove_variation_selectors(candidate);
-            if (normalized != candidate && !normalized.empty()) {
-                it = m_impl->entries.find(normalized);
-                if (it != m_impl->entries.end()) {
-                    if (!result.empty() && result.back() != ' ') {
-                        result += ' ';
+                // If no exact match, try with variation selectors removed from candidate
+                // This handles cases where the input text has variation selectors
+                // but our dictionary entry doesn't (or vice versa - handled during load)
+                size_t stripped = Impl::strip_variation_selectors(candidate, normalized);
+                if (stripped != len && stripped > 0) {
+                    replacement = m_impl->find(std::string_view(normalized, stripped));
+                    if (replacement) {
+                        matched = len;
+                        break;
                     }
-                    result += it->second;
-                    result += ' ';
-                    pos += len;
-                    found = true;
-                    break;
                 }
             }
         }
 
-        if (!found) {
+        if (replacement) {
+            // Found match - add space before/after if needed
+            if (!out.empty() && out.back() != ' ') {
+                out += ' ';
+            }
+            out += *replacement;
+            out += ' ';
+            pos += matched;
+        } else {
             // No match - copy character as-is
-            size_t char_len = Impl::utf8_char_length(static_cast<unsigned char>(text[pos]));
-            result += text.substr(pos, char_len);
+            size_t char_len = std::min(Impl::utf8_char_length(lead), text.size() - pos);
+            out.append(text, pos, char_len);
             pos += char_len;
         }
     }
 
-    // Clean up extra spaces
-    // Remove leading space
-    size_t start = 0;
-    while (start < result.size() && result[start] == ' ') start++;
-    // Remove trailing space
-    size_t end = result.size();
-    while (end > start && result[end - 1] == ' ') end--;
-    // Collapse multiple spaces
-    std::string cleaned;
-    cleaned.reserve(end - start);
-    bool prev_space = false;
-    for (size_t i = start; i < end; ++i) {
-        if (result[i] == ' ') {
+    // Clean up extra spaces in place: remove leading and trailing spaces
+    // and collapse runs of spaces
+    size_t length = 0;
+    bool prev_space = true;
+    for (size_t i = 0; i < out.size(); ++i) {
+        if (out[i] == ' ') {
             if (!prev_space) {
-                cleaned += ' ';
+                out[length++] = ' ';
                 prev_space = true;
             }
         } else {
-            cleaned += result[i];
+            out[length++] = out[i];
             prev_space = false;
         }
     }
-
-    return cleaned;
+    if (length > 0 && out[length - 1] == ' ') {
+        --length;
+    }
+    out.resize(length);
 }
 
 // =============================================================================
@@ -341,7 +402,7 @@ std::string EmojiDictionary::replace_emojis(const std::string& text) const {
 
 void EmojiDictionary::add_entry(const std::string& emoji, const std::string& text) {
     if (!emoji.empty() && !text.empty()) {
-        m_impl->entries[emoji] = text;
+        m_impl->insert(emoji, text);
     }
 }
 
@@ -350,7 +411,7 @@ void EmojiDictionary::add_entry(const std::string& emoji, const std::string& tex
 // =============================================================================
 
 void EmojiDictionary::clear() {
-    m_impl->entries.clear();
+    m_impl->reset();
 }
 
 // =============================================================================
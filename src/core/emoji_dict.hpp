@@ -76,6 +76,14 @@ public:
      */
     std::string replace_emojis(const std::string& text) const;
 
+    /**
+     * Replace all emojis in text, writing into a caller-owned string.
+     * Once out has grown to fit, no heap allocations are performed.
+     * @param text Input text possibly containing emojis.
+     * @param out Receives the text with emojis replaced (must not be text).
+     */
+    void replace_emojis(const std::string& text, std::string& out) const;
+
     /**
      * Add a single emoji entry.
      * @param emoji UTF-8 emoji character(s).
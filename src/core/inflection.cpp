@@ -3,8 +3,9 @@
 
 #include "inflection.hpp"
 #include "phoneme_mapper.hpp"
+#include "trace.hpp"
+#include "../audio/dsp_kernels.hpp"
 #include "../audio/sonic_processor.hpp"
-#include "../audio/formant_pitch.hpp"
 #include <cmath>
 #include <algorithm>
 
@@ -35,58 +36,90 @@ PauseSettings InflectionProcessor::pause_settings() const {
 
 std::vector<TextSegment> InflectionProcessor::analyze_text(const std::string& text) {
     std::vector<TextSegment> segments;
+    segments.resize(analyze_text(text, segments));
+    return segments;
+}
+
+size_t InflectionProcessor::analyze_text(const std::string& text,
+                                         std::vector<TextSegment>& segments,
+                                         const std::vector<uint32_t>* break_ms) {
+    trace::Scope trace_scope("inflection", "analyze_text");
 
     // Convert to UTF-32 for proper character handling
-    std::u32string utf32 = PhonemeMapper::utf8_to_utf32(text);
+    PhonemeMapper::utf8_to_utf32(text, m_utf32);
+    const std::u32string& utf32 = m_utf32;
 
-    if (utf32.empty()) {
-        return segments;
-    }
+    size_t count = 0;
+    uint32_t prosody = 0;
+    size_t breaks_used = 0;
+
+    // Fill the next segment slot, reusing the storage of earlier calls
+    auto emit = [&](size_t start, size_t length, Punctuation punct, bool force = false) {
+        if (length == 0 && !force) {
+            return;
+        }
+        if (count == segments.size()) {
+            segments.emplace_back();
+        }
+        TextSegment& segment = segments[count++];
+        segment.text.assign(utf32, start, length);
+        segment.trailing_punct = punct;
+        segment.inflection = punct_to_inflection(punct);
+        segment.marks = static_cast<uint32_t>(
+            std::count(segment.text.begin(), segment.text.end(),
+                       static_cast<char32_t>(MARK_BEGIN)));
+        segment.break_ms = 0;
+        segment.prosody = prosody;
+
+        // Check if this ends a sentence
+        segment.is_end_of_sentence = (punct == Punctuation::PERIOD ||
+                                      punct == Punctuation::QUESTION ||
+                                      punct == Punctuation::EXCLAMATION);
+    };
 
-    TextSegment current;
     size_t segment_start = 0;
 
     for (size_t i = 0; i < utf32.size(); ++i) {
-        char32_t ch = utf32[i];
-        Punctuation punct = PhonemeMapper::detect_punctuation(ch);
-
-        if (punct != Punctuation::NONE) {
-            // End current segment at this punctuation
-            if (i > segment_start) {
-                current.text = utf32.substr(segment_start, i - segment_start);
+        if (utf32[i] == static_cast<char32_t>(SSML_BREAK) ||
+            utf32[i] == static_cast<char32_t>(SSML_PROSODY)) {
+            // SSML controls end the text before them; blank text without
+            // marks is dropped
+            bool blank = true;
+            for (size_t k = segment_start; k < i && blank; ++k) {
+                blank = utf32[k] <= U' ' && utf32[k] != static_cast<char32_t>(MARK_BEGIN);
             }
+            if (!blank) {
+                emit(segment_start, i - segment_start, Punctuation::NONE);
+            }
+            segment_start = i + 1;
 
-            current.trailing_punct = punct;
-            current.inflection = punct_to_inflection(punct);
-
-            // Check if this ends a sentence
-            current.is_end_of_sentence = (punct == Punctuation::PERIOD ||
-                                           punct == Punctuation::QUESTION ||
-                                           punct == Punctuation::EXCLAMATION);
-
-            if (!current.text.empty()) {
-                segments.push_back(std::move(current));
+            if (utf32[i] == static_cast<char32_t>(SSML_PROSODY)) {
+                ++prosody;
+            } else if (break_ms && breaks_used < break_ms->size()) {
+                // Silence after the last segment
+                if (count == 0) {
+                    emit(segment_start, 0, Punctuation::NONE, true);
+                }
+                segments[count - 1].break_ms += (*break_ms)[breaks_used++];
             }
+            continue;
+        }
 
-            // Start new segment
-            current = TextSegment{};
+        Punctuation punct = PhonemeMapper::detect_punctuation(utf32[i]);
+
+        if (punct != Punctuation::NONE) {
+            // End current segment at this punctuation
+            emit(segment_start, i - segment_start, punct);
             segment_start = i + 1;
         }
     }
 
     // Handle remaining text (no trailing punctuation)
     if (segment_start < utf32.size()) {
-        current.text = utf32.substr(segment_start);
-        current.trailing_punct = Punctuation::NONE;
-        current.inflection = InflectionType::NEUTRAL;
-        current.is_end_of_sentence = false;
-
-        if (!current.text.empty()) {
-            segments.push_back(std::move(current));
-        }
+        emit(segment_start, utf32.size() - segment_start, Punctuation::NONE);
     }
 
-    return segments;
+    return count;
 }
 
 // =============================================================================
@@ -98,140 +131,52 @@ AudioBuffer InflectionProcessor::apply_inflection(
     InflectionType inflection,
     size_t phoneme_count) {
 
-    (void)phoneme_count;  // Unused in simplified implementation
-
-    if (samples.empty() || inflection == InflectionType::NEUTRAL) {
-        return samples;  // No modification needed
-    }
+    AudioBuffer result;
+    apply_inflection(samples, inflection, phoneme_count, result);
+    return result;
+}
 
-    InflectionParams params = get_inflection_params(inflection);
+void InflectionProcessor::apply_inflection(
+    const AudioBuffer& samples,
+    InflectionType inflection,
+    size_t phoneme_count,
+    AudioBuffer& output) {
 
-    // Calculate the last portion to affect (last ~30% of audio for the final word)
-    size_t total_samples = samples.samples.size();
-    size_t scope_samples = static_cast<size_t>(total_samples * 0.3f);
-    scope_samples = std::max(scope_samples, size_t(1024));  // At least ~46ms
-    scope_samples = std::min(scope_samples, total_samples);
+    (void)phoneme_count;  // Scope is derived from the envelope parameters
 
-    size_t split_point = total_samples - scope_samples;
+    apply_contour(samples, inflection, output);
 
-    // Copy the unchanged first portion
-    AudioBuffer result;
-    result.sample_rate = samples.sample_rate;
-    result.bits_per_sample = samples.bits_per_sample;
-    result.channels = samples.channels;
-    result.samples.assign(samples.samples.begin(), samples.samples.begin() + split_point);
-
-    // Extract the last portion to pitch-shift
-    AudioBuffer end_portion;
-    end_portion.sample_rate = samples.sample_rate;
-    end_portion.bits_per_sample = samples.bits_per_sample;
-    end_portion.channels = samples.channels;
-    end_portion.samples.assign(samples.samples.begin() + split_point, samples.samples.end());
-
-    AudioBuffer shifted_end;
-
-    if (params.has_peak) {
-        // Two-stage pattern (exclamation): rise to peak, then fall to end
-        // Split the end portion into two halves
-        size_t half_point = end_portion.samples.size() / 2;
-
-        // First half: pitch up to peak
-        AudioBuffer first_half;
-        first_half.sample_rate = end_portion.sample_rate;
-        first_half.bits_per_sample = end_portion.bits_per_sample;
-        first_half.channels = end_portion.channels;
-        first_half.samples.assign(end_portion.samples.begin(),
-                                  end_portion.samples.begin() + half_point);
-
-        // Second half: pitch down to end
-        AudioBuffer second_half;
-        second_half.sample_rate = end_portion.sample_rate;
-        second_half.bits_per_sample = end_portion.bits_per_sample;
-        second_half.channels = end_portion.channels;
-        second_half.samples.assign(end_portion.samples.begin() + half_point,
-                                   end_portion.samples.end());
-
-        // Apply formant-preserving pitch shifts
-        AudioBuffer shifted_first = formant::change_pitch_preserve_formants(first_half, params.pitch_peak);
-        AudioBuffer shifted_second = formant::change_pitch_preserve_formants(second_half, params.pitch_end);
-
-        // Safety: if pitch shifting failed, use originals
-        if (shifted_first.samples.empty()) shifted_first = first_half;
-        if (shifted_second.samples.empty()) shifted_second = second_half;
-
-        // Combine with crossfade
-        shifted_end.sample_rate = end_portion.sample_rate;
-        shifted_end.bits_per_sample = end_portion.bits_per_sample;
-        shifted_end.channels = end_portion.channels;
-        shifted_end.samples = std::move(shifted_first.samples);
-
-        // Crossfade between peak and end portions
-        constexpr size_t MID_CROSSFADE = 128;
-        size_t mid_cf = std::min({MID_CROSSFADE, shifted_end.samples.size(), shifted_second.samples.size()});
-
-        // Only apply crossfade if we have samples to blend
-        if (mid_cf > 0) {
-            for (size_t i = 0; i < mid_cf; ++i) {
-                float t = static_cast<float>(i) / static_cast<float>(mid_cf);
-                size_t idx = shifted_end.samples.size() - mid_cf + i;
-                float blended = shifted_end.samples[idx] * (1.0f - t) + shifted_second.samples[i] * t;
-                shifted_end.samples[idx] = static_cast<AudioSample>(std::clamp(blended, -32768.0f, 32767.0f));
-            }
-        }
+    // Apply emphasis (volume adjustment) if specified
+    float emphasis = get_inflection_params(inflection).emphasis;
+    if (!output.empty() && std::abs(emphasis - 1.0f) > 0.01f) {
+        dsp::apply_gain(output.samples.data(), output.samples.size(),
+                        emphasis, dsp::Rounding::TowardZero);
+    }
+}
 
-        // Append rest of second portion
-        if (shifted_second.samples.size() > mid_cf) {
-            shifted_end.samples.insert(shifted_end.samples.end(),
-                                       shifted_second.samples.begin() + mid_cf,
-                                       shifted_second.samples.end());
-        }
-    } else {
-        // Simple pattern: just shift to target pitch using formant-preserving algorithm
-        shifted_end = formant::change_pitch_preserve_formants(end_portion, params.pitch_end);
+void InflectionProcessor::apply_contour(
+    const AudioBuffer& samples,
+    InflectionType inflection,
+    AudioBuffer& output) {
 
-        // Safety: if pitch shifting failed and returned empty, use original
-        if (shifted_end.samples.empty()) {
-            shifted_end = end_portion;
-        }
+    if (samples.empty() || inflection == InflectionType::NEUTRAL) {
+        output = samples;  // No modification needed
+        return;
     }
 
-    // Crossfade between unchanged portion and shifted portion
-    if (!result.samples.empty() && !shifted_end.samples.empty()) {
-        constexpr size_t CROSSFADE_LEN = 256;  // ~12ms crossfade
-        size_t actual_crossfade = std::min({CROSSFADE_LEN, result.samples.size(), shifted_end.samples.size()});
-
-        // Only apply crossfade if we have samples to blend
-        if (actual_crossfade > 0) {
-            for (size_t i = 0; i < actual_crossfade; ++i) {
-                float t = static_cast<float>(i) / static_cast<float>(actual_crossfade);
-                size_t result_idx = result.samples.size() - actual_crossfade + i;
-                float blended = result.samples[result_idx] * (1.0f - t) + shifted_end.samples[i] * t;
-                result.samples[result_idx] = static_cast<AudioSample>(std::clamp(blended, -32768.0f, 32767.0f));
-            }
-        }
+    trace::Scope trace_scope("inflection", "apply_inflection");
+    InflectionParams params = get_inflection_params(inflection);
 
-        // Append the rest of the shifted portion (after crossfade)
-        if (shifted_end.samples.size() > actual_crossfade) {
-            result.samples.insert(result.samples.end(),
-                                 shifted_end.samples.begin() + actual_crossfade,
-                                 shifted_end.samples.end());
-        }
-    } else {
-        result.samples.insert(result.samples.end(),
-                             shifted_end.samples.begin(),
-                             shifted_end.samples.end());
-    }
+    // Build the contour for the whole segment and stream it through a single
+    // formant-preserving pass (rise/fall and peak patterns are both part of
+    // the envelope)
+    generate_pitch_envelope(samples.samples.size(), params, m_envelope);
+    m_pitch_shifter.process(samples, m_envelope, output);
 
-    // Apply emphasis (volume adjustment) if specified
-    if (std::abs(params.emphasis - 1.0f) > 0.01f) {
-        for (auto& sample : result.samples) {
-            float adjusted = static_cast<float>(sample) * params.emphasis;
-            adjusted = std::clamp(adjusted, -32768.0f, 32767.0f);
-            sample = static_cast<AudioSample>(adjusted);
-        }
+    // Safety: if pitch shifting failed and returned empty, use original
+    if (output.samples.empty()) {
+        output = samples;
     }
-
-    return result;
 }
 
 // =============================================================================
@@ -256,10 +201,21 @@ std::vector<float> InflectionProcessor::generate_pitch_envelope(
     size_t num_samples,
     const InflectionParams& params) {
 
-    std::vector<float> envelope(num_samples, 1.0f);
+    std::vector<float> envelope;
+    generate_pitch_envelope(num_samples, params, envelope);
+    return envelope;
+}
+
+void InflectionProcessor::generate_pitch_envelope(
+    size_t num_samples,
+    const InflectionParams& params,
+    std::vector<float>& envelope) {
+
+    trace::Scope trace_scope("inflection", "generate_pitch_envelope");
+    envelope.assign(num_samples, 1.0f);
 
     if (num_samples == 0 || params.scope_phonemes == 0) {
-        return envelope;
+        return;
     }
 
     // Calculate the affected region (last N% of samples)
@@ -293,8 +249,6 @@ std::vector<float> InflectionProcessor::generate_pitch_envelope(
             envelope[i] = lerp(params.pitch_start, params.pitch_end, smooth_progress);
         }
     }
-
-    return envelope;
 }
 
 // =============================================================================
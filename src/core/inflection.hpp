@@ -6,6 +6,7 @@
 #define LAPRDUS_INFLECTION_HPP
 
 #include "laprdus/types.hpp"
+#include "../audio/formant_pitch.hpp"
 #include <vector>
 #include <string>
 #include <string_view>
@@ -21,7 +22,8 @@ namespace laprdus {
  * - Comma (,): Slight rise (+12% over last 2 phonemes)
  * - Exclamation (!): Emphatic (+15-25% overall)
  *
- * Uses simple pitch shifting via sample resampling.
+ * The contour is applied in a single streaming pass by a persistent
+ * formant-preserving pitch shifter, so the voice keeps its timbre.
  */
 class InflectionProcessor {
 public:
@@ -47,8 +49,27 @@ public:
      */
     std::vector<TextSegment> analyze_text(const std::string& text);
 
+    /**
+     * Analyze text into a reusable segment list.
+     * Entries past the returned count are left over from earlier calls and
+     * keep their storage so later calls can reuse it. Each MARK_BEGIN left
+     * in the text by mark extraction stays in its segment's text and is
+     * counted in TextSegment::marks; it does not end the segment, so the
+     * audio is the same as without it. SSML_PROSODY and SSML_BREAK end the
+     * segment: the first advances TextSegment::prosody, the second adds
+     * the next of break_ms to the silence after the last segment.
+     * @param text UTF-8 text to analyze.
+     * @param segments Segment list to fill from the front.
+     * @param break_ms Durations of the SSML breaks in order (null ignores them).
+     * @return Number of segments produced.
+     */
+    size_t analyze_text(const std::string& text, std::vector<TextSegment>& segments,
+                        const std::vector<uint32_t>* break_ms = nullptr);
+
     /**
      * Apply inflection to audio samples.
+     * Generates the pitch envelope for the inflection type and applies it
+     * in one pass.
      * @param samples Input audio samples.
      * @param inflection Type of inflection to apply.
      * @param phoneme_count Number of phonemes in this segment.
@@ -58,6 +79,30 @@ public:
                                  InflectionType inflection,
                                  size_t phoneme_count);
 
+    /**
+     * Apply inflection into a caller-owned buffer.
+     * @param samples Input audio samples.
+     * @param inflection Type of inflection to apply.
+     * @param phoneme_count Number of phonemes in this segment.
+     * @param output Receives the processed audio (storage is reused).
+     */
+    void apply_inflection(const AudioBuffer& samples,
+                          InflectionType inflection,
+                          size_t phoneme_count,
+                          AudioBuffer& output);
+
+    /**
+     * Apply only the pitch contour of an inflection, leaving its emphasis
+     * gain (get_inflection_params().emphasis) to the caller, which folds it
+     * into the output quantization.
+     * @param samples Input audio samples.
+     * @param inflection Type of inflection to apply.
+     * @param output Receives the processed audio (storage is reused).
+     */
+    void apply_contour(const AudioBuffer& samples,
+                       InflectionType inflection,
+                       AudioBuffer& output);
+
     /**
      * Apply pitch shift to audio samples.
      * Simple resampling-based pitch shift.
@@ -77,6 +122,17 @@ public:
         size_t num_samples,
         const InflectionParams& params);
 
+    /**
+     * Generate a smooth pitch envelope into an existing vector.
+     * @param num_samples Number of samples.
+     * @param params Inflection parameters.
+     * @param envelope Receives one pitch factor per sample.
+     */
+    static void generate_pitch_envelope(
+        size_t num_samples,
+        const InflectionParams& params,
+        std::vector<float>& envelope);
+
     /**
      * Apply pitch envelope to audio.
      * @param samples Input samples.
@@ -111,6 +167,11 @@ public:
 
 private:
     PauseSettings m_pause_settings;
+    formant::PitchShifter m_pitch_shifter;
+
+    // Scratch storage reused across calls
+    std::u32string m_utf32;
+    std::vector<float> m_envelope;
 
     // Linear interpolation between pitch values
     static float lerp(float a, float b, float t) {
@@ -104,26 +104,31 @@ std::vector<PhonemeToken> PhonemeMapper::map_text(const std::string& text) {
     std::vector<PhonemeToken> result;
     result.reserve(text.size());  // Pre-allocate for efficiency
 
+    // Convert to UTF-32 for proper character handling
+    utf8_to_utf32(text, m_utf32);
+    map_text(m_utf32, result);
+
+    return result;
+}
+
+void PhonemeMapper::map_text(const std::u32string& text, std::vector<PhonemeToken>& output) {
+    output.clear();
+
     // Reset state machine
     m_state = State::NORMAL;
 
-    // Convert to UTF-32 for proper character handling
-    std::u32string utf32 = utf8_to_utf32(text);
-
     // Convert Cyrillic to Latin (supports Serbian and Macedonian)
     // This is done early in the pipeline so all subsequent processing
     // works with Latin characters (reusing existing phoneme mappings)
-    utf32 = cyrillic::to_latin(utf32);
+    cyrillic::to_latin(text, m_latin);
 
     // Process each character
-    for (char32_t ch : utf32) {
-        process_char(ch, result);
+    for (char32_t ch : m_latin) {
+        process_char(ch, output);
     }
 
     // Flush any remaining state
-    flush_state(result);
-
-    return result;
+    flush_state(output);
 }
 
 // =============================================================================
@@ -131,6 +136,15 @@ std::vector<PhonemeToken> PhonemeMapper::map_text(const std::string& text) {
 // =============================================================================
 
 void PhonemeMapper::process_char(char32_t ch, std::vector<PhonemeToken>& output) {
+    // An inline mark sits between the phonemes around it
+    if (ch == static_cast<char32_t>(MARK_BEGIN)) {
+        flush_state(output);
+        PhonemeToken mark;
+        mark.mark = true;
+        output.push_back(mark);
+        return;
+    }
+
     // Convert to lowercase for consistent handling
     char32_t ch_lower = ch;
     if (ch >= U'A' && ch <= U'Z') {
@@ -291,6 +305,12 @@ Punctuation PhonemeMapper::detect_punctuation(char32_t ch) {
 std::u32string PhonemeMapper::utf8_to_utf32(const std::string& utf8) {
     std::u32string result;
     result.reserve(utf8.size());  // Usually fewer chars, but good starting point
+    utf8_to_utf32(utf8, result);
+    return result;
+}
+
+void PhonemeMapper::utf8_to_utf32(const std::string& utf8, std::u32string& result) {
+    result.clear();
 
     size_t i = 0;
     while (i < utf8.size()) {
@@ -330,8 +350,6 @@ std::u32string PhonemeMapper::utf8_to_utf32(const std::string& utf8) {
 
         result.push_back(cp);
     }
-
-    return result;
 }
 
 // =============================================================================
@@ -467,6 +485,12 @@ constexpr char32_t CYRILLIC_S_W_DESC_UPPER = U'\u0405'; // Ѕ
 std::u32string to_latin(const std::u32string& text) {
     std::u32string result;
     result.reserve(text.size() * 2);  // May expand due to digraphs
+    to_latin(text, result);
+    return result;
+}
+
+void to_latin(const std::u32string& text, std::u32string& result) {
+    result.clear();
 
     for (char32_t ch : text) {
         // Fast path: non-Cyrillic characters pass through unchanged
@@ -608,7 +632,6 @@ std::u32string to_latin(const std::u32string& text) {
         }
     }
 
-    return result;
 }
 
 } // namespace cyrillic
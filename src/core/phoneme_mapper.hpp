@@ -41,6 +41,15 @@ public:
      */
     std::vector<PhonemeToken> map_text(const std::string& text);
 
+    /**
+     * Convert UTF-32 text to phoneme tokens, reusing the output storage.
+     * Each MARK_BEGIN in the text becomes a token with mark set and no
+     * phoneme, in text order.
+     * @param text UTF-32 input text (e.g. a TextSegment).
+     * @param output Receives the tokens; previous contents are replaced.
+     */
+    void map_text(const std::u32string& text, std::vector<PhonemeToken>& output);
+
     /**
      * Convert a single UTF-32 character to a phoneme.
      * @param ch Unicode code point.
@@ -62,6 +71,13 @@ public:
      */
     static std::u32string utf8_to_utf32(const std::string& utf8);
 
+    /**
+     * Convert UTF-8 string to UTF-32, reusing the output storage.
+     * @param utf8 UTF-8 encoded string.
+     * @param output Receives the UTF-32 string.
+     */
+    static void utf8_to_utf32(const std::string& utf8, std::u32string& output);
+
     /**
      * Convert UTF-32 string to UTF-8.
      * @param utf32 UTF-32 string.
@@ -97,6 +113,10 @@ private:
     // Direct character to phoneme mapping
     std::unordered_map<char32_t, Phoneme> m_char_map;
 
+    // Scratch buffers reused across map_text calls
+    std::u32string m_utf32;
+    std::u32string m_latin;
+
     // Initialize character mappings
     void init_mappings();
 
@@ -145,6 +165,13 @@ namespace cyrillic {
      */
     std::u32string to_latin(const std::u32string& text);
 
+    /**
+     * Convert Cyrillic text to Latin, reusing the output storage.
+     * @param text UTF-32 text with Cyrillic characters.
+     * @param output Receives the converted text.
+     */
+    void to_latin(const std::u32string& text, std::u32string& output);
+
     /**
      * Check if a character is Cyrillic.
      * @param ch Unicode code point.
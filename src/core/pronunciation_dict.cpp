@@ -19,14 +19,6 @@ namespace laprdus {
 
 namespace {
 
-// Helper to convert string to lowercase (ASCII only, sufficient for our use)
-std::string to_lower(const std::string& str) {
-    std::string result = str;
-    std::transform(result.begin(), result.end(), result.begin(),
-                   [](unsigned char c) -> char { return static_cast<char>(std::tolower(c)); });
-    return result;
-}
-
 // Simple JSON string value extractor with escape sequence handling
 std::string extract_string_value(const std::string& json, const std::string& key) {
     std::string search = "\"" + key + "\"";
@@ -142,10 +134,113 @@ std::vector<std::string> extract_entries(const std::string& json) {
     return entries;
 }
 
+// ASCII character helpers matching std::regex in the "C" locale
+char ascii_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+// Word characters for \b semantics ([A-Za-z0-9_])
+bool is_word_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_';
+}
+
+// Check whether a whole-word entry can be matched without building a regex.
+// The grapheme is inserted into the pattern verbatim, so it must not contain
+// metacharacters, and '$' in the phoneme would be a regex_replace format escape.
+bool is_literal_entry(const DictionaryEntry& entry) {
+    return entry.grapheme.find_first_of("^$\\.*+?()[]{}|") == std::string::npos &&
+           entry.phoneme.find('$') == std::string::npos;
+}
+
+bool matches_at(const std::string& text, size_t pos,
+                const std::string& pattern, bool case_sensitive) {
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        char a = text[pos + i];
+        char b = pattern[i];
+        if (case_sensitive ? (a != b) : (ascii_lower(a) != ascii_lower(b))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Replace every non-overlapping occurrence of the entry's grapheme, scanning
+// left to right like regex_replace. Whole-word entries require a \b boundary
+// on both sides of the match. Returns the number of replacements made.
+size_t replace_literal(const std::string& source, const DictionaryEntry& entry,
+                       std::string& dest) {
+    const std::string& pattern = entry.grapheme;
+    const size_t n = pattern.size();
+    size_t count = 0;
+    size_t copied = 0;
+    size_t pos = 0;
+
+    dest.clear();
+
+    while (pos + n <= source.size()) {
+        bool match = matches_at(source, pos, pattern, entry.case_sensitive);
+
+        if (match && entry.whole_word) {
+            bool before = pos > 0 && is_word_char(source[pos - 1]);
+            bool after = pos + n < source.size() && is_word_char(source[pos + n]);
+            match = (before != is_word_char(pattern.front())) &&
+                    (is_word_char(pattern.back()) != after);
+        }
+
+        if (match) {
+            dest.append(source, copied, pos - copied);
+            dest += entry.phoneme;
+            pos += n;
+            copied = pos;
+            ++count;
+        } else {
+            ++pos;
+        }
+    }
+
+    if (count > 0) {
+        dest.append(source, copied, std::string::npos);
+    }
+    return count;
+}
+
 } // anonymous namespace
 
 struct PronunciationDictionary::Impl {
     std::vector<DictionaryEntry> entries;
+    // Compiled word-boundary pattern per entry, or null for entries matched
+    // directly (or whose grapheme is not a valid regex)
+    std::vector<std::unique_ptr<const std::regex>> patterns;
+
+    void add(DictionaryEntry entry) {
+        patterns.push_back(compile(entry));
+        entries.push_back(std::move(entry));
+    }
+
+    void clear() {
+        entries.clear();
+        patterns.clear();
+    }
+
+    // Compiled once when the entry is added instead of on every apply()
+    static std::unique_ptr<const std::regex> compile(const DictionaryEntry& entry) {
+        if (!entry.whole_word || is_literal_entry(entry)) {
+            return nullptr;
+        }
+
+        // Note: We use std::regex::icase instead of character classes [yY][oO]...
+        // because the C++ std::regex implementation has issues with \b word
+        // boundaries when used adjacent to character class patterns
+        std::string pattern = "\\b" + entry.grapheme + "\\b";
+        try {
+            return std::make_unique<const std::regex>(pattern, entry.case_sensitive ?
+                std::regex::ECMAScript :
+                (std::regex::ECMAScript | std::regex::icase));
+        } catch (const std::regex_error&) {
+            return nullptr;
+        }
+    }
 };
 
 PronunciationDictionary::PronunciationDictionary()
@@ -173,7 +268,7 @@ bool PronunciationDictionary::load_from_memory(const char* json_content, size_t
     if (!json_content) return false;
 
     // Clear any existing entries before loading new ones
-    m_impl->entries.clear();
+    m_impl->clear();
 
     return parse_entries(json_content, length);
 }
@@ -214,62 +309,51 @@ bool PronunciationDictionary::parse_entries(const char* json_content, size_t len
             continue;
         }
 
-        m_impl->entries.push_back(std::move(entry));
+        m_impl->add(std::move(entry));
     }
 
     return !m_impl->entries.empty();
 }
 
 std::string PronunciationDictionary::apply(const std::string& text) const {
+    std::string result;
+    std::string scratch;
+    apply(text, result, scratch);
+    return result;
+}
+
+void PronunciationDictionary::apply(const std::string& text, std::string& result,
+                                    std::string& scratch) const {
+    result = text;
+
     if (m_impl->entries.empty() || text.empty()) {
-        return text;
+        return;
     }
 
-    std::string result = text;
-
-    for (const auto& entry : m_impl->entries) {
-        if (entry.whole_word) {
-            // Whole word matching - use word boundary regex with icase flag
-            // Note: We use std::regex::icase instead of character classes [yY][oO]...
-            // because the C++ std::regex implementation has issues with \b word
-            // boundaries when used adjacent to character class patterns
-            std::string pattern = "\\b" + entry.grapheme + "\\b";
-
-            try {
-                std::regex re(pattern, entry.case_sensitive ?
-                    std::regex::ECMAScript :
-                    (std::regex::ECMAScript | std::regex::icase));
-                result = std::regex_replace(result, re, entry.phoneme);
-            } catch (const std::regex_error&) {
-                // Fall back to simple replacement if regex fails
-                continue;
-            }
-        } else {
-            // Substring matching
-            size_t pos = 0;
-            std::string search_text = entry.case_sensitive ? result : to_lower(result);
-            std::string search_grapheme = entry.case_sensitive ? entry.grapheme : to_lower(entry.grapheme);
-
-            while ((pos = search_text.find(search_grapheme, pos)) != std::string::npos) {
-                result.replace(pos, entry.grapheme.length(), entry.phoneme);
-                // Update search_text to reflect the change
-                search_text = entry.case_sensitive ? result : to_lower(result);
-                pos += entry.phoneme.length();
+    for (size_t i = 0; i < m_impl->entries.size(); ++i) {
+        const DictionaryEntry& entry = m_impl->entries[i];
+        if (const std::regex* re = m_impl->patterns[i].get()) {
+            // Whole word matching - word boundary regex compiled at load time
+            result = std::regex_replace(result, *re, entry.phoneme);
+        } else if (!entry.whole_word || is_literal_entry(entry)) {
+            // Substring matching, and whole words with plain graphemes (the
+            // common case), are matched directly
+            if (replace_literal(result, entry, scratch) > 0) {
+                result.swap(scratch);
             }
         }
+        // Otherwise the grapheme is not a valid regex and the entry is skipped
     }
-
-    return result;
 }
 
 void PronunciationDictionary::add_entry(const DictionaryEntry& entry) {
     if (!entry.grapheme.empty() && !entry.phoneme.empty()) {
-        m_impl->entries.push_back(entry);
+        m_impl->add(entry);
     }
 }
 
 void PronunciationDictionary::clear() {
-    m_impl->entries.clear();
+    m_impl->clear();
 }
 
 size_t PronunciationDictionary::size() const {
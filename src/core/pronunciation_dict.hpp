@@ -87,6 +87,22 @@ public:
      */
     std::string apply(const std::string& text) const;
 
+    /**
+     * @brief Apply all dictionary replacements, reusing caller-owned storage
+     *
+     * Entries whose grapheme contains no regex metacharacters are matched
+     * directly instead of through std::regex, so once the buffers have grown
+     * this does not allocate. The other whole-word entries use a pattern
+     * compiled when the entry was loaded. Like every const method, safe to
+     * call from several threads at once as long as each uses its own result
+     * and scratch strings.
+     *
+     * @param text The input text to process
+     * @param result Receives the text with all matching entries replaced
+     * @param scratch Working storage, reused across calls
+     */
+    void apply(const std::string& text, std::string& result, std::string& scratch) const;
+
     /**
      * @brief Add a single entry to the dictionary
      * @param entry The dictionary entry to add
@@ -0,0 +1,266 @@
+// -*- coding: utf-8 -*-
+// speech_queue.cpp - Asynchronous utterance queue implementation
+
+#include "speech_queue.hpp"
+#include "trace.hpp"
+#include <chrono>
+#include <cstdint>
+
+namespace laprdus {
+
+namespace {
+
+uint64_t now_us() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Whether a new utterance of class `priority` interrupts one of class `other`
+bool interrupts(UtterancePriority priority, UtterancePriority other) {
+    return other != UtterancePriority::Notification && other < priority;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Constructor / Destructor
+// =============================================================================
+
+SpeechQueue::SpeechQueue(TTSEngine& engine, std::recursive_mutex& engine_mutex)
+    : m_engine(engine)
+    , m_engine_mutex(engine_mutex)
+{
+}
+
+SpeechQueue::~SpeechQueue() {
+    cancel();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_work_cv.notify_all();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+}
+
+// =============================================================================
+// Public Interface
+// =============================================================================
+
+uint32_t SpeechQueue::enqueue(std::string text, UtteranceCallbacks callbacks,
+                              UtterancePriority priority, uint32_t chunk_ms) {
+    Utterance utterance{0, 0, chunk_ms, priority, std::move(text), std::move(callbacks), nullptr};
+    utterance.times.submitted_us = now_us();
+    return push(std::move(utterance));
+}
+
+void SpeechQueue::post(std::function<void()> job) {
+    push(Utterance{0, 0, 0, UtterancePriority::Text, std::string(), UtteranceCallbacks{},
+                   std::move(job)});
+}
+
+uint32_t SpeechQueue::push(Utterance utterance) {
+    uint32_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!utterance.job) {
+            id = m_next_id;
+            // Wrap within the positive int32 range so IDs fit C API return values
+            m_next_id = (m_next_id == INT32_MAX) ? 1 : m_next_id + 1;
+        }
+        utterance.id = id;
+        utterance.generation = m_generation.load(std::memory_order_relaxed);
+        if (!utterance.job) {
+            preempt_below(utterance.priority);
+        }
+        m_pending.push_back(std::move(utterance));
+        if (!m_worker.joinable()) {
+            m_worker = std::thread(&SpeechQueue::run, this);
+        }
+    }
+    m_work_cv.notify_one();
+    return id;
+}
+
+void SpeechQueue::cancel() {
+    {
+        // Under the queue lock, so no utterance is stamped with a stale generation
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+    m_engine.cancel();
+}
+
+void SpeechQueue::preempt_below(UtterancePriority priority) {
+    // Called with m_mutex held
+    for (Utterance& pending : m_pending) {
+        if (!pending.job && interrupts(priority, pending.priority)) {
+            pending.preempted = true;
+        }
+    }
+
+    // The engine cancel is only sent while the worker is rendering, so it
+    // cannot reach a synchronous call that holds the engine meanwhile;
+    // until then the flag stops the utterance at its first chunk
+    if (m_current_id != 0 && interrupts(priority, m_current_priority) &&
+        !m_current_preempted.load(std::memory_order_relaxed)) {
+        m_current_preempted.store(true, std::memory_order_release);
+        if (m_current_rendering) {
+            m_engine.cancel();
+        }
+    }
+}
+
+std::deque<SpeechQueue::Utterance>::iterator SpeechQueue::next_pending() {
+    // Called with m_mutex held and m_pending not empty
+    uint64_t generation = m_generation.load(std::memory_order_acquire);
+    auto best = m_pending.end();
+    for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+        if (it->job) {
+            // Jobs keep their place: nothing queued after one runs before it
+            return best != m_pending.end() ? best : it;
+        }
+        if (it->preempted || it->generation != generation) {
+            return it;  // Discarded; only its end event is due, so send it now
+        }
+        if (best == m_pending.end() || it->priority > best->priority) {
+            best = it;
+        }
+    }
+    return best;
+}
+
+void SpeechQueue::flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle_cv.wait(lock, [this] { return m_pending.empty() && !m_busy; });
+}
+
+// =============================================================================
+// Worker Thread
+// =============================================================================
+
+void SpeechQueue::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_work_cv.wait(lock, [this] { return m_stop || !m_pending.empty(); });
+        if (m_pending.empty()) {
+            return;  // Stopped and drained
+        }
+
+        auto next = next_pending();
+        Utterance utterance = std::move(*next);
+        m_pending.erase(next);
+        m_busy = true;
+        m_current_id = utterance.id;
+        m_current_priority = utterance.priority;
+        m_current_preempted.store(utterance.preempted, std::memory_order_release);
+        lock.unlock();
+
+        if (utterance.job) {
+            run_job(utterance);
+        } else {
+            UtteranceStatus status = speak(utterance);
+            if (utterance.callbacks.end) {
+                std::lock_guard<std::recursive_mutex> engine_lock(m_engine_mutex);
+                utterance.times.finished_us = now_us();
+                utterance.callbacks.end(utterance.id, status, utterance.times);
+            }
+        }
+
+        lock.lock();
+        m_busy = false;
+        m_current_id = 0;
+        m_current_rendering = false;
+        m_idle_cv.notify_all();
+    }
+}
+
+void SpeechQueue::run_job(Utterance& job) {
+    // Jobs discarded by cancel() are dropped silently
+    if (m_generation.load(std::memory_order_acquire) != job.generation) {
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> engine_lock(m_engine_mutex);
+    trace::Scope trace_scope("queue", "job");
+    try {
+        job.job();
+    } catch (...) {
+        // Jobs report their own failures; keep the worker alive
+    }
+}
+
+UtteranceStatus SpeechQueue::speak(Utterance& utterance) {
+    auto stale = [this, &utterance] {
+        return m_generation.load(std::memory_order_acquire) != utterance.generation ||
+               m_current_preempted.load(std::memory_order_acquire);
+    };
+
+    // Utterances discarded by cancel() or a higher class only get their end event
+    if (stale()) {
+        return UtteranceStatus::Cancelled;
+    }
+
+    std::lock_guard<std::recursive_mutex> engine_lock(m_engine_mutex);
+    trace::Scope trace_scope("queue", "utterance");
+    trace_scope.set_arg("id", utterance.id);
+    trace_scope.set_arg("priority", static_cast<uint32_t>(utterance.priority));
+
+    if (utterance.callbacks.begin) {
+        utterance.callbacks.begin(utterance.id);
+    }
+
+    bool stopped = false;
+    auto keep_going = [&](bool keep) {
+        // A cancel() that raced with the start of synthesis is caught here
+        if (!keep || stale()) {
+            stopped = true;
+            m_engine.cancel();
+        }
+    };
+    auto on_chunk = [&](const AudioBuffer& chunk) {
+        // Nothing more is delivered once the utterance has been interrupted
+        if (!stopped && stale()) {
+            keep_going(false);
+        }
+        if (!stopped) {
+            if (utterance.times.first_audio_us == 0) {
+                utterance.times.first_audio_us = now_us();
+            }
+            keep_going(!utterance.callbacks.audio ||
+                       utterance.callbacks.audio(utterance.id, chunk));
+        }
+    };
+
+    TTSEngine::MarkSink on_mark;
+    if (utterance.callbacks.mark) {
+        on_mark = [&](const MarkEvent& mark) {
+            if (!stopped && stale()) {
+                keep_going(false);
+            }
+            if (!stopped) {
+                keep_going(utterance.callbacks.mark(utterance.id, mark));
+            }
+        };
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_current_rendering = true;
+    }
+    SynthesisResult result = m_engine.synthesize_streaming(
+        utterance.text, on_chunk, utterance.chunk_ms, on_mark);
+    {
+        // Cleared before the engine lock is released to another caller
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_current_rendering = false;
+    }
+
+    if (result.cancelled || stopped || stale()) {
+        return UtteranceStatus::Cancelled;
+    }
+    return result.success ? UtteranceStatus::Completed : UtteranceStatus::Failed;
+}
+
+} // namespace laprdus
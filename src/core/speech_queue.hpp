@@ -0,0 +1,164 @@
+// -*- coding: utf-8 -*-
+// speech_queue.hpp - Asynchronous utterance queue with a worker thread
+
+#ifndef LAPRDUS_SPEECH_QUEUE_HPP
+#define LAPRDUS_SPEECH_QUEUE_HPP
+
+#include "tts_engine.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace laprdus {
+
+/**
+ * How an utterance finished.
+ */
+enum class UtteranceStatus {
+    Completed,  // All audio was delivered
+    Cancelled,  // Stopped by cancel() or by the audio callback
+    Failed,     // Synthesis reported an error
+};
+
+/**
+ * Priority class of an utterance. A new utterance interrupts the current
+ * and pending utterances of the lower classes, except notifications;
+ * utterances of the same class are spoken in order.
+ */
+enum class UtterancePriority : uint8_t {
+    Notification = 0,  // Spoken when nothing else is pending; never interrupts or is interrupted
+    Progress = 1,      // Progress updates
+    Text = 2,          // Ordinary text (default)
+    Key = 3,           // Key and character echo
+};
+
+/**
+ * When an utterance passed through the queue, in microseconds on the
+ * steady clock.
+ */
+struct UtteranceTimes {
+    uint64_t submitted_us = 0;    // enqueue() accepted it
+    uint64_t first_audio_us = 0;  // Its first audio was handed on (0 if none was)
+    uint64_t finished_us = 0;     // Its end event was sent
+};
+
+/**
+ * Event callbacks for one utterance.
+ * All callbacks run on the queue's worker thread while the engine
+ * lock is held; they must not call back into the same engine.
+ */
+struct UtteranceCallbacks {
+    std::function<void(uint32_t id)> begin;
+    std::function<bool(uint32_t id, const AudioBuffer& chunk)> audio;  // false stops
+    std::function<bool(uint32_t id, const MarkEvent& mark)> mark;      // before its audio
+    std::function<void(uint32_t id, UtteranceStatus status, const UtteranceTimes& times)> end;
+};
+
+/**
+ * SpeechQueue - Speaks queued utterances on a background thread.
+ *
+ * The next utterance is the oldest of the highest pending class. A new
+ * utterance stops the current one at its next audio chunk if it belongs to
+ * a lower class, and discards pending ones of those classes, so key echo
+ * cuts off text and text cuts off progress updates.
+ *
+ * Every accepted utterance receives exactly one end event, including
+ * utterances discarded by cancel() or by a higher class before they
+ * started (those get no begin event). The worker thread is started by the
+ * first enqueue().
+ */
+class SpeechQueue {
+public:
+    /**
+     * @param engine Engine used for synthesis.
+     * @param engine_mutex Lock held by the worker while it uses the engine.
+     */
+    SpeechQueue(TTSEngine& engine, std::recursive_mutex& engine_mutex);
+    ~SpeechQueue();
+
+    SpeechQueue(const SpeechQueue&) = delete;
+    SpeechQueue& operator=(const SpeechQueue&) = delete;
+
+    /**
+     * Queue text for synthesis.
+     * @param text UTF-8 text to speak.
+     * @param callbacks Event callbacks for this utterance.
+     * @param priority Priority class.
+     * @param chunk_ms Maximum audio chunk duration in milliseconds.
+     * @return Utterance ID, between 1 and INT32_MAX.
+     */
+    uint32_t enqueue(std::string text, UtteranceCallbacks callbacks,
+                     UtterancePriority priority = UtterancePriority::Text,
+                     uint32_t chunk_ms = 100);
+
+    /**
+     * Queue a job to run on the worker thread, in order with utterances:
+     * nothing queued after it starts before it, whatever its priority.
+     * The job runs under the engine lock and produces no events. cancel()
+     * discards it if it has not started; to stop it midway it should
+     * watch the engine's own cancellation.
+     * @param job Function to run.
+     */
+    void post(std::function<void()> job);
+
+    /**
+     * Stop the current utterance and discard all pending ones.
+     * Returns without waiting; end events follow on the worker thread.
+     */
+    void cancel();
+
+    /**
+     * Block until every queued utterance has finished.
+     * Must not be called from an utterance callback.
+     */
+    void flush();
+
+private:
+    struct Utterance {
+        uint32_t id;
+        uint64_t generation;
+        uint32_t chunk_ms;
+        UtterancePriority priority;
+        std::string text;
+        UtteranceCallbacks callbacks;
+        std::function<void()> job;  // Set for posted jobs instead of text
+        bool preempted = false;     // Discarded by a higher class
+        UtteranceTimes times{};
+    };
+
+    uint32_t push(Utterance utterance);  // Returns the ID (0 for jobs)
+    void preempt_below(UtterancePriority priority);
+    std::deque<Utterance>::iterator next_pending();
+    void run();
+    void run_job(Utterance& job);
+    UtteranceStatus speak(Utterance& utterance);
+
+    TTSEngine& m_engine;
+    std::recursive_mutex& m_engine_mutex;
+
+    std::mutex m_mutex;
+    std::condition_variable m_work_cv;   // Signalled on enqueue, post and stop
+    std::condition_variable m_idle_cv;   // Signalled when an item finishes
+    std::deque<Utterance> m_pending;
+    uint32_t m_next_id = 1;
+    std::atomic<uint64_t> m_generation{0};  // Bumped by cancel()
+    bool m_busy = false;
+    bool m_stop = false;
+
+    // The utterance being spoken (ID 0 while idle or running a job)
+    uint32_t m_current_id = 0;
+    UtterancePriority m_current_priority = UtterancePriority::Text;
+    std::atomic<bool> m_current_preempted{false};
+    bool m_current_rendering = false;  // The worker holds the engine for it
+
+    std::thread m_worker;
+};
+
+} // namespace laprdus
+
+#endif // LAPRDUS_SPEECH_QUEUE_HPP
@@ -0,0 +1,97 @@
+// -*- coding: utf-8 -*-
+// spsc_queue.hpp - Bounded lock-free single-producer single-consumer queue
+
+#ifndef LAPRDUS_SPSC_QUEUE_HPP
+#define LAPRDUS_SPSC_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace laprdus {
+
+/**
+ * SpscQueue - Fixed-capacity ring shared by exactly one producer thread
+ * and one consumer thread.
+ *
+ * Slots are filled and read in place, so element storage (e.g. vector
+ * capacity) is reused as items cycle through the ring. Neither side ever
+ * blocks; callers decide how to wait when the queue is full or empty.
+ *
+ * @tparam T Slot type (default constructible).
+ * @tparam Capacity Number of slots, a power of two.
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() = default;
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // -------------------------------------------------------------------------
+    // Producer side
+    // -------------------------------------------------------------------------
+
+    /**
+     * Get the next free slot to fill.
+     * @return Slot pointer, or nullptr if the queue is full.
+     */
+    T* begin_push() {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == Capacity) {
+            return nullptr;
+        }
+        return &m_slots[tail & (Capacity - 1)];
+    }
+
+    /**
+     * Publish the slot returned by begin_push() to the consumer.
+     */
+    void end_push() {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // -------------------------------------------------------------------------
+    // Consumer side
+    // -------------------------------------------------------------------------
+
+    /**
+     * Get the oldest published slot.
+     * @return Slot pointer, or nullptr if the queue is empty.
+     */
+    T* front() {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &m_slots[head & (Capacity - 1)];
+    }
+
+    /**
+     * Release the slot returned by front() back to the producer.
+     */
+    void pop() {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * Discard all items. Only valid while neither side is active.
+     */
+    void clear() {
+        m_head.store(m_tail.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+private:
+    // Separate cache lines so producer and consumer do not false-share
+    alignas(64) std::atomic<size_t> m_head{0};  // Next slot to pop (consumer)
+    alignas(64) std::atomic<size_t> m_tail{0};  // Next slot to push (producer)
+    std::array<T, Capacity> m_slots;
+};
+
+} // namespace laprdus
+
+#endif // LAPRDUS_SPSC_QUEUE_HPP
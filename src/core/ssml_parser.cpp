@@ -0,0 +1,671 @@
+// -*- coding: utf-8 -*-
+// ssml_parser.cpp - SSML subset parser implementation
+
+#include "ssml_parser.hpp"
+#include "spelling_dict.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+namespace laprdus {
+
+namespace {
+
+constexpr uint32_t MAX_BREAK_MS = 10000;
+constexpr float MAX_PROSODY_SCALE = 4.0f;
+
+// =============================================================================
+// Character Helpers
+// =============================================================================
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool is_control(char c) {
+    return c == MARK_BEGIN || c == MARK_END || c == SSML_BREAK || c == SSML_PROSODY;
+}
+
+char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Case-insensitive comparison of [begin, end) with a lowercase literal
+bool equals(const char* begin, const char* end, const char* literal) {
+    size_t length = std::strlen(literal);
+    if (static_cast<size_t>(end - begin) != length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        if (to_lower(begin[i]) != literal[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool equals(const std::string& value, const char* literal) {
+    return equals(value.data(), value.data() + value.size(), literal);
+}
+
+void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x110000) {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+size_t utf8_length(unsigned char c) {
+    if ((c & 0x80) == 0) return 1;
+    if ((c & 0xE0) == 0xC0) return 2;
+    if ((c & 0xF0) == 0xE0) return 3;
+    if ((c & 0xF8) == 0xF0) return 4;
+    return 1;
+}
+
+/**
+ * Decode one entity starting at '&'.
+ * @return Characters consumed, or 0 if this is not a known entity.
+ */
+size_t decode_entity(const char* p, const char* end, std::string& out) {
+    size_t limit = std::min<size_t>(end - p, 12);
+    const char* semicolon = static_cast<const char*>(std::memchr(p, ';', limit));
+    if (!semicolon) {
+        return 0;
+    }
+    const char* name = p + 1;
+    if (name < semicolon && *name == '#') {
+        uint32_t cp = 0;
+        const char* digit = name + 1;
+        bool hex = digit < semicolon && (*digit == 'x' || *digit == 'X');
+        if (hex) {
+            ++digit;
+        }
+        if (digit == semicolon) {
+            return 0;
+        }
+        for (; digit < semicolon; ++digit) {
+            char c = to_lower(*digit);
+            uint32_t value;
+            if (c >= '0' && c <= '9') {
+                value = static_cast<uint32_t>(c - '0');
+            } else if (hex && c >= 'a' && c <= 'f') {
+                value = static_cast<uint32_t>(c - 'a' + 10);
+            } else {
+                return 0;
+            }
+            cp = cp * (hex ? 16 : 10) + value;
+        }
+        if (cp > 0 && cp < 0x110000 && !(cp < 0x80 && is_control(static_cast<char>(cp)))) {
+            append_utf8(out, cp);
+        }
+        return static_cast<size_t>(semicolon - p + 1);
+    }
+
+    static const struct { const char* name; char value; } ENTITIES[] = {
+        {"lt", '<'}, {"gt", '>'}, {"amp", '&'}, {"quot", '"'}, {"apos", '\''},
+    };
+    for (const auto& entity : ENTITIES) {
+        if (equals(name, semicolon, entity.name)) {
+            out.push_back(entity.value);
+            return static_cast<size_t>(semicolon - p + 1);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Find the '>' closing the tag that starts at p ('<'), skipping quoted
+ * attribute values. Returns nullptr if the tag is not closed.
+ */
+const char* find_tag_end(const char* p, const char* end) {
+    char quote = 0;
+    for (++p; p < end; ++p) {
+        if (quote) {
+            if (*p == quote) {
+                quote = 0;
+            }
+        } else if (*p == '"' || *p == '\'') {
+            quote = *p;
+        } else if (*p == '>') {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+const char* find(const char* p, const char* end, const char* literal) {
+    size_t length = std::strlen(literal);
+    for (; p + length <= end; ++p) {
+        if (std::memcmp(p, literal, length) == 0) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Find an attribute of a start tag and copy its value (entities decoded).
+ * @param p First character after the element name.
+ * @param end The tag's closing '>'.
+ */
+bool find_attribute(const char* p, const char* end, const char* name, std::string& value) {
+    while (p < end) {
+        while (p < end && (is_space(*p) || *p == '/')) {
+            ++p;
+        }
+        const char* name_begin = p;
+        while (p < end && *p != '=' && !is_space(*p) && *p != '/') {
+            ++p;
+        }
+        const char* name_end = p;
+        while (p < end && is_space(*p)) {
+            ++p;
+        }
+        if (p >= end || *p != '=') {
+            if (p == name_begin) {
+                ++p;  // Stray character
+            }
+            continue;  // Attribute without a value
+        }
+        ++p;
+        while (p < end && is_space(*p)) {
+            ++p;
+        }
+
+        const char* value_begin = p;
+        const char* value_end;
+        if (p < end && (*p == '"' || *p == '\'')) {
+            char quote = *p++;
+            value_begin = p;
+            while (p < end && *p != quote) {
+                ++p;
+            }
+            value_end = p;
+            if (p < end) {
+                ++p;
+            }
+        } else {
+            while (p < end && !is_space(*p)) {
+                ++p;
+            }
+            value_end = p;
+        }
+
+        if (equals(name_begin, name_end, name)) {
+            value.clear();
+            for (const char* c = value_begin; c < value_end; ++c) {
+                size_t used = (*c == '&') ? decode_entity(c, value_end, value) : 0;
+                if (used) {
+                    c += used - 1;
+                } else if (!is_control(*c)) {
+                    value.push_back(*c);
+                }
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// =============================================================================
+// Attribute Values
+// =============================================================================
+
+struct NamedValue {
+    const char* name;
+    float value;
+};
+
+constexpr NamedValue RATE_NAMES[] = {
+    {"x-slow", 0.5f}, {"slow", 0.75f}, {"medium", 1.0f}, {"fast", 1.5f},
+    {"x-fast", 2.0f}, {"default", 1.0f},
+};
+
+constexpr NamedValue PITCH_NAMES[] = {
+    {"x-low", 0.7f}, {"low", 0.85f}, {"medium", 1.0f}, {"high", 1.15f},
+    {"x-high", 1.3f}, {"default", 1.0f},
+};
+
+constexpr NamedValue VOLUME_NAMES[] = {
+    {"silent", 0.0f}, {"x-soft", 0.4f}, {"soft", 0.7f}, {"medium", 1.0f},
+    {"loud", 1.3f}, {"x-loud", 1.6f}, {"default", 1.0f},
+};
+
+constexpr NamedValue BREAK_STRENGTHS[] = {
+    {"none", 0.0f}, {"x-weak", 100.0f}, {"weak", 250.0f}, {"medium", 500.0f},
+    {"strong", 800.0f}, {"x-strong", 1200.0f},
+};
+
+/**
+ * Parse "[+|-]digits[.digits]" (locale independent).
+ * @param p Start; advanced past the number.
+ * @param sign Receives +1/-1 for an explicit sign, 0 for none.
+ */
+bool parse_number(const char*& p, const char* end, float& value, int& sign) {
+    sign = 0;
+    if (p < end && (*p == '+' || *p == '-')) {
+        sign = (*p == '-') ? -1 : 1;
+        ++p;
+    }
+    double number = 0.0;
+    double scale = 0.0;
+    bool digits = false;
+    for (; p < end; ++p) {
+        if (*p >= '0' && *p <= '9') {
+            digits = true;
+            if (scale > 0.0) {
+                number += (*p - '0') * scale;
+                scale *= 0.1;
+            } else {
+                number = number * 10.0 + (*p - '0');
+            }
+        } else if (*p == '.' && scale == 0.0) {
+            scale = 0.1;
+        } else {
+            break;
+        }
+    }
+    value = static_cast<float>(sign < 0 ? -number : number);
+    return digits;
+}
+
+bool same_prosody(const SsmlProsody& a, const SsmlProsody& b) {
+    return a.rate == b.rate && a.pitch == b.pitch && a.volume == b.volume;
+}
+
+bool find_named(const std::string& text, const NamedValue* names, size_t count, float& value) {
+    for (size_t i = 0; i < count; ++i) {
+        if (equals(text, names[i].name)) {
+            value = names[i].value;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Parse a prosody attribute into a multiplier of the outer setting.
+ * Plain numbers are multiplied by unit_scale (volume uses the 0-100 scale);
+ * a signed value is a change ("+20%" is 1.2), an unsigned one a multiplier.
+ * Semitones ("-2st") and decibels ("+6dB") are converted; Hz is ignored.
+ */
+template <size_t N>
+float parse_prosody(const std::string& text, const NamedValue (&names)[N], float unit_scale) {
+    float value = 1.0f;
+    if (find_named(text, names, N, value)) {
+        return value;
+    }
+
+    const char* p = text.data();
+    const char* end = p + text.size();
+    int sign = 0;
+    if (!parse_number(p, end, value, sign)) {
+        return 1.0f;
+    }
+
+    float result;
+    if (equals(p, end, "%")) {
+        result = sign ? 1.0f + value * 0.01f : value * 0.01f;
+    } else if (equals(p, end, "st")) {
+        result = std::exp2(value / 12.0f);
+    } else if (equals(p, end, "db")) {
+        result = std::pow(10.0f, value / 20.0f);
+    } else if (p == end) {
+        result = sign ? 1.0f + value * unit_scale : value * unit_scale;
+    } else {
+        return 1.0f;  // Hz and other absolute units
+    }
+    return std::clamp(result, 0.0f, MAX_PROSODY_SCALE);
+}
+
+uint32_t parse_time(const std::string& text) {
+    const char* p = text.data();
+    const char* end = p + text.size();
+    float value = 0.0f;
+    int sign = 0;
+    if (!parse_number(p, end, value, sign) || sign < 0) {
+        return 0;
+    }
+    if (equals(p, end, "s")) {
+        value *= 1000.0f;
+    } else if (!equals(p, end, "ms") && p != end) {
+        return 0;
+    }
+    return static_cast<uint32_t>(std::min(value, static_cast<float>(MAX_BREAK_MS)));
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Parse
+// =============================================================================
+
+void SsmlParser::parse(const std::string& ssml, SsmlDocument& document,
+                       const SsmlOptions& options) {
+    trace::Scope trace_scope("ssml", "parse");
+
+    m_document = &document;
+    m_options = options;
+    m_stack.clear();
+    m_prosody = 0;
+    m_spelling = 0;
+    m_suppressed = 0;
+    m_spelled_any = false;
+
+    document.clear();
+    document.text.reserve(ssml.size());
+
+    const char* p = ssml.data();
+    const char* end = p + ssml.size();
+    const char* text_start = p;
+
+    while (p < end) {
+        const char* tag = static_cast<const char*>(std::memchr(p, '<', end - p));
+        if (!tag) {
+            break;
+        }
+        p = tag + 1;
+
+        // Only "<name", "</", "<!" and "<?" start markup
+        char next = (p < end) ? *p : '\0';
+        bool markup = next == '/' || next == '!' || next == '?' ||
+                      (next >= 'a' && next <= 'z') || (next >= 'A' && next <= 'Z');
+        if (!markup) {
+            continue;
+        }
+
+        if (next == '!' && end - tag >= 4 && std::memcmp(tag, "<!--", 4) == 0) {
+            append_text(text_start, tag);
+            const char* close = find(tag + 4, end, "-->");
+            p = close ? close + 3 : end;
+            text_start = p;
+            continue;
+        }
+        if (next == '!' && end - tag >= 9 && std::memcmp(tag, "<![CDATA[", 9) == 0) {
+            append_text(text_start, tag);
+            const char* close = find(tag + 9, end, "]]>");
+            const char* cdata_end = close ? close : end;
+            // CDATA is literal text: no entities to decode
+            if (!m_suppressed) {
+                m_decoded.clear();
+                for (const char* c = tag + 9; c < cdata_end; ++c) {
+                    if (!is_control(*c)) {
+                        m_decoded.push_back(*c);
+                    }
+                }
+                if (m_spelling) {
+                    append_spelled(m_decoded);
+                } else {
+                    document.text += m_decoded;
+                }
+            }
+            p = close ? close + 3 : end;
+            text_start = p;
+            continue;
+        }
+
+        const char* tag_end = find_tag_end(tag, end);
+        if (!tag_end) {
+            continue;  // Unclosed '<' is text
+        }
+        append_text(text_start, tag);
+        p = tag_end + 1;
+        text_start = p;
+
+        if (next == '!' || next == '?') {
+            continue;  // Declarations and processing instructions
+        }
+
+        if (next == '/') {
+            const char* name = tag + 2;
+            const char* name_end = name;
+            while (name_end < tag_end && !is_space(*name_end)) {
+                ++name_end;
+            }
+            if (equals(name, name_end, "prosody")) {
+                close_element(ElementKind::Prosody);
+            } else if (equals(name, name_end, "say-as")) {
+                close_element(ElementKind::SayAs);
+            } else if (equals(name, name_end, "sub")) {
+                close_element(ElementKind::Sub);
+            } else if (equals(name, name_end, "p") || equals(name, name_end, "s")) {
+                close_element(ElementKind::Block);
+            } else {
+                close_element(ElementKind::Other);
+            }
+        } else {
+            bool self_closing = tag_end[-1] == '/';
+            open_element(tag + 1, self_closing ? tag_end - 1 : tag_end, self_closing);
+        }
+    }
+
+    append_text(text_start, end);
+    m_document = nullptr;
+}
+
+// =============================================================================
+// Elements
+// =============================================================================
+
+void SsmlParser::open_element(const char* tag, const char* end, bool self_closing) {
+    const char* name_end = tag;
+    while (name_end < end && !is_space(*name_end)) {
+        ++name_end;
+    }
+    // Namespace prefixes ("ssml:break") do not matter here
+    const char* name = tag;
+    for (const char* c = tag; c < name_end; ++c) {
+        if (*c == ':') {
+            name = c + 1;
+        }
+    }
+    const char* attributes = name_end;
+
+    if (equals(name, name_end, "break")) {
+        uint32_t ms = 500;  // Medium strength
+        float strength = 0.0f;
+        if (find_attribute(attributes, end, "time", m_value)) {
+            ms = parse_time(m_value);
+        } else if (find_attribute(attributes, end, "strength", m_value) &&
+                   find_named(m_value, BREAK_STRENGTHS, std::size(BREAK_STRENGTHS), strength)) {
+            ms = static_cast<uint32_t>(strength);
+        }
+        add_break(ms);
+        return;
+    }
+
+    if (equals(name, name_end, "mark")) {
+        if (!m_options.text_only && !m_suppressed &&
+            find_attribute(attributes, end, "name", m_value)) {
+            m_document->text.push_back(MARK_BEGIN);
+            m_document->text += m_value;
+            m_document->text.push_back(MARK_END);
+        }
+        return;
+    }
+
+    Element element;
+    element.outer_prosody = m_prosody;
+
+    if (equals(name, name_end, "prosody")) {
+        element.kind = ElementKind::Prosody;
+        SsmlProsody prosody = m_document->prosody[m_prosody];
+        if (find_attribute(attributes, end, "rate", m_value)) {
+            prosody.rate *= parse_prosody(m_value, RATE_NAMES, 1.0f);
+        }
+        if (find_attribute(attributes, end, "pitch", m_value)) {
+            prosody.pitch *= parse_prosody(m_value, PITCH_NAMES, 1.0f);
+        }
+        if (find_attribute(attributes, end, "volume", m_value)) {
+            prosody.volume *= parse_prosody(m_value, VOLUME_NAMES, 0.01f);
+        }
+        if (!self_closing && !same_prosody(prosody, m_document->prosody[m_prosody])) {
+            switch_prosody(prosody);
+        }
+    } else if (equals(name, name_end, "say-as")) {
+        element.kind = ElementKind::SayAs;
+        element.active = find_attribute(attributes, end, "interpret-as", m_value) &&
+                         (equals(m_value, "characters") || equals(m_value, "spell-out"));
+        if (element.active) {
+            if (m_spelling++ == 0) {
+                m_spelled_any = false;
+            }
+        }
+    } else if (equals(name, name_end, "sub")) {
+        element.kind = ElementKind::Sub;
+        if (find_attribute(attributes, end, "alias", m_value)) {
+            append_text(m_value.data(), m_value.data() + m_value.size());
+            element.active = true;
+            ++m_suppressed;
+        }
+    } else if (equals(name, name_end, "p") || equals(name, name_end, "s")) {
+        element.kind = ElementKind::Block;
+    }
+
+    m_stack.push_back(element);
+    if (self_closing) {
+        pop_element();
+    }
+}
+
+void SsmlParser::close_element(ElementKind kind) {
+    // Close the innermost element of this kind, and any left open inside it
+    for (size_t i = m_stack.size(); i-- > 0;) {
+        if (m_stack[i].kind == kind) {
+            while (m_stack.size() > i) {
+                pop_element();
+            }
+            return;
+        }
+    }
+}
+
+void SsmlParser::pop_element() {
+    Element element = m_stack.back();
+    m_stack.pop_back();
+
+    switch (element.kind) {
+        case ElementKind::Block:
+            if (!m_suppressed) {
+                m_document->text.push_back('\n');
+            }
+            break;
+        case ElementKind::Prosody: {
+            SsmlProsody outer = m_document->prosody[element.outer_prosody];
+            if (!same_prosody(outer, m_document->prosody[m_prosody])) {
+                switch_prosody(outer);
+            }
+            break;
+        }
+        case ElementKind::SayAs:
+            if (element.active) {
+                --m_spelling;
+            }
+            break;
+        case ElementKind::Sub:
+            if (element.active) {
+                --m_suppressed;
+            }
+            break;
+        case ElementKind::Other:
+            break;
+    }
+}
+
+// =============================================================================
+// Text Output
+// =============================================================================
+
+void SsmlParser::append_text(const char* begin, const char* end) {
+    if (begin >= end || m_suppressed) {
+        return;
+    }
+
+    std::string& text = m_document->text;
+    m_decoded.clear();
+    std::string& out = m_spelling ? m_decoded : text;
+
+    const char* run = begin;
+    for (const char* c = begin; c < end; ++c) {
+        if (*c != '&' && !is_control(*c)) {
+            continue;
+        }
+        out.append(run, c);
+        size_t used = (*c == '&') ? decode_entity(c, end, out) : 0;
+        if (*c == '&' && !used) {
+            out.push_back('&');  // Not an entity: literal ampersand
+            used = 1;
+        }
+        c += used ? used - 1 : 0;
+        run = c + 1;
+    }
+    out.append(run, end);
+
+    if (m_spelling) {
+        append_spelled(m_decoded);
+    }
+}
+
+void SsmlParser::append_spelled(const std::string& text) {
+    std::string& out = m_document->text;
+
+    for (size_t pos = 0; pos < text.size();) {
+        size_t length = std::min(utf8_length(static_cast<unsigned char>(text[pos])),
+                                 text.size() - pos);
+        if (is_space(text[pos])) {
+            pos += length;
+            continue;
+        }
+
+        // Letters are read one by one, like the spelling path does
+        if (m_spelled_any) {
+            add_break(m_options.spelling_pause_ms);
+        }
+        m_spelled_any = true;
+
+        out.push_back(' ');
+        if (m_options.spelling) {
+            out += m_options.spelling->get_pronunciation(text.substr(pos, length));
+        } else {
+            out.append(text, pos, length);
+        }
+        out.push_back(' ');
+        pos += length;
+    }
+}
+
+void SsmlParser::add_break(uint32_t ms) {
+    if (m_options.text_only || m_suppressed) {
+        if (!m_suppressed) {
+            m_document->text.push_back(' ');
+        }
+        return;
+    }
+    m_document->text.push_back(SSML_BREAK);
+    m_document->breaks.push_back(ms);
+}
+
+void SsmlParser::switch_prosody(const SsmlProsody& prosody) {
+    if (m_options.text_only) {
+        return;
+    }
+    m_document->text.push_back(SSML_PROSODY);
+    m_document->prosody.push_back(prosody);
+    m_prosody = static_cast<uint32_t>(m_document->prosody.size() - 1);
+}
+
+} // namespace laprdus
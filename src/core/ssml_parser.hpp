@@ -0,0 +1,117 @@
+// -*- coding: utf-8 -*-
+// ssml_parser.hpp - SSML subset parser feeding the text segmenter
+
+#ifndef LAPRDUS_SSML_PARSER_HPP
+#define LAPRDUS_SSML_PARSER_HPP
+
+#include "laprdus/types.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace laprdus {
+
+class SpellingDictionary;
+
+/**
+ * Speech settings of an SSML prosody element, relative to the voice.
+ */
+struct SsmlProsody {
+    float rate = 1.0f;    // Multiplies the speed
+    float pitch = 1.0f;   // Multiplies the user pitch
+    float volume = 1.0f;  // Multiplies the volume
+};
+
+/**
+ * Parsed SSML: plain text for the usual text pipeline, with inline marks
+ * and SSML_BREAK / SSML_PROSODY controls where the markup was.
+ */
+struct SsmlDocument {
+    std::string text;
+    std::vector<uint32_t> breaks;      // Silence of each SSML_BREAK (ms), in order
+    std::vector<SsmlProsody> prosody;  // Settings after each SSML_PROSODY; [0] is the voice's
+
+    void clear() {
+        text.clear();
+        breaks.clear();
+        prosody.assign(1, SsmlProsody());
+    }
+};
+
+/**
+ * Parse options.
+ */
+struct SsmlOptions {
+    const SpellingDictionary* spelling = nullptr;  // Letter names for say-as characters
+    uint32_t spelling_pause_ms = 0;                // Break between spelled characters
+    bool text_only = false;                        // Drop breaks, prosody and marks
+};
+
+/*
+ * SsmlParser - Converts the SSML subset screen readers send into a
+ * SsmlDocument in one pass, without building a tree:
+ *
+ * - <break time="300ms"/> or strength="..." becomes a silence
+ * - <prosody rate pitch volume> applies to the segments it contains
+ *   (named values, percentages, "+2st" and "-6dB"; nesting multiplies)
+ * - <say-as interpret-as="characters"> (or "spell-out") is spelled with
+ *   the spelling dictionary, letters separated by the spelling pause
+ * - <mark name="..."/> becomes an inline mark
+ * - <sub alias="..."> speaks the alias; </p> and </s> end a line
+ * - every other element is ignored and its text kept; comments,
+ *   processing instructions and declarations are skipped
+ *
+ * Entities (named and numeric) are decoded. Malformed markup never fails:
+ * a '<' that does not start a tag is read as text. The parser and the
+ * document keep their storage between calls, so parsing short texts does
+ * not allocate once they have grown.
+ */
+class SsmlParser {
+public:
+    /**
+     * Parse SSML into a document (replacing its contents).
+     * @param ssml UTF-8 SSML, with or without a <speak> root.
+     * @param document Receives the text and controls.
+     * @param options Spelling and output options.
+     */
+    void parse(const std::string& ssml, SsmlDocument& document,
+               const SsmlOptions& options = SsmlOptions());
+
+private:
+    enum class ElementKind : uint8_t {
+        Other,    // Unknown or content-only element
+        Block,    // p or s: ends a line when closed
+        Prosody,  // Restores the outer prosody when closed
+        SayAs,    // Spells its text while open (if spelling)
+        Sub,      // Its text is replaced by the alias
+    };
+
+    struct Element {
+        ElementKind kind = ElementKind::Other;
+        bool active = false;         // Spelling (say-as) or suppressing text (sub)
+        uint32_t outer_prosody = 0;  // Prosody to restore when closed
+    };
+
+    void open_element(const char* tag, const char* end, bool self_closing);
+    void close_element(ElementKind kind);
+    void pop_element();
+
+    void append_text(const char* begin, const char* end);
+    void append_spelled(const std::string& text);
+    void add_break(uint32_t ms);
+    void switch_prosody(const SsmlProsody& prosody);
+
+    SsmlDocument* m_document = nullptr;
+    SsmlOptions m_options;
+    std::vector<Element> m_stack;
+    std::string m_decoded;          // Entity-decoded text run
+    std::string m_value;            // Current attribute value
+    uint32_t m_prosody = 0;         // Index of the prosody in effect
+    uint32_t m_spelling = 0;        // Open say-as characters elements
+    uint32_t m_suppressed = 0;      // Open elements whose text is replaced
+    bool m_spelled_any = false;     // A letter was spelled in this say-as
+};
+
+} // namespace laprdus
+
+#endif // LAPRDUS_SSML_PARSER_HPP
@@ -0,0 +1,62 @@
+// -*- coding: utf-8 -*-
+// stage_timer.hpp - Scoped wall-clock timer for synthesis statistics
+
+#ifndef LAPRDUS_STAGE_TIMER_HPP
+#define LAPRDUS_STAGE_TIMER_HPP
+
+#include <chrono>
+
+namespace laprdus {
+
+/**
+ * StageTimer - Adds the duration of a scope to a millisecond counter.
+ *
+ * Constructed with a null counter it does nothing, so statistics
+ * collection costs a single branch per stage while disabled.
+ */
+class StageTimer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit StageTimer(double* counter_ms)
+        : m_counter_ms(counter_ms)
+    {
+        if (m_counter_ms) {
+            m_start = Clock::now();
+        }
+    }
+
+    ~StageTimer() {
+        stop();
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+    /**
+     * Stop timing early and add the elapsed time to the counter.
+     */
+    void stop() {
+        if (m_counter_ms) {
+            *m_counter_ms += elapsed_ms(m_start);
+            m_counter_ms = nullptr;
+        }
+    }
+
+    /**
+     * Milliseconds elapsed since a time point.
+     * @param start Start time.
+     * @return Elapsed wall time in milliseconds.
+     */
+    static double elapsed_ms(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+private:
+    double* m_counter_ms;
+    Clock::time_point m_start{};
+};
+
+} // namespace laprdus
+
+#endif // LAPRDUS_STAGE_TIMER_HPP
@@ -0,0 +1,223 @@
+// -*- coding: utf-8 -*-
+// trace.cpp - Opt-in Chrome trace event output implementation
+
+#include "trace.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+
+namespace laprdus {
+namespace trace {
+
+namespace {
+
+/**
+ * Writer - Owns the trace file and serializes events from all threads.
+ *
+ * Events use the JSON array form of the Chrome trace format, which
+ * chrome://tracing and Perfetto both load. The closing bracket is optional
+ * in that format, so a trace cut short by a crash is still readable.
+ */
+class Writer {
+public:
+    ~Writer() {
+        close();
+    }
+
+    bool open(const std::string& path) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        close_locked();
+
+        m_file = std::fopen(path.c_str(), "w");
+        if (!m_file) {
+            return false;
+        }
+
+        m_epoch = Scope::Clock::now();
+        m_first_event = true;
+        std::fputs("[\n", m_file);
+        write_separator();
+        std::fputs("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+                   "\"args\":{\"name\":\"laprdus\"}}", m_file);
+        m_enabled.store(true, std::memory_order_release);
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        close_locked();
+    }
+
+    bool enabled() const {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    void write(const char* phase, const char* category, const char* name,
+               Scope::Clock::time_point start, double duration_us,
+               const char* arg_key, int64_t arg_value, bool flush) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_file) {
+            return;
+        }
+
+        double ts = std::chrono::duration<double, std::micro>(start - m_epoch).count();
+        write_separator();
+        std::fputs("{\"name\":", m_file);
+        write_string(name);
+        std::fprintf(m_file, ",\"cat\":\"%s\",\"ph\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f",
+                     category, phase, thread_id(), ts);
+        if (duration_us >= 0.0) {
+            std::fprintf(m_file, ",\"dur\":%.3f", duration_us);
+        }
+        if (arg_key) {
+            std::fprintf(m_file, ",\"args\":{\"%s\":%lld}", arg_key,
+                         static_cast<long long>(arg_value));
+        }
+        std::fputc('}', m_file);
+
+        if (flush) {
+            std::fflush(m_file);
+        }
+    }
+
+private:
+    void close_locked() {
+        m_enabled.store(false, std::memory_order_release);
+        if (m_file) {
+            std::fputs("\n]\n", m_file);
+            std::fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    void write_separator() {
+        if (!m_first_event) {
+            std::fputs(",\n", m_file);
+        }
+        m_first_event = false;
+    }
+
+    // Names from host applications may contain characters JSON must escape
+    void write_string(const char* text) {
+        std::fputc('"', m_file);
+        for (const char* p = text; *p; ++p) {
+            unsigned char c = static_cast<unsigned char>(*p);
+            if (c == '"' || c == '\\') {
+                std::fputc('\\', m_file);
+                std::fputc(c, m_file);
+            } else if (c < 0x20) {
+                std::fprintf(m_file, "\\u%04x", c);
+            } else {
+                std::fputc(c, m_file);
+            }
+        }
+        std::fputc('"', m_file);
+    }
+
+    static unsigned thread_id() {
+        static std::atomic<unsigned> next_id{1};
+        thread_local unsigned id = next_id.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    std::mutex m_mutex;
+    std::FILE* m_file = nullptr;
+    std::atomic<bool> m_enabled{false};
+    bool m_first_event = true;
+    Scope::Clock::time_point m_epoch{};
+};
+
+Writer& writer() {
+    static Writer instance;
+    return instance;
+}
+
+// Nesting depth of open events on this thread. The file is flushed when an
+// outermost event ends, so buffered I/O does not skew the traced stages.
+thread_local int t_depth = 0;
+
+} // anonymous namespace
+
+// =============================================================================
+// Public Interface
+// =============================================================================
+
+bool open(const std::string& path) {
+    if (path.empty()) {
+        return false;
+    }
+    return writer().open(path);
+}
+
+void close() {
+    writer().close();
+}
+
+void open_from_environment() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        const char* path = std::getenv(TRACE_FILE_ENV);
+        if (path && *path) {
+            writer().open(path);
+        }
+    });
+}
+
+bool enabled() {
+    return writer().enabled();
+}
+
+void begin(const char* category, const char* name) {
+    Writer& w = writer();
+    if (!w.enabled()) {
+        return;
+    }
+    ++t_depth;
+    w.write("B", category, name, Scope::Clock::now(), -1.0, nullptr, 0, false);
+}
+
+void end(const char* category, const char* name) {
+    Writer& w = writer();
+    if (!w.enabled()) {
+        return;
+    }
+    if (t_depth > 0) {
+        --t_depth;
+    }
+    w.write("E", category, name, Scope::Clock::now(), -1.0, nullptr, 0, t_depth == 0);
+}
+
+// =============================================================================
+// Scope
+// =============================================================================
+
+Scope::Scope(const char* category, const char* name)
+    : m_category(category)
+    , m_name(name)
+    , m_active(writer().enabled())
+{
+    if (m_active) {
+        ++t_depth;
+        m_start = Clock::now();
+    }
+}
+
+Scope::~Scope() {
+    stop();
+}
+
+void Scope::stop() {
+    if (!m_active) {
+        return;
+    }
+    m_active = false;
+    double duration_us = std::chrono::duration<double, std::micro>(
+        Clock::now() - m_start).count();
+    --t_depth;
+    writer().write("X", m_category, m_name, m_start, duration_us,
+                   m_arg_key, m_arg_value, t_depth == 0);
+}
+
+} // namespace trace
+} // namespace laprdus
@@ -0,0 +1,103 @@
+// -*- coding: utf-8 -*-
+// trace.hpp - Opt-in Chrome trace event output for the synthesis pipeline
+
+#ifndef LAPRDUS_TRACE_HPP
+#define LAPRDUS_TRACE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace laprdus {
+namespace trace {
+
+/**
+ * Environment variable naming the trace file.
+ * Read once when the first engine is created.
+ */
+constexpr const char* TRACE_FILE_ENV = "LAPRDUS_TRACE_FILE";
+
+/**
+ * Start writing trace events to a file.
+ * Any previously open trace is finished and closed first.
+ * @param path Output path for Chrome trace JSON.
+ * @return true if the file was opened.
+ */
+bool open(const std::string& path);
+
+/**
+ * Finish the trace file and stop recording events.
+ */
+void close();
+
+/**
+ * Open the trace file named by LAPRDUS_TRACE_FILE, if set.
+ * Only the first call has any effect.
+ */
+void open_from_environment();
+
+/**
+ * Check whether tracing is active.
+ * @return true while a trace file is open.
+ */
+bool enabled();
+
+/**
+ * Record a duration begin ("B") event on the calling thread.
+ * Used by hosts to bracket work outside the engine (audio output etc.).
+ * @param category Event category.
+ * @param name Event name.
+ */
+void begin(const char* category, const char* name);
+
+/**
+ * Record a duration end ("E") event matching a previous begin().
+ * @param category Event category.
+ * @param name Event name.
+ */
+void end(const char* category, const char* name);
+
+/**
+ * Scope - Records a complete ("X") event covering its lifetime.
+ *
+ * Category and name must be string literals (they are stored, not copied).
+ * While tracing is disabled construction costs one flag check.
+ */
+class Scope {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Scope(const char* category, const char* name);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    /**
+     * End the event early. Later calls and the destructor do nothing.
+     */
+    void stop();
+
+    /**
+     * Attach an integer argument shown in the trace viewer.
+     * @param key Argument name (string literal).
+     * @param value Argument value.
+     */
+    void set_arg(const char* key, int64_t value) {
+        m_arg_key = key;
+        m_arg_value = value;
+    }
+
+private:
+    const char* m_category;
+    const char* m_name;
+    const char* m_arg_key = nullptr;
+    int64_t m_arg_value = 0;
+    bool m_active;
+    Clock::time_point m_start{};
+};
+
+} // namespace trace
+} // namespace laprdus
+
+#endif // LAPRDUS_TRACE_HPP
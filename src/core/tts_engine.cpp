@@ -4,10 +4,329 @@
 #include "tts_engine.hpp"
 #include "spelling_dict.hpp"
 #include "emoji_dict.hpp"
+#include "stage_timer.hpp"
+#include "spsc_queue.hpp"
+#include "ssml_parser.hpp"
+#include "trace.hpp"
+#include "work_pool.hpp"
+#include "../audio/resampler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
 #include <filesystem>
+#include <limits>
+#include <mutex>
+#include <thread>
 
 namespace laprdus {
 
+namespace {
+
+// =============================================================================
+// Look-ahead Mapper
+// =============================================================================
+
+/**
+ * Doorbell - Wakes a thread blocked on a lock-free condition.
+ *
+ * ring() costs one fence and one load unless somebody is waiting, so the
+ * SPSC hand-off only touches the mutex when one side actually sleeps.
+ */
+class Doorbell {
+public:
+    template <typename Ready>
+    void wait(Ready ready) {
+        if (ready()) {
+            return;
+        }
+        m_waiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, ready);
+        }
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void ring() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiters.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_cv.notify_all();
+        }
+    }
+
+private:
+    std::atomic<int> m_waiters{0};
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+};
+
+/**
+ * LookaheadMapper - Maps text segments to phonemes on a helper thread
+ * while the calling thread renders earlier segments.
+ *
+ * Mapped segments are handed over in order through a bounded SPSC ring,
+ * which also limits how far the helper runs ahead. The helper thread is
+ * started by the first job and sleeps between jobs; token vectors in the
+ * ring keep their capacity, so warm jobs do not allocate.
+ */
+class LookaheadMapper {
+public:
+    static constexpr size_t DEPTH = 4;  // Segments mapped ahead of rendering
+
+    struct Item {
+        size_t index = 0;                   // Segment index; >= count marks the end
+        std::vector<PhonemeToken> tokens;
+    };
+
+    /**
+     * Job - Ends the running job on scope exit (normal, cancelled or throwing).
+     */
+    class Job {
+    public:
+        explicit Job(LookaheadMapper& mapper) : m_mapper(mapper) {}
+        ~Job() { m_mapper.finish(); }
+
+        Job(const Job&) = delete;
+        Job& operator=(const Job&) = delete;
+
+    private:
+        LookaheadMapper& m_mapper;
+    };
+
+    LookaheadMapper() = default;
+
+    ~LookaheadMapper() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    LookaheadMapper(const LookaheadMapper&) = delete;
+    LookaheadMapper& operator=(const LookaheadMapper&) = delete;
+
+    // Pipelining needs a second core to pay off
+    static bool available() {
+        static const bool multi_core = std::thread::hardware_concurrency() > 1;
+        return multi_core;
+    }
+
+    // Begin mapping segments [0, count) on the helper thread
+    void start(PhonemeMapper& mapper, const std::vector<TextSegment>& segments,
+               size_t count, double* map_ms) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_thread.joinable()) {
+            m_thread = std::thread(&LookaheadMapper::run, this);
+        }
+        m_mapper = &mapper;
+        m_segments = &segments;
+        m_count = count;
+        m_map_ms = map_ms;
+        m_error = nullptr;
+        m_abort.store(false, std::memory_order_relaxed);
+        m_has_job = true;
+        m_busy = true;
+        m_cv.notify_all();
+    }
+
+    // Next mapped segment in order, blocking until it is ready
+    const Item& next() {
+        Item* item = nullptr;
+        m_doorbell.wait([&] { return (item = m_queue.front()) != nullptr; });
+        if (item->index >= m_count && m_error) {
+            std::rethrow_exception(m_error);
+        }
+        return *item;
+    }
+
+    // Hand the item returned by next() back to the helper
+    void release() {
+        m_queue.pop();
+        m_doorbell.ring();
+    }
+
+    // Stop the helper if still mapping and wait until it is idle
+    void finish() {
+        m_abort.store(true, std::memory_order_relaxed);
+        m_doorbell.ring();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] { return !m_busy; });
+        m_queue.clear();
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_cv.wait(lock, [this] { return m_stop || m_has_job; });
+            if (m_stop) {
+                return;
+            }
+            m_has_job = false;
+            lock.unlock();
+
+            produce();
+
+            lock.lock();
+            m_busy = false;
+            m_cv.notify_all();
+        }
+    }
+
+    // Free slot to fill, or nullptr once the job is aborted
+    Item* acquire() {
+        Item* item = nullptr;
+        m_doorbell.wait([&] {
+            return m_abort.load(std::memory_order_relaxed) ||
+                   (item = m_queue.begin_push()) != nullptr;
+        });
+        return m_abort.load(std::memory_order_relaxed) ? nullptr : item;
+    }
+
+    void publish() {
+        m_queue.end_push();
+        m_doorbell.ring();
+    }
+
+    void produce() {
+        try {
+            for (size_t i = 0; i < m_count; ++i) {
+                const TextSegment& segment = (*m_segments)[i];
+                if (segment.text.empty() && segment.break_ms == 0) {
+                    continue;
+                }
+
+                Item* item = acquire();
+                if (!item) {
+                    return;
+                }
+
+                item->index = i;
+                {
+                    StageTimer timer(m_map_ms);
+                    trace::Scope trace_scope("engine", "map_text");
+                    m_mapper->map_text(segment.text, item->tokens);
+                }
+                publish();
+            }
+        } catch (...) {
+            m_error = std::current_exception();  // Rethrown by next()
+        }
+
+        if (Item* end = acquire()) {
+            end->index = m_count;
+            end->tokens.clear();
+            publish();
+        }
+    }
+
+    SpscQueue<Item, DEPTH> m_queue;
+    Doorbell m_doorbell;
+    std::atomic<bool> m_abort{false};
+
+    // Current job (written by start(), read by the helper)
+    PhonemeMapper* m_mapper = nullptr;
+    const std::vector<TextSegment>* m_segments = nullptr;
+    size_t m_count = 0;
+    double* m_map_ms = nullptr;
+    std::exception_ptr m_error;
+
+    // Helper thread control
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_has_job = false;
+    bool m_busy = false;
+    bool m_stop = false;
+    std::thread m_thread;
+};
+
+// =============================================================================
+// Inline Marks
+// =============================================================================
+
+constexpr char CONTROL_CHARS[] = {MARK_BEGIN, MARK_END, SSML_BREAK, SSML_PROSODY, '\0'};
+
+/**
+ * Take the inline marks out of text: each MARK_BEGIN name MARK_END becomes
+ * a bare MARK_BEGIN, which segmentation turns into a segment boundary, so
+ * the names never reach the dictionaries or the number expansion. Stray
+ * mark characters are dropped, and so are SSML controls unless they came
+ * from the SSML parser.
+ * @param text Text containing marks.
+ * @param out Receives the text without mark names.
+ * @param names Receives the mark names in order (may be null).
+ * @param keep_ssml Keep SSML_BREAK and SSML_PROSODY.
+ */
+void extract_marks(const std::string& text, std::string& out, std::vector<std::string>* names,
+                   bool keep_ssml) {
+    out.clear();
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t mark = text.find_first_of(CONTROL_CHARS, pos);
+        if (mark == std::string::npos) {
+            out.append(text, pos, std::string::npos);
+            break;
+        }
+        out.append(text, pos, mark - pos);
+
+        if (text[mark] == SSML_BREAK || text[mark] == SSML_PROSODY) {
+            if (keep_ssml) {
+                out.push_back(text[mark]);
+            }
+            pos = mark + 1;
+            continue;
+        }
+
+        size_t end = text[mark] == MARK_BEGIN ? text.find_first_of(CONTROL_CHARS, mark + 1)
+                                              : std::string::npos;
+        if (end == std::string::npos || text[end] != MARK_END) {
+            pos = mark + 1;
+            continue;
+        }
+
+        out.push_back(MARK_BEGIN);
+        if (names) {
+            names->emplace_back(text, mark + 1, end - mark - 1);
+        }
+        pos = end + 1;
+    }
+}
+
+// =============================================================================
+// Batch Lane
+// =============================================================================
+
+/**
+ * BatchLane - Text front end and working storage of one batch worker.
+ * Dictionaries and phoneme data are shared read-only; everything with
+ * per-call state is owned here.
+ */
+struct BatchLane {
+    PhonemeMapper phoneme_mapper;
+    CroatianNumbers number_converter;
+    InflectionProcessor inflection;
+    SsmlParser ssml_parser;
+    SsmlDocument ssml;
+    std::string text_a;
+    std::string text_b;
+    std::string dictionary_scratch;
+    std::vector<TextSegment> segments;
+    std::vector<PhonemeToken> tokens;
+    AudioBuffer segment_audio;
+    Resampler resampler;
+    SynthesisResult result;
+    SynthesisStats stats;
+};
+
+} // anonymous namespace
+
 // =============================================================================
 // Implementation Structure
 // =============================================================================
@@ -24,9 +343,209 @@ struct TTSEngine::Impl {
     VoiceParams voice_params;
     bool initialized = false;
 
+    // Statistics of the last public synthesis call
+    SynthesisStats last_stats;
+    bool stats_enabled = false;
+    int stats_depth = 0;  // Nesting of public calls (spelling calls synthesize)
+
+    // Cancellation: cancel() bumps the generation, the running call compares
+    std::atomic<uint64_t> cancel_generation{0};
+    uint64_t call_generation = 0;
+
+    // Live parameters: post_param() stores a value under live_mutex and
+    // raises live_posted; the synthesis thread takes them between segments
+    std::mutex live_mutex;
+    float live_values[LIVE_PARAM_COUNT] = {};
+    uint32_t live_pending = 0;  // Bit per LiveParam with a value to apply
+    std::atomic<bool> live_posted{false};
+    bool live_held = false;     // Warm-up has replaced the settings for a moment
+
+    // Working storage reused across calls, so warm synthesis does not allocate
+    std::string text_a;                 // Preprocessing ping-pong buffers
+    std::string text_b;
+    std::string dictionary_scratch;     // Working storage of dictionary.apply()
+    std::vector<TextSegment> segments;  // Only the first segment_text() entries are valid
+    std::vector<PhonemeToken> tokens;
+    AudioBuffer segment_audio;
+    AudioBuffer stream_chunk;
+
+    // Conversion to the output rate, at the end of every output path
+    Resampler resampler;
+    AudioSamples resampled;
+
+    // SSML input: the parsed document of the current call (breaks and
+    // prosody are read while rendering, also by the render workers)
+    bool ssml_enabled = false;
+    SsmlParser ssml_parser;
+    SsmlDocument ssml;
+    std::string ssml_spelled;  // Text of SSML given to synthesize_spelled()
+
+    // Inline marks of the current call: names taken out by preprocessing,
+    // events added as their segments are rendered (offsets at the output rate)
+    std::vector<std::string> mark_names;
+    std::vector<MarkEvent> marks;
+    size_t marks_delivered = 0;    // Marks passed to the stream's mark sink
+    uint64_t native_position = 0;  // Native samples before the next segment
+    uint64_t written = 0;          // Output samples written to the stream
+
+    // Compact output encodings for synthesize_encoded()
+    AudioEncoder encoder;
+    std::vector<uint8_t> encoded;
+
+    // Parallel rendering: worker 0 (the caller) uses synthesizer, worker N
+    // uses worker_synthesizers[N - 1]
+    uint32_t render_threads = 1;
+    std::vector<std::unique_ptr<AudioSynthesizer>> worker_synthesizers;
+    std::vector<SynthesisStats> worker_stats;
+    std::vector<std::vector<PhonemeToken>> segment_tokens;
+    std::vector<AudioBuffer> segment_outputs;
+    std::vector<std::vector<size_t>> segment_marks;  // Mark offsets per segment
+    std::unique_ptr<WorkStealingPool> pool;
+
+    // Batch synthesis, one lane per pool worker
+    std::vector<std::unique_ptr<BatchLane>> batch_lanes;
+
+    // Text front end pipelined with rendering (declared last: stops first)
+    bool lookahead_enabled = true;
+    LookaheadMapper lookahead;
+
     Impl() = default;
+
+    // Statistics sink, or nullptr when collection is disabled
+    SynthesisStats* stats() {
+        return stats_enabled ? &last_stats : nullptr;
+    }
+
+    // Pool and per-worker synthesizers for render_threads, created on first use
+    WorkStealingPool& render_pool() {
+        if (!pool) {
+            pool = std::make_unique<WorkStealingPool>(render_threads);
+            worker_synthesizers.clear();
+            for (uint32_t i = 1; i < render_threads; ++i) {
+                worker_synthesizers.push_back(std::make_unique<AudioSynthesizer>(phoneme_data));
+            }
+            worker_stats.resize(worker_synthesizers.size());
+        }
+        return *pool;
+    }
+
+    // Synthesizer of a pool worker; worker 0 is the calling thread
+    AudioSynthesizer& worker_synthesizer(size_t worker) {
+        return worker == 0 ? *synthesizer : *worker_synthesizers[worker - 1];
+    }
+
+    // Give the worker synthesizers the engine's settings before a job
+    void sync_workers() {
+        for (size_t w = 0; w < worker_synthesizers.size(); ++w) {
+            worker_stats[w] = SynthesisStats{};
+            worker_synthesizers[w]->set_voice_params(synthesizer->voice_params());
+            worker_synthesizers[w]->set_stats(stats_enabled ? &worker_stats[w] : nullptr);
+        }
+    }
+
+    // Mark extraction, emoji, dictionary and number expansion, alternating
+    // between a and b. Batch lanes pass their own buffers so they can run
+    // concurrently, and no mark names (their text is plain).
+    const std::string& preprocess(const std::string& text, CroatianNumbers& numbers,
+                                  std::string& a, std::string& b,
+                                  std::string& dictionary_scratch,
+                                  std::vector<std::string>* mark_names = nullptr) const {
+        const std::string* current = &text;
+        auto next_buffer = [&]() -> std::string& {
+            return current == &a ? b : a;
+        };
+
+        // Step 0: Take out inline marks (SSML controls only stay for the
+        // engine's own calls, which resolve them)
+        if (text.find_first_of(CONTROL_CHARS) != std::string::npos) {
+            std::string& out = next_buffer();
+            extract_marks(*current, out, mark_names, mark_names && ssml_enabled);
+            current = &out;
+        }
+
+        // Step 1: Apply emoji dictionary (if enabled)
+        if (voice_params.emoji_enabled && !emoji_dictionary.empty()) {
+            std::string& out = next_buffer();
+            emoji_dictionary.replace_emojis(*current, out);
+            current = &out;
+        }
+
+        // Step 2: Apply pronunciation dictionary (word-level replacements)
+        if (!dictionary.empty()) {
+            std::string& out = next_buffer();
+            dictionary.apply(*current, out, dictionary_scratch);
+            current = &out;
+        }
+
+        // Step 3: Process numbers based on mode
+        std::string& out = next_buffer();
+        if (voice_params.number_mode == NumberMode::WholeNumbers) {
+            // Expand numbers to words (default behavior)
+            numbers.convert_numbers_in_text(*current, out);
+        } else {
+            // Digit-by-digit mode - convert each digit to its word form separately
+            numbers.convert_digits_in_text(*current, out);
+        }
+
+        return out;
+    }
 };
 
+namespace {
+
+/**
+ * StatsScope - Brackets one public synthesis call.
+ * The outermost scope resets the statistics and records the total time;
+ * nested calls (spelling) accumulate into the outer call's statistics.
+ */
+class StatsScope {
+public:
+    StatsScope(SynthesisStats* stats, int& depth)
+        : m_depth(depth)
+        , m_total(depth == 0 && stats ? &stats->total_ms : nullptr)
+    {
+        if (m_depth++ == 0 && stats) {
+            *stats = SynthesisStats{};
+        }
+    }
+
+    ~StatsScope() {
+        m_total.stop();
+        --m_depth;
+    }
+
+    StatsScope(const StatsScope&) = delete;
+    StatsScope& operator=(const StatsScope&) = delete;
+
+private:
+    int& m_depth;
+    StageTimer m_total;
+};
+
+// Accumulate the counters of a worker into the call's statistics
+void add_stats(SynthesisStats& total, const SynthesisStats& part) {
+    total.preprocess_ms += part.preprocess_ms;
+    total.segment_ms += part.segment_ms;
+    total.map_ms += part.map_ms;
+    total.concatenate_ms += part.concatenate_ms;
+    total.dsp_ms += part.dsp_ms;
+    total.inflection_ms += part.inflection_ms;
+    total.segment_count += part.segment_count;
+    total.phoneme_count += part.phoneme_count;
+    total.output_samples += part.output_samples;
+    total.peak_buffer_bytes = std::max(total.peak_buffer_bytes, part.peak_buffer_bytes);
+}
+
+// Track the largest audio working set seen during a call
+void note_buffer_bytes(SynthesisStats* stats, size_t samples) {
+    if (stats) {
+        stats->peak_buffer_bytes = std::max<uint64_t>(stats->peak_buffer_bytes,
+                                                        samples * sizeof(AudioSample));
+    }
+}
+
+} // anonymous namespace
+
 // =============================================================================
 // Constructor / Destructor
 // =============================================================================
@@ -34,6 +553,7 @@ struct TTSEngine::Impl {
 TTSEngine::TTSEngine()
     : m_impl(std::make_unique<Impl>())
 {
+    trace::open_from_environment();
 }
 
 TTSEngine::~TTSEngine() = default;
@@ -52,6 +572,7 @@ bool TTSEngine::initialize(const std::string& phoneme_path,
         m_impl = std::make_unique<Impl>();
     }
 
+    trace::Scope trace_scope("engine", "initialize");
     m_impl->initialized = false;
 
     // Determine if path is a directory or file
@@ -77,6 +598,8 @@ bool TTSEngine::initialize(const std::string& phoneme_path,
     // Create synthesizer
     m_impl->synthesizer = std::make_unique<AudioSynthesizer>(m_impl->phoneme_data);
     m_impl->synthesizer->set_voice_params(m_impl->voice_params);
+    m_impl->synthesizer->set_stats(m_impl->stats());
+    m_impl->pool.reset();
 
     m_impl->initialized = true;
     return true;
@@ -92,6 +615,7 @@ bool TTSEngine::initialize_from_memory(const uint8_t* data, size_t size,
         m_impl = std::make_unique<Impl>();
     }
 
+    trace::Scope trace_scope("engine", "initialize_from_memory");
     m_impl->initialized = false;
 
     if (!data || size == 0) {
@@ -105,11 +629,64 @@ bool TTSEngine::initialize_from_memory(const uint8_t* data, size_t size,
     // Create synthesizer
     m_impl->synthesizer = std::make_unique<AudioSynthesizer>(m_impl->phoneme_data);
     m_impl->synthesizer->set_voice_params(m_impl->voice_params);
+    m_impl->synthesizer->set_stats(m_impl->stats());
+    m_impl->pool.reset();
 
     m_impl->initialized = true;
     return true;
 }
 
+bool TTSEngine::initialize_from_memory_nocopy(const uint8_t* data, size_t size,
+                                              span<const uint8_t> key) {
+    if (!m_impl) {
+        m_impl = std::make_unique<Impl>();
+    }
+
+    trace::Scope trace_scope("engine", "initialize_from_memory_nocopy");
+    m_impl->initialized = false;
+
+    if (!data || size == 0) {
+        return false;
+    }
+
+    if (!m_impl->phoneme_data.load_from_memory_nocopy(data, size, key)) {
+        return false;
+    }
+
+    // Create synthesizer
+    m_impl->synthesizer = std::make_unique<AudioSynthesizer>(m_impl->phoneme_data);
+    m_impl->synthesizer->set_voice_params(m_impl->voice_params);
+    m_impl->synthesizer->set_stats(m_impl->stats());
+    m_impl->pool.reset();
+
+    m_impl->initialized = true;
+    return true;
+}
+
+// =============================================================================
+// Lazy Loading
+// =============================================================================
+
+void TTSEngine::set_lazy_loading(bool enabled) {
+    if (m_impl) {
+        m_impl->phoneme_data.set_lazy(enabled);
+    }
+}
+
+bool TTSEngine::lazy_loading() const {
+    return m_impl && m_impl->phoneme_data.is_lazy();
+}
+
+void TTSEngine::set_checksum_verification(bool enabled) {
+    if (m_impl) {
+        m_impl->phoneme_data.set_verify_checksum(enabled);
+    }
+}
+
+bool TTSEngine::checksum_verification() const {
+    return m_impl && m_impl->phoneme_data.verifies_checksum();
+}
+
 // =============================================================================
 // Is Initialized
 // =============================================================================
@@ -124,27 +701,53 @@ bool TTSEngine::is_initialized() const {
 
 SynthesisResult TTSEngine::synthesize(const std::string& text) {
     SynthesisResult result;
+    synthesize(text, result);
+    return result;
+}
+
+bool TTSEngine::synthesize(const std::string& text, SynthesisResult& result) {
+    result.audio.samples.clear();
+    result.marks.clear();
+    result.error_message.clear();
+    result.cancelled = false;
 
     if (!is_initialized()) {
         result.success = false;
         result.error_message = "Engine not initialized";
-        return result;
+        return false;
     }
 
+    begin_call();
+    StatsScope stats_scope(m_impl->stats(), m_impl->stats_depth);
+    trace::Scope trace_scope("engine", "synthesize");
+
     if (text.empty()) {
         result.success = true;  // Empty text is valid, just produces no audio
-        return result;
+        return true;
     }
 
     try {
         // Step 1: Preprocess text (expand numbers, normalize)
-        std::string processed = preprocess_text(text);
+        const std::string& processed = preprocess_text(text);
 
         // Step 2: Segment text by punctuation
-        std::vector<TextSegment> segments = segment_text(processed);
+        size_t segment_count = segment_text(processed);
 
         // Step 3: Synthesize each segment with inflection
-        result.audio = synthesize_segments(segments);
+        if (!synthesize_segments(segment_count, result.audio)) {
+            result.audio.samples.clear();
+            result.success = false;
+            result.cancelled = true;
+            result.error_message = "Synthesis cancelled";
+            return false;
+        }
+
+        resample_output(result.audio);
+        result.marks = m_impl->marks;
+
+        if (SynthesisStats* stats = m_impl->stats()) {
+            stats->output_samples += result.audio.samples.size();
+        }
 
         result.success = true;
     } catch (const std::exception& e) {
@@ -152,7 +755,7 @@ SynthesisResult TTSEngine::synthesize(const std::string& text) {
         result.error_message = e.what();
     }
 
-    return result;
+    return result.success;
 }
 
 // =============================================================================
@@ -162,7 +765,8 @@ SynthesisResult TTSEngine::synthesize(const std::string& text) {
 SynthesisResult TTSEngine::synthesize_streaming(
     const std::string& text,
     std::function<void(const AudioBuffer&)> callback,
-    uint32_t chunk_ms) {
+    uint32_t chunk_ms,
+    const MarkSink& on_mark) {
 
     SynthesisResult result;
 
@@ -178,35 +782,151 @@ SynthesisResult TTSEngine::synthesize_streaming(
         return result;
     }
 
+    begin_call();
+    StatsScope stats_scope(m_impl->stats(), m_impl->stats_depth);
+    trace::Scope trace_scope("engine", "synthesize_streaming");
+
     if (text.empty()) {
         result.success = true;
         return result;
     }
 
-    try {
-        // Set up streaming callback
-        m_impl->synthesizer->set_stream_callback(callback, chunk_ms);
+    // Chunks are copied into an AudioBuffer for the callback
+    const uint32_t rate = m_impl->voice_params.output_rate;
+    AudioBuffer& chunk = m_impl->stream_chunk;
+    chunk.sample_rate = rate;
+    chunk.bits_per_sample = BITS_PER_SAMPLE;
+    chunk.channels = NUM_CHANNELS;
+    SampleSink sink = [&chunk, &callback](const AudioSample* samples, size_t count) {
+        chunk.samples.assign(samples, samples + count);
+        callback(chunk);
+    };
+
+    // Each segment is streamed once inflection and voice DSP are applied
+    uint64_t chunk_samples = static_cast<uint64_t>(rate) * chunk_ms / 1000;
+    StreamTarget stream{sink, static_cast<size_t>(std::max<uint64_t>(chunk_samples, 1)),
+                        true, StageTimer::Clock::now(), rate != SAMPLE_RATE,
+                        on_mark ? &on_mark : nullptr};
+    stream_text(text, stream, result);
+    return result;
+}
+
+// =============================================================================
+// Synthesize to Sink
+// =============================================================================
+
+SynthesisResult TTSEngine::synthesize_to_sink(const std::string& text, const SampleSink& sink,
+                                              const MarkSink& on_mark) {
+    SynthesisResult result;
+    result.audio.sample_rate = m_impl ? m_impl->voice_params.output_rate : SAMPLE_RATE;
+    result.audio.bits_per_sample = BITS_PER_SAMPLE;
+    result.audio.channels = NUM_CHANNELS;
+
+    if (!is_initialized()) {
+        result.success = false;
+        result.error_message = "Engine not initialized";
+        return result;
+    }
+
+    if (!sink) {
+        result.success = false;
+        result.error_message = "No sink provided";
+        return result;
+    }
+
+    begin_call();
+    StatsScope stats_scope(m_impl->stats(), m_impl->stats_depth);
+    trace::Scope trace_scope("engine", "synthesize_to_sink");
+
+    if (text.empty()) {
+        result.success = true;
+        return result;
+    }
 
+    // Whole segments, rendered in parallel when render threads are set
+    StreamTarget stream{sink, 0, false, StageTimer::Clock::now(),
+                        result.audio.sample_rate != SAMPLE_RATE, on_mark ? &on_mark : nullptr};
+    stream_text(text, stream, result);
+    return result;
+}
+
+SynthesisResult TTSEngine::synthesize_encoded(const std::string& text, OutputEncoding encoding,
+                                              const ByteSink& sink, uint64_t* sample_count) {
+    if (sample_count) {
+        *sample_count = 0;
+    }
+    if (!is_initialized() || !sink) {
+        // synthesize_to_sink() reports the error
+        return synthesize_to_sink(text, nullptr);
+    }
+
+    AudioEncoder& encoder = m_impl->encoder;
+    std::vector<uint8_t>& encoded = m_impl->encoded;
+    encoder.reset(encoding);
+
+    SynthesisResult result = synthesize_to_sink(text,
+        [&encoder, &encoded, &sink](const AudioSample* samples, size_t count) {
+            encoded.clear();
+            encoder.encode(samples, count, encoded);
+            if (!encoded.empty()) {
+                sink(encoded.data(), encoded.size());
+            }
+        });
+
+    uint64_t encoded_samples = encoder.samples_encoded();
+    if (result.success) {
+        encoded.clear();
+        encoder.flush(encoded);
+        if (!encoded.empty()) {
+            sink(encoded.data(), encoded.size());
+        }
+    }
+    if (sample_count) {
+        *sample_count = encoded_samples;
+    }
+    return result;
+}
+
+void TTSEngine::stream_text(const std::string& text, const StreamTarget& stream,
+                            SynthesisResult& result) {
+    try {
         // Step 1: Preprocess text
-        std::string processed = preprocess_text(text);
+        const std::string& processed = preprocess_text(text);
 
         // Step 2: Segment text
-        std::vector<TextSegment> segments = segment_text(processed);
+        size_t segment_count = segment_text(processed);
 
-        // Step 3: Synthesize (will stream via callback)
-        result.audio = synthesize_segments(segments);
+        // Step 3: Synthesize (written to the stream, result.audio stays empty)
+        if (stream.resample) {
+            m_impl->resampler.configure(SAMPLE_RATE, m_impl->voice_params.output_rate);
+        }
+        bool completed = synthesize_segments(segment_count, result.audio, &stream);
+
+        // Write out what the resampler still holds
+        if (completed && stream.resample) {
+            AudioSamples& tail = m_impl->resampled;
+            tail.clear();
+            m_impl->resampler.flush(tail);
+            completed = write_chunks(stream, tail);
+        }
 
-        // Clear callback
-        m_impl->synthesizer->clear_stream_callback();
+        if (!completed) {
+            result.success = false;
+            result.cancelled = true;
+            result.error_message = "Synthesis cancelled";
+            return;
+        }
 
+        // Marks at the very end follow the last sample
+        if (stream.marks) {
+            deliver_marks(stream, std::numeric_limits<uint64_t>::max());
+        }
+        result.marks = m_impl->marks;
         result.success = true;
     } catch (const std::exception& e) {
-        m_impl->synthesizer->clear_stream_callback();
         result.success = false;
         result.error_message = e.what();
     }
-
-    return result;
 }
 
 // =============================================================================
@@ -214,6 +934,16 @@ SynthesisResult TTSEngine::synthesize_streaming(
 // =============================================================================
 
 void TTSEngine::set_voice_params(const VoiceParams& params) {
+    if (m_impl) {
+        // Values posted earlier and not yet applied are superseded
+        std::lock_guard<std::mutex> lock(m_impl->live_mutex);
+        m_impl->live_pending = 0;
+        m_impl->live_posted.store(false, std::memory_order_relaxed);
+    }
+    store_voice_params(params);
+}
+
+void TTSEngine::store_voice_params(const VoiceParams& params) {
     if (m_impl) {
         m_impl->voice_params = params;
         m_impl->voice_params.clamp();
@@ -250,6 +980,18 @@ uint32_t TTSEngine::sample_rate() const {
     return SAMPLE_RATE;
 }
 
+bool TTSEngine::set_output_rate(uint32_t rate) {
+    if (!m_impl || !is_output_rate(rate)) {
+        return false;
+    }
+    m_impl->voice_params.output_rate = rate;
+    return true;
+}
+
+uint32_t TTSEngine::output_rate() const {
+    return m_impl ? m_impl->voice_params.output_rate : SAMPLE_RATE;
+}
+
 size_t TTSEngine::memory_usage() const {
     if (m_impl) {
         return m_impl->phoneme_data.memory_usage();
@@ -258,92 +1000,483 @@ size_t TTSEngine::memory_usage() const {
 }
 
 // =============================================================================
-// Preprocess Text
+// Cancellation
 // =============================================================================
 
-std::string TTSEngine::preprocess_text(const std::string& text) {
-    std::string result = text;
+void TTSEngine::cancel() {
+    if (m_impl) {
+        m_impl->cancel_generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+}
 
-    // Step 1: Apply emoji dictionary (if enabled)
-    if (m_impl->voice_params.emoji_enabled && !m_impl->emoji_dictionary.empty()) {
-        result = m_impl->emoji_dictionary.replace_emojis(result);
+void TTSEngine::begin_call() {
+    // Nested calls (spelling) belong to the outer call's generation
+    if (m_impl->stats_depth == 0) {
+        m_impl->call_generation = m_impl->cancel_generation.load(std::memory_order_acquire);
     }
+    apply_posted_params();
+}
 
-    // Step 2: Apply pronunciation dictionary (word-level replacements)
-    if (!m_impl->dictionary.empty()) {
-        result = m_impl->dictionary.apply(result);
+bool TTSEngine::cancel_requested() const {
+    return m_impl->cancel_generation.load(std::memory_order_acquire) != m_impl->call_generation;
+}
+
+// =============================================================================
+// Live Parameters
+// =============================================================================
+
+void TTSEngine::post_param(LiveParam param, float value) {
+    size_t index = static_cast<size_t>(param);
+    if (!m_impl || index >= LIVE_PARAM_COUNT) {
+        return;
     }
+    std::lock_guard<std::mutex> lock(m_impl->live_mutex);
+    m_impl->live_values[index] = value;
+    m_impl->live_pending |= 1u << index;
+    m_impl->live_posted.store(true, std::memory_order_release);
+}
 
-    // Step 3: Process numbers based on mode
-    if (m_impl->voice_params.number_mode == NumberMode::WholeNumbers) {
-        // Expand numbers to words (default behavior)
-        result = m_impl->number_converter.convert_numbers_in_text(result);
-    } else {
-        // Digit-by-digit mode - convert each digit to its word form separately
-        result = m_impl->number_converter.convert_digits_in_text(result);
+void TTSEngine::apply_posted_params() {
+    Impl& impl = *m_impl;
+    if (impl.live_held || !impl.live_posted.load(std::memory_order_acquire)) {
+        return;
     }
 
-    return result;
+    float values[LIVE_PARAM_COUNT];
+    uint32_t pending;
+    {
+        std::lock_guard<std::mutex> lock(impl.live_mutex);
+        std::copy(impl.live_values, impl.live_values + LIVE_PARAM_COUNT, values);
+        pending = impl.live_pending;
+        impl.live_pending = 0;
+        impl.live_posted.store(false, std::memory_order_relaxed);
+    }
+
+    VoiceParams& params = impl.voice_params;
+    float* fields[LIVE_PARAM_COUNT] = {&params.speed, &params.pitch, &params.user_pitch,
+                                       &params.volume};
+    for (size_t i = 0; i < LIVE_PARAM_COUNT; ++i) {
+        if (pending & (1u << i)) {
+            *fields[i] = values[i];
+        }
+    }
+    params.clamp();
+
+    // Only the settings change; the synthesizer keeps its buffers
+    if (impl.synthesizer) {
+        impl.synthesizer->set_voice_params(params);
+    }
+}
+
+// =============================================================================
+// Preprocess Text
+// =============================================================================
+
+const std::string& TTSEngine::preprocess_text(const std::string& text) {
+    SynthesisStats* stats = m_impl->stats();
+    StageTimer timer(stats ? &stats->preprocess_ms : nullptr);
+    trace::Scope trace_scope("engine", "preprocess_text");
+
+    Impl& impl = *m_impl;
+    const std::string* input = &text;
+    if (impl.ssml_enabled) {
+        SsmlOptions options;
+        options.spelling = &impl.spelling_dictionary;
+        options.spelling_pause_ms = impl.voice_params.pause_settings.spelling_pause_ms;
+        impl.ssml_parser.parse(text, impl.ssml, options);
+        input = &impl.ssml.text;
+    }
+
+    // Each step reads the current text and writes the other scratch buffer
+    impl.mark_names.clear();
+    return impl.preprocess(*input, impl.number_converter, impl.text_a, impl.text_b,
+                           impl.dictionary_scratch, &impl.mark_names);
 }
 
 // =============================================================================
 // Segment Text
 // =============================================================================
 
-std::vector<TextSegment> TTSEngine::segment_text(const std::string& processed_text) {
+size_t TTSEngine::segment_text(const std::string& processed_text) {
+    SynthesisStats* stats = m_impl->stats();
+    StageTimer timer(stats ? &stats->segment_ms : nullptr);
+    trace::Scope trace_scope("engine", "segment_text");
+
     // Use inflection processor to analyze and segment text
-    return m_impl->inflection.analyze_text(processed_text);
+    size_t segment_count = m_impl->inflection.analyze_text(
+        processed_text, m_impl->segments, m_impl->ssml_enabled ? &m_impl->ssml.breaks : nullptr);
+
+    if (stats) {
+        stats->segment_count += static_cast<uint32_t>(segment_count);
+    }
+    return segment_count;
 }
 
 // =============================================================================
 // Synthesize Segments
 // =============================================================================
 
-AudioBuffer TTSEngine::synthesize_segments(const std::vector<TextSegment>& segments) {
-    AudioBuffer result;
+bool TTSEngine::synthesize_segments(size_t segment_count, AudioBuffer& result,
+                                    const StreamTarget* stream) {
     result.sample_rate = SAMPLE_RATE;
     result.bits_per_sample = BITS_PER_SAMPLE;
     result.channels = NUM_CHANNELS;
+    result.samples.clear();
+
+    Impl& impl = *m_impl;
+    impl.marks.clear();
+    impl.marks_delivered = 0;
+    impl.native_position = 0;
+    impl.written = 0;
+
+    if ((!stream || !stream->incremental) && segment_count > 1 && m_impl->render_threads > 1) {
+        return synthesize_segments_parallel(segment_count, result, stream);
+    }
+
+    // Single segments gain nothing from a hand-off to the helper thread
+    if (segment_count > 1 && m_impl->lookahead_enabled && LookaheadMapper::available()) {
+        return synthesize_segments_lookahead(segment_count, result, stream);
+    }
 
-    for (const auto& segment : segments) {
-        if (segment.text.empty()) {
+    SynthesisStats* stats = m_impl->stats();
+    std::vector<PhonemeToken>& tokens = m_impl->tokens;
+
+    for (size_t i = 0; i < segment_count; ++i) {
+        if (cancel_requested()) {
+            return false;
+        }
+        apply_posted_params();
+
+        const TextSegment& segment = m_impl->segments[i];
+        if (segment.text.empty() && segment.break_ms == 0) {
             continue;
         }
 
-        // Convert UTF-32 segment text back to UTF-8 for phoneme mapping
-        std::string utf8_text = PhonemeMapper::utf32_to_utf8(segment.text);
+        trace::Scope segment_trace("engine", "segment");
+        StageTimer map_timer(stats ? &stats->map_ms : nullptr);
 
-        // Map text to phonemes
-        std::vector<PhonemeToken> tokens = m_impl->phoneme_mapper.map_text(utf8_text);
+        // Map text to phonemes (directly from the UTF-32 segment text)
+        {
+            trace::Scope map_trace("engine", "map_text");
+            m_impl->phoneme_mapper.map_text(segment.text, tokens);
+        }
 
-        if (tokens.empty()) {
+        map_timer.stop();
+
+        if (tokens.empty() && segment.break_ms == 0) {
             continue;
         }
 
-        // Synthesize this segment with inflection
-        AudioBuffer segment_audio;
+        segment_trace.set_arg("phonemes", static_cast<int64_t>(tokens.size()));
+
+        if (!render_segment(segment, tokens, result, stream)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool TTSEngine::synthesize_segments_lookahead(size_t segment_count, AudioBuffer& result,
+                                              const StreamTarget* stream) {
+    SynthesisStats* stats = m_impl->stats();
+    LookaheadMapper& lookahead = m_impl->lookahead;
+
+    // The helper owns the phoneme mapper until finish()
+    lookahead.start(m_impl->phoneme_mapper, m_impl->segments, segment_count,
+                    stats ? &stats->map_ms : nullptr);
+    LookaheadMapper::Job job(lookahead);
+
+    for (;;) {
+        const LookaheadMapper::Item& item = lookahead.next();
+        if (item.index >= segment_count) {
+            break;  // End of text (rethrows a mapping error)
+        }
+
+        if (cancel_requested()) {
+            return false;
+        }
+        apply_posted_params();
+
+        if (!item.tokens.empty() || m_impl->segments[item.index].break_ms > 0) {
+            trace::Scope segment_trace("engine", "segment");
+            segment_trace.set_arg("phonemes", static_cast<int64_t>(item.tokens.size()));
+
+            if (!render_segment(m_impl->segments[item.index], item.tokens, result, stream)) {
+                return false;
+            }
+        }
+
+        lookahead.release();
+    }
+
+    return true;
+}
+
+bool TTSEngine::synthesize_segments_parallel(size_t segment_count, AudioBuffer& result,
+                                             const StreamTarget* stream) {
+    Impl& impl = *m_impl;
+    SynthesisStats* stats = impl.stats();
+    WorkStealingPool& pool = impl.render_pool();
+
+    if (impl.segment_tokens.size() < segment_count) {
+        impl.segment_tokens.resize(segment_count);
+        impl.segment_outputs.resize(segment_count);
+        impl.segment_marks.resize(segment_count);
+    }
+
+    // Map everything up front; mapping is cheap next to rendering
+    {
+        StageTimer map_timer(stats ? &stats->map_ms : nullptr);
+        trace::Scope map_trace("engine", "map_text");
+        for (size_t i = 0; i < segment_count; ++i) {
+            const TextSegment& segment = impl.segments[i];
+            if (segment.text.empty()) {
+                impl.segment_tokens[i].clear();
+            } else {
+                impl.phoneme_mapper.map_text(segment.text, impl.segment_tokens[i]);
+            }
+        }
+    }
+
+    // Workers render with the same settings as the engine's own synthesizer;
+    // segments render out of order, so later posted values wait for the next call
+    apply_posted_params();
+    impl.sync_workers();
+
+    std::atomic<bool> cancelled{false};
+    pool.run(segment_count, [&](size_t i, size_t worker) {
+        AudioBuffer& output = impl.segment_outputs[i];
+        output.samples.clear();
+
+        const std::vector<PhonemeToken>& tokens = impl.segment_tokens[i];
+        if ((tokens.empty() && impl.segments[i].break_ms == 0) ||
+            cancelled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        if (cancel_requested()) {
+            cancelled.store(true, std::memory_order_relaxed);
+            return;
+        }
+
+        trace::Scope segment_trace("engine", "segment");
+        segment_trace.set_arg("phonemes", static_cast<int64_t>(tokens.size()));
+
+        AudioSynthesizer& synthesizer = impl.worker_synthesizer(worker);
+        render_audio(synthesizer, impl.segments[i], tokens, output);
+        if (impl.segments[i].marks > 0) {
+            impl.segment_marks[i] = synthesizer.mark_offsets();
+        }
+    });
+
+    if (cancelled.load(std::memory_order_relaxed) || cancel_requested()) {
+        return false;
+    }
 
-        if (m_impl->voice_params.inflection_enabled) {
-            segment_audio = m_impl->synthesizer->synthesize_segment(segment, tokens);
+    // Reassemble (or write out) in text order
+    size_t total_samples = 0;
+    size_t held_samples = 0;
+    for (size_t i = 0; i < segment_count; ++i) {
+        total_samples += impl.segment_outputs[i].samples.size();
+        held_samples += impl.segment_outputs[i].samples.capacity();
+    }
+    if (!stream) {
+        result.samples.reserve(total_samples);
+    }
+    for (size_t i = 0; i < segment_count; ++i) {
+        if (impl.segments[i].marks > 0) {
+            reach_marks(impl.segments[i], impl.segment_marks[i]);
+        }
+        const AudioBuffer& output = impl.segment_outputs[i];
+        if (stream) {
+            if (!write_stream(*stream, output.samples)) {
+                return false;
+            }
         } else {
-            // No inflection, just synthesize raw
-            segment_audio = m_impl->synthesizer->synthesize(tokens);
-
-            // Still add pause for punctuation
-            if (segment.trailing_punct != Punctuation::NONE) {
-                uint32_t pause_ms = m_impl->inflection.get_pause_duration(
-                    segment.trailing_punct);
-                if (pause_ms > 0) {
-                    segment_audio.append_silence(pause_ms);
-                }
+            result.append(output);
+        }
+        impl.native_position += output.samples.size();
+    }
+
+    if (stats) {
+        // Stage times are summed over workers (CPU time, not wall time)
+        for (const SynthesisStats& worker_stats : impl.worker_stats) {
+            add_stats(*stats, worker_stats);
+        }
+        for (size_t i = 0; i < segment_count; ++i) {
+            stats->phoneme_count += static_cast<uint32_t>(impl.segment_tokens[i].size());
+        }
+        note_buffer_bytes(stats, result.samples.capacity() + held_samples);
+    }
+
+    return true;
+}
+
+void TTSEngine::render_audio(AudioSynthesizer& synthesizer, const TextSegment& segment,
+                             const std::vector<PhonemeToken>& tokens,
+                             AudioBuffer& output) const {
+    // SSML prosody scales the synthesizer's settings for this segment only
+    const std::vector<SsmlProsody>& prosody_table = m_impl->ssml.prosody;
+    const bool prosody = segment.prosody > 0 && segment.prosody < prosody_table.size();
+    VoiceParams saved_params;
+    if (prosody) {
+        const SsmlProsody& scale = prosody_table[segment.prosody];
+        saved_params = synthesizer.voice_params();
+        VoiceParams params = saved_params;
+        params.speed *= scale.rate;
+        params.user_pitch *= scale.pitch;
+        params.volume *= scale.volume;
+        synthesizer.set_voice_params(params);
+    }
+
+    // Synthesize this segment with inflection
+    if (tokens.empty()) {
+        output.sample_rate = SAMPLE_RATE;
+        output.samples.clear();  // Only an SSML break
+    } else if (m_impl->voice_params.inflection_enabled) {
+        synthesizer.synthesize_segment(segment, tokens, output);
+    } else {
+        // No inflection, just synthesize raw
+        synthesizer.synthesize(tokens, output);
+
+        // Still add pause for punctuation
+        if (segment.trailing_punct != Punctuation::NONE) {
+            uint32_t pause_ms = m_impl->inflection.get_pause_duration(
+                segment.trailing_punct);
+            if (pause_ms > 0) {
+                output.append_silence(pause_ms);
             }
         }
+    }
 
+    if (segment.break_ms > 0) {
+        output.append_silence(segment.break_ms);
+    }
+    if (prosody) {
+        synthesizer.set_voice_params(saved_params);
+    }
+}
+
+bool TTSEngine::render_segment(const TextSegment& segment,
+                               const std::vector<PhonemeToken>& tokens,
+                               AudioBuffer& result, const StreamTarget* stream) {
+    SynthesisStats* stats = m_impl->stats();
+    AudioBuffer& segment_audio = m_impl->segment_audio;
+
+    if (stats) {
+        stats->phoneme_count += static_cast<uint32_t>(tokens.size());
+    }
+
+    render_audio(*m_impl->synthesizer, segment, tokens, segment_audio);
+    if (segment.marks > 0) {
+        reach_marks(segment, m_impl->synthesizer->mark_offsets());
+    }
+    m_impl->native_position += segment_audio.samples.size();
+
+    if (!stream) {
         // Append to result
         result.append(segment_audio);
+        note_buffer_bytes(stats, result.samples.capacity() + segment_audio.samples.capacity());
+        return true;
     }
 
-    return result;
+    // Deliver the finished segment in chunks
+    note_buffer_bytes(stats, segment_audio.samples.capacity());
+    return write_stream(*stream, segment_audio.samples);
+}
+
+bool TTSEngine::write_stream(const StreamTarget& stream, const AudioSamples& samples) {
+    if (!stream.resample) {
+        return write_chunks(stream, samples);
+    }
+
+    // Convert as the audio leaves the engine; the resampler carries its
+    // state from segment to segment
+    AudioSamples& converted = m_impl->resampled;
+    converted.clear();
+    {
+        SynthesisStats* stats = m_impl->stats();
+        StageTimer timer(stats ? &stats->dsp_ms : nullptr);
+        trace::Scope trace_scope("engine", "resample");
+        m_impl->resampler.process(samples.data(), samples.size(), converted);
+    }
+    return write_chunks(stream, converted);
+}
+
+bool TTSEngine::write_chunks(const StreamTarget& stream, const AudioSamples& samples) {
+    Impl& impl = *m_impl;
+    SynthesisStats* stats = impl.stats();
+    size_t chunk_samples = stream.chunk_samples ? stream.chunk_samples : samples.size();
+
+    size_t offset = 0;
+    while (offset < samples.size()) {
+        size_t count = std::min(chunk_samples, samples.size() - offset);
+
+        // Marks due here go first; a chunk running past the next one ends at it
+        if (stream.marks) {
+            deliver_marks(stream, impl.written);
+            if (impl.marks_delivered < impl.marks.size()) {
+                uint64_t next = impl.marks[impl.marks_delivered].sample_offset;
+                count = static_cast<size_t>(std::min<uint64_t>(count, next - impl.written));
+            }
+        }
+
+        // Count written audio and time the first chunk when collecting stats
+        if (stats) {
+            if (stats->output_samples == 0) {
+                stats->first_chunk_ms = StageTimer::elapsed_ms(stream.start);
+            }
+            stats->output_samples += count;
+        }
+
+        stream.sink(samples.data() + offset, count);
+        impl.written += count;
+        offset += count;
+
+        if (cancel_requested()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void TTSEngine::reach_marks(const TextSegment& segment, const std::vector<size_t>& offsets) {
+    Impl& impl = *m_impl;
+    const uint64_t rate = impl.voice_params.output_rate;
+
+    for (uint32_t k = 0; k < segment.marks && impl.marks.size() < impl.mark_names.size(); ++k) {
+        MarkEvent event;
+        event.name = std::move(impl.mark_names[impl.marks.size()]);
+        // First output sample at or after the mark's position in the
+        // segment; the resampler puts output n at input time
+        // n * SAMPLE_RATE / rate
+        uint64_t position = impl.native_position + (k < offsets.size() ? offsets[k] : 0);
+        event.sample_offset = (position * rate + SAMPLE_RATE - 1) / SAMPLE_RATE;
+        impl.marks.push_back(std::move(event));
+    }
+}
+
+void TTSEngine::deliver_marks(const StreamTarget& stream, uint64_t position) {
+    Impl& impl = *m_impl;
+    while (impl.marks_delivered < impl.marks.size() &&
+           impl.marks[impl.marks_delivered].sample_offset <= position) {
+        (*stream.marks)(impl.marks[impl.marks_delivered++]);
+    }
+}
+
+void TTSEngine::resample_output(AudioBuffer& audio) {
+    const uint32_t rate = m_impl->voice_params.output_rate;
+    if (audio.sample_rate == rate) {
+        return;
+    }
+
+    SynthesisStats* stats = m_impl->stats();
+    StageTimer timer(stats ? &stats->dsp_ms : nullptr);
+    trace::Scope trace_scope("engine", "resample");
+
+    m_impl->resampler.configure(audio.sample_rate, rate);
+    m_impl->resampler.convert(audio);
 }
 
 // =============================================================================
@@ -424,9 +1557,26 @@ SynthesisResult TTSEngine::synthesize_spelled(const std::string& text) {
         return result;
     }
 
-    if (text.empty()) {
+    begin_call();
+    StatsScope stats_scope(m_impl->stats(), m_impl->stats_depth);
+    trace::Scope trace_scope("engine", "synthesize_spelled");
+
+    // SSML input is spelled as its text; each character is then
+    // synthesized on its own, reusing the parser, so keep a copy
+    if (m_impl->ssml_enabled) {
+        SsmlOptions options;
+        options.text_only = true;
+        m_impl->ssml_parser.parse(text, m_impl->ssml, options);
+        m_impl->ssml_spelled = m_impl->ssml.text;
+    }
+    const std::string& letters = m_impl->ssml_enabled ? m_impl->ssml_spelled : text;
+
+    // Characters come back at the output rate, so the pauses use it too
+    const uint32_t rate = m_impl->voice_params.output_rate;
+
+    if (letters.empty()) {
         result.success = true;
-        result.audio.sample_rate = SAMPLE_RATE;
+        result.audio.sample_rate = rate;
         result.audio.bits_per_sample = BITS_PER_SAMPLE;
         result.audio.channels = NUM_CHANNELS;
         return result;
@@ -436,8 +1586,8 @@ SynthesisResult TTSEngine::synthesize_spelled(const std::string& text) {
     // No pause needed for single char
     size_t char_count = 0;
     size_t pos = 0;
-    while (pos < text.size()) {
-        unsigned char c = text[pos];
+    while (pos < letters.size()) {
+        unsigned char c = letters[pos];
         size_t char_len = 1;
         if ((c & 0x80) == 0) char_len = 1;
         else if ((c & 0xE0) == 0xC0) char_len = 2;
@@ -454,40 +1604,43 @@ SynthesisResult TTSEngine::synthesize_spelled(const std::string& text) {
         // Single character - add trailing pause for spacing between sequential spell calls
         std::string pronunciation;
         if (!m_impl->spelling_dictionary.empty()) {
-            pronunciation = m_impl->spelling_dictionary.get_pronunciation(text);
+            pronunciation = m_impl->spelling_dictionary.get_pronunciation(letters);
         } else {
-            pronunciation = text;
+            pronunciation = letters;
         }
         SynthesisResult char_result = synthesize(pronunciation);
         if (char_result.success && spelling_pause_ms > 0) {
             // Add configurable trailing silence for pause between spelled characters
-            const size_t pause_samples = static_cast<size_t>(SAMPLE_RATE * spelling_pause_ms / 1000);
+            const size_t pause_samples = static_cast<size_t>(rate * spelling_pause_ms / 1000);
             char_result.audio.samples.resize(char_result.audio.samples.size() + pause_samples, 0);
         }
+        if (SynthesisStats* stats = m_impl->stats()) {
+            stats->output_samples = char_result.audio.samples.size();
+        }
         return char_result;
     }
 
     // Multiple characters - synthesize each with pause between
-    result.audio.sample_rate = SAMPLE_RATE;
+    result.audio.sample_rate = rate;
     result.audio.bits_per_sample = BITS_PER_SAMPLE;
     result.audio.channels = NUM_CHANNELS;
 
     // Pause duration: configurable spelling pause
-    const size_t pause_samples = static_cast<size_t>(SAMPLE_RATE * spelling_pause_ms / 1000);
+    const size_t pause_samples = static_cast<size_t>(rate * spelling_pause_ms / 1000);
     std::vector<AudioSample> silence(pause_samples, 0);
 
     pos = 0;
     bool first = true;
-    while (pos < text.size()) {
+    while (pos < letters.size()) {
         // Extract UTF-8 character
-        unsigned char c = text[pos];
+        unsigned char c = letters[pos];
         size_t char_len = 1;
         if ((c & 0x80) == 0) char_len = 1;
         else if ((c & 0xE0) == 0xC0) char_len = 2;
         else if ((c & 0xF0) == 0xE0) char_len = 3;
         else if ((c & 0xF8) == 0xF0) char_len = 4;
 
-        std::string character = text.substr(pos, char_len);
+        std::string character = letters.substr(pos, char_len);
         pos += char_len;
 
         // Get pronunciation
@@ -500,6 +1653,9 @@ SynthesisResult TTSEngine::synthesize_spelled(const std::string& text) {
 
         // Synthesize this character's pronunciation
         SynthesisResult char_result = synthesize(pronunciation);
+        if (char_result.cancelled) {
+            return char_result;
+        }
         if (!char_result.success) {
             continue;  // Skip failed characters
         }
@@ -520,6 +1676,12 @@ SynthesisResult TTSEngine::synthesize_spelled(const std::string& text) {
             char_result.audio.samples.begin(),
             char_result.audio.samples.end()
         );
+        note_buffer_bytes(m_impl->stats(),
+                          result.audio.samples.capacity() + char_result.audio.samples.capacity());
+    }
+
+    if (SynthesisStats* stats = m_impl->stats()) {
+        stats->output_samples = result.audio.samples.size();
     }
 
     result.success = !result.audio.samples.empty();
@@ -642,4 +1804,305 @@ NumberMode TTSEngine::number_mode() const {
     return NumberMode::WholeNumbers;
 }
 
+// =============================================================================
+// Synthesis Statistics
+// =============================================================================
+
+void TTSEngine::set_stats_enabled(bool enabled) {
+    if (!m_impl) {
+        return;
+    }
+
+    m_impl->stats_enabled = enabled;
+    if (m_impl->synthesizer) {
+        m_impl->synthesizer->set_stats(m_impl->stats());
+    }
+}
+
+bool TTSEngine::stats_enabled() const {
+    return m_impl && m_impl->stats_enabled;
+}
+
+SynthesisStats TTSEngine::last_stats() const {
+    if (m_impl) {
+        return m_impl->last_stats;
+    }
+    return SynthesisStats{};
+}
+
+// =============================================================================
+// Look-ahead Pipeline
+// =============================================================================
+
+void TTSEngine::set_lookahead_enabled(bool enabled) {
+    if (m_impl) {
+        m_impl->lookahead_enabled = enabled;
+    }
+}
+
+bool TTSEngine::lookahead_enabled() const {
+    return m_impl && m_impl->lookahead_enabled;
+}
+
+// =============================================================================
+// SSML Input
+// =============================================================================
+
+void TTSEngine::set_ssml_enabled(bool enabled) {
+    if (m_impl) {
+        m_impl->ssml_enabled = enabled;
+        m_impl->ssml.clear();
+    }
+}
+
+bool TTSEngine::ssml_enabled() const {
+    return m_impl && m_impl->ssml_enabled;
+}
+
+// =============================================================================
+// Parallel Rendering
+// =============================================================================
+
+void TTSEngine::set_render_threads(uint32_t threads) {
+    if (!m_impl) {
+        return;
+    }
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min<uint32_t>(threads, 64);
+
+    if (threads != m_impl->render_threads) {
+        m_impl->render_threads = threads;
+        m_impl->pool.reset();  // Rebuilt with the new size on next use
+    }
+}
+
+uint32_t TTSEngine::render_threads() const {
+    return m_impl ? m_impl->render_threads : 1;
+}
+
+// =============================================================================
+// Batch Synthesis
+// =============================================================================
+
+bool TTSEngine::synthesize_batch(const std::vector<std::string>& texts,
+                                 const BatchCallback& on_result) {
+    if (!is_initialized() || !on_result) {
+        return false;
+    }
+
+    begin_call();
+    StatsScope stats_scope(m_impl->stats(), m_impl->stats_depth);
+    trace::Scope trace_scope("engine", "synthesize_batch");
+    trace_scope.set_arg("texts", static_cast<int64_t>(texts.size()));
+
+    Impl& impl = *m_impl;
+    WorkStealingPool& pool = impl.render_pool();
+    SynthesisStats* stats = impl.stats();
+
+    while (impl.batch_lanes.size() < pool.size()) {
+        impl.batch_lanes.push_back(std::make_unique<BatchLane>());
+    }
+    for (size_t w = 0; w < pool.size(); ++w) {
+        BatchLane& lane = *impl.batch_lanes[w];
+        lane.inflection.set_pause_settings(impl.voice_params.pause_settings);
+        lane.stats = SynthesisStats{};
+    }
+    impl.sync_workers();
+
+    std::atomic<bool> all_succeeded{true};
+    pool.run(texts.size(), [&](size_t index, size_t worker) {
+        BatchLane& lane = *impl.batch_lanes[worker];
+        SynthesisStats* lane_stats = stats ? &lane.stats : nullptr;
+        SynthesisResult& result = lane.result;
+        AudioBuffer& audio = result.audio;
+
+        result.success = false;
+        result.cancelled = false;
+        result.error_message.clear();
+        audio.sample_rate = SAMPLE_RATE;
+        audio.bits_per_sample = BITS_PER_SAMPLE;
+        audio.channels = NUM_CHANNELS;
+        audio.samples.clear();
+
+        try {
+            trace::Scope text_trace("engine", "batch_text");
+
+            StageTimer preprocess_timer(lane_stats ? &lane_stats->preprocess_ms : nullptr);
+            const std::string* text = &texts[index];
+            if (impl.ssml_enabled) {
+                // Batch results are plain audio: only the text of SSML is used
+                SsmlOptions options;
+                options.spelling = &impl.spelling_dictionary;
+                options.text_only = true;
+                lane.ssml_parser.parse(*text, lane.ssml, options);
+                text = &lane.ssml.text;
+            }
+            const std::string& processed = impl.preprocess(
+                *text, lane.number_converter, lane.text_a, lane.text_b,
+                lane.dictionary_scratch);
+            preprocess_timer.stop();
+
+            StageTimer segment_timer(lane_stats ? &lane_stats->segment_ms : nullptr);
+            size_t segment_count = lane.inflection.analyze_text(processed, lane.segments);
+            segment_timer.stop();
+
+            AudioSynthesizer& synthesizer = impl.worker_synthesizer(worker);
+            for (size_t i = 0; i < segment_count && !cancel_requested(); ++i) {
+                const TextSegment& segment = lane.segments[i];
+                if (segment.text.empty()) {
+                    continue;
+                }
+
+                StageTimer map_timer(lane_stats ? &lane_stats->map_ms : nullptr);
+                lane.phoneme_mapper.map_text(segment.text, lane.tokens);
+                map_timer.stop();
+                if (lane.tokens.empty()) {
+                    continue;
+                }
+
+                render_audio(synthesizer, segment, lane.tokens, lane.segment_audio);
+                audio.append(lane.segment_audio);
+
+                if (lane_stats) {
+                    lane_stats->phoneme_count += static_cast<uint32_t>(lane.tokens.size());
+                }
+            }
+
+            if (cancel_requested()) {
+                audio.samples.clear();
+                result.cancelled = true;
+                result.error_message = "Synthesis cancelled";
+            } else {
+                if (impl.voice_params.output_rate != SAMPLE_RATE) {
+                    StageTimer resample_timer(lane_stats ? &lane_stats->dsp_ms : nullptr);
+                    lane.resampler.configure(SAMPLE_RATE, impl.voice_params.output_rate);
+                    lane.resampler.convert(audio);
+                }
+                result.success = true;
+            }
+
+            if (lane_stats) {
+                lane_stats->segment_count += static_cast<uint32_t>(segment_count);
+                lane_stats->output_samples += audio.samples.size();
+                note_buffer_bytes(lane_stats, audio.samples.capacity() +
+                                              lane.segment_audio.samples.capacity());
+            }
+        } catch (const std::exception& e) {
+            audio.samples.clear();
+            result.error_message = e.what();
+        }
+
+        if (!result.success) {
+            all_succeeded.store(false, std::memory_order_relaxed);
+        }
+        on_result(index, result);
+    });
+
+    if (stats) {
+        // Stage times are summed over workers (CPU time, not wall time)
+        for (size_t w = 0; w < pool.size(); ++w) {
+            add_stats(*stats, impl.batch_lanes[w]->stats);
+        }
+        for (const SynthesisStats& worker_stats : impl.worker_stats) {
+            add_stats(*stats, worker_stats);
+        }
+    }
+
+    return all_succeeded.load(std::memory_order_relaxed);
+}
+
+// =============================================================================
+// Warm-up
+// =============================================================================
+
+SynthesisResult TTSEngine::warmup(const std::atomic<bool>* stop) {
+    SynthesisResult result;
+    if (!is_initialized()) {
+        result.error_message = "Engine not initialized";
+        return result;
+    }
+
+    // First-use setup is cheap next to rendering, so the texts are short:
+    // one with numbers and every inflection kind to size the working
+    // buffers, and a single word for the other paths
+    static const std::string text = "Dobar dan, kako ste? Imam 21 godinu. Hvala!";
+    static const std::string word = "Da?";
+
+    Impl& impl = *m_impl;
+    trace::Scope trace_scope("engine", "warmup");
+
+    // Each step is an ordinary call; a cancel() between steps is caught here
+    uint64_t generation = impl.cancel_generation.load(std::memory_order_acquire);
+    auto stopped = [&] {
+        return impl.cancel_generation.load(std::memory_order_acquire) != generation ||
+               (stop && stop->load(std::memory_order_acquire));
+    };
+
+    // Decode what lazy loading left for first use
+    impl.phoneme_data.decode_all();
+
+    auto proceed = [&](const SynthesisResult& step) {
+        if (step.success && stopped()) {
+            result.success = false;
+            result.cancelled = true;
+            result.error_message = "Synthesis cancelled";
+            return false;
+        }
+        if (!step.success) {
+            result.success = false;
+            result.cancelled = step.cancelled;
+            result.error_message = step.error_message;
+        }
+        return step.success;
+    };
+
+    // Warm-up calls must not replace the caller's statistics
+    SynthesisStats saved_stats = impl.last_stats;
+    apply_posted_params();
+    VoiceParams saved_params = impl.voice_params;
+    SynthesisResult step;
+    if (stopped()) {
+        result.cancelled = true;
+        result.error_message = "Synthesis cancelled";
+        trace_scope.set_arg("completed", 0);
+        return result;
+    }
+
+    // Rate and pitch other than 1 bring up Sonic and the formant shifter;
+    // values posted meanwhile wait, or restoring would drop them
+    VoiceParams shifted = saved_params;
+    shifted.speed = 1.5f;
+    shifted.pitch = 1.25f;
+    shifted.user_pitch = 1.25f;
+    store_voice_params(shifted);
+    impl.live_held = true;
+    synthesize(word, step);
+    impl.live_held = false;
+    store_voice_params(saved_params);
+    bool ok = proceed(step);
+
+    // Then every output path at the settings actually in use
+    ok = ok && proceed(synthesize(text));
+    ok = ok && proceed(synthesize_streaming(word, [](const AudioBuffer&) {}));
+    ok = ok && proceed(synthesize_to_sink(word, [](const AudioSample*, size_t) {}));
+    ok = ok && proceed(synthesize_spelled("A1"));
+
+    if (ok && impl.render_threads > 1) {
+        std::vector<std::string> texts(impl.render_threads, text);
+        bool completed = synthesize_batch(texts, [](size_t, const SynthesisResult&) {});
+        step.success = completed;
+        step.cancelled = !completed && cancel_requested();
+        step.error_message = completed ? "" : "Batch synthesis failed";
+        ok = proceed(step);
+    }
+
+    impl.last_stats = saved_stats;
+    result.success = ok;
+    trace_scope.set_arg("completed", ok ? 1 : 0);
+    return result;
+}
+
 } // namespace laprdus
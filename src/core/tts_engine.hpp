@@ -14,6 +14,9 @@
 #include "emoji_dict.hpp"
 #include "../audio/phoneme_data.hpp"
 #include "../audio/audio_synthesizer.hpp"
+#include "../audio/audio_encoder.hpp"
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <functional>
@@ -31,7 +34,8 @@ namespace laprdus {
  * 5. Inflection application (pitch contours)
  *
  * Thread safety: Create one engine per thread,
- * or use external synchronization.
+ * or use external synchronization. Only cancel() and post_param()
+ * may be called concurrently with synthesis.
  */
 class TTSEngine {
 public:
@@ -67,6 +71,49 @@ public:
     bool initialize_from_memory(const uint8_t* data, size_t size,
                                span<const uint8_t> key = {});
 
+    /**
+     * Initialize engine with phoneme data borrowed from memory.
+     * An unencrypted, uncompressed pack is used in place, without a copy
+     * (see PhonemeData::load_from_memory_nocopy()). The buffer must stay
+     * valid and unchanged until the engine is destroyed or initialized
+     * again, including while other threads synthesize with it.
+     * @param data Pointer to packed phoneme data, owned by the caller.
+     * @param size Size of data.
+     * @param key Optional decryption key.
+     * @return true on success.
+     */
+    bool initialize_from_memory_nocopy(const uint8_t* data, size_t size,
+                                       span<const uint8_t> key = {});
+
+    /**
+     * Decode packed phonemes on first use instead of at initialization.
+     * Initialization then only validates the pack's header and index;
+     * warmup() decodes the remaining phonemes. Applies to later
+     * initialize() and initialize_from_memory() calls.
+     * @param enabled true for lazy decoding (default false).
+     */
+    void set_lazy_loading(bool enabled);
+
+    /**
+     * Check if lazy phoneme decoding is enabled.
+     * @return true if enabled.
+     */
+    bool lazy_loading() const;
+
+    /**
+     * Verify the CRC32 recorded in packed voice data before using it.
+     * Applies to later initialize() and initialize_from_memory() calls,
+     * which fail if the checksum does not match.
+     * @param enabled true to verify (default false).
+     */
+    void set_checksum_verification(bool enabled);
+
+    /**
+     * Check if packed voice data checksums are verified.
+     * @return true if enabled.
+     */
+    bool checksum_verification() const;
+
     /**
      * Check if engine is initialized and ready.
      * @return true if ready.
@@ -75,25 +122,120 @@ public:
 
     /**
      * Synthesize text to audio.
+     * Inline marks in the text (MARK_BEGIN name MARK_END) are returned in
+     * result.marks with their sample offsets, without changing the audio,
+     * so a whole paragraph with index marks is one call.
      * @param text UTF-8 text to synthesize.
      * @return Synthesis result with audio buffer.
      */
     SynthesisResult synthesize(const std::string& text);
 
+    /**
+     * Synthesize text into a caller-owned result.
+     * The engine keeps its working buffers between calls and the result's
+     * audio storage is reused, so once warm, synthesizing text of similar
+     * length performs no heap allocations (number expansion and regex
+     * dictionary entries still allocate).
+     * @param text UTF-8 text to synthesize.
+     * @param result Receives the synthesis result.
+     * @return true on success (same as result.success).
+     */
+    bool synthesize(const std::string& text, SynthesisResult& result);
+
+    /**
+     * Receives an inline mark (MARK_BEGIN name MARK_END in the text) in
+     * order with the audio: after the sample_offset samples before it
+     * and before any sample after it.
+     * @param mark Mark name and position, only valid during the call.
+     */
+    using MarkSink = std::function<void(const MarkEvent& mark)>;
+
     /**
      * Synthesize with streaming output.
+     * Each text segment is delivered as soon as it has been synthesized,
+     * split into chunks of at most chunk_ms. The concatenated chunks are
+     * identical to the audio returned by synthesize(). A chunk that
+     * would contain a mark's position ends there.
      * @param text UTF-8 text to synthesize.
      * @param callback Function to receive audio chunks.
-     * @param chunk_ms Approximate chunk duration in milliseconds.
-     * @return Synthesis result (audio buffer may be empty if streamed).
+     * @param chunk_ms Maximum chunk duration in milliseconds.
+     * @param on_mark Function to receive inline marks (optional).
+     * @return Synthesis result (audio buffer is empty; all audio is streamed).
      */
     SynthesisResult synthesize_streaming(
         const std::string& text,
         std::function<void(const AudioBuffer&)> callback,
-        uint32_t chunk_ms = 100);
+        uint32_t chunk_ms = 100,
+        const MarkSink& on_mark = MarkSink());
+
+    /**
+     * Receives synthesized samples in text order.
+     * @param samples Sample data, only valid during the call.
+     * @param count Number of samples.
+     */
+    using SampleSink = std::function<void(const AudioSample* samples, size_t count)>;
+
+    /**
+     * Synthesize text and write the audio to a sink.
+     * Each text segment is written once, straight from the engine's
+     * working storage, so the utterance is never gathered into one buffer.
+     * With several render threads the segments are rendered in parallel
+     * and written in order once all are done. The written samples are
+     * identical to the audio returned by synthesize(); call cancel() from
+     * the sink to stop early.
+     * @param text UTF-8 text to synthesize.
+     * @param sink Function receiving the audio.
+     * @param on_mark Function to receive inline marks (optional).
+     * @return Synthesis result (audio buffer is empty; all audio is written).
+     */
+    SynthesisResult synthesize_to_sink(const std::string& text, const SampleSink& sink,
+                                       const MarkSink& on_mark = MarkSink());
+
+    /**
+     * Receives encoded audio in text order.
+     * @param data Encoded bytes, only valid during the call.
+     * @param size Number of bytes.
+     */
+    using ByteSink = std::function<void(const uint8_t* data, size_t size)>;
+
+    /**
+     * Synthesize text and write the audio to a sink in a compact encoding.
+     * Each segment is encoded as it leaves synthesize_to_sink(), so the
+     * utterance is never held as PCM. IMA-ADPCM is written in whole blocks
+     * of IMA_ADPCM_BLOCK_BYTES, the last one padded.
+     * @param text UTF-8 text to synthesize.
+     * @param encoding Byte format to write.
+     * @param sink Function receiving the encoded audio.
+     * @param sample_count Receives the number of samples encoded (optional).
+     * @return Synthesis result (audio buffer is empty; all audio is written).
+     */
+    SynthesisResult synthesize_encoded(const std::string& text, OutputEncoding encoding,
+                                       const ByteSink& sink, uint64_t* sample_count = nullptr);
+
+    /**
+     * Abort the synthesis call currently in progress, if any.
+     * The call stops at the next segment or chunk boundary and returns
+     * a result with cancelled set. Calls started afterwards are not affected.
+     * Unlike the rest of the engine, this may be called from any thread.
+     */
+    void cancel();
+
+    /**
+     * Change one voice parameter, including for the call in progress.
+     * The running call picks the value up before its next segment, so a
+     * long utterance changes rate, pitch or volume without being cancelled
+     * and synthesized again; calls started later use it from the start.
+     * Like cancel(), this may be called from any thread. Values are
+     * clamped as by set_voice_params().
+     * @param param Parameter to change.
+     * @param value New value.
+     */
+    void post_param(LiveParam param, float value);
 
     /**
      * Set voice parameters.
+     * Values given to post_param() and not yet applied are discarded, so
+     * the later explicit setting wins.
      * @param params Voice parameters (rate, pitch, volume).
      */
     void set_voice_params(const VoiceParams& params);
@@ -111,11 +253,27 @@ public:
     static const char* version();
 
     /**
-     * Get sample rate of output audio.
+     * Get the native sample rate of the loaded voice data.
      * @return Sample rate in Hz.
      */
     uint32_t sample_rate() const;
 
+    /**
+     * Set the sample rate of synthesized audio (VoiceParams::output_rate).
+     * Audio at another rate than the native one is converted by a
+     * polyphase resampler as it leaves the engine, so players and sound
+     * servers running at that rate need no conversion of their own.
+     * @param rate Output rate in Hz, one of OUTPUT_RATES.
+     * @return false (rate unchanged) if the rate is not supported.
+     */
+    bool set_output_rate(uint32_t rate);
+
+    /**
+     * Get the sample rate of synthesized audio.
+     * @return Output rate in Hz (the native rate by default).
+     */
+    uint32_t output_rate() const;
+
     /**
      * Get memory usage of loaded phoneme data.
      * @return Memory usage in bytes.
@@ -306,14 +464,180 @@ public:
      */
     NumberMode number_mode() const;
 
+    // =========================================================================
+    // Synthesis Statistics
+    // =========================================================================
+
+    /**
+     * Enable or disable per-call statistics collection.
+     * Disabled by default; when disabled the pipeline only pays a null check
+     * per stage.
+     * @param enabled true to collect statistics.
+     */
+    void set_stats_enabled(bool enabled);
+
+    /**
+     * Check if statistics collection is enabled.
+     * @return true if enabled.
+     */
+    bool stats_enabled() const;
+
+    /**
+     * Get statistics of the most recent synthesis call.
+     * All fields are zero if collection was disabled during that call.
+     * @return Statistics of the last synthesize, synthesize_streaming or
+     *         synthesize_spelled call.
+     */
+    SynthesisStats last_stats() const;
+
+    // =========================================================================
+    // Look-ahead Pipeline
+    // =========================================================================
+
+    /**
+     * Enable or disable look-ahead phoneme mapping.
+     * When enabled (the default) and the text has several segments, a helper
+     * thread maps segment N+1 to phonemes while segment N is rendered.
+     * Output is identical either way. Ignored on single-core systems.
+     * @param enabled true to pipeline the text front end.
+     */
+    void set_lookahead_enabled(bool enabled);
+
+    /**
+     * Check if look-ahead phoneme mapping is enabled.
+     * @return true if enabled.
+     */
+    bool lookahead_enabled() const;
+
+    // =========================================================================
+    // SSML Input
+    // =========================================================================
+
+    /**
+     * Read text passed to the synthesis calls as SSML (see SsmlParser).
+     * Breaks, prosody, say-as characters and marks are applied by the
+     * synthesize, streaming and sink calls; batch and spelling calls use
+     * only the text. Disabled by default.
+     * @param enabled true to parse SSML.
+     */
+    void set_ssml_enabled(bool enabled);
+
+    /**
+     * Check if SSML input is enabled.
+     * @return true if enabled.
+     */
+    bool ssml_enabled() const;
+
+    // =========================================================================
+    // Parallel Rendering
+    // =========================================================================
+
+    /**
+     * Set the number of threads used to render text segments.
+     * With more than one thread, synthesize() maps all segments first and
+     * then renders them on a work-stealing pool, each worker with its own
+     * synthesizer sharing the loaded phoneme data. Output is identical to
+     * serial rendering. Streaming calls always render serially.
+     * @param threads Thread count; 1 renders serially (default),
+     *                0 uses one thread per core.
+     */
+    void set_render_threads(uint32_t threads);
+
+    /**
+     * Get the number of threads used to render text segments.
+     * @return Thread count (at least 1).
+     */
+    uint32_t render_threads() const;
+
+    // =========================================================================
+    // Batch Synthesis
+    // =========================================================================
+
+    /**
+     * Receives one result of synthesize_batch().
+     * @param index Position of the text in the batch.
+     * @param result Result for that text, only valid during the call.
+     */
+    using BatchCallback = std::function<void(size_t index, const SynthesisResult& result)>;
+
+    /**
+     * Synthesize many independent texts on the render threads.
+     * Each worker synthesizes whole texts with its own text front end and
+     * synthesizer, sharing the loaded voice data and dictionaries; worker
+     * state stays warm from one batch to the next. The audio for each text
+     * is identical to synthesize(). The callback runs once per text,
+     * concurrently on several threads and in no particular order, and must
+     * not call into the engine other than cancel().
+     * @param texts UTF-8 texts to synthesize.
+     * @param on_result Receives the result of each text.
+     * @return true if every text was synthesized.
+     */
+    bool synthesize_batch(const std::vector<std::string>& texts, const BatchCallback& on_result);
+
+    // =========================================================================
+    // Warm-up
+    // =========================================================================
+
+    /**
+     * Bring the engine to its steady state ahead of the first utterance.
+     * Synthesizes representative text through every output path, once with
+     * shifted rate and pitch so the DSP stages run, and discards the audio.
+     * This decodes all phonemes in lazy loading mode, creates the lazily
+     * built parts (DSP state and presets, helper and render threads,
+     * working buffers) and pulls the voice data into cache. Voice parameters and last_stats() are restored afterwards, and
+     * later output is identical to an engine that was not warmed up.
+     * Stops early when cancel() is called, at the next segment boundary.
+     * @param stop Optional flag that also stops it, checked between steps
+     *             (covers a cancel() that arrives before the first step).
+     * @return Result of the first step that did not complete, otherwise
+     *         success (the audio buffer is always empty).
+     */
+    SynthesisResult warmup(const std::atomic<bool>* stop = nullptr);
+
 private:
     struct Impl;
     std::unique_ptr<Impl> m_impl;
 
-    // Internal synthesis steps
-    std::string preprocess_text(const std::string& text);
-    std::vector<TextSegment> segment_text(const std::string& processed_text);
-    AudioBuffer synthesize_segments(const std::vector<TextSegment>& segments);
+    // Streaming destination for synthesize_segments()
+    struct StreamTarget {
+        const SampleSink& sink;
+        size_t chunk_samples;    // 0 writes whole segments
+        bool incremental;        // Write each segment as soon as it is rendered
+        std::chrono::steady_clock::time_point start;  // Call start, for first_chunk_ms
+        bool resample;           // Convert to the output rate before writing
+        const MarkSink* marks;   // Receives inline marks between samples (may be null)
+    };
+
+    // Internal synthesis steps (results live in the engine's working storage)
+    const std::string& preprocess_text(const std::string& text);
+    size_t segment_text(const std::string& processed_text);
+    void stream_text(const std::string& text, const StreamTarget& stream,
+                     SynthesisResult& result);
+    bool synthesize_segments(size_t segment_count, AudioBuffer& output,
+                             const StreamTarget* stream = nullptr);
+    bool synthesize_segments_lookahead(size_t segment_count, AudioBuffer& output,
+                                       const StreamTarget* stream);
+    bool synthesize_segments_parallel(size_t segment_count, AudioBuffer& output,
+                                      const StreamTarget* stream);
+    bool render_segment(const TextSegment& segment, const std::vector<PhonemeToken>& tokens,
+                        AudioBuffer& output, const StreamTarget* stream);
+    void render_audio(AudioSynthesizer& synthesizer, const TextSegment& segment,
+                      const std::vector<PhonemeToken>& tokens, AudioBuffer& output) const;
+    bool write_stream(const StreamTarget& stream, const AudioSamples& samples);
+    bool write_chunks(const StreamTarget& stream, const AudioSamples& samples);
+    void reach_marks(const TextSegment& segment, const std::vector<size_t>& offsets);
+    void deliver_marks(const StreamTarget& stream, uint64_t position);
+    void resample_output(AudioBuffer& audio);
+
+    // Cancellation bookkeeping for public synthesis calls
+    void begin_call();
+    bool cancel_requested() const;
+
+    // Apply values given to post_param() since the last check
+    void apply_posted_params();
+
+    // set_voice_params() keeping posted values (warm-up restores with it)
+    void store_voice_params(const VoiceParams& params);
 };
 
 } // namespace laprdus
@@ -0,0 +1,183 @@
+// -*- coding: utf-8 -*-
+// work_pool.cpp - Work-stealing thread pool implementation
+
+#include "work_pool.hpp"
+#include "trace.hpp"
+#include <algorithm>
+
+namespace laprdus {
+
+namespace {
+
+constexpr uint64_t pack(uint64_t begin, uint64_t end) {
+    return (begin << 32) | end;
+}
+
+constexpr size_t range_begin(uint64_t bounds) {
+    return static_cast<size_t>(bounds >> 32);
+}
+
+constexpr size_t range_end(uint64_t bounds) {
+    return static_cast<size_t>(bounds & 0xFFFFFFFFu);
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Constructor / Destructor
+// =============================================================================
+
+WorkStealingPool::WorkStealingPool(size_t workers)
+    : m_workers(std::max<size_t>(workers, 1))
+    , m_ranges(std::make_unique<Range[]>(m_workers))
+{
+    m_threads.reserve(m_workers - 1);
+    for (size_t i = 1; i < m_workers; ++i) {
+        m_threads.emplace_back(&WorkStealingPool::worker_loop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start_cv.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+// =============================================================================
+// Run Job
+// =============================================================================
+
+void WorkStealingPool::run(size_t count, const Task& task) {
+    if (count == 0) {
+        return;
+    }
+
+    // Contiguous share per worker keeps neighbouring items on one thread
+    size_t workers = size();
+    size_t share = count / workers;
+    size_t extra = count % workers;
+    size_t begin = 0;
+    for (size_t i = 0; i < workers; ++i) {
+        size_t end = begin + share + (i < extra ? 1 : 0);
+        m_ranges[i].bounds.store(pack(begin, end), std::memory_order_relaxed);
+        begin = end;
+    }
+
+    m_task = &task;
+    m_failed.store(false, std::memory_order_relaxed);
+    m_error = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_job;
+        m_active = m_threads.size();
+    }
+    m_start_cv.notify_all();
+
+    work(0);
+
+    // Tasks may still be running on other workers after the ranges drain
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done_cv.wait(lock, [this] { return m_active == 0; });
+    }
+
+    m_task = nullptr;
+    if (m_error) {
+        std::rethrow_exception(m_error);
+    }
+}
+
+// =============================================================================
+// Workers
+// =============================================================================
+
+void WorkStealingPool::worker_loop(size_t worker) {
+    uint64_t seen_job = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_start_cv.wait(lock, [&] { return m_stop || m_job != seen_job; });
+        if (m_stop) {
+            return;
+        }
+        seen_job = m_job;
+        lock.unlock();
+
+        work(worker);
+
+        lock.lock();
+        if (--m_active == 0) {
+            m_done_cv.notify_all();
+        }
+    }
+}
+
+void WorkStealingPool::work(size_t worker) {
+    trace::Scope trace_scope("pool", "work");
+    int64_t done = 0;
+
+    size_t index;
+    while (take_own(worker, index) || steal(worker, index)) {
+        if (m_failed.load(std::memory_order_relaxed)) {
+            continue;  // Drain the remaining indices without running them
+        }
+        try {
+            (*m_task)(index, worker);
+            ++done;
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(m_error_mutex);
+            if (!m_error) {
+                m_error = std::current_exception();
+            }
+            m_failed.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    trace_scope.set_arg("items", done);
+}
+
+bool WorkStealingPool::take_own(size_t worker, size_t& index) {
+    std::atomic<uint64_t>& bounds = m_ranges[worker].bounds;
+    uint64_t current = bounds.load(std::memory_order_acquire);
+    for (;;) {
+        size_t begin = range_begin(current);
+        size_t end = range_end(current);
+        if (begin >= end) {
+            return false;
+        }
+        if (bounds.compare_exchange_weak(current, pack(begin + 1, end),
+                                         std::memory_order_acq_rel)) {
+            index = begin;
+            return true;
+        }
+    }
+}
+
+bool WorkStealingPool::steal(size_t thief, size_t& index) {
+    size_t workers = size();
+    for (size_t offset = 1; offset < workers; ++offset) {
+        std::atomic<uint64_t>& bounds = m_ranges[(thief + offset) % workers].bounds;
+        uint64_t current = bounds.load(std::memory_order_acquire);
+        for (;;) {
+            size_t begin = range_begin(current);
+            size_t end = range_end(current);
+            if (begin >= end) {
+                break;
+            }
+            // Take from the back, away from where the owner is working
+            if (bounds.compare_exchange_weak(current, pack(begin, end - 1),
+                                             std::memory_order_acq_rel)) {
+                index = end - 1;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace laprdus
@@ -0,0 +1,97 @@
+// -*- coding: utf-8 -*-
+// work_pool.hpp - Work-stealing thread pool for index-parallel jobs
+
+#ifndef LAPRDUS_WORK_POOL_HPP
+#define LAPRDUS_WORK_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace laprdus {
+
+/**
+ * WorkStealingPool - Runs a function over an index range on several threads.
+ *
+ * Each job splits [0, count) into one contiguous range per worker. Workers
+ * take indices from the front of their own range and, once it is empty,
+ * steal from the back of the others' ranges, so uneven items (segments of
+ * very different lengths) still keep every thread busy. The calling thread
+ * takes part as worker 0; the other workers sleep between jobs.
+ *
+ * Jobs must not be started from more than one thread at a time.
+ */
+class WorkStealingPool {
+public:
+    /**
+     * Worker function.
+     * @param index Item index in [0, count).
+     * @param worker Worker number in [0, size()), stable for the job.
+     */
+    using Task = std::function<void(size_t index, size_t worker)>;
+
+    /**
+     * Create a pool.
+     * @param workers Total number of workers including the calling thread.
+     */
+    explicit WorkStealingPool(size_t workers);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /**
+     * Number of workers, including the calling thread.
+     */
+    size_t size() const { return m_workers; }
+
+    /**
+     * Run task for every index in [0, count) and wait for all of them.
+     * If a task throws, the remaining indices are skipped and the first
+     * exception is rethrown here.
+     * @param count Number of items.
+     * @param task Function called once per item.
+     */
+    void run(size_t count, const Task& task);
+
+private:
+    // Remaining indices of one worker, packed as (begin << 32) | end so
+    // the owner and thieves can claim an index with a single CAS.
+    struct alignas(64) Range {
+        std::atomic<uint64_t> bounds{0};
+    };
+
+    void worker_loop(size_t worker);
+    void work(size_t worker);
+    bool take_own(size_t worker, size_t& index);
+    bool steal(size_t thief, size_t& index);
+
+    size_t m_workers;
+    std::unique_ptr<Range[]> m_ranges;
+    std::vector<std::thread> m_threads;
+
+    // Current job
+    const Task* m_task = nullptr;
+    std::atomic<bool> m_failed{false};
+    std::exception_ptr m_error;
+    std::mutex m_error_mutex;
+
+    // Job hand-off to the background workers
+    std::mutex m_mutex;
+    std::condition_variable m_start_cv;
+    std::condition_variable m_done_cv;
+    uint64_t m_job = 0;       // Incremented per job
+    size_t m_active = 0;      // Background workers still in the current job
+    bool m_stop = false;
+};
+
+} // namespace laprdus
+
+#endif // LAPRDUS_WORK_POOL_HPP
@@ -141,9 +141,13 @@ bool Laprdus::inflectionEnabled() const {
 // Utility
 // =============================================================================
 
+bool Laprdus::setOutputRate(uint32_t rate) {
+    return m_engine && m_engine->set_output_rate(rate);
+}
+
 uint32_t Laprdus::sampleRate() const {
     if (m_engine) {
-        return m_engine->sample_rate();
+        return m_engine->output_rate();
     }
     return SAMPLE_RATE;
 }
@@ -12,6 +12,8 @@
  *   laprdus "Text to speak"
  *   laprdus -v josip -r 1.5 "Dobar dan!"
  *   laprdus -i input.txt -o output.wav
+ *   laprdus -b prompts.txt -j 4 -o prompts/
+ *   laprdus --server "Dobar dan!"
  *   echo "Hello" | laprdus
  */
 
@@ -20,10 +22,17 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <getopt.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <unistd.h>
 
 /* For audio playback */
@@ -42,6 +51,9 @@
 /* User configuration */
 #include "core/user_config.hpp"
 
+/* laprdus-server protocol */
+#include "platform/linux/server/server_protocol.hpp"
+
 /* Version information */
 #define CLI_VERSION "1.0.0"
 
@@ -65,7 +77,13 @@ struct Options {
     uint32_t newline_pause = 100;
     std::string output_file;
     std::string input_file;
+    std::string batch_file;
     std::string data_dir = LAPRDUS_DATA_DIR;
+    std::string trace_file;
+    uint32_t render_threads = 1;
+    uint32_t sample_rate = 0;  /* 0 keeps the voice's rate */
+    LaprdusEncoding encoding = LAPRDUS_ENCODING_PCM16;
+    std::string server_socket;  /* Synthesize on laprdus-server when set */
     bool show_help = false;
     bool show_version = false;
     bool list_voices = false;
@@ -73,7 +91,7 @@ struct Options {
 };
 
 /* Short options */
-static const char *short_options = "v:r:p:V:dc:e:x:q:n:o:i:D:hlLw";
+static const char *short_options = "v:r:p:V:dc:e:x:q:n:o:i:b:D:T:t:j:s:f:hlLw";
 
 /* Long options */
 static struct option long_options[] = {
@@ -89,7 +107,14 @@ static struct option long_options[] = {
     {"newline-pauses",      required_argument, nullptr, 'n'},
     {"output-file",         required_argument, nullptr, 'o'},
     {"input-file",          required_argument, nullptr, 'i'},
+    {"batch",               required_argument, nullptr, 'b'},
     {"data-dir",            required_argument, nullptr, 'D'},
+    {"trace",               required_argument, nullptr, 'T'},
+    {"threads",             required_argument, nullptr, 't'},
+    {"jobs",                required_argument, nullptr, 'j'},
+    {"sample-rate",         required_argument, nullptr, 's'},
+    {"format",              required_argument, nullptr, 'f'},
+    {"server",              optional_argument, nullptr, 'S'},
     {"help",                no_argument,       nullptr, 'h'},
     {"list-voices",         no_argument,       nullptr, 'l'},
     {"list",                no_argument,       nullptr, 'L'},
@@ -124,7 +149,19 @@ void print_help(const char *program_name)
               << "  -n, --newline-pauses MS    Pause duration for newlines (default: 100)\n"
               << "  -o, --output-file FILE     Output to WAV file instead of speakers\n"
               << "  -i, --input-file FILE      Read text from file (- for stdin)\n"
+              << "  -b, --batch FILE           Synthesize each line of FILE (- for stdin) to its own\n"
+              << "                             WAV file, named by line number, in the -o directory\n"
               << "  -D, --data-dir DIR         Voice data directory (default: " << LAPRDUS_DATA_DIR << ")\n"
+              << "  -T, --trace FILE           Write Chrome trace JSON of the synthesis pipeline\n"
+              << "  -t, --threads N            Render sentences on N threads, 0 = all cores (default: 1)\n"
+              << "  -j, --jobs N               Same as --threads; with -b, lines are spread over N threads\n"
+              << "  -s, --sample-rate HZ       Output sample rate: 8000, 11025, 16000, 22050, 24000,\n"
+              << "                             32000, 44100 or 48000 (default: 22050)\n"
+              << "  -f, --format FORMAT        WAV encoding for -o: pcm, mulaw, alaw or adpcm\n"
+              << "                             (IMA-ADPCM) (default: pcm)\n"
+              << "      --server[=SOCKET]      Synthesize on a running laprdus-server instead of\n"
+              << "                             loading the voice (default socket: "
+              << laprdus::server::default_socket_path() << ")\n"
               << "  -l, --list-voices          List available voices\n"
               << "  -w, --verbose              Enable verbose output\n"
               << "  -h, --help                 Show this help message\n\n"
@@ -132,6 +169,9 @@ void print_help(const char *program_name)
               << "  " << program_name << " \"Dobar dan!\"\n"
               << "  " << program_name << " -v vlado -r 1.5 \"Zdravo svete!\"\n"
               << "  " << program_name << " -i document.txt -o speech.wav\n"
+              << "  " << program_name << " -b prompts.txt -j 4 -o prompts/\n"
+              << "  " << program_name << " -s 8000 -f mulaw -o prompt.wav \"Molimo pričekajte.\"\n"
+              << "  " << program_name << " --server \"Dobar dan!\"\n"
               << "  echo \"Jedan, dva, tri\" | " << program_name << "\n\n"
               << "Voices:\n"
               << "  josip   - Croatian male adult (default)\n"
@@ -164,6 +204,25 @@ void list_voices()
     }
 }
 
+/**
+ * Parse an output format name
+ */
+bool parse_encoding(const std::string &name, LaprdusEncoding &encoding)
+{
+    if (name == "pcm") {
+        encoding = LAPRDUS_ENCODING_PCM16;
+    } else if (name == "mulaw" || name == "ulaw") {
+        encoding = LAPRDUS_ENCODING_MULAW;
+    } else if (name == "alaw") {
+        encoding = LAPRDUS_ENCODING_ALAW;
+    } else if (name == "adpcm" || name == "ima-adpcm") {
+        encoding = LAPRDUS_ENCODING_IMA_ADPCM;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 /**
  * Parse command-line arguments
  */
@@ -219,9 +278,31 @@ bool parse_args(int argc, char *argv[], Options &opts)
             case 'i':
                 opts.input_file = optarg;
                 break;
+            case 'b':
+                opts.batch_file = optarg;
+                break;
             case 'D':
                 opts.data_dir = optarg;
                 break;
+            case 'T':
+                opts.trace_file = optarg;
+                break;
+            case 't':
+            case 'j':
+                opts.render_threads = static_cast<uint32_t>(std::stoul(optarg));
+                break;
+            case 's':
+                opts.sample_rate = static_cast<uint32_t>(std::stoul(optarg));
+                break;
+            case 'f':
+                if (!parse_encoding(optarg, opts.encoding)) {
+                    std::cerr << "Error: Unknown format: " << optarg << "\n";
+                    return false;
+                }
+                break;
+            case 'S':
+                opts.server_socket = optarg ? optarg : laprdus::server::default_socket_path();
+                break;
             case 'h':
                 opts.show_help = true;
                 return true;
@@ -325,6 +406,303 @@ bool write_wav_file(const std::string &filename, const int16_t *samples, int32_t
     return true;
 }
 
+/**
+ * Write the header of a WAV file holding G.711 or IMA-ADPCM data.
+ * These formats need an extended fmt chunk and a fact chunk with the
+ * sample count, since it does not follow from the data size.
+ */
+void write_encoded_wav_header(std::ofstream &file, const LaprdusAudioFormat &format,
+                              LaprdusEncoding encoding, uint32_t data_size, uint32_t num_samples)
+{
+    bool adpcm = encoding == LAPRDUS_ENCODING_IMA_ADPCM;
+    uint16_t audio_format = adpcm ? 0x11 : (encoding == LAPRDUS_ENCODING_MULAW ? 7 : 6);
+    uint16_t channels = format.channels;
+    uint32_t sample_rate = format.sample_rate;
+    uint16_t block_align = adpcm ? LAPRDUS_IMA_ADPCM_BLOCK_BYTES : channels;
+    uint32_t byte_rate = adpcm
+        ? static_cast<uint32_t>(static_cast<uint64_t>(sample_rate) * LAPRDUS_IMA_ADPCM_BLOCK_BYTES /
+                                LAPRDUS_IMA_ADPCM_BLOCK_SAMPLES)
+        : sample_rate * channels;
+    uint16_t bits_per_sample = format.bits_per_sample;
+    uint16_t extra_size = adpcm ? 2 : 0;
+    uint32_t fmt_size = 18 + extra_size;
+    uint32_t chunk_size = 4 + (8 + fmt_size) + 12 + (8 + data_size);
+
+    /* RIFF header */
+    file.write("RIFF", 4);
+    file.write(reinterpret_cast<const char*>(&chunk_size), 4);
+    file.write("WAVE", 4);
+
+    /* fmt subchunk (WAVEFORMATEX) */
+    file.write("fmt ", 4);
+    file.write(reinterpret_cast<const char*>(&fmt_size), 4);
+    file.write(reinterpret_cast<const char*>(&audio_format), 2);
+    file.write(reinterpret_cast<const char*>(&channels), 2);
+    file.write(reinterpret_cast<const char*>(&sample_rate), 4);
+    file.write(reinterpret_cast<const char*>(&byte_rate), 4);
+    file.write(reinterpret_cast<const char*>(&block_align), 2);
+    file.write(reinterpret_cast<const char*>(&bits_per_sample), 2);
+    file.write(reinterpret_cast<const char*>(&extra_size), 2);
+    if (adpcm) {
+        uint16_t samples_per_block = LAPRDUS_IMA_ADPCM_BLOCK_SAMPLES;
+        file.write(reinterpret_cast<const char*>(&samples_per_block), 2);
+    }
+
+    /* fact subchunk */
+    file.write("fact", 4);
+    uint32_t fact_size = 4;
+    file.write(reinterpret_cast<const char*>(&fact_size), 4);
+    file.write(reinterpret_cast<const char*>(&num_samples), 4);
+
+    /* data subchunk */
+    file.write("data", 4);
+    file.write(reinterpret_cast<const char*>(&data_size), 4);
+}
+
+/**
+ * Encoded WAV output state shared with the write callback
+ */
+struct EncodedOutput {
+    std::ofstream file;
+    uint64_t data_size = 0;
+};
+
+int LAPRDUS_CALL on_encoded_data(const uint8_t *data, size_t size, void *user_data)
+{
+    EncodedOutput *output = static_cast<EncodedOutput*>(user_data);
+    output->file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    output->data_size += size;
+    return output->file.good() ? 1 : 0;
+}
+
+/**
+ * Synthesize text straight into an encoded WAV file. Each sentence is
+ * encoded and written as it is synthesized; the header is completed
+ * once the sizes are known.
+ */
+bool write_encoded_wav_file(LaprdusHandle engine, const Options &opts)
+{
+    EncodedOutput output;
+    output.file.open(opts.output_file, std::ios::binary);
+    if (!output.file.is_open()) {
+        std::cerr << "Error: Cannot create output file: " << opts.output_file << "\n";
+        return false;
+    }
+
+    /* Room for the header, rewritten with the real sizes at the end */
+    LaprdusAudioFormat format = {};
+    write_encoded_wav_header(output.file, format, opts.encoding, 0, 0);
+
+    int32_t num_samples = laprdus_synthesize_encoded_to_sink(
+        engine, opts.text.c_str(), opts.encoding, on_encoded_data, &output, &format);
+    if (num_samples <= 0) {
+        std::cerr << "Error: Synthesis failed: " << laprdus_get_error_message(engine) << "\n";
+        return false;
+    }
+
+    output.file.seekp(0);
+    write_encoded_wav_header(output.file, format, opts.encoding,
+                             static_cast<uint32_t>(output.data_size),
+                             static_cast<uint32_t>(num_samples));
+    output.file.close();
+
+    if (opts.verbose) {
+        std::cout << "Encoded " << num_samples << " samples into " << output.data_size
+                  << " bytes (" << format.sample_rate << " Hz, "
+                  << format.bits_per_sample << " bit)\n";
+    }
+    return !output.file.fail();
+}
+
+/**
+ * Batch job state shared with the batch callback
+ */
+struct BatchJob {
+    std::vector<std::string> paths;   /* Output file per text */
+    LaprdusAudioFormat format;
+    std::atomic<size_t> failed{0};
+    bool verbose = false;
+};
+
+/**
+ * Write one batch result (called concurrently from the render threads)
+ */
+void LAPRDUS_CALL on_batch_result(size_t index, LaprdusError status, const int16_t *samples,
+                                  size_t num_samples, void *user_data)
+{
+    BatchJob *job = static_cast<BatchJob*>(user_data);
+    const std::string &path = job->paths[index];
+
+    if (status != LAPRDUS_OK) {
+        std::cerr << "Error: Synthesis failed for " << path << ": "
+                  << laprdus_error_to_string(status) << "\n";
+        job->failed.fetch_add(1);
+        return;
+    }
+
+    if (!write_wav_file(path, samples, static_cast<int32_t>(num_samples), job->format)) {
+        job->failed.fetch_add(1);
+    } else if (job->verbose) {
+        std::cout << "Wrote " + path + "\n" << std::flush;
+    }
+}
+
+/**
+ * Synthesize every non-empty line of the batch file to its own WAV file
+ */
+bool run_batch(LaprdusHandle engine, const Options &opts)
+{
+    std::string input = read_text_from_file(opts.batch_file);
+    std::string dir = opts.output_file.empty() ? "." : opts.output_file;
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "Error: Cannot create output directory: " << dir << "\n";
+        return false;
+    }
+    if (dir.back() != '/') {
+        dir += '/';
+    }
+
+    /* Files are named by line number so they map back to the input */
+    BatchJob job;
+    job.verbose = opts.verbose;
+    std::vector<std::string> lines;
+    std::istringstream stream(input);
+    std::string line;
+    for (size_t number = 1; std::getline(stream, line); ++number) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "%04zu.wav", number);
+        lines.push_back(line);
+        job.paths.push_back(dir + name);
+    }
+
+    if (lines.empty()) {
+        std::cerr << "Error: No text to speak in " << opts.batch_file << "\n";
+        return false;
+    }
+
+    std::vector<const char*> texts;
+    for (const std::string &text : lines) {
+        texts.push_back(text.c_str());
+    }
+
+    LaprdusError err = laprdus_synthesize_batch(engine, texts.data(), texts.size(),
+                                                on_batch_result, &job, &job.format);
+    if (err != LAPRDUS_OK && job.failed.load() == 0) {
+        std::cerr << "Error: Batch synthesis failed: " << laprdus_get_error_message(engine) << "\n";
+    }
+
+    if (opts.verbose) {
+        std::cout << "Synthesized " << (lines.size() - job.failed.load()) << " of "
+                  << lines.size() << " lines\n";
+    }
+    return err == LAPRDUS_OK && job.failed.load() == 0;
+}
+
+/**
+ * Synthesize the text on a running laprdus-server: one request on a fresh
+ * connection, with the audio collected as it streams back.
+ * @return LAPRDUS_OK, or the error the server reported.
+ */
+LaprdusError synthesize_on_server(const Options &opts, std::vector<int16_t> &samples,
+                                  LaprdusAudioFormat &format)
+{
+    namespace proto = laprdus::server;
+
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (opts.server_socket.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Error: Socket path too long: " << opts.server_socket << "\n";
+        return LAPRDUS_ERROR_INVALID_PATH;
+    }
+    memcpy(addr.sun_path, opts.server_socket.c_str(), opts.server_socket.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "Error: Cannot connect to laprdus-server at " << opts.server_socket
+                  << ": " << strerror(errno) << "\n";
+        if (fd >= 0) {
+            close(fd);
+        }
+        return LAPRDUS_ERROR_INVALID_PATH;
+    }
+
+    proto::SpeakParams params;
+    size_t voice_length = std::min(opts.voice.size(), proto::VOICE_ID_SIZE - 1);
+    memcpy(params.voice, opts.voice.data(), voice_length);
+    params.voice[voice_length] = '\0';
+    params.speed = opts.speech_rate;
+    params.user_pitch = opts.speech_pitch;
+    params.volume = opts.speech_volume;
+    params.sample_rate = opts.sample_rate;
+    params.comma_pause_ms = static_cast<uint16_t>(std::min<uint32_t>(opts.comma_pause, 0xFFFF));
+    params.sentence_pause_ms = static_cast<uint16_t>(std::min<uint32_t>(opts.period_pause, 0xFFFF));
+    params.newline_pause_ms = static_cast<uint16_t>(std::min<uint32_t>(opts.newline_pause, 0xFFFF));
+
+    std::string payload(reinterpret_cast<const char*>(&params), sizeof(params));
+    payload += opts.text;
+    uint16_t flags = opts.numbers_as_digits ? proto::SPEAK_DIGITS : 0;
+
+    LaprdusError status = LAPRDUS_ERROR_SYNTHESIS_FAILED;
+    if (proto::write_frame(fd, proto::FrameType::Speak, 1, payload.data(),
+                           static_cast<uint32_t>(payload.size()),
+                           static_cast<uint8_t>(LAPRDUS_PRIORITY_TEXT), flags)) {
+        /* Sizes are checked before anything is allocated or read */
+        auto malformed = [](const char *frame) {
+            std::cerr << "Error: Malformed " << frame << " frame from laprdus-server\n";
+        };
+        proto::FrameHeader header;
+        while (proto::read_all(fd, &header, sizeof(header))) {
+            auto type = static_cast<proto::FrameType>(header.type);
+            if (type == proto::FrameType::Audio) {
+                if (header.size % sizeof(int16_t) != 0 ||
+                    header.size > proto::MAX_AUDIO_SAMPLES * sizeof(int16_t)) {
+                    malformed("AUDIO");
+                    break;
+                }
+                size_t offset = samples.size();
+                samples.resize(offset + header.size / sizeof(int16_t));
+                if (!proto::read_all(fd, samples.data() + offset, header.size)) {
+                    break;
+                }
+            } else if (type == proto::FrameType::Begin) {
+                if (header.size != sizeof(proto::AudioInfo)) {
+                    malformed("BEGIN");
+                    break;
+                }
+                proto::AudioInfo info;
+                if (!proto::read_all(fd, &info, sizeof(info))) {
+                    break;
+                }
+                format.sample_rate = info.sample_rate;
+                format.channels = info.channels;
+                format.bits_per_sample = info.bits_per_sample;
+            } else if (type == proto::FrameType::End) {
+                if (header.size != sizeof(proto::EndInfo)) {
+                    malformed("END");
+                    break;
+                }
+                proto::EndInfo info;
+                if (proto::read_all(fd, &info, sizeof(info))) {
+                    status = static_cast<LaprdusError>(info.status);
+                }
+                break;
+            } else {
+                malformed("unknown");
+                break;
+            }
+        }
+    }
+
+    close(fd);
+    return status;
+}
+
 #ifdef HAVE_PULSEAUDIO
 /**
  * Play audio using PulseAudio
@@ -465,7 +843,8 @@ int main(int argc, char *argv[])
     }
 
     /* Read text from input file if specified */
-    if (!opts.input_file.empty()) {
+    bool batch_mode = !opts.batch_file.empty();
+    if (!opts.input_file.empty() && !batch_mode) {
         opts.text = read_text_from_file(opts.input_file);
         if (opts.text.empty()) {
             return 1;
@@ -473,19 +852,25 @@ int main(int argc, char *argv[])
     }
 
     /* Read from stdin if no text provided and stdin is not a terminal */
-    if (opts.text.empty() && !isatty(STDIN_FILENO)) {
+    if (opts.text.empty() && !batch_mode && !isatty(STDIN_FILENO)) {
         std::stringstream buffer;
         buffer << std::cin.rdbuf();
         opts.text = buffer.str();
     }
 
     /* Check for text */
-    if (opts.text.empty()) {
+    if (opts.text.empty() && !batch_mode) {
         std::cerr << "Error: No text to speak. Provide text as argument, use -i, or pipe to stdin.\n";
         std::cerr << "Use -h for help.\n";
         return 1;
     }
 
+    /* Encoded output is only written to a single WAV file */
+    if (opts.encoding != LAPRDUS_ENCODING_PCM16 && (batch_mode || opts.output_file.empty())) {
+        std::cerr << "Error: --format needs -o with a file name (not -b)\n";
+        return 1;
+    }
+
     if (opts.verbose) {
         std::cout << "Voice: " << opts.voice << "\n";
         std::cout << "Rate: " << opts.speech_rate << "\n";
@@ -494,6 +879,37 @@ int main(int argc, char *argv[])
         std::cout << "Text length: " << opts.text.length() << " characters\n";
     }
 
+    /* Server mode: the server has everything loaded, so no engine is created here */
+    if (!opts.server_socket.empty()) {
+        if (batch_mode || opts.encoding != LAPRDUS_ENCODING_PCM16) {
+            std::cerr << "Error: --server does not support -b or --format\n";
+            return 1;
+        }
+
+        std::vector<int16_t> samples;
+        LaprdusAudioFormat format;
+        laprdus_get_default_format(&format);
+        LaprdusError status = synthesize_on_server(opts, samples, format);
+        if (status != LAPRDUS_OK || samples.empty()) {
+            if (status != LAPRDUS_ERROR_INVALID_PATH) {
+                std::cerr << "Error: Synthesis failed: " << laprdus_error_to_string(status) << "\n";
+            }
+            return 1;
+        }
+
+        int32_t num_samples = static_cast<int32_t>(samples.size());
+        bool success;
+        if (!opts.output_file.empty()) {
+            success = write_wav_file(opts.output_file, samples.data(), num_samples, format);
+            if (success && opts.verbose) {
+                std::cout << "Wrote " << opts.output_file << "\n";
+            }
+        } else {
+            success = play_audio(samples.data(), num_samples, format);
+        }
+        return success ? 0 : 1;
+    }
+
     /* Auto-detect data directory if user didn't specify one */
     if (opts.data_dir == LAPRDUS_DATA_DIR) {
         /* Check candidate paths in order of preference */
@@ -511,6 +927,12 @@ int main(int argc, char *argv[])
         }
     }
 
+    /* Start tracing before the engine exists so voice loading is covered too */
+    if (!opts.trace_file.empty() &&
+        laprdus_set_trace_file(opts.trace_file.c_str()) != LAPRDUS_OK) {
+        std::cerr << "Warning: Cannot write trace file '" << opts.trace_file << "'\n";
+    }
+
     /* Create TTS engine */
     LaprdusHandle engine = laprdus_create();
     if (!engine) {
@@ -580,6 +1002,34 @@ int main(int argc, char *argv[])
         laprdus_set_number_mode(engine, LAPRDUS_NUMBER_MODE_DIGIT);
     }
 
+    laprdus_set_render_threads(engine, opts.render_threads);
+
+    if (opts.sample_rate != 0 &&
+        laprdus_set_output_rate(engine, opts.sample_rate) != LAPRDUS_OK) {
+        std::cerr << "Error: Unsupported sample rate: " << opts.sample_rate << "\n";
+        laprdus_destroy(engine);
+        return 1;
+    }
+
+    /* Compact encodings are written straight to the file as they are produced */
+    if (opts.encoding != LAPRDUS_ENCODING_PCM16) {
+        bool encoded_ok = write_encoded_wav_file(engine, opts);
+        if (encoded_ok && opts.verbose) {
+            std::cout << "Wrote " << opts.output_file << "\n";
+        }
+        laprdus_destroy(engine);
+        laprdus_set_trace_file(nullptr);
+        return encoded_ok ? 0 : 1;
+    }
+
+    /* Batch mode: one WAV file per input line */
+    if (batch_mode) {
+        bool batch_ok = run_batch(engine, opts);
+        laprdus_destroy(engine);
+        laprdus_set_trace_file(nullptr);
+        return batch_ok ? 0 : 1;
+    }
+
     /* Synthesize text */
     int16_t *samples = nullptr;
     LaprdusAudioFormat format;
@@ -600,6 +1050,7 @@ int main(int argc, char *argv[])
 
     /* Output audio */
     bool success = false;
+    laprdus_trace_begin("output");
     if (!opts.output_file.empty()) {
         /* Write to file */
         success = write_wav_file(opts.output_file, samples, num_samples, format);
@@ -610,10 +1061,12 @@ int main(int argc, char *argv[])
         /* Play to audio device */
         success = play_audio(samples, num_samples, format);
     }
+    laprdus_trace_end("output");
 
     /* Clean up */
     laprdus_free_buffer(samples);
     laprdus_destroy(engine);
+    laprdus_set_trace_file(nullptr);
 
     return success ? 0 : 1;
 }
@@ -0,0 +1,995 @@
+/*
+ * laprdus_server.cpp - Resident synthesis server for LaprdusTTS
+ *
+ * Copyright (C) 2025 Hrvoje Katic
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * Keeps voices, dictionaries and the engines' warmed working state loaded
+ * and synthesizes for any number of clients over a Unix domain socket,
+ * streaming the audio back in chunks (see server_protocol.hpp).
+ *
+ * Usage:
+ *   laprdus-server
+ *   laprdus-server -s /run/user/1000/laprdus.sock -v josip -v vlado
+ *   laprdus "Dobar dan!" --server
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* LaprdusTTS C API */
+#include <laprdus/laprdus_api.h>
+
+/* User configuration */
+#include "core/user_config.hpp"
+
+#include "platform/linux/server/server_protocol.hpp"
+
+namespace proto = laprdus::server;
+
+/* Version information */
+#define SERVER_VERSION "1.0.0"
+
+/* Default paths */
+#ifndef LAPRDUS_DATA_DIR
+#define LAPRDUS_DATA_DIR "/usr/share/laprdus"
+#endif
+
+#define DEFAULT_VOICE "josip"
+
+/* Output a client may have queued before workers wait for it to read */
+constexpr size_t OUTPUT_HIGH_WATER = 1u << 20;
+
+/* Queued output beyond this drops the connection */
+constexpr size_t MAX_QUEUED_OUTPUT = 4u << 20;
+
+/* A client that reads nothing for this long while behind is dropped */
+constexpr auto CLIENT_STALL_TIMEOUT = std::chrono::seconds(5);
+
+/* Command-line options */
+struct Options {
+    std::string socket_path;
+    std::string data_dir = LAPRDUS_DATA_DIR;
+    std::vector<std::string> voices;  /* Loaded at startup */
+    uint32_t workers = 2;
+    uint32_t render_threads = 1;
+    bool show_help = false;
+    bool verbose = false;
+};
+
+static const char* short_options = "s:D:v:j:t:wh";
+
+static struct option long_options[] = {
+    {"socket",     required_argument, nullptr, 's'},
+    {"data-dir",   required_argument, nullptr, 'D'},
+    {"voice",      required_argument, nullptr, 'v'},
+    {"jobs",       required_argument, nullptr, 'j'},
+    {"threads",    required_argument, nullptr, 't'},
+    {"verbose",    no_argument,       nullptr, 'w'},
+    {"help",       no_argument,       nullptr, 'h'},
+    {nullptr,      0,                 nullptr, 0}
+};
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_signal(int) {
+    g_stop = 1;
+}
+
+/**
+ * Print help message
+ */
+void print_help(const char* program_name) {
+    std::cout << "LaprdusTTS synthesis server\n"
+              << "Version " << SERVER_VERSION << "\n\n"
+              << "Usage:\n"
+              << "  " << program_name << " [OPTIONS]\n\n"
+              << "Options:\n"
+              << "  -s, --socket PATH     Listen on PATH (default: " << proto::default_socket_path() << ")\n"
+              << "  -D, --data-dir DIR    Voice data directory (default: " << LAPRDUS_DATA_DIR << ")\n"
+              << "  -v, --voice NAME      Load voice NAME at startup; may be repeated\n"
+              << "                        (default: " << DEFAULT_VOICE << ")\n"
+              << "  -j, --jobs N          Synthesize up to N requests at once (default: 2)\n"
+              << "  -t, --threads N       Render threads per request, 0 = all cores (default: 1)\n"
+              << "  -w, --verbose         Log connections and requests\n"
+              << "  -h, --help            Show this help message\n\n"
+              << "Clients: laprdus --server[=PATH] \"Text\"\n";
+}
+
+/**
+ * Parse command-line arguments
+ */
+bool parse_args(int argc, char* argv[], Options& opts) {
+    int opt;
+    int option_index = 0;
+
+    while ((opt = getopt_long(argc, argv, short_options, long_options, &option_index)) != -1) {
+        switch (opt) {
+            case 's':
+                opts.socket_path = optarg;
+                break;
+            case 'D':
+                opts.data_dir = optarg;
+                break;
+            case 'v':
+                opts.voices.push_back(optarg);
+                break;
+            case 'j':
+                opts.workers = static_cast<uint32_t>(std::stoul(optarg));
+                if (opts.workers == 0) opts.workers = 1;
+                break;
+            case 't':
+                opts.render_threads = static_cast<uint32_t>(std::stoul(optarg));
+                break;
+            case 'w':
+                opts.verbose = true;
+                break;
+            case 'h':
+                opts.show_help = true;
+                return true;
+            case '?':
+            default:
+                return false;
+        }
+    }
+
+    if (optind < argc) {
+        std::cerr << "Error: Unexpected argument: " << argv[optind] << "\n";
+        return false;
+    }
+    return true;
+}
+
+// =============================================================================
+// Connections and Requests
+// =============================================================================
+
+/*
+ * Wakeup - Self-pipe that interrupts the main thread's poll() when a
+ * worker queues output or drops a connection.
+ */
+class Wakeup {
+public:
+    Wakeup() {
+        if (pipe2(m_fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+            m_fds[0] = m_fds[1] = -1;
+        }
+    }
+
+    ~Wakeup() {
+        if (m_fds[0] >= 0) {
+            close(m_fds[0]);
+            close(m_fds[1]);
+        }
+    }
+
+    Wakeup(const Wakeup&) = delete;
+    Wakeup& operator=(const Wakeup&) = delete;
+
+    bool valid() const { return m_fds[0] >= 0; }
+    int fd() const { return m_fds[0]; }
+
+    void notify() {
+        /* A full pipe already has a wake-up pending */
+        char byte = 0;
+        ssize_t written = write(m_fds[1], &byte, 1);
+        (void)written;
+    }
+
+    void drain() {
+        char buffer[64];
+        while (read(m_fds[0], buffer, sizeof(buffer)) > 0) {
+        }
+    }
+
+private:
+    int m_fds[2];
+};
+
+/**
+ * A client connection. The socket is non-blocking and only the main thread
+ * touches it: frames are read there, and the frames the workers send are
+ * queued and written out whenever the socket is writable. A client that
+ * stops reading holds up only its own requests, and is dropped once its
+ * queue is full or it has been behind for CLIENT_STALL_TIMEOUT.
+ */
+struct Connection {
+    int fd;
+    Wakeup& wakeup;
+    std::mutex output_mutex;
+    std::condition_variable output_drained;
+    std::string output;  /* Frames queued for the client */
+    std::atomic<bool> closed{false};
+    std::string input;  /* Bytes of the frame being received */
+
+    Connection(int socket_fd, Wakeup& main_wakeup) : fd(socket_fd), wakeup(main_wakeup) {}
+    ~Connection() { close(fd); }
+
+    /**
+     * Queue a frame; never blocks.
+     * @return false once the connection is closed.
+     */
+    bool send(proto::FrameType type, uint32_t request_id, const void* payload, uint32_t size) {
+        if (closed.load(std::memory_order_acquire)) {
+            return false;
+        }
+        proto::FrameHeader header = proto::make_header(type, request_id, size);
+        {
+            std::lock_guard<std::mutex> lock(output_mutex);
+            if (output.size() + sizeof(header) + size > MAX_QUEUED_OUTPUT) {
+                drop_locked();
+            } else {
+                output.append(reinterpret_cast<const char*>(&header), sizeof(header));
+                output.append(static_cast<const char*>(payload), size);
+            }
+        }
+        wakeup.notify();
+        return !closed.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Wait while the client is more than OUTPUT_HIGH_WATER behind.
+     * Called by workers only.
+     * @return false once the connection is closed.
+     */
+    bool wait_for_room() {
+        std::unique_lock<std::mutex> lock(output_mutex);
+        bool room = output_drained.wait_for(lock, CLIENT_STALL_TIMEOUT, [this] {
+            return closed.load(std::memory_order_acquire) || output.size() <= OUTPUT_HIGH_WATER;
+        });
+        if (!room) {
+            drop_locked();
+            lock.unlock();
+            wakeup.notify();
+        }
+        return !closed.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Write as much queued output as the socket takes without blocking.
+     * Called by the main thread only.
+     * @return false if the client is gone.
+     */
+    bool flush() {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        size_t sent = 0;
+        while (sent < output.size()) {
+            ssize_t written = ::send(fd, output.data() + sent, output.size() - sent,
+                                     MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    break;
+                }
+                drop_locked();
+                return false;
+            }
+            sent += static_cast<size_t>(written);
+        }
+        output.erase(0, sent);
+        output_drained.notify_all();
+        return true;
+    }
+
+    bool has_output() {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        return !output.empty();
+    }
+
+    /**
+     * Mark the connection closed and discard its queued output.
+     */
+    void drop() {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        drop_locked();
+    }
+
+    void send_end(uint32_t request_id, LaprdusError status, uint32_t num_samples) {
+        proto::EndInfo info;
+        info.status = static_cast<int32_t>(status);
+        info.num_samples = num_samples;
+        send(proto::FrameType::End, request_id, &info, sizeof(info));
+    }
+
+private:
+    /* Called with output_mutex held */
+    void drop_locked() {
+        closed.store(true, std::memory_order_release);
+        output.clear();
+        output_drained.notify_all();
+    }
+};
+
+/**
+ * A SPEAK request, queued until a worker picks it up.
+ */
+struct Request {
+    std::shared_ptr<Connection> connection;
+    uint32_t id = 0;
+    LaprdusPriority priority = LAPRDUS_PRIORITY_TEXT;
+    uint16_t flags = 0;
+    uint64_t sequence = 0;  /* Arrival order within a priority */
+    proto::SpeakParams params;
+    std::string voice;
+    std::string text;
+    std::atomic<bool> cancelled{false};
+};
+
+using RequestPtr = std::shared_ptr<Request>;
+
+// =============================================================================
+// Engine Pool
+// =============================================================================
+
+/*
+ * EnginePool - Engines stay loaded between requests, grouped by voice.
+ * A request borrows an idle engine of its voice, so engines are created
+ * only for the first request of a voice and for each additional request
+ * of that voice running at the same time; after that every request finds
+ * voice data, dictionaries and working buffers ready.
+ */
+class EnginePool {
+public:
+    EnginePool(const Options& opts, const laprdus::UserConfig* user_config)
+        : m_opts(opts), m_user_config(user_config) {}
+
+    ~EnginePool() {
+        for (auto& entry : m_idle) {
+            for (LaprdusHandle engine : entry.second) {
+                laprdus_destroy(engine);
+            }
+        }
+    }
+
+    /**
+     * Borrow an engine with the voice loaded.
+     * @return Engine handle, or NULL with the reason in error.
+     */
+    LaprdusHandle acquire(const std::string& voice, std::string& error) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::vector<LaprdusHandle>& idle = m_idle[voice];
+            if (!idle.empty()) {
+                LaprdusHandle engine = idle.back();
+                idle.pop_back();
+                return engine;
+            }
+        }
+        return create(voice, error);
+    }
+
+    /**
+     * Return a borrowed engine.
+     */
+    void release(const std::string& voice, LaprdusHandle engine) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_idle[voice].push_back(engine);
+    }
+
+private:
+    LaprdusHandle create(const std::string& voice, std::string& error) {
+        LaprdusHandle engine = laprdus_create();
+        if (!engine) {
+            error = "Failed to create TTS engine";
+            return nullptr;
+        }
+
+        if (laprdus_set_voice(engine, voice.c_str(), m_opts.data_dir.c_str()) != LAPRDUS_OK) {
+            error = "Failed to set voice '" + voice + "': " + laprdus_get_error_message(engine);
+            laprdus_destroy(engine);
+            return nullptr;
+        }
+
+        std::string dict_path = m_opts.data_dir + "/internal.json";
+        laprdus_load_dictionary(engine, dict_path.c_str());
+
+        std::string spelling_path = m_opts.data_dir + "/spelling.json";
+        laprdus_load_spelling_dictionary(engine, spelling_path.c_str());
+
+        std::string emoji_path = m_opts.data_dir + "/emoji.json";
+        laprdus_load_emoji_dictionary(engine, emoji_path.c_str());
+
+        /* User dictionaries extend the internal ones, as in the CLI */
+        if (m_user_config) {
+            const laprdus::UserSettings& settings = m_user_config->settings();
+
+            if (settings.user_dictionaries_enabled) {
+                if (m_user_config->user_dictionary_exists("user.json")) {
+                    std::string path = m_user_config->get_user_dictionary_path();
+                    laprdus_append_dictionary(engine, path.c_str());
+                }
+                if (m_user_config->user_dictionary_exists("spelling.json")) {
+                    std::string path = m_user_config->get_user_spelling_dictionary_path();
+                    laprdus_append_spelling_dictionary(engine, path.c_str());
+                }
+                if (m_user_config->user_dictionary_exists("emoji.json")) {
+                    std::string path = m_user_config->get_user_emoji_dictionary_path();
+                    laprdus_append_emoji_dictionary(engine, path.c_str());
+                }
+            }
+
+            if (settings.emoji_enabled) {
+                laprdus_set_emoji_enabled(engine, 1);
+            }
+        }
+
+        laprdus_set_render_threads(engine, m_opts.render_threads);
+        laprdus_warmup(engine);
+
+        if (m_opts.verbose) {
+            std::cerr << "Loaded voice " << voice << "\n";
+        }
+        return engine;
+    }
+
+    const Options& m_opts;
+    const laprdus::UserConfig* m_user_config;
+    std::mutex m_mutex;
+    std::map<std::string, std::vector<LaprdusHandle>> m_idle;
+};
+
+// =============================================================================
+// Scheduler
+// =============================================================================
+
+/*
+ * Scheduler - Runs requests on a fixed set of worker threads. The queue
+ * is ordered by priority, then arrival. A new request stops the queued
+ * and running requests of its own connection that have a lower priority,
+ * like key echo interrupting the text being read; requests of other
+ * connections are only overtaken in the queue. Running requests stop at
+ * the next chunk of audio. The classes interrupt each other as in
+ * laprdus_speak_async_with_priority(), so notifications are never stopped.
+ */
+class Scheduler {
+public:
+    Scheduler(EnginePool& pool, uint32_t workers) : m_pool(pool) {
+        for (uint32_t i = 0; i < workers; i++) {
+            m_workers.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~Scheduler() {
+        std::vector<RequestPtr> dropped;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+            dropped.swap(m_queue);
+            for (const RequestPtr& request : m_running) {
+                request->cancelled.store(true, std::memory_order_release);
+            }
+        }
+        m_wake.notify_all();
+        for (std::thread& worker : m_workers) {
+            worker.join();
+        }
+        for (const RequestPtr& request : dropped) {
+            request->connection->send_end(request->id, LAPRDUS_ERROR_CANCELLED, 0);
+        }
+    }
+
+    void submit(const RequestPtr& request) {
+        std::vector<RequestPtr> dropped;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            request->sequence = m_next_sequence++;
+            auto preempted = [&](const RequestPtr& other) {
+                return other->connection == request->connection &&
+                       other->priority != LAPRDUS_PRIORITY_NOTIFICATION &&
+                       other->priority < request->priority;
+            };
+            take_queued(preempted, dropped);
+            for (const RequestPtr& other : m_running) {
+                if (preempted(other)) {
+                    other->cancelled.store(true, std::memory_order_release);
+                }
+            }
+            m_queue.push_back(request);
+        }
+        m_wake.notify_one();
+        for (const RequestPtr& other : dropped) {
+            other->connection->send_end(other->id, LAPRDUS_ERROR_CANCELLED, 0);
+        }
+    }
+
+    /**
+     * Cancel a request of a connection, or all of them when id is 0.
+     * @param notify Send END for queued requests (false once the client is gone).
+     */
+    void cancel(const std::shared_ptr<Connection>& connection, uint32_t id, bool notify) {
+        std::vector<RequestPtr> dropped;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto matches = [&](const RequestPtr& other) {
+                return other->connection == connection && (id == 0 || other->id == id);
+            };
+            take_queued(matches, dropped);
+            for (const RequestPtr& other : m_running) {
+                if (matches(other)) {
+                    other->cancelled.store(true, std::memory_order_release);
+                }
+            }
+        }
+        if (notify) {
+            for (const RequestPtr& other : dropped) {
+                connection->send_end(other->id, LAPRDUS_ERROR_CANCELLED, 0);
+            }
+        }
+    }
+
+private:
+    template <typename Predicate>
+    void take_queued(Predicate predicate, std::vector<RequestPtr>& out) {
+        auto it = std::stable_partition(m_queue.begin(), m_queue.end(),
+                                        [&](const RequestPtr& r) { return !predicate(r); });
+        out.insert(out.end(), it, m_queue.end());
+        m_queue.erase(it, m_queue.end());
+    }
+
+    /* Highest priority first, then oldest; called with m_mutex held */
+    RequestPtr pop_next() {
+        auto best = std::min_element(m_queue.begin(), m_queue.end(),
+            [](const RequestPtr& a, const RequestPtr& b) {
+                if (a->priority != b->priority) {
+                    return a->priority > b->priority;
+                }
+                return a->sequence < b->sequence;
+            });
+        RequestPtr request = *best;
+        m_queue.erase(best);
+        return request;
+    }
+
+    void worker_loop() {
+        for (;;) {
+            RequestPtr request;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+                if (m_stopping) {
+                    return;
+                }
+                request = pop_next();
+                m_running.push_back(request);
+            }
+
+            run(*request);
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running.erase(std::find(m_running.begin(), m_running.end(), request));
+        }
+    }
+
+    /**
+     * State of a running request shared with the write callback
+     */
+    struct Output {
+        Request* request;
+        uint64_t num_samples = 0;
+    };
+
+    static int LAPRDUS_CALL on_audio(const int16_t* samples, size_t num_samples, void* user_data) {
+        Output* output = static_cast<Output*>(user_data);
+        Request* request = output->request;
+
+        while (num_samples > 0) {
+            if (request->cancelled.load(std::memory_order_acquire) ||
+                !request->connection->wait_for_room()) {
+                return 0;
+            }
+            size_t chunk = std::min(num_samples, proto::MAX_AUDIO_SAMPLES);
+            if (!request->connection->send(proto::FrameType::Audio, request->id, samples,
+                                           static_cast<uint32_t>(chunk * sizeof(int16_t)))) {
+                return 0;
+            }
+            output->num_samples += chunk;
+            samples += chunk;
+            num_samples -= chunk;
+        }
+        return request->cancelled.load(std::memory_order_acquire) ? 0 : 1;
+    }
+
+    void run(Request& request) {
+        Connection& connection = *request.connection;
+        if (request.cancelled.load(std::memory_order_acquire) ||
+            connection.closed.load(std::memory_order_acquire)) {
+            connection.send_end(request.id, LAPRDUS_ERROR_CANCELLED, 0);
+            return;
+        }
+
+        std::string error;
+        LaprdusHandle engine = m_pool.acquire(request.voice, error);
+        if (!engine) {
+            std::cerr << "Error: " << error << "\n";
+            connection.send_end(request.id, LAPRDUS_ERROR_LOAD_FAILED, 0);
+            return;
+        }
+
+        /* Every request brings all of its settings */
+        const proto::SpeakParams& params = request.params;
+        laprdus_set_speed(engine, params.speed);
+        laprdus_set_user_pitch(engine, params.user_pitch);
+        laprdus_set_volume(engine, params.volume);
+        laprdus_set_comma_pause(engine, params.comma_pause_ms);
+        laprdus_set_sentence_pause(engine, params.sentence_pause_ms);
+        laprdus_set_newline_pause(engine, params.newline_pause_ms);
+        laprdus_set_number_mode(engine, (request.flags & proto::SPEAK_DIGITS)
+                                ? LAPRDUS_NUMBER_MODE_DIGIT : LAPRDUS_NUMBER_MODE_WHOLE);
+        laprdus_set_ssml_enabled(engine, (request.flags & proto::SPEAK_SSML) ? 1 : 0);
+
+        LaprdusAudioFormat format;
+        laprdus_get_default_format(&format);
+        if (params.sample_rate != 0) {
+            format.sample_rate = params.sample_rate;
+        }
+        if (laprdus_set_output_rate(engine, format.sample_rate) != LAPRDUS_OK) {
+            m_pool.release(request.voice, engine);
+            connection.send_end(request.id, LAPRDUS_ERROR_INVALID_PARAMETER, 0);
+            return;
+        }
+
+        proto::AudioInfo info;
+        info.sample_rate = format.sample_rate;
+        info.channels = static_cast<uint16_t>(format.channels);
+        info.bits_per_sample = static_cast<uint16_t>(format.bits_per_sample);
+        connection.send(proto::FrameType::Begin, request.id, &info, sizeof(info));
+
+        Output output;
+        output.request = &request;
+        int32_t result = laprdus_synthesize_to_sink(engine, request.text.c_str(),
+                                                    on_audio, &output, nullptr);
+        m_pool.release(request.voice, engine);
+
+        LaprdusError status = LAPRDUS_OK;
+        if (request.cancelled.load(std::memory_order_acquire)) {
+            status = LAPRDUS_ERROR_CANCELLED;
+        } else if (result < 0) {
+            status = static_cast<LaprdusError>(result);
+        }
+        connection.send_end(request.id, status, static_cast<uint32_t>(output.num_samples));
+    }
+
+    EnginePool& m_pool;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<RequestPtr> m_queue;
+    std::vector<RequestPtr> m_running;
+    std::vector<std::thread> m_workers;
+    uint64_t m_next_sequence = 0;
+    bool m_stopping = false;
+};
+
+// =============================================================================
+// Socket Handling
+// =============================================================================
+
+/**
+ * Create the listening socket. A socket file left behind by a server that
+ * is no longer running is replaced.
+ * @return Socket descriptor, or -1 on failure.
+ */
+int listen_on(const std::string& path) {
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Error: Socket path too long: " << path << "\n";
+        return -1;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "Error: Cannot create socket: " << strerror(errno) << "\n";
+        return -1;
+    }
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        bool stale = false;
+        if (errno == EADDRINUSE) {
+            int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            stale = connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0;
+            close(probe);
+            if (!stale) {
+                std::cerr << "Error: A server is already listening on " << path << "\n";
+                close(fd);
+                return -1;
+            }
+            unlink(path.c_str());
+        }
+        if (!stale || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            std::cerr << "Error: Cannot bind " << path << ": " << strerror(errno) << "\n";
+            close(fd);
+            return -1;
+        }
+    }
+
+    if (listen(fd, 16) != 0) {
+        std::cerr << "Error: Cannot listen on " << path << ": " << strerror(errno) << "\n";
+        close(fd);
+        unlink(path.c_str());
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Handle the complete frames received on a connection.
+ * @return false on a protocol error (the connection is dropped).
+ */
+bool handle_input(const std::shared_ptr<Connection>& connection, Scheduler& scheduler, bool verbose) {
+    std::string& input = connection->input;
+    size_t pos = 0;
+
+    while (input.size() - pos >= sizeof(proto::FrameHeader)) {
+        proto::FrameHeader header;
+        memcpy(&header, input.data() + pos, sizeof(header));
+        if (header.size > proto::MAX_PAYLOAD + sizeof(proto::SpeakParams)) {
+            return false;
+        }
+        if (input.size() - pos - sizeof(header) < header.size) {
+            break;
+        }
+        const char* payload = input.data() + pos + sizeof(header);
+        pos += sizeof(header) + header.size;
+
+        switch (static_cast<proto::FrameType>(header.type)) {
+            case proto::FrameType::Speak: {
+                if (header.size < sizeof(proto::SpeakParams)) {
+                    return false;
+                }
+                if (header.priority > LAPRDUS_PRIORITY_KEY) {
+                    connection->send_end(header.request_id, LAPRDUS_ERROR_INVALID_PARAMETER, 0);
+                    break;
+                }
+                auto request = std::make_shared<Request>();
+                request->connection = connection;
+                request->id = header.request_id;
+                request->priority = static_cast<LaprdusPriority>(header.priority);
+                request->flags = header.flags;
+                memcpy(&request->params, payload, sizeof(request->params));
+                request->voice.assign(request->params.voice,
+                                      strnlen(request->params.voice, proto::VOICE_ID_SIZE));
+                if (request->voice.empty()) {
+                    request->voice = DEFAULT_VOICE;
+                }
+                request->text.assign(payload + sizeof(proto::SpeakParams),
+                                     header.size - sizeof(proto::SpeakParams));
+                if (verbose) {
+                    std::cerr << "Request " << request->id << " on connection " << connection->fd
+                              << ": " << request->text.size() << " bytes, priority "
+                              << static_cast<int>(request->priority) << "\n";
+                }
+                scheduler.submit(request);
+                break;
+            }
+            case proto::FrameType::Cancel:
+                scheduler.cancel(connection, header.request_id, true);
+                break;
+            default:
+                return false;
+        }
+    }
+
+    input.erase(0, pos);
+    return true;
+}
+
+/**
+ * Accept clients, read their frames and write out their queued output
+ * until a signal stops the server.
+ */
+void serve(int listen_fd, Scheduler& scheduler, Wakeup& wakeup, bool verbose) {
+    std::vector<std::shared_ptr<Connection>> connections;
+    std::vector<pollfd> fds;
+    char buffer[65536];
+
+    auto drop = [&](size_t i) {
+        std::shared_ptr<Connection> connection = connections[i];
+        if (verbose) {
+            std::cerr << "Connection " << connection->fd << " closed\n";
+        }
+        connection->drop();
+        scheduler.cancel(connection, 0, false);
+        shutdown(connection->fd, SHUT_RDWR);
+        connections.erase(connections.begin() + static_cast<std::ptrdiff_t>(i));
+    };
+
+    while (!g_stop) {
+        /* Workers close connections that fell too far behind */
+        for (size_t i = connections.size(); i-- > 0;) {
+            if (connections[i]->closed.load(std::memory_order_acquire)) {
+                drop(i);
+            }
+        }
+
+        fds.clear();
+        fds.push_back({listen_fd, POLLIN, 0});
+        fds.push_back({wakeup.fd(), POLLIN, 0});
+        for (const auto& connection : connections) {
+            short events = POLLIN;
+            if (connection->has_output()) {
+                events |= POLLOUT;
+            }
+            fds.push_back({connection->fd, events, 0});
+        }
+
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error: poll failed: " << strerror(errno) << "\n";
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            wakeup.drain();
+        }
+
+        /* Connections first, so indices match fds before any is added */
+        for (size_t i = connections.size(); i-- > 0;) {
+            short revents = fds[i + 2].revents;
+            if (revents == 0) {
+                continue;
+            }
+            std::shared_ptr<Connection> connection = connections[i];
+            bool keep = true;
+            if (revents & POLLOUT) {
+                keep = connection->flush();
+            }
+            if (keep && (revents & ~POLLOUT)) {
+                ssize_t got = recv(connection->fd, buffer, sizeof(buffer), 0);
+                keep = got > 0 || (got < 0 && (errno == EINTR || errno == EAGAIN));
+                if (got > 0) {
+                    connection->input.append(buffer, static_cast<size_t>(got));
+                    keep = handle_input(connection, scheduler, verbose);
+                }
+            }
+            if (!keep) {
+                drop(i);
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (fd >= 0) {
+                connections.push_back(std::make_shared<Connection>(fd, wakeup));
+                if (verbose) {
+                    std::cerr << "Connection " << fd << " opened\n";
+                }
+            }
+        }
+    }
+
+    /* Whatever the clients take at once of the final END frames */
+    for (const auto& connection : connections) {
+        scheduler.cancel(connection, 0, true);
+        connection->flush();
+        shutdown(connection->fd, SHUT_RDWR);
+    }
+}
+
+/**
+ * Main entry point
+ */
+int main(int argc, char* argv[]) {
+    Options opts;
+    if (!parse_args(argc, argv, opts)) {
+        std::cerr << "Use -h for help.\n";
+        return 1;
+    }
+    if (opts.show_help) {
+        print_help(argv[0]);
+        return 0;
+    }
+    if (opts.socket_path.empty()) {
+        opts.socket_path = proto::default_socket_path();
+    }
+    if (opts.voices.empty()) {
+        opts.voices.push_back(DEFAULT_VOICE);
+    }
+
+    /* Auto-detect data directory if user didn't specify one */
+    if (opts.data_dir == LAPRDUS_DATA_DIR) {
+        const char* candidates[] = {
+            "/usr/share/laprdus",
+            "/usr/local/share/laprdus",
+            NULL
+        };
+        for (int i = 0; candidates[i]; i++) {
+            std::string test = std::string(candidates[i]) + "/Josip.bin";
+            if (access(test.c_str(), R_OK) == 0) {
+                opts.data_dir = candidates[i];
+                break;
+            }
+        }
+    }
+
+    laprdus::UserConfig user_config;
+    bool has_user_config = user_config.load_settings();
+
+    /* Only the main thread takes the stop signals */
+    struct sigaction action = {};
+    action.sa_handler = on_signal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr);
+
+    int exit_code = 0;
+    {
+        EnginePool pool(opts, has_user_config ? &user_config : nullptr);
+
+        /* Load the startup voices, one engine per worker, before listening */
+        for (const std::string& voice : opts.voices) {
+            std::vector<LaprdusHandle> engines;
+            for (uint32_t i = 0; i < opts.workers; i++) {
+                std::string error;
+                LaprdusHandle engine = pool.acquire(voice, error);
+                if (!engine) {
+                    std::cerr << "Error: " << error << "\n";
+                    exit_code = 1;
+                    break;
+                }
+                engines.push_back(engine);
+            }
+            for (LaprdusHandle engine : engines) {
+                pool.release(voice, engine);
+            }
+        }
+
+        /* Outlives the scheduler, whose workers may still queue output */
+        Wakeup wakeup;
+        if (!wakeup.valid()) {
+            std::cerr << "Error: Cannot create wake-up pipe: " << strerror(errno) << "\n";
+            exit_code = 1;
+        }
+
+        int listen_fd = exit_code == 0 ? listen_on(opts.socket_path) : -1;
+        if (listen_fd >= 0) {
+            Scheduler scheduler(pool, opts.workers);
+            pthread_sigmask(SIG_UNBLOCK, &stop_signals, nullptr);
+
+            if (opts.verbose) {
+                std::cerr << "Listening on " << opts.socket_path << "\n";
+            }
+            serve(listen_fd, scheduler, wakeup, opts.verbose);
+
+            close(listen_fd);
+            unlink(opts.socket_path.c_str());
+        } else {
+            exit_code = 1;
+        }
+    }
+
+    return exit_code;
+}
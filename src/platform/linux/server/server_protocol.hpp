@@ -0,0 +1,179 @@
+// -*- coding: utf-8 -*-
+// server_protocol.hpp - Wire protocol of the laprdus-server Unix socket
+
+#ifndef LAPRDUS_SERVER_PROTOCOL_HPP
+#define LAPRDUS_SERVER_PROTOCOL_HPP
+
+#include <laprdus/laprdus_api.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+/*
+ * Every message in either direction is a 12-byte FrameHeader followed by
+ * `size` payload bytes. Fields are in host byte order: both ends run on
+ * the same machine.
+ *
+ * Client to server:
+ *   SPEAK   SpeakParams, then the UTF-8 text (or SSML with SPEAK_SSML).
+ *           `priority` (a LaprdusPriority) and `flags` are set in the
+ *           header.
+ *   CANCEL  No payload. Stops the request with this ID, or every request
+ *           of the connection when the ID is 0.
+ *
+ * Server to client, for each SPEAK in turn:
+ *   BEGIN   AudioInfo, sent when synthesis starts.
+ *   AUDIO   Mono 16-bit PCM samples, at most MAX_AUDIO_SAMPLES per frame.
+ *   END     EndInfo. Every SPEAK gets exactly one END, also when it was
+ *           cancelled or failed before BEGIN.
+ *
+ * Request IDs are chosen by the client and only need to be unique on its
+ * connection. Priorities are the classes of laprdus_speak_async_with_priority():
+ * a request with a higher priority runs before the queued requests of all
+ * connections, and stops the lower-priority requests of its own connection
+ * at the next chunk (they end as cancelled). Notifications run last and
+ * never stop or are stopped by other requests.
+ */
+
+namespace laprdus {
+namespace server {
+
+constexpr uint32_t MAX_PAYLOAD = 1u << 20;      // Longest accepted SPEAK text
+constexpr size_t MAX_AUDIO_SAMPLES = 4096;      // Samples per AUDIO frame
+constexpr size_t VOICE_ID_SIZE = 16;
+
+enum class FrameType : uint8_t {
+    Speak = 1,
+    Cancel = 2,
+    Begin = 0x81,
+    Audio = 0x82,
+    End = 0x83,
+};
+
+enum SpeakFlags : uint16_t {
+    SPEAK_SSML = 1u << 0,         // Parse the text as SSML
+    SPEAK_DIGITS = 1u << 1,       // Read numbers digit by digit
+};
+
+#pragma pack(push, 1)
+struct FrameHeader {
+    uint32_t size = 0;          // Payload bytes after the header
+    uint32_t request_id = 0;
+    uint8_t type = 0;           // FrameType
+    uint8_t priority = 0;       // SPEAK: LaprdusPriority
+    uint16_t flags = 0;         // SPEAK: SpeakFlags
+};
+
+struct SpeakParams {
+    char voice[VOICE_ID_SIZE] = {};  // Voice ID, NUL-padded; empty for the default
+    float speed = 1.0f;
+    float user_pitch = 1.0f;
+    float volume = 1.0f;
+    uint32_t sample_rate = 0;        // 0 keeps the voice's rate
+    uint16_t comma_pause_ms = 40;
+    uint16_t sentence_pause_ms = 80;
+    uint16_t newline_pause_ms = 100;
+    uint16_t reserved = 0;
+};
+
+struct AudioInfo {
+    uint32_t sample_rate = 0;
+    uint16_t channels = 0;
+    uint16_t bits_per_sample = 0;
+};
+
+struct EndInfo {
+    int32_t status = 0;         // LaprdusError: 0, or why the request stopped
+    uint32_t num_samples = 0;   // Samples sent in AUDIO frames
+};
+#pragma pack(pop)
+
+static_assert(sizeof(FrameHeader) == 12, "FrameHeader is part of the wire format");
+static_assert(sizeof(SpeakParams) == 40, "SpeakParams is part of the wire format");
+
+/**
+ * Socket path used when none is given: $XDG_RUNTIME_DIR/laprdus.sock,
+ * or /tmp/laprdus-UID.sock without a runtime directory.
+ */
+inline std::string default_socket_path() {
+    const char* runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir && *runtime_dir) {
+        return std::string(runtime_dir) + "/laprdus.sock";
+    }
+    return "/tmp/laprdus-" + std::to_string(getuid()) + ".sock";
+}
+
+/**
+ * Write all bytes, retrying short writes.
+ * @return true on success, false if the peer is gone.
+ */
+inline bool write_all(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+/**
+ * Read exactly `size` bytes.
+ * @return true on success, false on end of stream or error.
+ */
+inline bool read_all(int fd, void* data, size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t got = recv(fd, bytes, size, 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        bytes += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+/**
+ * Header of a frame with `size` payload bytes.
+ */
+inline FrameHeader make_header(FrameType type, uint32_t request_id, uint32_t size,
+                               uint8_t priority = 0, uint16_t flags = 0) {
+    FrameHeader header;
+    header.size = size;
+    header.request_id = request_id;
+    header.type = static_cast<uint8_t>(type);
+    header.priority = priority;
+    header.flags = flags;
+    return header;
+}
+
+/**
+ * Write one frame (header and payload).
+ */
+inline bool write_frame(int fd, FrameType type, uint32_t request_id,
+                        const void* payload, uint32_t size,
+                        uint8_t priority = 0, uint16_t flags = 0) {
+    FrameHeader header = make_header(type, request_id, size, priority, flags);
+    return write_all(fd, &header, sizeof(header)) &&
+           (size == 0 || write_all(fd, payload, size));
+}
+
+} // namespace server
+} // namespace laprdus
+
+#endif // LAPRDUS_SERVER_PROTOCOL_HPP
@@ -33,6 +33,8 @@
  * - Full SSIP parameter support (rate, pitch, volume)
  * - Spelling mode support
  * - Punctuation mode support (via pauses)
+ * - SSML: breaks, prosody, say-as characters and index marks
+ * - Pause and resume without synthesizing the message again
  */
 
 #define _POSIX_C_SOURCE 200809L
@@ -60,6 +62,10 @@
 #define DEFAULT_DATA_DIR "/usr/share/laprdus"
 #define DEFAULT_VOICE "josip"
 
+/* Audio is sent in chunks of this length, so PAUSE and STOP take effect
+ * inside a sentence, not only at index marks */
+#define AUDIO_CHUNK_MS 100
+
 /* Configuration options */
 static char *laprdus_data_dir = NULL;
 static char *laprdus_default_voice = NULL;
@@ -68,6 +74,7 @@ static int laprdus_debug = 0;
 /* Runtime state */
 static LaprdusHandle engine = NULL;
 static volatile int stop_requested = 0;
+static volatile int pause_requested = 0;
 static volatile int speaking = 0;
 
 /* Current voice parameters */
@@ -94,33 +101,236 @@ static SPDVoice **voice_list = NULL;
  * Helper Functions
  * -------------------------------------------------------------------------- */
 
+/*
+ * Audio and index marks of one message. Speech Dispatcher sends SSML; the
+ * engine parses it, and its <mark> elements come back with the sample
+ * offset they belong at, so the audio is sent in pieces split there.
+ */
+typedef struct {
+    int16_t *samples;
+    size_t num_samples;
+    size_t capacity;
+    char **mark_names;
+    size_t *mark_offsets;
+    size_t num_marks;
+    size_t mark_capacity;
+} MessageAudio;
+
+static int LAPRDUS_CALL message_audio_write(const int16_t *samples, size_t num_samples,
+                                            void *user_data)
+{
+    MessageAudio *audio = user_data;
+
+    if (audio->num_samples + num_samples > audio->capacity) {
+        size_t capacity = audio->capacity ? audio->capacity * 2 : 32768;
+        while (capacity < audio->num_samples + num_samples) {
+            capacity *= 2;
+        }
+        int16_t *grown = realloc(audio->samples, capacity * sizeof(int16_t));
+        if (!grown) {
+            return 0;  /* Stops synthesis */
+        }
+        audio->samples = grown;
+        audio->capacity = capacity;
+    }
+
+    memcpy(audio->samples + audio->num_samples, samples, num_samples * sizeof(int16_t));
+    audio->num_samples += num_samples;
+    return 1;
+}
+
+static int LAPRDUS_CALL message_audio_mark(const char *name, uint64_t sample_offset,
+                                           void *user_data)
+{
+    MessageAudio *audio = user_data;
+
+    if (audio->num_marks == audio->mark_capacity) {
+        size_t capacity = audio->mark_capacity ? audio->mark_capacity * 2 : 8;
+        char **names = realloc(audio->mark_names, capacity * sizeof(char *));
+        if (!names) {
+            return 0;
+        }
+        audio->mark_names = names;
+        size_t *offsets = realloc(audio->mark_offsets, capacity * sizeof(size_t));
+        if (!offsets) {
+            return 0;
+        }
+        audio->mark_offsets = offsets;
+        audio->mark_capacity = capacity;
+    }
+
+    char *copy = strdup(name);
+    if (!copy) {
+        return 0;
+    }
+    audio->mark_names[audio->num_marks] = copy;
+    audio->mark_offsets[audio->num_marks] = (size_t)sample_offset;
+    audio->num_marks++;
+    return 1;
+}
+
+static void message_audio_free(MessageAudio *audio)
+{
+    for (size_t i = 0; i < audio->num_marks; i++) {
+        free(audio->mark_names[i]);
+    }
+    free(audio->mark_names);
+    free(audio->mark_offsets);
+    free(audio->samples);
+    memset(audio, 0, sizeof(*audio));
+}
+
+/**
+ * Send part of a message's audio to the server.
+ */
+static void send_audio(const int16_t *samples, size_t num_samples,
+                       const LaprdusAudioFormat *format)
+{
+    AudioTrack track;
+    track.bits = format->bits_per_sample;
+    track.num_channels = format->channels;
+    track.sample_rate = format->sample_rate;
+    track.num_samples = (int)num_samples;
+    track.samples = (short *)samples;
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    AudioFormat audio_format = SPD_AUDIO_BE;
+#else
+    AudioFormat audio_format = SPD_AUDIO_LE;
+#endif
+
+    module_tts_output_server(&track, audio_format);
+}
+
+/*
+ * A message interrupted by PAUSE. On resume Speech Dispatcher sends the
+ * rest of the message again, starting after the last index mark it heard;
+ * the audio is still here, so sending continues from the chunk the pause
+ * stopped at (or that mark's offset) without synthesizing anything. Any
+ * other message discards it.
+ */
+typedef struct {
+    int valid;
+    char *text;              /* The message as received */
+    MessageAudio audio;
+    LaprdusAudioFormat format;
+    size_t piece;            /* Piece the pause stopped in */
+    size_t position;         /* Samples sent before the pause */
+    char *voice;             /* Settings the audio was made with */
+    int rate;
+    int pitch;
+    int volume;
+    int spell;
+} PausedMessage;
+
+static PausedMessage paused_message;
+
+static void discard_paused_message(void)
+{
+    free(paused_message.text);
+    free(paused_message.voice);
+    message_audio_free(&paused_message.audio);
+    memset(&paused_message, 0, sizeof(paused_message));
+}
+
+static int is_tag(const char *p, const char *name)
+{
+    size_t len = strlen(name);
+    return p[0] == '<' && strncmp(p + 1, name, len) == 0 &&
+           (p[len + 1] == '>' || p[len + 1] == '/' || p[len + 1] == ' ');
+}
+
 /**
- * Strip SSML/XML tags from text in-place.
- * Speech Dispatcher wraps text in <speak> tags and may include other SSML markup.
- * Since LaprdusTTS doesn't process SSML, we strip all tags before synthesis.
- * Returns the new length of the stripped text.
+ * Skip whitespace and the tags a resent message may gain or lose:
+ * <mark>, <speak>, </speak> and the XML declaration.
+ * Sets *skipped if anything was skipped.
  */
-static size_t strip_ssml_tags(char *text, size_t len)
+static const char *skip_ignorable(const char *p, int *skipped)
 {
-    size_t read_pos = 0, write_pos = 0;
-    int in_tag = 0;
-
-    while (read_pos < len) {
-        if (text[read_pos] == '<') {
-            in_tag = 1;
-            read_pos++;
-        } else if (text[read_pos] == '>' && in_tag) {
-            in_tag = 0;
-            read_pos++;
-        } else if (in_tag) {
-            read_pos++;
+    for (;;) {
+        if (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+            p++;
+        } else if (is_tag(p, "mark") || is_tag(p, "speak") || is_tag(p, "/speak") ||
+                   (p[0] == '<' && p[1] == '?')) {
+            const char *end = strchr(p, '>');
+            if (!end) {
+                return p;
+            }
+            p = end + 1;
         } else {
-            text[write_pos++] = text[read_pos++];
+            return p;
         }
+        *skipped = 1;
     }
+}
 
-    text[write_pos] = '\0';
-    return write_pos;
+/**
+ * Compare two messages, treating runs of whitespace and ignorable tags
+ * as one separator and ignoring them at both ends.
+ */
+static int same_speech(const char *a, const char *b)
+{
+    int first = 1;
+    for (;;) {
+        int skipped_a = 0, skipped_b = 0;
+        a = skip_ignorable(a, &skipped_a);
+        b = skip_ignorable(b, &skipped_b);
+        if (!*a && !*b) {
+            return 1;
+        }
+        if (*a != *b || (!first && skipped_a != skipped_b)) {
+            return 0;
+        }
+        a++;
+        b++;
+        first = 0;
+    }
+}
+
+/**
+ * Find the <mark> element with the given name.
+ * Returns the text following it, or NULL.
+ */
+static const char *find_mark_tag(const char *text, const char *name)
+{
+    size_t len = strlen(name);
+    for (const char *p = strstr(text, "<mark"); p; p = strstr(p + 1, "<mark")) {
+        const char *end = strchr(p, '>');
+        if (!end) {
+            return NULL;
+        }
+        for (const char *q = p; q + 6 + len < end; q++) {
+            if (strncmp(q, "name=", 5) == 0 && (q[5] == '"' || q[5] == '\'') &&
+                strncmp(q + 6, name, len) == 0 && q[6 + len] == q[5]) {
+                return end + 1;
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Check whether a message resumes the paused one.
+ * Returns the piece to continue with (piece i ends at mark i), or -1.
+ */
+static long find_resume_piece(const char *data, int spell)
+{
+    if (!paused_message.valid || paused_message.spell != spell ||
+        paused_message.rate != current_rate || paused_message.pitch != current_pitch ||
+        paused_message.volume != current_volume || !paused_message.voice ||
+        !current_voice_name || strcmp(paused_message.voice, current_voice_name) != 0) {
+        return -1;
+    }
+
+    /* The latest mark first: the resent text starts after the last one heard */
+    const MessageAudio *audio = &paused_message.audio;
+    for (size_t i = audio->num_marks; i > 0; i--) {
+        const char *rest = find_mark_tag(paused_message.text, audio->mark_names[i - 1]);
+        if (rest && same_speech(rest, data)) {
+            return (long)i;
+        }
+    }
+    return same_speech(paused_message.text, data) ? 0 : -1;
 }
 
 /**
@@ -348,20 +558,9 @@ int module_init(char **msg)
         return -1;
     }
 
-    /* Set default voice (which initializes phoneme data) */
     const char *data_dir = laprdus_data_dir ? laprdus_data_dir : DEFAULT_DATA_DIR;
     const char *voice = laprdus_default_voice ? laprdus_default_voice : DEFAULT_VOICE;
 
-    if (laprdus_set_voice(engine, voice, data_dir) != LAPRDUS_OK) {
-        *msg = strdup("Failed to initialize voice. Check data directory.");
-        ERR("%s: %s", *msg, laprdus_get_error_message(engine));
-        laprdus_destroy(engine);
-        engine = NULL;
-        return -1;
-    }
-
-    current_voice_name = strdup(voice);
-
     /* Load dictionaries if present */
     char dict_path[512];
     snprintf(dict_path, sizeof(dict_path), "%s/internal.json", data_dir);
@@ -373,6 +572,31 @@ int module_init(char **msg)
     /* Load user configuration from ~/.config/Laprdus */
     laprdus_load_user_config(engine);
 
+    /*
+     * Warm up on the engine's queue thread whenever voice data is loaded,
+     * so INIT returns at once and the first message does not pay for
+     * first-use setup. The dictionaries and user settings are loaded
+     * before the voice so the warm-up runs with them.
+     */
+    laprdus_set_auto_warmup(engine, LAPRDUS_WARMUP_BACKGROUND);
+
+    /* Refuse damaged voice data; the CRC costs a fraction of a millisecond */
+    laprdus_set_checksum_verification(engine, 1);
+
+    /* Messages arrive as SSML; breaks, prosody and marks are honoured */
+    laprdus_set_ssml_enabled(engine, 1);
+
+    /* Set default voice (which initializes phoneme data) */
+    if (laprdus_set_voice(engine, voice, data_dir) != LAPRDUS_OK) {
+        *msg = strdup("Failed to initialize voice. Check data directory.");
+        ERR("%s: %s", *msg, laprdus_get_error_message(engine));
+        laprdus_destroy(engine);
+        engine = NULL;
+        return -1;
+    }
+
+    current_voice_name = strdup(voice);
+
     /* Build voice list for module_list_voices */
     build_voice_list();
 
@@ -597,6 +821,7 @@ void module_speak_sync(const char *data, size_t bytes, SPDMessageType msgtype)
     }
 
     stop_requested = 0;
+    pause_requested = 0;
     speaking = 1;
 
     /* Confirm we're ready to speak */
@@ -605,95 +830,147 @@ void module_speak_sync(const char *data, size_t bytes, SPDMessageType msgtype)
     /* Apply current parameters */
     apply_parameters();
 
-    /* Strip SSML tags - Speech Dispatcher wraps text in <speak>...</speak> */
-    char *text = strdup(data);
-    if (!text) {
-        speaking = 0;
-        module_report_event_stop();
-        return;
-    }
-    size_t text_len = strip_ssml_tags(text, bytes);
-
-    if (text_len == 0) {
-        free(text);
-        speaking = 0;
-        module_report_event_stop();
-        return;
-    }
-
-    /* Handle different message types */
-    int16_t *samples = NULL;
-    LaprdusAudioFormat format;
-    int32_t num_samples = 0;
-
+    int spell = spelling_mode;
     switch (msgtype) {
         case SPD_MSGTYPE_SPELL:
         case SPD_MSGTYPE_CHAR:
         case SPD_MSGTYPE_KEY:
             /* Use spelling mode for character/key announcements */
-            num_samples = laprdus_synthesize_spelled(engine, text, &samples, &format);
+            spell = 1;
             break;
 
         case SPD_MSGTYPE_TEXT:
         case SPD_MSGTYPE_SOUND_ICON:
         default:
-            /* Normal text synthesis */
-            if (spelling_mode) {
-                num_samples = laprdus_synthesize_spelled(engine, text, &samples, &format);
-            } else {
-                num_samples = laprdus_synthesize(engine, text, &samples, &format);
-            }
             break;
     }
 
-    free(text);
+    /* The engine parses the SSML (set up in module_init) */
+    MessageAudio audio;
+    memset(&audio, 0, sizeof(audio));
+    LaprdusAudioFormat format;
+    size_t first_piece = 0;
+    size_t position = 0;
+    int report_marks = 1;
+
+    long resume_piece = find_resume_piece(data, spell);
+    if (resume_piece >= 0) {
+        /* Resuming: take over the paused message's audio */
+        DBG("Resuming paused message at piece %ld", resume_piece);
+        audio = paused_message.audio;
+        format = paused_message.format;
+        memset(&paused_message.audio, 0, sizeof(paused_message.audio));
+        first_piece = (size_t)resume_piece;
+        /* The resent text starts at the piece the pause stopped in, or at
+         * an earlier mark */
+        if (first_piece == paused_message.piece) {
+            position = paused_message.position;
+        } else if (first_piece > 0) {
+            position = audio.mark_offsets[first_piece - 1];
+        }
+        /* Only marks the resent text still carries are reported */
+        report_marks = strstr(data, "<mark") != NULL;
+    } else {
+        int32_t num_samples = 0;
+
+        laprdus_trace_begin("module_speak_sync: synthesize");
+        if (spell) {
+            int16_t *samples = NULL;
+            num_samples = laprdus_synthesize_spelled(engine, data, &samples, &format);
+            if (num_samples > 0 &&
+                !message_audio_write(samples, (size_t)num_samples, &audio)) {
+                num_samples = LAPRDUS_ERROR_OUT_OF_MEMORY;
+            }
+            laprdus_free_buffer(samples);
+        } else {
+            /* Normal text synthesis, with the positions of index marks */
+            num_samples = laprdus_synthesize_to_sink_with_marks(
+                engine, data, message_audio_write, message_audio_mark, &audio, &format);
+        }
+        laprdus_trace_end("module_speak_sync: synthesize");
 
-    if (num_samples <= 0 || !samples) {
-        ERR("Synthesis failed: %s", laprdus_get_error_message(engine));
-        speaking = 0;
-        module_report_event_stop();
-        return;
+        if (num_samples <= 0) {
+            if (num_samples < 0) {
+                ERR("Synthesis failed: %s", laprdus_get_error_message(engine));
+            }
+            message_audio_free(&audio);
+            discard_paused_message();
+            speaking = 0;
+            module_report_event_stop();
+            return;
+        }
     }
+    discard_paused_message();
 
     /* Report begin */
     module_report_event_begin();
 
-    /* Check for stop request before sending audio */
-    module_process(STDIN_FILENO, 0);
-    if (stop_requested) {
-        DBG("Stop requested before audio output");
-        laprdus_free_buffer(samples);
-        speaking = 0;
-        module_report_event_stop();
-        return;
+    /* Send the audio up to each mark in chunks, then the mark */
+    DBG("Sending %zu samples and %zu marks to server (rate=%d, bits=%d, ch=%d)",
+        audio.num_samples, audio.num_marks, format.sample_rate, format.bits_per_sample,
+        format.channels);
+    laprdus_trace_begin("module_speak_sync: output");
+    size_t chunk = (size_t)format.sample_rate * AUDIO_CHUNK_MS / 1000;
+    if (chunk == 0) {
+        chunk = 1;
     }
+    size_t piece = first_piece;
+    for (; piece <= audio.num_marks; piece++) {
+        size_t end = (piece < audio.num_marks) ? audio.mark_offsets[piece] : audio.num_samples;
+
+        /* Check for a stop request before each chunk */
+        module_process(STDIN_FILENO, 0);
+        while (!stop_requested && position < end) {
+            size_t count = (end - position < chunk) ? end - position : chunk;
+            send_audio(audio.samples + position, count, &format);
+            if (stop_requested) {
+                break;  /* Cut short: the chunk is sent again on resume */
+            }
+            position += count;
+            if (position < end) {
+                module_process(STDIN_FILENO, 0);
+            }
+        }
+        if (stop_requested) {
+            break;
+        }
+        if (piece < audio.num_marks && report_marks) {
+            module_report_index_mark(audio.mark_names[piece]);
+        }
+    }
+    laprdus_trace_end("module_speak_sync: output");
 
-    /* Create audio track */
-    AudioTrack track;
-    track.bits = format.bits_per_sample;
-    track.num_channels = format.channels;
-    track.sample_rate = format.sample_rate;
-    track.num_samples = num_samples;
-    track.samples = samples;
-
-#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
-    AudioFormat audio_format = SPD_AUDIO_BE;
-#else
-    AudioFormat audio_format = SPD_AUDIO_LE;
-#endif
+    /* Check for stop again */
+    if (!stop_requested) {
+        module_process(STDIN_FILENO, 0);
+    }
 
-    /* Send audio to server */
-    DBG("Sending %d samples to server (rate=%d, bits=%d, ch=%d)",
-        num_samples, format.sample_rate, format.bits_per_sample, format.channels);
-    module_tts_output_server(&track, audio_format);
+    if (stop_requested && pause_requested) {
+        /* Keep the audio and the position for the resume */
+        DBG("Paused in piece %zu of %zu at sample %zu", piece, audio.num_marks + 1, position);
+        paused_message.valid = 1;
+        paused_message.text = strdup(data);
+        paused_message.audio = audio;
+        paused_message.format = format;
+        paused_message.piece = piece;
+        paused_message.position = position;
+        paused_message.voice = current_voice_name ? strdup(current_voice_name) : NULL;
+        paused_message.rate = current_rate;
+        paused_message.pitch = current_pitch;
+        paused_message.volume = current_volume;
+        paused_message.spell = spell;
+        if (!paused_message.text) {
+            discard_paused_message();
+        }
+        speaking = 0;
+        module_report_event_pause();
+        return;
+    }
 
-    /* Free audio buffer */
-    laprdus_free_buffer(samples);
+    message_audio_free(&audio);
 
-    /* Check for stop again */
-    module_process(STDIN_FILENO, 0);
     if (stop_requested) {
-        DBG("Stop requested after audio output");
+        DBG("Stop requested during audio output");
         speaking = 0;
         module_report_event_stop();
         return;
@@ -707,7 +984,8 @@ void module_speak_sync(const char *data, size_t bytes, SPDMessageType msgtype)
 }
 
 /**
- * Pause speech (not fully supported - we just stop)
+ * Pause speech. The message stops at the next chunk; its audio is kept
+ * and reported paused by module_speak_sync().
  */
 size_t module_pause(void)
 {
@@ -715,8 +993,8 @@ size_t module_pause(void)
 
     if (speaking) {
         stop_requested = 1;
+        pause_requested = 1;
         laprdus_cancel(engine);
-        module_report_event_pause();
     }
 
     return 0;
@@ -750,8 +1028,9 @@ int module_close(void)
         laprdus_cancel(engine);
     }
 
-    /* Free voice list */
+    /* Free voice list and a paused message */
     free_voice_list();
+    discard_paused_message();
 
     /* Destroy engine */
     if (engine) {
@@ -0,0 +1,297 @@
+/*
+ * bench_interrupt.cpp - Interrupt-to-new-audio latency benchmark for LaprdusTTS
+ *
+ * Measures how quickly a higher-priority asynchronous utterance is heard
+ * while a lower-priority one is being spoken. Each trial queues a long
+ * utterance, waits until its audio has started plus a varying delay (so
+ * the interrupt lands at different points of a chunk), then queues a
+ * short utterance of a higher class and waits for the queue to drain.
+ *
+ * Scenarios, mirroring speech-dispatcher message types:
+ *   - key-over-text:      character echo (KEY) interrupts a message (TEXT)
+ *   - text-over-progress: a message (TEXT) interrupts a progress update
+ *
+ * Each scenario runs idle and under load: --load threads synthesize
+ * continuously on engines of their own, competing for the CPU.
+ *
+ * Reported per scenario and load (milliseconds, median, p95 and max):
+ *   - latency_ms: from queuing the interrupt to its first audio chunk,
+ *                 from the END event's submitted_us and first_audio_us
+ *   - stop_ms:    from queuing the interrupt until the interrupted
+ *                 utterance ended
+ * Trials in which the long utterance finished before the interrupt are
+ * counted as missed and left out.
+ *
+ * Build: scons bench-interrupt (links the core sources statically)
+ * Run:   laprdus_bench_interrupt --voices data/voices --output bench_interrupt.json
+ */
+
+#include "laprdus/laprdus_api.h"
+#include "bench_util.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace bench;
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+struct Options {
+    std::string voices_dir = "data/voices";
+    std::string output;
+    int trials = 21;
+    int load = 0;       // Background synthesis threads; 0 = hardware threads
+};
+
+struct Scenario {
+    const char* name;
+    LaprdusPriority background;
+    LaprdusPriority interrupt;
+    const char* interrupt_text;
+};
+
+constexpr Scenario SCENARIOS[] = {
+    {"key-over-text", LAPRDUS_PRIORITY_TEXT, LAPRDUS_PRIORITY_KEY, "a"},
+    {"text-over-progress", LAPRDUS_PRIORITY_PROGRESS, LAPRDUS_PRIORITY_TEXT, "Dobar dan."},
+};
+
+constexpr const char* SENTENCE =
+    "Ovo je dulja poruka koja se dugo govori, a zatim slijedi jos jedna. ";
+
+// Long enough that synthesis outlasts the interrupt delay on fast machines
+std::string long_text() {
+    std::string text;
+    for (int i = 0; i < 200; ++i) {
+        text += SENTENCE;
+    }
+    return text;
+}
+
+// =============================================================================
+// Event Recording
+// =============================================================================
+
+struct EndTimes {
+    uint32_t id = 0;
+    LaprdusError status = LAPRDUS_OK;
+    uint64_t submitted_us = 0;
+    uint64_t first_audio_us = 0;
+    uint64_t finished_us = 0;
+};
+
+struct Recorder {
+    std::mutex mutex;
+    std::vector<EndTimes> ends;
+    std::atomic<bool> audio{false};
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        ends.clear();
+        audio = false;
+    }
+
+    bool find(uint32_t id, EndTimes& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const EndTimes& end : ends) {
+            if (end.id == id) {
+                out = end;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static int LAPRDUS_CALL sink(const LaprdusEvent* event, void* user_data) {
+        auto* self = static_cast<Recorder*>(user_data);
+        if (event->type == LAPRDUS_EVENT_AUDIO) {
+            self->audio = true;
+        } else if (event->type == LAPRDUS_EVENT_END) {
+            std::lock_guard<std::mutex> lock(self->mutex);
+            self->ends.push_back({event->utterance_id, event->status, event->submitted_us,
+                                  event->first_audio_us, event->finished_us});
+        }
+        return 1;
+    }
+};
+
+// =============================================================================
+// Background Load
+// =============================================================================
+
+// Synthesizes continuously on its own engine until stopped
+class LoadThreads {
+public:
+    LoadThreads(int count, const std::string& voices_dir) {
+        for (int i = 0; i < count; ++i) {
+            m_threads.emplace_back([this, voices_dir] { run(voices_dir); });
+        }
+    }
+
+    ~LoadThreads() {
+        m_stop = true;
+        for (std::thread& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+private:
+    void run(const std::string& voices_dir) {
+        LaprdusHandle engine = laprdus_create();
+        if (!engine || laprdus_set_voice(engine, "josip", voices_dir.c_str()) != LAPRDUS_OK) {
+            laprdus_destroy(engine);
+            return;
+        }
+        while (!m_stop) {
+            int16_t* samples = nullptr;
+            LaprdusAudioFormat format;
+            laprdus_synthesize(engine, SENTENCE, &samples, &format);
+            laprdus_free_buffer(samples);
+        }
+        laprdus_destroy(engine);
+    }
+
+    std::vector<std::thread> m_threads;
+    std::atomic<bool> m_stop{false};
+};
+
+// =============================================================================
+// Measurement
+// =============================================================================
+
+double us_to_ms(uint64_t later, uint64_t earlier) {
+    return later >= earlier ? static_cast<double>(later - earlier) / 1000.0 : 0.0;
+}
+
+void write_stats(std::ostream& out, const char* name, const std::vector<double>& values) {
+    out << "\"" << name << "\": {\"median\": " << median(values)
+        << ", \"p95\": " << percentile(values, 95.0)
+        << ", \"max\": " << percentile(values, 100.0) << "}";
+}
+
+bool run_scenario(LaprdusHandle engine, const Scenario& scenario, int load,
+                  const Options& opts, std::ostream& out) {
+    const std::string text = long_text();
+    Recorder recorder;
+    std::vector<double> latency, stop;
+    int missed = 0;
+
+    for (int i = 0; i < opts.trials; ++i) {
+        recorder.reset();
+        int32_t background = laprdus_speak_async_with_priority(
+            engine, text.c_str(), scenario.background, Recorder::sink, &recorder);
+        if (background <= 0) {
+            return false;
+        }
+
+        auto deadline = Clock::now() + std::chrono::seconds(5);
+        while (!recorder.audio && Clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        // Spread the interrupt over the chunk period
+        std::this_thread::sleep_for(std::chrono::milliseconds((i * 7) % 50));
+
+        int32_t interrupt = laprdus_speak_async_with_priority(
+            engine, scenario.interrupt_text, scenario.interrupt, Recorder::sink, &recorder);
+        if (interrupt <= 0 || laprdus_flush(engine) != LAPRDUS_OK) {
+            return false;
+        }
+
+        EndTimes stopped, spoken;
+        if (!recorder.find(static_cast<uint32_t>(background), stopped) ||
+            !recorder.find(static_cast<uint32_t>(interrupt), spoken) ||
+            spoken.status != LAPRDUS_OK || spoken.first_audio_us == 0) {
+            return false;
+        }
+        if (stopped.status != LAPRDUS_ERROR_CANCELLED) {
+            ++missed;
+            continue;
+        }
+        latency.push_back(us_to_ms(spoken.first_audio_us, spoken.submitted_us));
+        stop.push_back(us_to_ms(stopped.finished_us, spoken.submitted_us));
+    }
+    if (latency.empty()) {
+        return false;
+    }
+
+    out << "{\"scenario\": \"" << scenario.name << "\""
+        << ", \"load_threads\": " << load
+        << ", \"trials\": " << latency.size()
+        << ", \"missed\": " << missed << ", ";
+    write_stats(out, "latency_ms", latency);
+    out << ", ";
+    write_stats(out, "stop_ms", stop);
+    out << "}";
+    return true;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char* argv[]) {
+    Options opts;
+
+    OptionParser parser;
+    parser.add("--voices", "DIR", "Directory with Josip.bin (default: data/voices)",
+               opts.voices_dir)
+          .add("--trials", "N", "Interrupts per scenario and load (default: 21)", opts.trials, 1)
+          .add("--load", "N", "Background synthesis threads (default: hardware threads)",
+               opts.load, 0)
+          .add("--output", "FILE", "Write JSON results to FILE (default: stdout)", opts.output);
+    int status = 0;
+    if (!parser.parse(argc, argv, status)) {
+        return status;
+    }
+    if (opts.load == 0) {
+        opts.load = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    LaprdusHandle engine = laprdus_create();
+    if (!engine || laprdus_set_voice(engine, "josip", opts.voices_dir.c_str()) != LAPRDUS_OK) {
+        std::cerr << "Error: cannot load the voice from " << opts.voices_dir << "\n";
+        laprdus_destroy(engine);
+        return 1;
+    }
+    laprdus_warmup(engine);
+
+    std::ostringstream json;
+    json << "{\n  \"laprdus_version\": \"" << laprdus_get_version() << "\""
+         << ",\n  \"trials\": " << opts.trials
+         << ",\n  \"results\": [\n";
+
+    bool ok = true;
+    const int loads[] = {0, opts.load};
+    for (size_t l = 0; l < std::size(loads); ++l) {
+        LoadThreads threads(loads[l], opts.voices_dir);
+        for (size_t s = 0; s < std::size(SCENARIOS); ++s) {
+            json << "    ";
+            if (!run_scenario(engine, SCENARIOS[s], loads[l], opts, json)) {
+                ok = false;
+                json << "{\"scenario\": \"" << SCENARIOS[s].name << "\", \"error\": true}";
+            }
+            bool last = l + 1 == std::size(loads) && s + 1 == std::size(SCENARIOS);
+            json << (last ? "\n" : ",\n");
+        }
+    }
+    json << "  ]\n}\n";
+    laprdus_destroy(engine);
+
+    if (!write_results(json.str(), opts.output, "Interrupt benchmark")) {
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+/*
+ * bench_kernels.cpp - DSP kernel microbenchmark for LaprdusTTS
+ *
+ * Times each sample kernel with every instruction set the CPU supports,
+ * over a buffer the size of a short utterance and over one crossfade
+ * overlap (the size the synthesizer actually blends between phonemes).
+ *
+ * Reported per instruction set and kernel:
+ *   - ns_per_sample: median time per sample
+ *   - speedup: scalar time divided by this time
+ *
+ * Build: scons bench-kernels (links the core sources statically)
+ * Run:   laprdus_bench_kernels --output bench_kernels.json
+ */
+
+#include "audio/dsp_kernels.hpp"
+#include "bench_util.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace laprdus;
+using namespace bench;
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+struct Options {
+    std::string output;
+    size_t samples = 22050;   // Half a second at the native rate
+    size_t overlap = 64;      // CROSSFADE_SAMPLES in the synthesizer
+    int iterations = 51;
+};
+
+constexpr dsp::Isa ISAS[] = {dsp::Isa::Scalar, dsp::Isa::SSE2, dsp::Isa::AVX2, dsp::Isa::NEON};
+
+// =============================================================================
+// Timing
+// =============================================================================
+
+struct Buffers {
+    std::vector<AudioSample> dest;
+    std::vector<AudioSample> src;
+    std::vector<float> floats;
+};
+
+struct Kernel {
+    const char* name;
+    std::function<void(Buffers&, size_t)> run;
+};
+
+const Kernel KERNELS[] = {
+    {"gain", [](Buffers& b, size_t n) {
+        dsp::apply_gain(b.dest.data(), n, 1.0f);
+    }},
+    {"gain_truncate", [](Buffers& b, size_t n) {
+        dsp::apply_gain(b.dest.data(), n, 1.0f, dsp::Rounding::TowardZero);
+    }},
+    {"crossfade_linear", [](Buffers& b, size_t n) {
+        dsp::crossfade(b.dest.data(), b.src.data(), n);
+    }},
+    {"crossfade_equal_power", [](Buffers& b, size_t n) {
+        dsp::crossfade(b.dest.data(), b.src.data(), n, dsp::FadeCurve::EqualPower);
+    }},
+    {"to_float", [](Buffers& b, size_t n) {
+        dsp::to_float(b.src.data(), b.floats.data(), n);
+    }},
+    {"from_float", [](Buffers& b, size_t n) {
+        dsp::from_float(b.floats.data(), b.dest.data(), n);
+    }},
+    {"quantize", [](Buffers& b, size_t n) {
+        dsp::quantize(b.floats.data(), b.dest.data(), n, 0.7f);
+    }},
+};
+
+// Median nanoseconds per sample over the iterations. Each iteration runs
+// the kernel often enough to cover about a million samples.
+double time_kernel(const Kernel& kernel, Buffers& buffers, size_t count, int iterations) {
+    size_t repeats = std::max<size_t>(1, 1000000 / std::max<size_t>(count, 1));
+    std::vector<double> times;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = Clock::now();
+        for (size_t r = 0; r < repeats; ++r) {
+            kernel.run(buffers, count);
+        }
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        times.push_back(ns / static_cast<double>(repeats * count));
+    }
+    return median(times);
+}
+
+void run_size(const Options& opts, const char* label, size_t count, std::ostream& out) {
+    Buffers buffers;
+    std::mt19937 rng(41);
+    std::uniform_int_distribution<int> dist(-20000, 20000);
+    buffers.dest.resize(count);
+    buffers.src.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        buffers.dest[i] = static_cast<AudioSample>(dist(rng));
+        buffers.src[i] = static_cast<AudioSample>(dist(rng));
+    }
+    buffers.floats.resize(count);
+    dsp::to_float(buffers.src.data(), buffers.floats.data(), count);
+
+    out << "    \"" << label << "\": {\"samples\": " << count << ", \"isas\": [\n";
+    std::vector<double> scalar(std::size(KERNELS));
+    bool first = true;
+    for (dsp::Isa isa : ISAS) {
+        if (!dsp::set_isa(isa)) {
+            continue;
+        }
+        out << (first ? "" : ",\n") << "      {\"isa\": \"" << dsp::isa_name(isa) << "\"";
+        first = false;
+        for (size_t k = 0; k < std::size(KERNELS); ++k) {
+            double ns = time_kernel(KERNELS[k], buffers, count, opts.iterations);
+            if (isa == dsp::Isa::Scalar) {
+                scalar[k] = ns;
+            }
+            out << ", \"" << KERNELS[k].name << "\": {\"ns_per_sample\": " << ns
+                << ", \"speedup\": " << (ns > 0.0 ? scalar[k] / ns : 0.0) << "}";
+        }
+        out << "}";
+    }
+    out << "\n    ]}";
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char* argv[]) {
+    Options opts;
+
+    OptionParser parser;
+    parser.add("--samples", "N", "Samples in the long buffer (default: 22050)", opts.samples, 1)
+          .add("--overlap", "N", "Samples in the crossfade-sized buffer (default: 64)",
+               opts.overlap, 1)
+          .add("--iterations", "N", "Timings per kernel and instruction set (default: 51)",
+               opts.iterations, 1)
+          .add("--output", "FILE", "Write JSON results to FILE (default: stdout)", opts.output);
+    int status = 0;
+    if (!parser.parse(argc, argv, status)) {
+        return status;
+    }
+
+    dsp::Isa automatic = dsp::active_isa();
+
+    std::ostringstream json;
+    json << "{\n  \"iterations\": " << opts.iterations
+         << ",\n  \"automatic_isa\": \"" << dsp::isa_name(automatic) << "\",\n  \"buffers\": {\n";
+    run_size(opts, "utterance", opts.samples, json);
+    json << ",\n";
+    run_size(opts, "overlap", opts.overlap, json);
+    json << "\n  }\n}\n";
+
+    dsp::set_isa(automatic);
+
+    return write_results(json.str(), opts.output, "Kernel benchmark") ? 0 : 1;
+}
@@ -0,0 +1,350 @@
+/*
+ * bench_packs.cpp - Voice pack size and decode speed benchmark for LaprdusTTS
+ *
+ * Compresses each voice pack with the phoneme codec (as the packer's
+ * --compress option does), checks that every phoneme decodes back
+ * bit-exactly, and compares loading the raw and compressed packs from
+ * memory. File reads are timed separately (page cache warm): with the
+ * smaller pack they can only get cheaper, so the decode cost is what
+ * startup has to pay for. Each load is also timed with checksum
+ * verification, and the raw pack once more XOR encrypted.
+ *
+ * Reported per voice:
+ *   - raw_bytes / compressed_bytes: pack sizes
+ *   - encode_ms: time to compress the pack (packer side, once)
+ *   - eager_ms:  load_from_memory() with every phoneme decoded (median)
+ *   - lazy_ms:   load_from_memory() in lazy mode, index only (median)
+ *   - decode_all_ms: lazy load followed by decode_all() (median)
+ *   - decode_msamples_per_s: eager decode throughput of the compressed pack
+ *   - read_ms:   reading the raw pack file (median)
+ *   - verified_eager_ms / verified_lazy_ms: the same loads with CRC32
+ *                verification enabled (median)
+ *   - crc_gb_per_s: CRC32 throughput implied by the lazy load difference
+ *   - bytewise_crc_ms: the packer's table-per-byte CRC32 over the same data
+ *   - encrypted: eager and lazy loads of the raw pack XOR encrypted
+ *
+ * Build: scons bench-packs (links the core sources statically)
+ * Run:   laprdus_bench_packs --voices data/voices --output bench_packs.json
+ */
+
+#include "audio/phoneme_data.hpp"
+#include "audio/phoneme_codec.hpp"
+#include "bench_util.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace laprdus;
+using namespace bench;
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+struct Options {
+    std::string voices_dir = "data/voices";
+    std::string output;
+    int iterations = 50;
+};
+
+constexpr const char* VOICE_FILES[] = {"Josip.bin", "Vlado.bin"};
+
+// =============================================================================
+// Pack Conversion
+// =============================================================================
+
+// Bytewise CRC32 as computed by the packer, the baseline for verification
+uint32_t bytewise_crc32(const uint8_t* data, size_t size) {
+    static uint32_t table[256];
+    if (table[1] == 0) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int j = 0; j < 8; ++j) {
+                c = (c >> 1) ^ ((c & 1) ? 0xEDB88320 : 0);
+            }
+            table[i] = c;
+        }
+    }
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+// Rebuild an unencrypted pack with compressed phoneme audio. Returns an
+// empty vector if the pack cannot be read or does not round-trip.
+std::vector<uint8_t> compress_pack(const std::vector<uint8_t>& pack, size_t& samples_total) {
+    PackedFileHeader header;
+    if (pack.size() < sizeof(header)) {
+        return {};
+    }
+    std::memcpy(&header, pack.data(), sizeof(header));
+    if (header.flags & (PACKED_FLAG_ENCRYPTED | PACKED_FLAG_COMPRESSED) ||
+        header.data_offset > pack.size() ||
+        header.index_offset + header.phoneme_count * sizeof(PhonemeIndexEntry) > header.data_offset) {
+        return {};
+    }
+
+    std::vector<PhonemeIndexEntry> index(header.phoneme_count);
+    std::memcpy(index.data(), pack.data() + header.index_offset,
+                index.size() * sizeof(PhonemeIndexEntry));
+
+    std::vector<uint8_t> audio;
+    samples_total = 0;
+    for (PhonemeIndexEntry& entry : index) {
+        if (header.data_offset + static_cast<size_t>(entry.data_offset) + entry.original_size >
+            pack.size()) {
+            return {};
+        }
+        size_t count = entry.original_size / sizeof(AudioSample);
+        std::vector<AudioSample> samples(count);
+        std::memcpy(samples.data(), pack.data() + header.data_offset + entry.data_offset,
+                    count * sizeof(AudioSample));
+
+        std::vector<uint8_t> compressed = compress_phoneme(samples.data(), count);
+        std::vector<AudioSample> decoded(count);
+        if (!decompress_phoneme(compressed.data(), compressed.size(), decoded.data(), count) ||
+            decoded != samples) {
+            std::cerr << "Error: phoneme " << entry.phoneme_id << " does not round-trip\n";
+            return {};
+        }
+
+        entry.data_offset = static_cast<uint32_t>(audio.size());
+        entry.compressed_size = static_cast<uint32_t>(compressed.size());
+        audio.insert(audio.end(), compressed.begin(), compressed.end());
+        samples_total += count;
+    }
+
+    header.flags |= PACKED_FLAG_COMPRESSED;
+    header.total_size = static_cast<uint32_t>(header.data_offset + audio.size());
+    header.checksum = bytewise_crc32(audio.data(), audio.size());
+
+    std::vector<uint8_t> result(header.data_offset);
+    std::memcpy(result.data(), &header, sizeof(header));
+    std::memcpy(result.data() + header.index_offset, index.data(),
+                index.size() * sizeof(PhonemeIndexEntry));
+    result.insert(result.end(), audio.begin(), audio.end());
+    return result;
+}
+
+// =============================================================================
+// Measurements
+// =============================================================================
+
+struct LoadTimes {
+    double eager_ms = 0.0;
+    double lazy_ms = 0.0;
+    double decode_all_ms = 0.0;
+    double verified_eager_ms = 0.0;
+    double verified_lazy_ms = 0.0;
+};
+
+// Key used for the encrypted variant, the packer's key length
+constexpr uint8_t BENCH_KEY[32] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF,
+    0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0x0F, 0x1E, 0x2D, 0x3C, 0x4B, 0x5A, 0x69, 0x78,
+};
+
+// Time one load_from_memory() call, or return a negative value on failure
+double time_load(const std::vector<uint8_t>& pack, span<const uint8_t> key,
+                 bool lazy, bool verify, bool decode_all = false) {
+    PhonemeData data;
+    data.set_lazy(lazy);
+    data.set_verify_checksum(verify);
+    auto start = Clock::now();
+    if (!data.load_from_memory(pack.data(), pack.size(), key)) {
+        return -1.0;
+    }
+    if (decode_all) {
+        data.decode_all();
+    }
+    return elapsed_ms(start);
+}
+
+bool time_loads(const std::vector<uint8_t>& pack, span<const uint8_t> key,
+                int iterations, LoadTimes& times) {
+    std::vector<double> runs[5];
+    for (int i = 0; i < iterations; ++i) {
+        runs[0].push_back(time_load(pack, key, false, false));
+        runs[1].push_back(time_load(pack, key, true, false));
+        runs[2].push_back(time_load(pack, key, true, false, true));
+        runs[3].push_back(time_load(pack, key, false, true));
+        runs[4].push_back(time_load(pack, key, true, true));
+    }
+    for (const auto& run : runs) {
+        if (*std::min_element(run.begin(), run.end()) < 0.0) {
+            return false;
+        }
+    }
+    times.eager_ms = median(runs[0]);
+    times.lazy_ms = median(runs[1]);
+    times.decode_all_ms = median(runs[2]);
+    times.verified_eager_ms = median(runs[3]);
+    times.verified_lazy_ms = median(runs[4]);
+    return true;
+}
+
+// XOR the data section the way the packer's --encrypt does
+std::vector<uint8_t> encrypt_pack(std::vector<uint8_t> pack) {
+    PackedFileHeader header;
+    std::memcpy(&header, pack.data(), sizeof(header));
+    for (size_t i = header.data_offset; i < pack.size(); ++i) {
+        pack[i] ^= BENCH_KEY[(i - header.data_offset) % sizeof(BENCH_KEY)];
+    }
+    header.flags |= PACKED_FLAG_ENCRYPTED;
+    header.checksum = bytewise_crc32(pack.data() + header.data_offset,
+                                     pack.size() - header.data_offset);
+    std::memcpy(pack.data(), &header, sizeof(header));
+    return pack;
+}
+
+double time_read(const std::string& path, int iterations) {
+    std::vector<double> reads;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = Clock::now();
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        std::vector<uint8_t> data(static_cast<size_t>(in.tellg()));
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(data.data()), data.size());
+        reads.push_back(elapsed_ms(start));
+    }
+    return median(reads);
+}
+
+// Check that both packs yield identical phonemes
+bool same_phonemes(const std::vector<uint8_t>& raw, const std::vector<uint8_t>& compressed) {
+    PhonemeData a, b;
+    if (!a.load_from_memory(raw.data(), raw.size()) ||
+        !b.load_from_memory(compressed.data(), compressed.size())) {
+        return false;
+    }
+    for (size_t i = 0; i < static_cast<size_t>(Phoneme::COUNT); ++i) {
+        span<const AudioSample> x = a.get_phoneme(static_cast<Phoneme>(i));
+        span<const AudioSample> y = b.get_phoneme(static_cast<Phoneme>(i));
+        if (x.size() != y.size() || !std::equal(x.begin(), x.end(), y.begin())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void write_times(std::ostream& out, const char* name, const LoadTimes& times) {
+    out << "\"" << name << "\": {\"eager_ms\": " << times.eager_ms
+        << ", \"lazy_ms\": " << times.lazy_ms
+        << ", \"decode_all_ms\": " << times.decode_all_ms
+        << ", \"verified_eager_ms\": " << times.verified_eager_ms
+        << ", \"verified_lazy_ms\": " << times.verified_lazy_ms << "}";
+}
+
+bool run_voice(const Options& opts, const char* file, std::ostream& out) {
+    std::string path = join_path(opts.voices_dir, file);
+    std::ifstream in(path, std::ios::binary);
+    std::vector<uint8_t> raw((std::istreambuf_iterator<char>(in)),
+                             std::istreambuf_iterator<char>());
+    if (raw.empty()) {
+        std::cerr << "Error: cannot read " << path << "\n";
+        return false;
+    }
+
+    size_t samples = 0;
+    auto start = Clock::now();
+    std::vector<uint8_t> compressed = compress_pack(raw, samples);
+    double encode_ms = elapsed_ms(start);
+    if (compressed.empty() || !same_phonemes(raw, compressed)) {
+        std::cerr << "Error: " << path << " cannot be compressed losslessly\n";
+        return false;
+    }
+
+    std::vector<uint8_t> encrypted = encrypt_pack(raw);
+    LoadTimes raw_times, compressed_times, encrypted_times;
+    if (!time_loads(raw, {}, opts.iterations, raw_times) ||
+        !time_loads(compressed, {}, opts.iterations, compressed_times) ||
+        !time_loads(encrypted, BENCH_KEY, opts.iterations, encrypted_times)) {
+        std::cerr << "Error: " << path << " failed to load\n";
+        return false;
+    }
+
+    double throughput = compressed_times.eager_ms > 0.0
+        ? samples / (compressed_times.eager_ms * 1000.0) : 0.0;
+
+    // Verification cost, against the packer's bytewise CRC
+    PackedFileHeader header;
+    std::memcpy(&header, raw.data(), sizeof(header));
+    size_t data_bytes = raw.size() - header.data_offset;
+    double crc_ms = raw_times.verified_lazy_ms - raw_times.lazy_ms;
+    double crc_throughput = crc_ms > 0.0 ? data_bytes / (crc_ms * 1e6) : 0.0;
+    std::vector<double> bytewise;
+    for (int i = 0; i < opts.iterations; ++i) {
+        start = Clock::now();
+        volatile uint32_t crc = bytewise_crc32(raw.data() + header.data_offset, data_bytes);
+        (void)crc;
+        bytewise.push_back(elapsed_ms(start));
+    }
+
+    out << "{\"voice\": \"" << file << "\""
+        << ", \"raw_bytes\": " << raw.size()
+        << ", \"compressed_bytes\": " << compressed.size()
+        << ", \"ratio\": " << static_cast<double>(compressed.size()) / raw.size()
+        << ", \"samples\": " << samples
+        << ", \"encode_ms\": " << encode_ms
+        << ", \"decode_msamples_per_s\": " << throughput
+        << ", \"read_ms\": " << time_read(path, opts.iterations)
+        << ", \"crc_gb_per_s\": " << crc_throughput
+        << ", \"bytewise_crc_ms\": " << median(bytewise) << ", ";
+    write_times(out, "raw", raw_times);
+    out << ", ";
+    write_times(out, "compressed", compressed_times);
+    out << ", ";
+    write_times(out, "encrypted", encrypted_times);
+    out << "}";
+    return true;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char* argv[]) {
+    Options opts;
+
+    OptionParser parser;
+    parser.add("--voices", "DIR",
+               "Directory with Josip.bin and Vlado.bin (default: data/voices)", opts.voices_dir)
+          .add("--iterations", "N", "Loads timed per pack and mode (default: 50)",
+               opts.iterations, 1)
+          .add("--output", "FILE", "Write JSON results to FILE (default: stdout)", opts.output);
+    int status = 0;
+    if (!parser.parse(argc, argv, status)) {
+        return status;
+    }
+
+    std::ostringstream json;
+    json << "{\n  \"iterations\": " << opts.iterations << ",\n  \"voices\": [\n";
+    bool ok = true;
+    for (size_t v = 0; v < std::size(VOICE_FILES); ++v) {
+        json << "    ";
+        if (!run_voice(opts, VOICE_FILES[v], json)) {
+            ok = false;
+            json << "{\"voice\": \"" << VOICE_FILES[v] << "\", \"error\": true}";
+        }
+        json << (v + 1 < std::size(VOICE_FILES) ? ",\n" : "\n");
+    }
+    json << "  ]\n}\n";
+
+    if (!write_results(json.str(), opts.output, "Pack benchmark")) {
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
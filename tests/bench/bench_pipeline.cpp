@@ -0,0 +1,442 @@
+/*
+ * bench_pipeline.cpp - Per-stage performance benchmark for LaprdusTTS
+ *
+ * Times each stage of the synthesis pipeline separately on the bundled
+ * Croatian and Serbian corpora, plus end-to-end synthesize() and
+ * synthesize_spelled(), and writes the results as JSON. End-to-end
+ * synthesis is timed with and without the look-ahead phoneme mapper.
+ * Parallel rendering is measured by synthesizing each whole corpus as
+ * one document with 1 to --max-threads render threads.
+ *
+ * Reported per stage:
+ *   - p50/p99/mean latency per utterance
+ *   - throughput in input characters per second
+ *   - real-time factor (processing time / synthesized audio duration)
+ *   - heap allocations per utterance (global operator new calls)
+ *
+ * Build: scons bench (links the core sources statically)
+ * Run:   laprdus_bench --voices data/voices --dictionaries data/dictionary
+ *                      --corpus tests/bench --output bench_results.json
+ */
+
+#include "core/tts_engine.hpp"
+#include "core/phoneme_mapper.hpp"
+#include "core/croatian_numbers.hpp"
+#include "core/inflection.hpp"
+#include "core/pronunciation_dict.hpp"
+#include "core/emoji_dict.hpp"
+#include "audio/phoneme_data.hpp"
+#include "audio/audio_synthesizer.hpp"
+#include "audio/sonic_processor.hpp"
+#include "audio/formant_pitch.hpp"
+#include "bench_util.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// =============================================================================
+// Allocation Counting
+// =============================================================================
+
+static std::atomic<uint64_t> g_allocations{0};
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+using namespace laprdus;
+using namespace bench;
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+struct Options {
+    std::string voices_dir = "data/voices";
+    std::string dictionaries_dir = "data/dictionary";
+    std::string corpus_dir = "tests/bench";
+    std::string output;
+    int iterations = 5;
+    int warmup = 1;
+    int max_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+};
+
+struct Corpus {
+    const char* name;
+    const char* file;
+    const char* voice_file;
+};
+
+constexpr Corpus CORPORA[] = {
+    {"croatian", "corpus_hr.txt", "Josip.bin"},
+    {"serbian",  "corpus_sr.txt", "Vlado.bin"},
+};
+
+// Parameters used for the isolated DSP stages
+constexpr float BENCH_RATE = 1.5f;
+constexpr float BENCH_PITCH = 1.2f;
+constexpr float BENCH_USER_PITCH = 1.2f;
+
+// =============================================================================
+// Stage Statistics
+// =============================================================================
+
+class Stage {
+public:
+    explicit Stage(const char* name) : m_name(name) {}
+
+    // Time one call; repeated calls within an utterance are accumulated
+    template <typename Fn>
+    auto time(Fn&& fn) {
+        uint64_t allocs = g_allocations.load(std::memory_order_relaxed);
+        auto start = Clock::now();
+        auto result = fn();
+        m_pending_ms += elapsed_ms(start);
+        m_pending_allocs += g_allocations.load(std::memory_order_relaxed) - allocs;
+        return result;
+    }
+
+    // Close the current utterance
+    void commit(size_t chars, double audio_seconds) {
+        m_latency_ms.push_back(m_pending_ms);
+        m_total_allocs += m_pending_allocs;
+        m_chars += chars;
+        m_audio_seconds += audio_seconds;
+        discard();
+    }
+
+    // Drop the current utterance (warm-up passes)
+    void discard() {
+        m_pending_ms = 0.0;
+        m_pending_allocs = 0;
+    }
+
+    void write_json(std::ostream& out) const;
+
+private:
+    const char* m_name;
+    std::vector<double> m_latency_ms;
+    uint64_t m_total_allocs = 0;
+    size_t m_chars = 0;
+    double m_audio_seconds = 0.0;
+    double m_pending_ms = 0.0;
+    uint64_t m_pending_allocs = 0;
+};
+
+void Stage::write_json(std::ostream& out) const {
+    double total_ms = 0.0;
+    for (double ms : m_latency_ms) {
+        total_ms += ms;
+    }
+    size_t count = m_latency_ms.size();
+    double total_s = total_ms / 1000.0;
+
+    out << "{\"name\": \"" << m_name << "\""
+        << ", \"utterances\": " << count
+        << ", \"total_ms\": " << total_ms
+        << ", \"mean_ms\": " << (count ? total_ms / static_cast<double>(count) : 0.0)
+        << ", \"p50_ms\": " << percentile(m_latency_ms, 50.0)
+        << ", \"p99_ms\": " << percentile(m_latency_ms, 99.0)
+        << ", \"chars_per_sec\": " << (total_s > 0.0 ? static_cast<double>(m_chars) / total_s : 0.0)
+        << ", \"rtf\": " << (m_audio_seconds > 0.0 ? total_s / m_audio_seconds : 0.0)
+        << ", \"allocs_per_utterance\": "
+        << (count ? static_cast<double>(m_total_allocs) / static_cast<double>(count) : 0.0)
+        << "}";
+}
+
+// =============================================================================
+// Helpers
+// =============================================================================
+
+std::vector<std::string> load_corpus(const std::string& path) {
+    std::vector<std::string> lines;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            lines.push_back(line);
+        }
+    }
+    return lines;
+}
+
+size_t utf8_length(const std::string& text) {
+    size_t count = 0;
+    for (unsigned char c : text) {
+        if ((c & 0xC0) != 0x80) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+double audio_seconds(const AudioBuffer& buffer) {
+    return buffer.sample_rate ? static_cast<double>(buffer.samples.size()) / buffer.sample_rate : 0.0;
+}
+
+// =============================================================================
+// Thread Scaling
+// =============================================================================
+
+// Synthesize the corpus as one document per render thread count
+void write_scaling(TTSEngine& engine, const std::vector<std::string>& lines,
+                   const Options& opts, std::ostream& out) {
+    std::string document;
+    for (const std::string& line : lines) {
+        document += line;
+        document += '\n';
+    }
+
+    double serial_ms = 0.0;
+    for (int threads = 1; threads <= opts.max_threads; ++threads) {
+        engine.set_render_threads(static_cast<uint32_t>(threads));
+
+        std::vector<double> latency_ms;
+        for (int pass = 0; pass < opts.warmup + opts.iterations; ++pass) {
+            auto start = Clock::now();
+            SynthesisResult result = engine.synthesize(document);
+            double ms = elapsed_ms(start);
+            if (pass >= opts.warmup && result.success) {
+                latency_ms.push_back(ms);
+            }
+        }
+
+        double median_ms = percentile(latency_ms, 50.0);
+        if (threads == 1) {
+            serial_ms = median_ms;
+        }
+        out << "       {\"threads\": " << threads
+            << ", \"p50_ms\": " << median_ms
+            << ", \"speedup\": " << (median_ms > 0.0 ? serial_ms / median_ms : 0.0)
+            << "}" << (threads < opts.max_threads ? ",\n" : "\n");
+    }
+    engine.set_render_threads(1);
+}
+
+// =============================================================================
+// Corpus Benchmark
+// =============================================================================
+
+bool run_corpus(const Corpus& corpus, const Options& opts, std::ostream& out) {
+    std::vector<std::string> lines = load_corpus(join_path(opts.corpus_dir, corpus.file));
+    if (lines.empty()) {
+        std::cerr << "Error: empty or missing corpus " << corpus.file << "\n";
+        return false;
+    }
+
+    std::string voice_path = join_path(opts.voices_dir, corpus.voice_file);
+    std::string dict_path = join_path(opts.dictionaries_dir, "internal.json");
+    std::string spelling_path = join_path(opts.dictionaries_dir, "spelling.json");
+    std::string emoji_path = join_path(opts.dictionaries_dir, "emoji.json");
+
+    // End-to-end engine
+    TTSEngine engine;
+    if (!engine.initialize(voice_path)) {
+        std::cerr << "Error: failed to load voice " << voice_path << "\n";
+        return false;
+    }
+    engine.load_dictionary(dict_path);
+    engine.load_spelling_dictionary(spelling_path);
+    engine.load_emoji_dictionary(emoji_path);
+    engine.set_emoji_enabled(true);
+
+    // Standalone components for per-stage timing
+    PhonemeData phoneme_data;
+    if (!phoneme_data.load_from_file(voice_path)) {
+        std::cerr << "Error: failed to load voice " << voice_path << "\n";
+        return false;
+    }
+    PronunciationDictionary dictionary;
+    dictionary.load_from_file(dict_path);
+    EmojiDictionary emoji_dictionary;
+    emoji_dictionary.load_from_file(emoji_path);
+    CroatianNumbers number_converter;
+    PhonemeMapper mapper;
+    InflectionProcessor inflection;
+    AudioSynthesizer synthesizer(phoneme_data);
+    synthesizer.set_voice_params(VoiceParams{});  // Concatenation only
+
+    Stage preprocess("preprocess_text");
+    Stage analyze("analyze_text");
+    Stage map("map_text");
+    Stage concat("concatenate");
+    Stage rate("apply_rate");
+    Stage pitch("apply_pitch");
+    Stage formant_pitch("change_pitch_preserve_formants");
+    Stage inflect("apply_inflection");
+    Stage synthesize("synthesize");
+    Stage synthesize_serial("synthesize_no_lookahead");
+    Stage spelled("synthesize_spelled");
+    Stage* stages[] = {&preprocess, &analyze, &map, &concat, &rate, &pitch,
+                       &formant_pitch, &inflect, &synthesize, &synthesize_serial, &spelled};
+
+    size_t total_chars = 0;
+    double total_audio = 0.0;
+
+    for (int pass = 0; pass < opts.warmup + opts.iterations; ++pass) {
+        bool record = pass >= opts.warmup;
+
+        for (const std::string& line : lines) {
+            size_t chars = utf8_length(line);
+
+            // Front end
+            std::string text = preprocess.time([&] {
+                std::string result = emoji_dictionary.replace_emojis(line);
+                result = dictionary.apply(result);
+                return number_converter.convert_numbers_in_text(result);
+            });
+            std::vector<TextSegment> segments = analyze.time([&] {
+                return inflection.analyze_text(text);
+            });
+
+            // Back end, per segment
+            for (const TextSegment& segment : segments) {
+                std::vector<PhonemeToken> tokens = map.time([&] {
+                    return mapper.map_text(PhonemeMapper::utf32_to_utf8(segment.text));
+                });
+                if (tokens.empty()) {
+                    continue;
+                }
+                AudioBuffer raw = concat.time([&] { return synthesizer.synthesize(tokens); });
+
+                rate.time([&] { return sonic::change_speed(raw, BENCH_RATE); });
+                pitch.time([&] { return sonic::change_pitch(raw, BENCH_PITCH); });
+                formant_pitch.time([&] {
+                    return formant::change_pitch_preserve_formants(raw, BENCH_USER_PITCH);
+                });
+                inflect.time([&] {
+                    return inflection.apply_inflection(raw, segment.inflection, tokens.size());
+                });
+            }
+
+            // End to end
+            SynthesisResult result = synthesize.time([&] { return engine.synthesize(line); });
+            double seconds = audio_seconds(result.audio);
+
+            // Same, with phoneme mapping and rendering on one thread
+            engine.set_lookahead_enabled(false);
+            synthesize_serial.time([&] { return engine.synthesize(line); });
+            engine.set_lookahead_enabled(true);
+
+            std::string first_word = line.substr(0, line.find(' '));
+            SynthesisResult spelled_result = spelled.time([&] {
+                return engine.synthesize_spelled(first_word);
+            });
+
+            if (!record) {
+                for (Stage* stage : stages) {
+                    stage->discard();
+                }
+                continue;
+            }
+
+            for (Stage* stage : stages) {
+                if (stage == &spelled) {
+                    stage->commit(utf8_length(first_word), audio_seconds(spelled_result.audio));
+                } else {
+                    stage->commit(chars, seconds);
+                }
+            }
+            total_chars += chars;
+            total_audio += seconds;
+        }
+    }
+
+    out << "    {\"corpus\": \"" << corpus.name << "\""
+        << ", \"voice\": \"" << corpus.voice_file << "\""
+        << ", \"utterances\": " << lines.size()
+        << ", \"chars\": " << total_chars
+        << ", \"audio_seconds\": " << total_audio
+        << ",\n     \"stages\": [\n";
+    for (size_t i = 0; i < std::size(stages); ++i) {
+        out << "       ";
+        stages[i]->write_json(out);
+        out << (i + 1 < std::size(stages) ? ",\n" : "\n");
+    }
+    out << "     ],\n     \"scaling\": [\n";
+    write_scaling(engine, lines, opts, out);
+    out << "     ]}";
+    return true;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char* argv[]) {
+    Options opts;
+
+    OptionParser parser;
+    parser.add("--voices", "DIR", "Directory with Josip.bin/Vlado.bin (default: data/voices)",
+               opts.voices_dir)
+          .add("--dictionaries", "DIR",
+               "Directory with dictionary JSON files (default: data/dictionary)",
+               opts.dictionaries_dir)
+          .add("--corpus", "DIR", "Directory with corpus_*.txt files (default: tests/bench)",
+               opts.corpus_dir)
+          .add("--iterations", "N", "Measured passes over each corpus (default: 5)",
+               opts.iterations, 1)
+          .add("--warmup", "N", "Unmeasured passes before measuring (default: 1)", opts.warmup, 0)
+          .add("--max-threads", "N", "Highest render thread count for scaling (default: cores)",
+               opts.max_threads, 1)
+          .add("--output", "FILE", "Write JSON results to FILE (default: stdout)", opts.output);
+    int status = 0;
+    if (!parser.parse(argc, argv, status)) {
+        return status;
+    }
+
+    std::ostringstream json;
+    json << "{\n  \"laprdus_version\": \"" << TTSEngine::version() << "\""
+         << ",\n  \"iterations\": " << opts.iterations
+         << ",\n  \"warmup\": " << opts.warmup
+         << ",\n  \"corpora\": [\n";
+
+    bool ok = true;
+    bool first = true;
+    for (const Corpus& corpus : CORPORA) {
+        std::ostringstream section;
+        if (!run_corpus(corpus, opts, section)) {
+            ok = false;
+            continue;
+        }
+        json << (first ? "" : ",\n") << section.str();
+        first = false;
+    }
+    json << "\n  ]\n}\n";
+
+    if (!write_results(json.str(), opts.output, "Benchmark")) {
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
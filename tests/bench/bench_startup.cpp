@@ -0,0 +1,266 @@
+/*
+ * bench_startup.cpp - First-utterance latency benchmark for LaprdusTTS
+ *
+ * Measures how long a freshly started process takes to produce its first
+ * utterance, with and without engine warm-up. Every trial runs in a new
+ * process (the benchmark re-executes itself), so nothing is shared with
+ * earlier trials apart from the operating system's file cache.
+ *
+ * Two start-up sequences are measured, each mirroring a front end:
+ *   - cli:     load the voice, then the dictionaries, synthesize a sentence
+ *   - speechd: the speech-dispatcher module's INIT sequence, a pause while
+ *              the client connects (--idle), then a short message
+ *
+ * Each sequence runs in these modes:
+ *   - cold:            no warm-up
+ *   - warmup:          laprdus_warmup() right after loading
+ *   - background:      LAPRDUS_WARMUP_BACKGROUND set before the voice loads
+ *   - lazy:            laprdus_set_lazy_loading(), no warm-up
+ *   - lazy-background: lazy loading with background warm-up
+ *
+ * Reported per mode (median over trials, milliseconds):
+ *   - load_ms:    engine creation and loading until the front end is ready
+ *   - warmup_ms:  explicit warm-up call
+ *   - first_ms:   first utterance
+ *   - second_ms:  second utterance of the same text (steady state)
+ *   - startup_ms: load + warm-up + first utterance (excludes --idle)
+ *
+ * Build: scons bench-startup (links the core sources statically)
+ * Run:   laprdus_bench_startup --voices data/voices --dictionaries data/dictionary
+ *                              --output bench_startup.json
+ */
+
+#include "laprdus/laprdus_api.h"
+#include "bench_util.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define popen _popen
+#define pclose _pclose
+#endif
+
+namespace {
+
+using namespace bench;
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+struct Options {
+    std::string voices_dir = "data/voices";
+    std::string dictionaries_dir = "data/dictionary";
+    std::string output;
+    int trials = 9;
+    int idle_ms = 100;
+};
+
+constexpr const char* PROFILES[] = {"cli", "speechd"};
+constexpr const char* MODES[] = {"cold", "warmup", "background", "lazy", "lazy-background"};
+
+// A typical command line sentence and a typical screen reader message
+constexpr const char* CLI_TEXT =
+    "Danas je 18. listopada, a temperatura je 21 stupanj. Kako ste?";
+constexpr const char* SPEECHD_TEXT = "Dobar dan, kako ste?";
+
+// One trial as reported by the child process
+struct Trial {
+    double load_ms = 0.0;
+    double warmup_ms = 0.0;
+    double first_ms = 0.0;
+    double second_ms = 0.0;
+};
+
+// =============================================================================
+// Child Process
+// =============================================================================
+
+// Synthesize text and return the elapsed time, or a negative value on error
+double time_utterance(LaprdusHandle engine, const char* text) {
+    int16_t* samples = nullptr;
+    LaprdusAudioFormat format;
+    auto start = Clock::now();
+    int32_t count = laprdus_synthesize(engine, text, &samples, &format);
+    double ms = elapsed_ms(start);
+    laprdus_free_buffer(samples);
+    return count > 0 ? ms : -1.0;
+}
+
+int run_child(const std::string& profile, const std::string& mode, const Options& opts) {
+    bool speechd = profile == "speechd";
+    std::string dict_path = join_path(opts.dictionaries_dir, "internal.json");
+    std::string spelling_path = join_path(opts.dictionaries_dir, "spelling.json");
+    Trial trial;
+
+    auto start = Clock::now();
+    LaprdusHandle engine = laprdus_create();
+    if (!engine) {
+        return 1;
+    }
+    if (mode == "background" || mode == "lazy-background") {
+        laprdus_set_auto_warmup(engine, LAPRDUS_WARMUP_BACKGROUND);
+    }
+    if (mode == "lazy" || mode == "lazy-background") {
+        laprdus_set_lazy_loading(engine, 1);
+    }
+
+    LaprdusError err;
+    if (speechd) {
+        // Same order as module_init() in the speech-dispatcher module
+        laprdus_load_dictionary(engine, dict_path.c_str());
+        laprdus_load_spelling_dictionary(engine, spelling_path.c_str());
+        laprdus_load_user_config(engine);
+        err = laprdus_set_voice(engine, "josip", opts.voices_dir.c_str());
+    } else {
+        err = laprdus_set_voice(engine, "josip", opts.voices_dir.c_str());
+        laprdus_load_dictionary(engine, dict_path.c_str());
+        laprdus_load_spelling_dictionary(engine, spelling_path.c_str());
+    }
+    trial.load_ms = elapsed_ms(start);
+
+    if (err != LAPRDUS_OK) {
+        std::cerr << "Error: " << laprdus_get_error_message(engine) << "\n";
+        laprdus_destroy(engine);
+        return 1;
+    }
+
+    if (mode == "warmup") {
+        auto warmup_start = Clock::now();
+        laprdus_warmup(engine);
+        trial.warmup_ms = elapsed_ms(warmup_start);
+    }
+
+    // The module waits for its first SPEAK; the CLI speaks immediately
+    if (speechd && opts.idle_ms > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(opts.idle_ms));
+    }
+
+    const char* text = speechd ? SPEECHD_TEXT : CLI_TEXT;
+    trial.first_ms = time_utterance(engine, text);
+    trial.second_ms = time_utterance(engine, text);
+    laprdus_destroy(engine);
+
+    if (trial.first_ms < 0.0 || trial.second_ms < 0.0) {
+        return 1;
+    }
+    std::printf("%.4f %.4f %.4f %.4f\n",
+                trial.load_ms, trial.warmup_ms, trial.first_ms, trial.second_ms);
+    return 0;
+}
+
+// =============================================================================
+// Parent Process
+// =============================================================================
+
+// Run one trial in a new process
+bool run_trial(const std::string& program, const std::string& profile,
+               const std::string& mode, const Options& opts, Trial& trial) {
+    std::ostringstream command;
+    command << "\"" << program << "\" --child " << profile << " " << mode
+            << " --voices \"" << opts.voices_dir << "\""
+            << " --dictionaries \"" << opts.dictionaries_dir << "\""
+            << " --idle " << opts.idle_ms;
+
+    FILE* pipe = popen(command.str().c_str(), "r");
+    if (!pipe) {
+        return false;
+    }
+    int fields = std::fscanf(pipe, "%lf %lf %lf %lf", &trial.load_ms, &trial.warmup_ms,
+                             &trial.first_ms, &trial.second_ms);
+    int status = pclose(pipe);
+    return fields == 4 && status == 0;
+}
+
+bool run_mode(const std::string& program, const char* profile, const char* mode,
+              const Options& opts, std::ostream& out) {
+    std::vector<double> load, warmup, first, second, startup;
+    for (int i = 0; i < opts.trials; ++i) {
+        Trial trial;
+        if (!run_trial(program, profile, mode, opts, trial)) {
+            std::cerr << "Error: " << profile << "/" << mode << " trial failed\n";
+            return false;
+        }
+        load.push_back(trial.load_ms);
+        warmup.push_back(trial.warmup_ms);
+        first.push_back(trial.first_ms);
+        second.push_back(trial.second_ms);
+        startup.push_back(trial.load_ms + trial.warmup_ms + trial.first_ms);
+    }
+
+    out << "{\"mode\": \"" << mode << "\""
+        << ", \"load_ms\": " << median(load)
+        << ", \"warmup_ms\": " << median(warmup)
+        << ", \"first_ms\": " << median(first)
+        << ", \"second_ms\": " << median(second)
+        << ", \"startup_ms\": " << median(startup) << "}";
+    return true;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char* argv[]) {
+    Options opts;
+    std::string child_profile;
+    std::string child_mode;
+
+    OptionParser parser;
+    parser.add("--voices", "DIR", "Directory with Josip.bin (default: data/voices)",
+               opts.voices_dir)
+          .add("--dictionaries", "DIR",
+               "Directory with dictionary JSON files (default: data/dictionary)",
+               opts.dictionaries_dir)
+          .add("--trials", "N", "Processes started per profile and mode (default: 9)",
+               opts.trials, 1)
+          .add("--idle", "MS", "speechd pause between INIT and the first message (default: 100)",
+               opts.idle_ms, 0)
+          .add("--output", "FILE", "Write JSON results to FILE (default: stdout)", opts.output)
+          .add("--child", nullptr, nullptr, 2, [&](char** values) {
+              child_profile = values[0];
+              child_mode = values[1];
+          });
+    int status = 0;
+    if (!parser.parse(argc, argv, status)) {
+        return status;
+    }
+
+    if (!child_profile.empty()) {
+        return run_child(child_profile, child_mode, opts);
+    }
+
+    std::ostringstream json;
+    json << "{\n  \"laprdus_version\": \"" << laprdus_get_version() << "\""
+         << ",\n  \"trials\": " << opts.trials
+         << ",\n  \"idle_ms\": " << opts.idle_ms
+         << ",\n  \"profiles\": [\n";
+
+    bool ok = true;
+    for (size_t p = 0; p < std::size(PROFILES); ++p) {
+        json << "    {\"profile\": \"" << PROFILES[p] << "\", \"modes\": [\n";
+        for (size_t m = 0; m < std::size(MODES); ++m) {
+            json << "      ";
+            if (!run_mode(argv[0], PROFILES[p], MODES[m], opts, json)) {
+                ok = false;
+                json << "{\"mode\": \"" << MODES[m] << "\", \"error\": true}";
+            }
+            json << (m + 1 < std::size(MODES) ? ",\n" : "\n");
+        }
+        json << "    ]}" << (p + 1 < std::size(PROFILES) ? ",\n" : "\n");
+    }
+    json << "  ]\n}\n";
+
+    if (!write_results(json.str(), opts.output, "Startup benchmark")) {
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
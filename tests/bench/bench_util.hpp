@@ -0,0 +1,200 @@
+/*
+ * bench_util.hpp - Helpers shared by the LaprdusTTS benchmarks
+ *
+ * Timing, summary statistics, paths, command line parsing and result
+ * output used by every laprdus_bench_* program. Header-only, so each
+ * benchmark stays a single source file in SConstruct.
+ */
+
+#ifndef LAPRDUS_BENCH_UTIL_HPP
+#define LAPRDUS_BENCH_UTIL_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+// =============================================================================
+// Timing and Statistics
+// =============================================================================
+
+inline double elapsed_ms(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+inline double median(std::vector<double> values) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t mid = values.size() / 2;
+    return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2.0;
+}
+
+// Nearest-rank percentile (100 gives the maximum)
+inline double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t rank = static_cast<size_t>(p / 100.0 * static_cast<double>(values.size()) + 0.999999);
+    rank = std::clamp(rank, size_t(1), values.size());
+    return values[rank - 1];
+}
+
+// =============================================================================
+// Files
+// =============================================================================
+
+inline std::string join_path(const std::string& dir, const std::string& file) {
+    if (dir.empty() || dir.back() == '/' || dir.back() == '\\') {
+        return dir + file;
+    }
+    return dir + "/" + file;
+}
+
+/**
+ * Write the JSON results to path, or to stdout when path is empty.
+ * @param json Results document.
+ * @param path Output file (empty for stdout).
+ * @param label Benchmark name for the confirmation, e.g. "Pack benchmark".
+ * @return false if the file cannot be written.
+ */
+inline bool write_results(const std::string& json, const std::string& path, const char* label) {
+    if (path.empty()) {
+        std::cout << json;
+        return true;
+    }
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Error: cannot write " << path << "\n";
+        return false;
+    }
+    file << json;
+    std::cerr << label << " results written to " << path << "\n";
+    return true;
+}
+
+// =============================================================================
+// Command Line
+// =============================================================================
+
+/*
+ * Command line options of a benchmark. Each option names its flag, the
+ * value it takes and a help line; parse() stores the values and prints the
+ * usage for --help or anything it does not recognize.
+ */
+class OptionParser {
+public:
+    OptionParser& add(const char* flag, const char* value, const char* help,
+                      std::string& target) {
+        return add(flag, value, help, [&target](const char* arg) { target = arg; });
+    }
+
+    // Integer value, raised to at least minimum
+    OptionParser& add(const char* flag, const char* value, const char* help,
+                      int& target, int minimum) {
+        return add(flag, value, help, [&target, minimum](const char* arg) {
+            target = std::max(minimum, std::atoi(arg));
+        });
+    }
+
+    OptionParser& add(const char* flag, const char* value, const char* help,
+                      size_t& target, size_t minimum) {
+        return add(flag, value, help, [&target, minimum](const char* arg) {
+            target = std::max(minimum, static_cast<size_t>(std::max(0, std::atoi(arg))));
+        });
+    }
+
+    OptionParser& add(const char* flag, const char* value, const char* help,
+                      std::function<void(const char*)> set) {
+        return add(flag, value, help, 1, [set](char** args) { set(args[0]); });
+    }
+
+    /**
+     * Add an option with a custom setter.
+     * @param value Name of the value in the usage, or nullptr.
+     * @param help Help line, or nullptr to leave the option out of the usage.
+     * @param values Number of values that follow the flag.
+     * @param set Receives the values.
+     */
+    OptionParser& add(const char* flag, const char* value, const char* help, int values,
+                      std::function<void(char**)> set) {
+        m_options.push_back({flag, value, help, values, std::move(set)});
+        return *this;
+    }
+
+    /**
+     * Parse the command line.
+     * @param status Exit status when parsing stops: 0 for --help, 1 for an
+     *               unknown option or a missing value.
+     * @return false if the program should exit, after printing the usage.
+     */
+    bool parse(int argc, char* argv[], int& status) const {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            const Option* option = find(arg);
+            if (!option || i + option->values >= argc) {
+                print_usage(argv[0]);
+                status = arg == "--help" || arg == "-h" ? 0 : 1;
+                return false;
+            }
+            option->set(argv + i + 1);
+            i += option->values;
+        }
+        return true;
+    }
+
+    void print_usage(const char* program) const {
+        size_t width = 0;
+        for (const Option& option : m_options) {
+            if (option.help) {
+                width = std::max(width, usage_name(option).size());
+            }
+        }
+        std::cerr << "Usage: " << program << " [options]\n";
+        for (const Option& option : m_options) {
+            if (option.help) {
+                std::string name = usage_name(option);
+                std::cerr << "  " << name << std::string(width - name.size() + 3, ' ')
+                          << option.help << "\n";
+            }
+        }
+    }
+
+private:
+    struct Option {
+        const char* flag;
+        const char* value;
+        const char* help;
+        int values;
+        std::function<void(char**)> set;
+    };
+
+    std::vector<Option> m_options;
+
+    const Option* find(const std::string& flag) const {
+        for (const Option& option : m_options) {
+            if (flag == option.flag) {
+                return &option;
+            }
+        }
+        return nullptr;
+    }
+
+    static std::string usage_name(const Option& option) {
+        return option.value ? std::string(option.flag) + " " + option.value : option.flag;
+    }
+};
+
+} // namespace bench
+
+#endif // LAPRDUS_BENCH_UTIL_HPP
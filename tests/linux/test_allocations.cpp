@@ -0,0 +1,243 @@
+/*
+ * test_allocations.cpp - Heap allocation regression tests for LaprdusTTS
+ *
+ * Verifies that once an engine is warm, synthesizing short text into a
+ * reused SynthesisResult performs no heap allocations. Allocations are
+ * counted by hooking malloc/calloc/realloc (glibc) or global operator new.
+ *
+ * The test links the core sources statically, since the reusable
+ * TTSEngine::synthesize(text, result) overload is not part of the C API.
+ *
+ * Build: scons --platform=linux test-alloc
+ * Run:   LAPRDUS_DATA=data/voices ./build/linux-x64-release/test_allocations
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include "core/tts_engine.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <sys/stat.h>
+
+// =============================================================================
+// Allocation Counting
+// =============================================================================
+
+static std::atomic<uint64_t> g_allocations{0};
+
+#if defined(__GLIBC__)
+// Interpose the C allocator so Sonic's malloc/realloc calls are counted too;
+// operator new is implemented on top of malloc.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+#else
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+#endif
+
+using namespace laprdus;
+
+/* Default data directory (can be overridden by LAPRDUS_DATA) */
+static const char* DATA_DIR = "/usr/share/laprdus";
+
+static std::string get_data_dir() {
+    const char* env = std::getenv("LAPRDUS_DATA");
+    return env ? env : DATA_DIR;
+}
+
+static bool file_exists(const std::string& path) {
+    struct stat buffer;
+    return stat(path.c_str(), &buffer) == 0;
+}
+
+/* Synthesize a few times to grow the working buffers, then count one call */
+static uint64_t warm_allocations(TTSEngine& engine, const std::string& text,
+                                 SynthesisResult& result) {
+    for (int i = 0; i < 3; ++i) {
+        engine.synthesize(text, result);
+    }
+
+    uint64_t before = g_allocations.load(std::memory_order_relaxed);
+    engine.synthesize(text, result);
+    return g_allocations.load(std::memory_order_relaxed) - before;
+}
+
+TEST_CASE("Warm synthesis performs no heap allocations", "[alloc]") {
+    std::string voice_path = get_data_dir() + "/Josip.bin";
+    if (!file_exists(voice_path)) {
+        SKIP("Voice data not found: " + voice_path);
+    }
+
+    TTSEngine engine;
+    REQUIRE(engine.initialize(voice_path));
+
+    SynthesisResult result;
+
+    SECTION("Allocation hook is active") {
+        // The first call grows every buffer, so it must be counted
+        uint64_t before = g_allocations.load(std::memory_order_relaxed);
+        engine.synthesize("Dobar dan", result);
+        REQUIRE(g_allocations.load(std::memory_order_relaxed) > before);
+    }
+
+    SECTION("Default parameters") {
+        uint64_t count = warm_allocations(engine, "Dobar dan", result);
+        CAPTURE(count);
+        REQUIRE(result.success);
+        REQUIRE(!result.audio.samples.empty());
+        REQUIRE(count == 0);
+    }
+
+    SECTION("Punctuation and inflection") {
+        uint64_t count = warm_allocations(engine, "Dobar dan, kako ste? Hvala!", result);
+        CAPTURE(count);
+        REQUIRE(result.success);
+        REQUIRE(count == 0);
+    }
+
+    SECTION("Rate, pitch and user pitch") {
+        VoiceParams params;
+        params.speed = 1.5f;
+        params.pitch = 1.2f;
+        params.user_pitch = 0.8f;
+        params.volume = 0.7f;
+        engine.set_voice_params(params);
+
+        uint64_t count = warm_allocations(engine, "Dobar dan, kako ste?", result);
+        CAPTURE(count);
+        REQUIRE(result.success);
+        REQUIRE(count == 0);
+    }
+
+    SECTION("Pronunciation dictionary and digits") {
+        engine.add_pronunciation("ZG", "Ze Ge");
+        engine.set_number_mode(NumberMode::DigitByDigit);
+
+        uint64_t count = warm_allocations(engine, "Let 42 za ZG.", result);
+        CAPTURE(count);
+        REQUIRE(result.success);
+        REQUIRE(count == 0);
+    }
+
+    SECTION("Emoji replacement") {
+        const char* emoji_json =
+            "{ \"entries\": [ { \"emoji\": \"\xF0\x9F\x98\x80\", \"text\": \"nasmijano lice\" },"
+            " { \"emoji\": \"\xE2\x9D\xA4\xEF\xB8\x8F\", \"text\": \"crveno srce\" } ] }";
+        REQUIRE(engine.load_emoji_dictionary_from_memory(emoji_json));
+        engine.set_emoji_enabled(true);
+
+        uint64_t count = warm_allocations(
+            engine, "Dobar dan \xF0\x9F\x98\x80, volim te \xE2\x9D\xA4!", result);
+        CAPTURE(count);
+        REQUIRE(result.success);
+        REQUIRE(count == 0);
+        engine.set_emoji_enabled(false);
+    }
+
+    SECTION("Look-ahead pipeline matches serial rendering") {
+        const char* text = "Prva rečenica. Druga, s zarezom! Treća? I četvrta 1234.";
+        engine.set_lookahead_enabled(false);
+        SynthesisResult serial = engine.synthesize(text);
+
+        engine.set_lookahead_enabled(true);
+        uint64_t count = warm_allocations(engine, text, result);
+        CAPTURE(count);
+        REQUIRE(result.success);
+        REQUIRE(result.audio.samples == serial.audio.samples);
+        REQUIRE(count == 0);
+    }
+
+    SECTION("Sink output matches and does not allocate") {
+        const std::string text = "Dobar dan, kako ste? Hvala!";
+        SynthesisResult expected = engine.synthesize(text);
+
+        AudioSamples written;
+        written.reserve(expected.audio.samples.size());
+        TTSEngine::SampleSink sink = [&written](const AudioSample* samples, size_t count) {
+            written.insert(written.end(), samples, samples + count);
+        };
+        for (int i = 0; i < 3; ++i) {
+            written.clear();
+            engine.synthesize_to_sink(text, sink);
+        }
+
+        written.clear();
+        uint64_t before = g_allocations.load(std::memory_order_relaxed);
+        SynthesisResult sunk = engine.synthesize_to_sink(text, sink);
+        uint64_t count = g_allocations.load(std::memory_order_relaxed) - before;
+        CAPTURE(count);
+        REQUIRE(sunk.success);
+        REQUIRE(sunk.audio.samples.empty());
+        REQUIRE(written == expected.audio.samples);
+        REQUIRE(count == 0);
+    }
+
+    SECTION("First call after warm-up does not allocate") {
+        const std::string text = "Dobar dan, kako ste? Hvala!";
+        TTSEngine fresh;
+        REQUIRE(fresh.initialize(voice_path));
+        REQUIRE(fresh.warmup().success);
+
+        AudioSamples written;
+        written.reserve(1 << 20);
+        TTSEngine::SampleSink sink = [&written](const AudioSample* samples, size_t count) {
+            written.insert(written.end(), samples, samples + count);
+        };
+
+        uint64_t before = g_allocations.load(std::memory_order_relaxed);
+        SynthesisResult sunk = fresh.synthesize_to_sink(text, sink);
+        uint64_t count = g_allocations.load(std::memory_order_relaxed) - before;
+        CAPTURE(count);
+        REQUIRE(sunk.success);
+        REQUIRE(count == 0);
+
+        // The engine above has other settings by now
+        TTSEngine cold;
+        REQUIRE(cold.initialize(voice_path));
+        REQUIRE(written == cold.synthesize(text).audio.samples);
+    }
+
+    SECTION("Same output as the allocating overload") {
+        SynthesisResult reused;
+        warm_allocations(engine, "Dobar dan, kako ste?", reused);
+        SynthesisResult fresh = engine.synthesize("Dobar dan, kako ste?");
+        REQUIRE(fresh.success);
+        REQUIRE(fresh.audio.samples == reused.audio.samples);
+    }
+}
@@ -11,18 +11,35 @@
 #define CATCH_CONFIG_MAIN
 #include "catch2/catch.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <string>
 #include <fstream>
+#include <iterator>
 #include <sstream>
 #include <vector>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
 #include <memory>
+#include <thread>
+
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 /* LaprdusTTS C API */
 #include <laprdus/laprdus_api.h>
 
+/* laprdus-server protocol */
+#include "../../src/platform/linux/server/server_protocol.hpp"
+
 /* Path to data directory (set by test runner or default) */
 static const char* DATA_DIR = "/usr/share/laprdus";
 
@@ -32,6 +49,18 @@ static std::string get_cli_path() {
     return env ? env : "laprdus";
 }
 
+/* Get phoneme packer path from environment or default */
+static std::string get_packer_path() {
+    const char* env = std::getenv("LAPRDUS_PACKER");
+    return env ? env : "phoneme_packer";
+}
+
+/* Get laprdus-server path from environment or default */
+static std::string get_server_path() {
+    const char* env = std::getenv("LAPRDUS_SERVER");
+    return env ? env : "laprdus-server";
+}
+
 /* Get data directory from environment or default */
 static std::string get_data_dir() {
     const char* env = std::getenv("LAPRDUS_DATA");
@@ -69,6 +98,13 @@ size_t file_size(const std::string& path) {
     return f.tellg();
 }
 
+/* Helper to read a whole file */
+std::vector<uint8_t> read_file(const std::string& path) {
+    std::ifstream f(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(f),
+                                std::istreambuf_iterator<char>());
+}
+
 // =============================================================================
 // CLI Argument Parsing Tests
 // =============================================================================
@@ -168,6 +204,31 @@ TEST_CASE("CLI reads from input file with -i", "[cli][input]") {
     std::remove(output_file);
 }
 
+TEST_CASE("CLI writes one WAV per line with -b", "[cli][input]") {
+    const char* input_file = "/tmp/laprdus_test_batch.txt";
+    const char* output_dir = "/tmp/laprdus_test_batch";
+
+    {
+        std::ofstream f(input_file);
+        f << "Dobar dan!\n\nKako ste?\n";
+    }
+    std::remove((std::string(output_dir) + "/0001.wav").c_str());
+    std::remove((std::string(output_dir) + "/0003.wav").c_str());
+
+    auto [exit_code, output] = run_cli("-b " + std::string(input_file) +
+                                       " -j 2 -o " + std::string(output_dir));
+
+    REQUIRE(exit_code == 0);
+    REQUIRE(file_size(std::string(output_dir) + "/0001.wav") > 44);
+    REQUIRE(!file_exists(std::string(output_dir) + "/0002.wav"));
+    REQUIRE(file_size(std::string(output_dir) + "/0003.wav") > 44);
+
+    std::remove(input_file);
+    std::remove((std::string(output_dir) + "/0001.wav").c_str());
+    std::remove((std::string(output_dir) + "/0003.wav").c_str());
+    std::remove(output_dir);
+}
+
 // =============================================================================
 // CLI Parameter Tests
 // =============================================================================
@@ -211,6 +272,82 @@ TEST_CASE("CLI accepts valid pitch", "[cli][params]") {
     std::remove(output_file);
 }
 
+TEST_CASE("CLI writes WAV at the requested sample rate", "[cli][params]") {
+    const char* output_file = "/tmp/laprdus_test_sample_rate.wav";
+    std::remove(output_file);
+
+    SECTION("48 kHz") {
+        auto [exit_code, output] = run_cli("-s 48000 -o " + std::string(output_file) + " \"Test\"");
+        REQUIRE(exit_code == 0);
+
+        // Sample rate field of the fmt chunk
+        std::ifstream wav(output_file, std::ios::binary);
+        wav.seekg(24);
+        uint32_t rate = 0;
+        wav.read(reinterpret_cast<char*>(&rate), 4);
+        REQUIRE(rate == 48000);
+    }
+
+    SECTION("Unsupported rate") {
+        auto [exit_code, output] = run_cli("-s 12345 \"Test\"");
+        REQUIRE(exit_code != 0);
+    }
+
+    std::remove(output_file);
+}
+
+TEST_CASE("CLI writes compact WAV encodings", "[cli][output]") {
+    const char* output_file = "/tmp/laprdus_test_encoded.wav";
+    std::remove(output_file);
+
+    SECTION("mu-law") {
+        auto [exit_code, output] = run_cli("-s 8000 -f mulaw -o " + std::string(output_file) +
+                                           " \"Test\"");
+        REQUIRE(exit_code == 0);
+
+        std::vector<uint8_t> wav = read_file(output_file);
+        REQUIRE(wav.size() > 58);
+        REQUIRE(std::memcmp(wav.data() + 8, "WAVE", 4) == 0);
+        REQUIRE((wav[20] | (wav[21] << 8)) == 7);      // WAVE_FORMAT_MULAW
+        REQUIRE((wav[34] | (wav[35] << 8)) == 8);      // Bits per sample
+        REQUIRE(std::memcmp(wav.data() + 38, "fact", 4) == 0);
+        REQUIRE(std::memcmp(wav.data() + 50, "data", 4) == 0);
+
+        // One byte per sample: the fact count equals the data size
+        uint32_t samples = 0;
+        uint32_t data_size = 0;
+        std::memcpy(&samples, wav.data() + 46, 4);
+        std::memcpy(&data_size, wav.data() + 54, 4);
+        REQUIRE(samples == data_size);
+        REQUIRE(wav.size() == 58 + data_size);
+    }
+
+    SECTION("IMA-ADPCM") {
+        auto [exit_code, output] = run_cli("-f adpcm -o " + std::string(output_file) +
+                                           " \"Test\"");
+        REQUIRE(exit_code == 0);
+
+        std::vector<uint8_t> wav = read_file(output_file);
+        REQUIRE(wav.size() > 60);
+        REQUIRE((wav[20] | (wav[21] << 8)) == 0x11);   // WAVE_FORMAT_IMA_ADPCM
+        REQUIRE((wav[32] | (wav[33] << 8)) == 512);    // Block align
+        REQUIRE((wav[38] | (wav[39] << 8)) == 1017);   // Samples per block
+        REQUIRE(std::memcmp(wav.data() + 52, "data", 4) == 0);
+
+        uint32_t data_size = 0;
+        std::memcpy(&data_size, wav.data() + 56, 4);
+        REQUIRE(data_size % 512 == 0);
+        REQUIRE(wav.size() == 60 + data_size);
+    }
+
+    SECTION("Invalid use") {
+        REQUIRE(run_cli("-f mulaw \"Test\"").first != 0);
+        REQUIRE(run_cli("-f flac -o " + std::string(output_file) + " \"Test\"").first != 0);
+    }
+
+    std::remove(output_file);
+}
+
 TEST_CASE("CLI accepts valid volume", "[cli][params]") {
     const char* output_file = "/tmp/laprdus_test_volume.wav";
     std::remove(output_file);
@@ -253,6 +390,19 @@ TEST_CASE("CLI accepts pause settings", "[cli][params]") {
     std::remove(output_file);
 }
 
+TEST_CASE("CLI accepts render thread count", "[cli][params]") {
+    const char* output_file = "/tmp/laprdus_test_threads.wav";
+    std::remove(output_file);
+
+    auto [exit_code, output] = run_cli(
+        "-t 2 -o " + std::string(output_file) + " \"Prva rečenica. Druga rečenica.\"");
+
+    REQUIRE(exit_code == 0);
+    REQUIRE(file_exists(output_file));
+
+    std::remove(output_file);
+}
+
 // =============================================================================
 // CLI Voice Selection Tests
 // =============================================================================
@@ -278,6 +428,362 @@ TEST_CASE("CLI synthesizes with different voices", "[cli][voices]") {
     std::remove(output_file);
 }
 
+// =============================================================================
+// Server Tests
+// =============================================================================
+
+/* Connect to a server socket, or return -1 */
+static int connect_server(const std::string& path) {
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* laprdus-server running on a private socket for the duration of a test */
+class ServerProcess {
+public:
+    explicit ServerProcess(const std::string& socket_path) : m_socket(socket_path) {
+        unlink(m_socket.c_str());
+        std::string server = get_server_path();
+        std::string data = get_data_dir();
+        m_pid = fork();
+        if (m_pid == 0) {
+            execlp(server.c_str(), server.c_str(), "-D", data.c_str(), "-s", m_socket.c_str(),
+                   static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        for (int i = 0; i < 500; i++) {
+            int fd = connect_server(m_socket);
+            if (fd >= 0) {
+                close(fd);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    ~ServerProcess() { stop(); }
+
+    /* Stop with SIGTERM; returns the exit code */
+    int stop() {
+        if (m_pid <= 0) {
+            return m_exit_code;
+        }
+        kill(m_pid, SIGTERM);
+        int status = 0;
+        waitpid(m_pid, &status, 0);
+        m_pid = -1;
+        m_exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        return m_exit_code;
+    }
+
+private:
+    std::string m_socket;
+    pid_t m_pid = -1;
+    int m_exit_code = -1;
+};
+
+static bool send_speak(int fd, uint32_t id, LaprdusPriority priority,
+                       const std::string& text) {
+    laprdus::server::SpeakParams params;
+    std::string payload(reinterpret_cast<const char*>(&params), sizeof(params));
+    payload += text;
+    return laprdus::server::write_frame(fd, laprdus::server::FrameType::Speak, id,
+                                        payload.data(), static_cast<uint32_t>(payload.size()),
+                                        static_cast<uint8_t>(priority));
+}
+
+/* What the server sent back for one request */
+struct ServerReply {
+    bool began = false;
+    size_t num_samples = 0;      // Samples received in AUDIO frames
+    int32_t status = 1;          // END status, 1 until END arrives
+    uint32_t end_samples = 0;    // Sample count reported in END
+};
+
+/* Read frames until `count` requests have ended */
+static std::map<uint32_t, ServerReply> read_replies(int fd, size_t count) {
+    std::map<uint32_t, ServerReply> replies;
+    int ended = 0;
+    laprdus::server::FrameHeader header;
+    std::vector<char> payload;
+    while (static_cast<size_t>(ended) < count &&
+           laprdus::server::read_all(fd, &header, sizeof(header))) {
+        payload.resize(header.size);
+        if (header.size > 0 && !laprdus::server::read_all(fd, payload.data(), header.size)) {
+            break;
+        }
+        ServerReply& reply = replies[header.request_id];
+        switch (static_cast<laprdus::server::FrameType>(header.type)) {
+            case laprdus::server::FrameType::Begin:
+                reply.began = true;
+                break;
+            case laprdus::server::FrameType::Audio:
+                reply.num_samples += header.size / sizeof(int16_t);
+                break;
+            case laprdus::server::FrameType::End: {
+                laprdus::server::EndInfo info;
+                std::memcpy(&info, payload.data(), sizeof(info));
+                reply.status = info.status;
+                reply.end_samples = info.num_samples;
+                ++ended;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return replies;
+}
+
+TEST_CASE("CLI speaks through the server", "[cli][server]") {
+    const std::string socket_path = "/tmp/laprdus_test_server.sock";
+    const char* server_file = "/tmp/laprdus_test_server.wav";
+    const char* local_file = "/tmp/laprdus_test_local.wav";
+    ServerProcess server(socket_path);
+
+    std::string args = "-v vlado -r 1.3 -s 16000 -d -o ";
+    std::string text = " \"Dobar dan, broj 42. Kako ste?\"";
+    auto [server_exit, server_output] =
+        run_cli("--server=" + socket_path + " " + args + server_file + text);
+    CAPTURE(server_output);
+    REQUIRE(server_exit == 0);
+
+    auto [local_exit, local_output] = run_cli(args + local_file + text);
+    REQUIRE(local_exit == 0);
+
+    // Same settings give the same file, whichever process synthesizes
+    std::vector<uint8_t> from_server = read_file(server_file);
+    REQUIRE(from_server.size() > 44);
+    REQUIRE(from_server == read_file(local_file));
+
+    // Errors from the server are reported
+    auto [bad_exit, bad_output] = run_cli("--server=" + socket_path + " -v nobody \"Test\"");
+    REQUIRE(bad_exit != 0);
+
+    // The server removes its socket when stopped
+    REQUIRE(server.stop() == 0);
+    REQUIRE_FALSE(file_exists(socket_path));
+
+    auto [gone_exit, gone_output] = run_cli("--server=" + socket_path + " \"Test\"");
+    REQUIRE(gone_exit != 0);
+    REQUIRE(gone_output.find("Cannot connect") != std::string::npos);
+
+    std::remove(server_file);
+    std::remove(local_file);
+}
+
+/* Answers one connection's SPEAK with a single frame header and payload */
+static void serve_one_frame(int listen_fd, laprdus::server::FrameType type, uint32_t size,
+                            const std::string& payload) {
+    int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+        return;
+    }
+    laprdus::server::FrameHeader request;
+    std::vector<char> body;
+    if (laprdus::server::read_all(fd, &request, sizeof(request))) {
+        body.resize(request.size);
+        laprdus::server::read_all(fd, body.data(), request.size);
+        laprdus::server::FrameHeader header;
+        header.size = size;
+        header.request_id = request.request_id;
+        header.type = static_cast<uint8_t>(type);
+        laprdus::server::write_all(fd, &header, sizeof(header));
+        laprdus::server::write_all(fd, payload.data(), payload.size());
+    }
+    close(fd);
+}
+
+TEST_CASE("CLI rejects malformed server frames", "[cli][server]") {
+    using laprdus::server::FrameType;
+    const std::string socket_path = "/tmp/laprdus_test_malformed.sock";
+    unlink(socket_path.c_str());
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    REQUIRE(bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    REQUIRE(listen(listen_fd, 1) == 0);
+
+    struct Case {
+        FrameType type;
+        uint32_t size;
+        size_t payload;
+        const char* frame;
+    };
+    const Case cases[] = {
+        {FrameType::Audio, 3, 3, "AUDIO"},              // Odd: half a sample
+        {FrameType::Audio, 1u << 30, 0, "AUDIO"},       // Larger than a frame holds
+        {FrameType::Begin, 4, 4, "BEGIN"},
+        {FrameType::End, 64, 64, "END"},
+    };
+    for (const Case& c : cases) {
+        CAPTURE(c.frame);
+        std::thread server(serve_one_frame, listen_fd, c.type, c.size,
+                           std::string(c.payload, '\0'));
+        auto [exit_code, output] = run_cli("--server=" + socket_path + " \"Test\"");
+        server.join();
+        REQUIRE(exit_code != 0);
+        REQUIRE(output.find(std::string("Malformed ") + c.frame) != std::string::npos);
+    }
+
+    close(listen_fd);
+    unlink(socket_path.c_str());
+}
+
+TEST_CASE("Server cancels and prioritizes requests", "[server]") {
+    const std::string socket_path = "/tmp/laprdus_test_priority.sock";
+    ServerProcess server(socket_path);
+
+    std::string long_text;
+    for (int i = 0; i < 200; i++) {
+        long_text += "Ovo je dugačka rečenica koja se čita polako. ";
+    }
+
+    int fd = connect_server(socket_path);
+    REQUIRE(fd >= 0);
+
+    SECTION("Key echo stops text of the same connection") {
+        REQUIRE(send_speak(fd, 1, LAPRDUS_PRIORITY_TEXT, long_text));
+        REQUIRE(send_speak(fd, 2, LAPRDUS_PRIORITY_TEXT, long_text));
+        REQUIRE(send_speak(fd, 3, LAPRDUS_PRIORITY_KEY, "a"));
+        auto replies = read_replies(fd, 3);
+
+        REQUIRE(replies[1].status == LAPRDUS_ERROR_CANCELLED);
+        REQUIRE(replies[2].status == LAPRDUS_ERROR_CANCELLED);
+        REQUIRE(replies[3].status == LAPRDUS_OK);
+        REQUIRE(replies[3].began);
+        REQUIRE(replies[3].num_samples > 0);
+        REQUIRE(replies[3].num_samples == replies[3].end_samples);
+    }
+
+    SECTION("Cancel stops one request") {
+        REQUIRE(send_speak(fd, 4, LAPRDUS_PRIORITY_TEXT, long_text));
+        REQUIRE(send_speak(fd, 5, LAPRDUS_PRIORITY_TEXT, "Kratko."));
+        REQUIRE(laprdus::server::write_frame(fd, laprdus::server::FrameType::Cancel, 4,
+                                             nullptr, 0));
+        auto replies = read_replies(fd, 2);
+
+        REQUIRE(replies[4].status == LAPRDUS_ERROR_CANCELLED);
+        REQUIRE(replies[4].num_samples == replies[4].end_samples);
+        REQUIRE(replies[5].status == LAPRDUS_OK);
+    }
+
+    SECTION("Cancel without an ID stops the whole connection") {
+        REQUIRE(send_speak(fd, 6, LAPRDUS_PRIORITY_PROGRESS, long_text));
+        REQUIRE(send_speak(fd, 7, LAPRDUS_PRIORITY_PROGRESS, long_text));
+        REQUIRE(laprdus::server::write_frame(fd, laprdus::server::FrameType::Cancel, 0,
+                                             nullptr, 0));
+        auto replies = read_replies(fd, 2);
+
+        REQUIRE(replies[6].status == LAPRDUS_ERROR_CANCELLED);
+        REQUIRE(replies[7].status == LAPRDUS_ERROR_CANCELLED);
+    }
+
+    SECTION("Requests of other connections are not stopped") {
+        int other = connect_server(socket_path);
+        REQUIRE(other >= 0);
+        REQUIRE(send_speak(other, 8, LAPRDUS_PRIORITY_TEXT, "Dobar dan."));
+        REQUIRE(send_speak(fd, 9, LAPRDUS_PRIORITY_KEY, "b"));
+        auto other_replies = read_replies(other, 1);
+        auto replies = read_replies(fd, 1);
+
+        REQUIRE(other_replies[8].status == LAPRDUS_OK);
+        REQUIRE(replies[9].status == LAPRDUS_OK);
+        close(other);
+    }
+
+    SECTION("Notifications are not stopped") {
+        // A tenth of the long text: still running when the key echo arrives
+        REQUIRE(send_speak(fd, 10, LAPRDUS_PRIORITY_NOTIFICATION,
+                           long_text.substr(0, long_text.size() / 10)));
+        REQUIRE(send_speak(fd, 11, LAPRDUS_PRIORITY_PROGRESS, long_text));
+        REQUIRE(send_speak(fd, 12, LAPRDUS_PRIORITY_KEY, "c"));
+        auto replies = read_replies(fd, 3);
+
+        REQUIRE(replies[10].status == LAPRDUS_OK);
+        REQUIRE(replies[10].num_samples == replies[10].end_samples);
+        REQUIRE(replies[11].status == LAPRDUS_ERROR_CANCELLED);
+        REQUIRE(replies[12].status == LAPRDUS_OK);
+    }
+
+    SECTION("Unknown priorities are rejected") {
+        REQUIRE(send_speak(fd, 13, static_cast<LaprdusPriority>(9), "Dobar dan."));
+        auto replies = read_replies(fd, 1);
+
+        REQUIRE(replies[13].status == LAPRDUS_ERROR_INVALID_PARAMETER);
+        REQUIRE_FALSE(replies[13].began);
+    }
+
+    close(fd);
+}
+
+TEST_CASE("Server keeps serving when a client stops reading", "[server]") {
+    const std::string socket_path = "/tmp/laprdus_test_stalled.sock";
+    ServerProcess server(socket_path);
+
+    std::string long_text;
+    for (int i = 0; i < 200; i++) {
+        long_text += "Ovo je dugačka rečenica koja se čita polako. ";
+    }
+
+    // Reads give up rather than hang the test if the server stalls
+    auto connect_with_timeout = [&]() {
+        int fd = connect_server(socket_path);
+        timeval timeout = {20, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        return fd;
+    };
+
+    SECTION("Requests and cancels of a stalled client do not block others") {
+        int stalled = connect_with_timeout();
+        REQUIRE(stalled >= 0);
+        REQUIRE(send_speak(stalled, 1, LAPRDUS_PRIORITY_TEXT, long_text));
+        REQUIRE(send_speak(stalled, 2, LAPRDUS_PRIORITY_TEXT, long_text));
+        REQUIRE(send_speak(stalled, 3, LAPRDUS_PRIORITY_TEXT, long_text));
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        REQUIRE(send_speak(stalled, 4, LAPRDUS_PRIORITY_KEY, "a"));
+        REQUIRE(laprdus::server::write_frame(stalled, laprdus::server::FrameType::Cancel, 0,
+                                             nullptr, 0));
+
+        int other = connect_with_timeout();
+        REQUIRE(other >= 0);
+        REQUIRE(send_speak(other, 5, LAPRDUS_PRIORITY_TEXT, "Dobar dan."));
+        auto replies = read_replies(other, 1);
+        REQUIRE(replies[5].status == LAPRDUS_OK);
+        close(other);
+        close(stalled);
+    }
+
+    SECTION("A client that stays behind is dropped") {
+        int stalled = connect_with_timeout();
+        REQUIRE(stalled >= 0);
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE(send_speak(stalled, 6, LAPRDUS_PRIORITY_TEXT, long_text));
+
+        int other = connect_with_timeout();
+        REQUIRE(other >= 0);
+        REQUIRE(send_speak(other, 7, LAPRDUS_PRIORITY_TEXT, "Dobar dan."));
+        auto replies = read_replies(other, 1);
+        REQUIRE(replies[7].status == LAPRDUS_OK);
+        close(other);
+
+        // After the stall timeout the connection ends without an END frame
+        std::this_thread::sleep_until(start + std::chrono::seconds(8));
+        auto stalled_replies = read_replies(stalled, 1);
+        REQUIRE(stalled_replies[6].status == 1);
+        REQUIRE(stalled_replies[6].num_samples > 0);
+        close(stalled);
+    }
+}
+
 // =============================================================================
 // C API Unit Tests
 // =============================================================================
@@ -346,6 +852,1311 @@ TEST_CASE("C API synthesizes text", "[api]") {
     laprdus_destroy(engine);
 }
 
+TEST_CASE("C API renders segments in parallel", "[api][threads]") {
+    LaprdusHandle engine = laprdus_create();
+    REQUIRE(engine != nullptr);
+
+    REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+
+    const char* text = "Dobar dan. Kako ste? Ja sam dobro, hvala! "
+                       "Danas je lijep dan.\nSutra je 12. listopada.";
+    LaprdusAudioFormat format;
+
+    int16_t* serial = nullptr;
+    int32_t serial_count = laprdus_synthesize(engine, text, &serial, &format);
+    REQUIRE(serial_count > 0);
+
+    SECTION("Output matches single-threaded rendering") {
+        for (uint32_t threads : {2u, 4u, 0u}) {
+            REQUIRE(laprdus_set_render_threads(engine, threads) == LAPRDUS_OK);
+
+            int16_t* parallel = nullptr;
+            int32_t parallel_count = laprdus_synthesize(engine, text, &parallel, &format);
+            REQUIRE(parallel_count == serial_count);
+            REQUIRE(parallel != nullptr);
+            REQUIRE(std::memcmp(parallel, serial, serial_count * sizeof(int16_t)) == 0);
+            laprdus_free_buffer(parallel);
+        }
+    }
+
+    REQUIRE(laprdus_set_render_threads(nullptr, 2) == LAPRDUS_ERROR_INVALID_HANDLE);
+
+    laprdus_free_buffer(serial);
+    laprdus_destroy(engine);
+}
+
+/* Appends sink output; stops after max_calls writes when non-zero */
+struct SinkRecorder {
+    std::vector<int16_t> samples;
+    size_t calls = 0;
+    size_t max_calls = 0;
+};
+
+static int LAPRDUS_CALL record_sink(const int16_t* samples, size_t num_samples, void* user_data) {
+    SinkRecorder* recorder = static_cast<SinkRecorder*>(user_data);
+    recorder->samples.insert(recorder->samples.end(), samples, samples + num_samples);
+    ++recorder->calls;
+    return recorder->max_calls == 0 || recorder->calls < recorder->max_calls;
+}
+
+TEST_CASE("C API synthesizes to a sink", "[api][sink]") {
+    LaprdusHandle engine = laprdus_create();
+    REQUIRE(engine != nullptr);
+
+    REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+
+    const char* text = "Dobar dan. Kako ste? Ja sam dobro, hvala!";
+    LaprdusAudioFormat format;
+    int16_t* expected = nullptr;
+    int32_t expected_count = laprdus_synthesize(engine, text, &expected, &format);
+    REQUIRE(expected_count > 0);
+
+    SECTION("Output matches laprdus_synthesize") {
+        for (uint32_t threads : {1u, 3u}) {
+            REQUIRE(laprdus_set_render_threads(engine, threads) == LAPRDUS_OK);
+
+            SinkRecorder recorder;
+            LaprdusAudioFormat sink_format;
+            int32_t written = laprdus_synthesize_to_sink(engine, text, record_sink, &recorder,
+                                                         &sink_format);
+            REQUIRE(written == expected_count);
+            REQUIRE(sink_format.sample_rate == format.sample_rate);
+            REQUIRE(recorder.calls > 1);
+            REQUIRE(recorder.samples.size() == static_cast<size_t>(expected_count));
+            REQUIRE(std::memcmp(recorder.samples.data(), expected,
+                                expected_count * sizeof(int16_t)) == 0);
+        }
+        REQUIRE(laprdus_set_render_threads(engine, 1) == LAPRDUS_OK);
+    }
+
+    SECTION("Returning zero stops synthesis") {
+        SinkRecorder recorder;
+        recorder.max_calls = 1;
+        int32_t written = laprdus_synthesize_to_sink(engine, text, record_sink, &recorder, nullptr);
+        REQUIRE(written == LAPRDUS_ERROR_CANCELLED);
+        REQUIRE(recorder.calls == 1);
+    }
+
+    SECTION("Caller buffer reports the required size") {
+        std::vector<int16_t> small(16);
+        int32_t required = laprdus_synthesize_to_buffer(engine, text, small.data(),
+                                                        small.size(), &format);
+        REQUIRE(required == expected_count);
+
+        std::vector<int16_t> exact(required);
+        int32_t written = laprdus_synthesize_to_buffer(engine, text, exact.data(),
+                                                       exact.size(), &format);
+        REQUIRE(written == expected_count);
+        REQUIRE(std::memcmp(exact.data(), expected, expected_count * sizeof(int16_t)) == 0);
+    }
+
+    REQUIRE(laprdus_synthesize_to_sink(engine, text, nullptr, nullptr, nullptr) ==
+            LAPRDUS_ERROR_INVALID_PARAMETER);
+    REQUIRE(laprdus_synthesize_to_sink(nullptr, text, record_sink, nullptr, nullptr) ==
+            LAPRDUS_ERROR_INVALID_HANDLE);
+
+    laprdus_free_buffer(expected);
+    laprdus_destroy(engine);
+}
+
+/* Synthesizes text and returns the samples (empty on failure) */
+static std::vector<int16_t> synthesize_samples(LaprdusHandle engine, const char* text) {
+    int16_t* samples = nullptr;
+    LaprdusAudioFormat format;
+    int32_t count = laprdus_synthesize(engine, text, &samples, &format);
+    std::vector<int16_t> result;
+    if (count > 0) {
+        result.assign(samples, samples + count);
+    }
+    laprdus_free_buffer(samples);
+    return result;
+}
+
+/* Records marks together with the number of samples written before each */
+struct MarkRecorder {
+    std::vector<int16_t> samples;
+    std::vector<std::string> names;
+    std::vector<uint64_t> offsets;
+    std::vector<size_t> written;
+    bool stop_at_mark = false;
+};
+
+static int LAPRDUS_CALL record_mark_audio(const int16_t* samples, size_t num_samples,
+                                          void* user_data) {
+    MarkRecorder* recorder = static_cast<MarkRecorder*>(user_data);
+    recorder->samples.insert(recorder->samples.end(), samples, samples + num_samples);
+    return 1;
+}
+
+static int LAPRDUS_CALL record_mark(const char* name, uint64_t sample_offset, void* user_data) {
+    MarkRecorder* recorder = static_cast<MarkRecorder*>(user_data);
+    recorder->names.push_back(name);
+    recorder->offsets.push_back(sample_offset);
+    recorder->written.push_back(recorder->samples.size());
+    return recorder->stop_at_mark ? 0 : 1;
+}
+
+TEST_CASE("C API reports inline marks", "[api][marks]") {
+    LaprdusHandle engine = laprdus_create();
+    REQUIRE(engine != nullptr);
+    REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+
+    const std::string text = std::string(LAPRDUS_MARK_BEGIN "start" LAPRDUS_MARK_END) +
+        "Dobar " LAPRDUS_MARK_BEGIN "w2" LAPRDUS_MARK_END "dan. Kako ste? " +
+        LAPRDUS_MARK_BEGIN "s3" LAPRDUS_MARK_END "Ja sam dobro, hvala!" +
+        LAPRDUS_MARK_BEGIN "end" LAPRDUS_MARK_END;
+    const std::vector<std::string> names = {"start", "w2", "s3", "end"};
+
+    SECTION("Marks are not spoken") {
+        // A mark at the very start leaves the audio unchanged
+        std::vector<int16_t> plain = synthesize_samples(engine, "Dobar dan.");
+        std::vector<int16_t> marked = synthesize_samples(
+            engine, LAPRDUS_MARK_BEGIN "a" LAPRDUS_MARK_END "Dobar dan.");
+        REQUIRE(!plain.empty());
+        REQUIRE(marked == plain);
+
+        // Mark names never reach the phoneme mapper
+        std::vector<int16_t> silent = synthesize_samples(
+            engine, LAPRDUS_MARK_BEGIN "Dobar dan" LAPRDUS_MARK_END);
+        REQUIRE(silent.empty());
+    }
+
+    SECTION("Marks arrive in order just before their audio") {
+        for (uint32_t rate : {22050u, 48000u}) {
+            REQUIRE(laprdus_set_output_rate(engine, rate) == LAPRDUS_OK);
+            std::vector<int16_t> expected = synthesize_samples(engine, text.c_str());
+            REQUIRE(!expected.empty());
+
+            for (uint32_t threads : {1u, 3u}) {
+                REQUIRE(laprdus_set_render_threads(engine, threads) == LAPRDUS_OK);
+
+                MarkRecorder recorder;
+                int32_t written = laprdus_synthesize_to_sink_with_marks(
+                    engine, text.c_str(), record_mark_audio, record_mark, &recorder, nullptr);
+                REQUIRE(written == static_cast<int32_t>(expected.size()));
+                REQUIRE(recorder.samples == expected);
+                REQUIRE(recorder.names == names);
+                REQUIRE(recorder.offsets.front() == 0);
+                REQUIRE(recorder.offsets.back() == expected.size());
+                for (size_t i = 0; i < recorder.offsets.size(); ++i) {
+                    REQUIRE(recorder.written[i] == recorder.offsets[i]);
+                    if (i > 0) {
+                        REQUIRE(recorder.offsets[i] > recorder.offsets[i - 1]);
+                    }
+                }
+            }
+        }
+        REQUIRE(laprdus_set_render_threads(engine, 1) == LAPRDUS_OK);
+        REQUIRE(laprdus_set_output_rate(engine, 22050) == LAPRDUS_OK);
+    }
+
+    SECTION("A mark inside a sentence leaves its audio unchanged") {
+        const char* plain_text = "Dobar dan, kako ste danas?";
+        const char* marked_text = "Dobar dan, kako " LAPRDUS_MARK_BEGIN "m" LAPRDUS_MARK_END
+                                  "ste danas?";
+        std::vector<int16_t> plain = synthesize_samples(engine, plain_text);
+        std::vector<int16_t> first_part = synthesize_samples(engine, "Dobar dan,");
+        REQUIRE(!plain.empty());
+        REQUIRE(synthesize_samples(engine, marked_text) == plain);
+
+        for (uint32_t threads : {1u, 3u}) {
+            REQUIRE(laprdus_set_render_threads(engine, threads) == LAPRDUS_OK);
+
+            MarkRecorder recorder;
+            int32_t written = laprdus_synthesize_to_sink_with_marks(
+                engine, marked_text, record_mark_audio, record_mark, &recorder, nullptr);
+            REQUIRE(written == static_cast<int32_t>(plain.size()));
+            REQUIRE(recorder.samples == plain);
+            REQUIRE(recorder.names == std::vector<std::string>{"m"});
+            REQUIRE(recorder.written[0] == recorder.offsets[0]);
+            // Inside the sentence part after the comma
+            REQUIRE(recorder.offsets[0] > first_part.size());
+            REQUIRE(recorder.offsets[0] < plain.size());
+        }
+        REQUIRE(laprdus_set_render_threads(engine, 1) == LAPRDUS_OK);
+    }
+
+    SECTION("Returning zero from the mark callback stops synthesis") {
+        MarkRecorder recorder;
+        recorder.stop_at_mark = true;
+        int32_t written = laprdus_synthesize_to_sink_with_marks(
+            engine, text.c_str(), record_mark_audio, record_mark, &recorder, nullptr);
+        REQUIRE(written == LAPRDUS_ERROR_CANCELLED);
+        REQUIRE(recorder.names.size() == 1);
+        REQUIRE(recorder.samples.empty());
+    }
+
+    SECTION("A NULL mark callback ignores marks") {
+        MarkRecorder recorder;
+        int32_t written = laprdus_synthesize_to_sink_with_marks(
+            engine, text.c_str(), record_mark_audio, nullptr, &recorder, nullptr);
+        REQUIRE(written > 0);
+        REQUIRE(recorder.names.empty());
+    }
+
+    laprdus_destroy(engine);
+}
+
+/* Collects batch results; each index is written by exactly one thread */
+struct BatchRecorder {
+    std::vector<std::vector<int16_t>> audio;
+    std::vector<LaprdusError> status;
+};
+
+static void LAPRDUS_CALL record_batch(size_t index, LaprdusError status, const int16_t* samples,
+                                      size_t num_samples, void* user_data) {
+    BatchRecorder* recorder = static_cast<BatchRecorder*>(user_data);
+    recorder->status[index] = status;
+    recorder->audio[index].assign(samples, samples + num_samples);
+}
+
+TEST_CASE("C API synthesizes a batch", "[api][batch]") {
+    LaprdusHandle engine = laprdus_create();
+    REQUIRE(engine != nullptr);
+
+    REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+
+    const char* texts[] = {"Dobar dan!", "Imam 25 godina.", "", "Kako ste? Dobro sam.",
+                           "Zatvori", "Nova poruka od Ivana."};
+    const size_t count = sizeof(texts) / sizeof(texts[0]);
+
+    // Reference: one synthesize call per text
+    std::vector<std::vector<int16_t>> expected(count);
+    LaprdusAudioFormat format;
+    for (size_t i = 0; i < count; ++i) {
+        int16_t* samples = nullptr;
+        int32_t num_samples = laprdus_synthesize(engine, texts[i], &samples, &format);
+        REQUIRE(num_samples >= 0);
+        expected[i].assign(samples, samples + num_samples);
+        laprdus_free_buffer(samples);
+    }
+
+    SECTION("Results match single synthesis") {
+        for (uint32_t threads : {1u, 3u}) {
+            REQUIRE(laprdus_set_render_threads(engine, threads) == LAPRDUS_OK);
+
+            BatchRecorder recorder;
+            recorder.audio.resize(count);
+            recorder.status.assign(count, LAPRDUS_ERROR_INVALID_PARAMETER);
+            LaprdusAudioFormat batch_format;
+
+            REQUIRE(laprdus_synthesize_batch(engine, texts, count, record_batch, &recorder,
+                                             &batch_format) == LAPRDUS_OK);
+            REQUIRE(batch_format.sample_rate == format.sample_rate);
+            for (size_t i = 0; i < count; ++i) {
+                REQUIRE(recorder.status[i] == LAPRDUS_OK);
+                REQUIRE(recorder.audio[i] == expected[i]);
+            }
+        }
+    }
+
+    REQUIRE(laprdus_synthesize_batch(engine, texts, count, nullptr, nullptr, nullptr) ==
+            LAPRDUS_ERROR_INVALID_PARAMETER);
+    REQUIRE(laprdus_synthesize_batch(nullptr, texts, count, record_batch, nullptr, nullptr) ==
+            LAPRDUS_ERROR_INVALID_HANDLE);
+
+    laprdus_destroy(engine);
+}
+
+/* Counts the zero samples at the end of a buffer */
+static size_t trailing_zeros(const std::vector<int16_t>& samples) {
+    size_t count = 0;
+    while (count < samples.size() && samples[samples.size() - 1 - count] == 0) {
+        ++count;
+    }
+    return count;
+}
+
+TEST_CASE("C API reads SSML input", "[api][ssml]") {
+    LaprdusHandle engine = laprdus_create();
+    REQUIRE(engine != nullptr);
+    REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+    REQUIRE(laprdus_load_spelling_dictionary(
+                engine, (get_data_dir() + "/spelling.json").c_str()) == LAPRDUS_OK);
+
+    std::vector<int16_t> plain = synthesize_samples(engine, "Dobar dan.");
+    REQUIRE(!plain.empty());
+    REQUIRE(laprdus_set_ssml_enabled(engine, 1) == LAPRDUS_OK);
+
+    SECTION("Markup is not spoken") {
+        REQUIRE(synthesize_samples(engine, "Dobar dan.") == plain);
+        REQUIRE(synthesize_samples(
+                    engine, "<?xml version=\"1.0\"?><speak>Dobar <!-- x --> dan.</speak>") ==
+                plain);
+        REQUIRE(synthesize_samples(
+                    engine, "<speak><unknown a=\"b\">Dobar</unknown> dan.</speak>") == plain);
+
+        std::vector<int16_t> entities = synthesize_samples(engine, "Ivan &amp; Ana");
+        REQUIRE(laprdus_set_ssml_enabled(engine, 0) == LAPRDUS_OK);
+        REQUIRE(entities == synthesize_samples(engine, "Ivan & Ana"));
+        REQUIRE(laprdus_set_ssml_enabled(engine, 1) == LAPRDUS_OK);
+    }
+
+    SECTION("Breaks add silence") {
+        std::vector<int16_t> second = synthesize_samples(
+            engine, "<speak>Dobar dan.<break time=\"1s\"/></speak>");
+        REQUIRE(second.size() == plain.size() + 22050);
+        REQUIRE(trailing_zeros(second) >= 22050);
+
+        std::vector<int16_t> none = synthesize_samples(
+            engine, "<speak>Dobar dan.<break strength=\"none\"/></speak>");
+        REQUIRE(none == plain);
+
+        std::vector<int16_t> only = synthesize_samples(engine, "<break time=\"100ms\"/>");
+        REQUIRE(only.size() == 2205);
+        REQUIRE(trailing_zeros(only) == only.size());
+    }
+
+    SECTION("Prosody changes the voice for its content") {
+        REQUIRE(laprdus_set_speed(engine, 2.0f) == LAPRDUS_OK);
+        std::vector<int16_t> fast = synthesize_samples(engine, "Dobar dan.");
+        REQUIRE(laprdus_set_speed(engine, 1.0f) == LAPRDUS_OK);
+        REQUIRE(synthesize_samples(engine, "<prosody rate=\"200%\">Dobar dan.</prosody>") ==
+                fast);
+
+        std::vector<int16_t> silent = synthesize_samples(
+            engine, "<prosody volume=\"silent\">Dobar dan.</prosody>");
+        REQUIRE(!silent.empty());
+        REQUIRE(trailing_zeros(silent) == silent.size());
+
+        // The voice settings come back after the element
+        std::vector<int16_t> after = synthesize_samples(
+            engine, "<prosody volume=\"silent\">Kako ste?</prosody> Dobar dan.");
+        REQUIRE(after.size() > plain.size());
+        REQUIRE(std::equal(plain.begin(), plain.end(), after.end() - plain.size()));
+    }
+
+    SECTION("say-as characters is spelled") {
+        std::vector<int16_t> spelled;
+        int16_t* samples = nullptr;
+        int32_t count = laprdus_synthesize_spelled(engine, "ab", &samples, nullptr);
+        REQUIRE(count > 0);
+        spelled.assign(samples, samples + count);
+        laprdus_free_buffer(samples);
+
+        REQUIRE(synthesize_samples(
+                    engine, "<say-as interpret-as=\"characters\">ab</say-as>") == spelled);
+
+        // Spelling SSML spells only its text
+        count = laprdus_synthesize_spelled(engine, "<speak>ab</speak>", &samples, nullptr);
+        REQUIRE(count == static_cast<int32_t>(spelled.size()));
+        laprdus_free_buffer(samples);
+    }
+
+    SECTION("Marks report their offsets") {
+        const char* ssml = "<speak><mark name=\"a\"/>Dobar dan.<break time=\"200ms\"/>"
+                           "<mark name=\"b\"/>Kako ste?<mark name=\"c\"/></speak>";
+        const std::vector<std::string> names = {"a", "b", "c"};
+        std::vector<int16_t> expected = synthesize_samples(engine, ssml);
+        REQUIRE(!expected.empty());
+
+        for (uint32_t threads : {1u, 3u}) {
+            REQUIRE(laprdus_set_render_threads(engine, threads) == LAPRDUS_OK);
+
+            MarkRecorder recorder;
+            int32_t written = laprdus_synthesize_to_sink_with_marks(
+                engine, ssml, record_mark_audio, record_mark, &recorder, nullptr);
+            REQUIRE(written == static_cast<int32_t>(expected.size()));
+            REQUIRE(recorder.samples == expected);
+            REQUIRE(recorder.names == names);
+            REQUIRE(recorder.offsets[0] == 0);
+            REQUIRE(recorder.offsets[1] == plain.size() + 4410);
+            REQUIRE(recorder.offsets[2] == expected.size());
+        }
+        REQUIRE(laprdus_set_render_threads(engine, 1) == LAPRDUS_OK);
+    }
+
+    SECTION("Batch synthesis speaks the text") {
+        const char* texts[] = {"<speak>Dobar <break time=\"1s\"/>dan.</speak>"};
+        BatchRecorder recorder;
+        recorder.audio.resize(1);
+        recorder.status.assign(1, LAPRDUS_ERROR_INVALID_PARAMETER);
+        REQUIRE(laprdus_synthesize_batch(engine, texts, 1, record_batch, &recorder, nullptr) ==
+                LAPRDUS_OK);
+        REQUIRE(recorder.status[0] == LAPRDUS_OK);
+        REQUIRE(recorder.audio[0] == plain);
+    }
+
+    REQUIRE(laprdus_set_ssml_enabled(nullptr, 1) == LAPRDUS_ERROR_INVALID_HANDLE);
+
+    laprdus_destroy(engine);
+}
+
+TEST_CASE("C API warms up the engine", "[api][warmup]") {
+    const char* text = "Dobar dan. Kako ste? Imam 25 godina, hvala!";
+
+    LaprdusHandle cold = laprdus_create();
+    REQUIRE(cold != nullptr);
+    REQUIRE(laprdus_set_voice(cold, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+    REQUIRE(laprdus_set_speed(cold, 1.3f) == LAPRDUS_OK);
+    std::vector<int16_t> expected = synthesize_samples(cold, text);
+    REQUIRE(!expected.empty());
+
+    SECTION("Output is unchanged after laprdus_warmup") {
+        LaprdusHandle engine = laprdus_create();
+        REQUIRE(engine != nullptr);
+        REQUIRE(laprdus_warmup(engine) == LAPRDUS_ERROR_NOT_INITIALIZED);
+        REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+        REQUIRE(laprdus_set_speed(engine, 1.3f) == LAPRDUS_OK);
+        REQUIRE(laprdus_set_stats_enabled(engine, 1) == LAPRDUS_OK);
+
+        std::vector<int16_t> before = synthesize_samples(engine, text);
+        LaprdusStats stats_before;
+        REQUIRE(laprdus_get_last_stats(engine, &stats_before) == LAPRDUS_OK);
+
+        REQUIRE(laprdus_warmup(engine) == LAPRDUS_OK);
+
+        // Settings and the last call's statistics are left alone
+        LaprdusVoiceParams params;
+        REQUIRE(laprdus_get_voice_params(engine, &params) == LAPRDUS_OK);
+        REQUIRE(params.speed == 1.3f);
+        LaprdusStats stats_after;
+        REQUIRE(laprdus_get_last_stats(engine, &stats_after) == LAPRDUS_OK);
+        REQUIRE(stats_after.output_samples == stats_before.output_samples);
+
+        REQUIRE(before == expected);
+        REQUIRE(synthesize_samples(engine, text) == expected);
+
+        REQUIRE(laprdus_set_render_threads(engine, 3) == LAPRDUS_OK);
+        REQUIRE(laprdus_warmup(engine) == LAPRDUS_OK);
+        REQUIRE(synthesize_samples(engine, text) == expected);
+        laprdus_destroy(engine);
+    }
+
+    SECTION("Automatic warm-up after voice load") {
+        for (LaprdusWarmupMode mode : {LAPRDUS_WARMUP_BLOCKING, LAPRDUS_WARMUP_BACKGROUND}) {
+            LaprdusHandle engine = laprdus_create();
+            REQUIRE(engine != nullptr);
+            REQUIRE(laprdus_set_auto_warmup(engine, mode) == LAPRDUS_OK);
+            REQUIRE(laprdus_set_speed(engine, 1.3f) == LAPRDUS_OK);
+            REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+            REQUIRE(laprdus_flush(engine) == LAPRDUS_OK);
+            REQUIRE(synthesize_samples(engine, text) == expected);
+            laprdus_destroy(engine);
+        }
+    }
+
+    SECTION("Background warm-up can be cancelled") {
+        LaprdusHandle engine = laprdus_create();
+        REQUIRE(engine != nullptr);
+        REQUIRE(laprdus_set_auto_warmup(engine, LAPRDUS_WARMUP_BACKGROUND) == LAPRDUS_OK);
+        REQUIRE(laprdus_set_speed(engine, 1.3f) == LAPRDUS_OK);
+        REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+        laprdus_cancel(engine);
+        REQUIRE(laprdus_flush(engine) == LAPRDUS_OK);
+        REQUIRE(synthesize_samples(engine, text) == expected);
+        laprdus_destroy(engine);
+    }
+
+    SECTION("A synthesis request stops background warm-up") {
+        const char* trace_file = "/tmp/laprdus_test_warmup_trace.json";
+        std::remove(trace_file);
+        REQUIRE(laprdus_set_trace_file(trace_file) == LAPRDUS_OK);
+
+        // The warm-up takes a few tens of milliseconds with render threads;
+        // the request comes once the worker has started it
+        LaprdusHandle engine = laprdus_create();
+        REQUIRE(engine != nullptr);
+        REQUIRE(laprdus_set_auto_warmup(engine, LAPRDUS_WARMUP_BACKGROUND) == LAPRDUS_OK);
+        REQUIRE(laprdus_set_render_threads(engine, 4) == LAPRDUS_OK);
+        REQUIRE(laprdus_set_speed(engine, 1.3f) == LAPRDUS_OK);
+        REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        REQUIRE(synthesize_samples(engine, text) == expected);
+        REQUIRE(laprdus_flush(engine) == LAPRDUS_OK);
+        laprdus_destroy(engine);
+        REQUIRE(laprdus_set_trace_file(nullptr) == LAPRDUS_OK);
+
+        std::ifstream f(trace_file);
+        std::stringstream buffer;
+        buffer << f.rdbuf();
+        std::string trace = buffer.str();
+        size_t warmup = trace.find("\"name\":\"warmup\",\"cat\":\"engine\"");
+        REQUIRE(warmup != std::string::npos);
+        REQUIRE(trace.find("\"completed\":0", warmup) < trace.find('}', warmup));
+        std::remove(trace_file);
+    }
+
+    REQUIRE(laprdus_warmup(nullptr) == LAPRDUS_ERROR_INVALID_HANDLE);
+    REQUIRE(laprdus_set_auto_warmup(nullptr, LAPRDUS_WARMUP_NONE) ==
+            LAPRDUS_ERROR_INVALID_HANDLE);
+    REQUIRE(laprdus_set_auto_warmup(cold, static_cast<LaprdusWarmupMode>(7)) ==
+            LAPRDUS_ERROR_INVALID_PARAMETER);
+
+    laprdus_destroy(cold);
+}
+
+TEST_CASE("C API decodes phonemes lazily", "[api][lazy]") {
+    const char* text = "Dobar dan. Kako ste? Ja sam dobro, hvala! Danas je 12. listopada.";
+    std::vector<uint8_t> pack = read_file(get_data_dir() + "/Josip.bin");
+    REQUIRE(pack.size() > 64);
+
+    LaprdusHandle eager = laprdus_create();
+    REQUIRE(eager != nullptr);
+    REQUIRE(laprdus_init_from_memory(eager, pack.data(), pack.size(), nullptr, 0) == LAPRDUS_OK);
+    std::vector<int16_t> expected = synthesize_samples(eager, text);
+    REQUIRE(!expected.empty());
+    laprdus_destroy(eager);
+
+    SECTION("Output matches eager loading") {
+        for (uint32_t threads : {1u, 3u}) {
+            LaprdusHandle engine = laprdus_create();
+            REQUIRE(engine != nullptr);
+            REQUIRE(laprdus_set_lazy_loading(engine, 1) == LAPRDUS_OK);
+            REQUIRE(laprdus_set_render_threads(engine, threads) == LAPRDUS_OK);
+            REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+            REQUIRE(synthesize_samples(engine, text) == expected);
+            REQUIRE(synthesize_samples(engine, text) == expected);
+            laprdus_destroy(engine);
+        }
+    }
+
+    SECTION("Encrypted pack decodes per phoneme") {
+        // XOR the data section the way the packer does
+        const uint8_t key[] = {0x5A, 0x13, 0xC7, 0x21, 0x9E};
+        std::vector<uint8_t> encrypted = pack;
+        uint32_t data_offset;
+        std::memcpy(&data_offset, encrypted.data() + 16, sizeof(data_offset));
+        encrypted[6] |= 0x01;  // PACKED_FLAG_ENCRYPTED
+        for (size_t i = data_offset; i < encrypted.size(); ++i) {
+            encrypted[i] ^= key[(i - data_offset) % sizeof(key)];
+        }
+
+        for (int lazy : {0, 1}) {
+            LaprdusHandle engine = laprdus_create();
+            REQUIRE(engine != nullptr);
+            REQUIRE(laprdus_set_lazy_loading(engine, lazy) == LAPRDUS_OK);
+            REQUIRE(laprdus_init_from_memory(engine, encrypted.data(), encrypted.size(),
+                                             nullptr, 0) == LAPRDUS_ERROR_LOAD_FAILED);
+            REQUIRE(laprdus_init_from_memory(engine, encrypted.data(), encrypted.size(),
+                                             key, sizeof(key)) == LAPRDUS_OK);
+            REQUIRE(synthesize_samples(engine, text) == expected);
+            laprdus_destroy(engine);
+        }
+    }
+
+    SECTION("Truncated index is rejected") {
+        LaprdusHandle engine = laprdus_create();
+        REQUIRE(engine != nullptr);
+        REQUIRE(laprdus_set_lazy_loading(engine, 1) == LAPRDUS_OK);
+        REQUIRE(laprdus_init_from_memory(engine, pack.data(), 80, nullptr, 0) ==
+                LAPRDUS_ERROR_LOAD_FAILED);
+        laprdus_destroy(engine);
+    }
+
+    REQUIRE(laprdus_set_lazy_loading(nullptr, 1) == LAPRDUS_ERROR_INVALID_HANDLE);
+}
+
+TEST_CASE("C API borrows voice data from memory", "[api][nocopy]") {
+    const char* text = "Dobar dan. Kako ste? Ja sam dobro, hvala! Danas je 12. listopada.";
+    std::vector<uint8_t> pack = read_file(get_data_dir() + "/Josip.bin");
+    REQUIRE(pack.size() > 64);
+    uint32_t data_offset;
+    std::memcpy(&data_offset, pack.data() + 16, sizeof(data_offset));
+
+    LaprdusHandle copied = laprdus_create();
+    REQUIRE(copied != nullptr);
+    REQUIRE(laprdus_init_from_memory(copied, pack.data(), pack.size(), nullptr, 0) == LAPRDUS_OK);
+    std::vector<int16_t> expected = synthesize_samples(copied, text);
+    REQUIRE(!expected.empty());
+
+    SECTION("Plain packs are used in place") {
+        std::vector<uint8_t> buffer = pack;
+        LaprdusHandle engine = laprdus_create();
+        REQUIRE(engine != nullptr);
+        REQUIRE(laprdus_init_from_memory_nocopy(engine, buffer.data(), buffer.size(),
+                                                nullptr, 0) == LAPRDUS_OK);
+        REQUIRE(synthesize_samples(engine, text) == expected);
+
+        // Silencing the caller's buffer silences the borrowing engine only
+        std::fill(buffer.begin() + data_offset, buffer.end(), 0);
+        std::vector<int16_t> silenced = synthesize_samples(engine, text);
+        REQUIRE(std::all_of(silenced.begin(), silenced.end(), [](int16_t s) { return s == 0; }));
+        REQUIRE(synthesize_samples(copied, text) == expected);
+        laprdus_destroy(engine);
+    }
+
+    SECTION("Unaligned buffers still load") {
+        std::vector<uint8_t> buffer(pack.size() + 1);
+        std::copy(pack.begin(), pack.end(), buffer.begin() + 1);
+        LaprdusHandle engine = laprdus_create();
+        REQUIRE(engine != nullptr);
+        REQUIRE(laprdus_init_from_memory_nocopy(engine, buffer.data() + 1, pack.size(),
+                                                nullptr, 0) == LAPRDUS_OK);
+        REQUIRE(synthesize_samples(engine, text) == expected);
+        laprdus_destroy(engine);
+    }
+
+    SECTION("Encrypted packs are decoded") {
+        const uint8_t key[] = {0x5A, 0x13, 0xC7, 0x21, 0x9E};
+        std::vector<uint8_t> encrypted = pack;
+        encrypted[6] |= 0x01;  // PACKED_FLAG_ENCRYPTED
+        for (size_t i = data_offset; i < encrypted.size(); ++i) {
+            encrypted[i] ^= key[(i - data_offset) % sizeof(key)];
+        }
+
+        for (int lazy : {0, 1}) {
+            LaprdusHandle engine = laprdus_create();
+            REQUIRE(engine != nullptr);
+            REQUIRE(laprdus_set_lazy_loading(engine, lazy) == LAPRDUS_OK);
+            REQUIRE(laprdus_init_from_memory_nocopy(engine, encrypted.data(), encrypted.size(),
+                                                    nullptr, 0) == LAPRDUS_ERROR_LOAD_FAILED);
+            REQUIRE(laprdus_init_from_memory_nocopy(engine, encrypted.data(), encrypted.size(),
+                                                    key, sizeof(key)) == LAPRDUS_OK);
+            REQUIRE(synthesize_samples(engine, text) == expected);
+            laprdus_destroy(engine);
+        }
+    }
+
+    laprdus_destroy(copied);
+    REQUIRE(laprdus_init_from_memory_nocopy(nullptr, pack.data(), pack.size(), nullptr, 0) ==
+            LAPRDUS_ERROR_INVALID_HANDLE);
+}
+
+TEST_CASE("Packer compresses voice packs losslessly", "[packer][compress]") {
+    const char* text = "Dobar dan. Kako ste? Ja sam dobro, hvala! Danas je 12. listopada.";
+    const char* compressed_file = "/tmp/laprdus_test_compressed.bin";
+    const char* encrypted_file = "/tmp/laprdus_test_compressed_encrypted.bin";
+    const char* key_hex = "00112233445566778899aabbccddeeff0123456789abcdef0f1e2d3c4b5a6978";
+    std::string original_file = get_data_dir() + "/Josip.bin";
+
+    std::string pack_cmd = get_packer_path() + " --input-pack " + original_file + " --compress";
+    REQUIRE(std::system((pack_cmd + " --output " + compressed_file + " > /dev/null").c_str()) == 0);
+    REQUIRE(std::system((pack_cmd + " --encrypt --key " + key_hex + " --output " +
+                         encrypted_file + " > /dev/null").c_str()) == 0);
+
+    std::vector<uint8_t> original = read_file(original_file);
+    std::vector<uint8_t> compressed = read_file(compressed_file);
+    std::vector<uint8_t> encrypted = read_file(encrypted_file);
+    REQUIRE(!compressed.empty());
+    REQUIRE(compressed.size() < original.size());
+    REQUIRE(encrypted.size() == compressed.size());
+
+    LaprdusHandle reference = laprdus_create();
+    REQUIRE(reference != nullptr);
+    REQUIRE(laprdus_init_from_memory(reference, original.data(), original.size(), nullptr, 0) ==
+            LAPRDUS_OK);
+    std::vector<int16_t> expected = synthesize_samples(reference, text);
+    REQUIRE(!expected.empty());
+    laprdus_destroy(reference);
+
+    SECTION("Output matches the uncompressed pack") {
+        uint8_t key[32];
+        for (size_t i = 0; i < sizeof(key); ++i) {
+            key[i] = static_cast<uint8_t>(std::stoi(std::string(key_hex + i * 2, 2), nullptr, 16));
+        }
+        for (int lazy : {0, 1}) {
+            LaprdusHandle engine = laprdus_create();
+            REQUIRE(engine != nullptr);
+            REQUIRE(laprdus_set_lazy_loading(engine, lazy) == LAPRDUS_OK);
+            REQUIRE(laprdus_init_from_memory(engine, compressed.data(), compressed.size(),
+                                             nullptr, 0) == LAPRDUS_OK);
+            REQUIRE(synthesize_samples(engine, text) == expected);
+            REQUIRE(laprdus_init_from_memory(engine, encrypted.data(), encrypted.size(),
+                                             key, sizeof(key)) == LAPRDUS_OK);
+            REQUIRE(synthesize_samples(engine, text) == expected);
+            laprdus_destroy(engine);
+        }
+    }
+
+    SECTION("Packer expands a compressed pack back to the original") {
+        const char* expanded_file = "/tmp/laprdus_test_expanded.bin";
+        REQUIRE(std::system((get_packer_path() + " --input-pack " + compressed_file +
+                             " --output " + expanded_file + " > /dev/null").c_str()) == 0);
+        REQUIRE(read_file(expanded_file) == original);
+        std::remove(expanded_file);
+    }
+
+    SECTION("Corrupt compressed audio is rejected") {
+        uint32_t data_offset;
+        std::memcpy(&data_offset, compressed.data() + 16, sizeof(data_offset));
+        std::fill(compressed.begin() + data_offset, compressed.end(), 0xFF);
+
+        LaprdusHandle engine = laprdus_create();
+        REQUIRE(engine != nullptr);
+        REQUIRE(laprdus_init_from_memory(engine, compressed.data(), compressed.size(),
+                                         nullptr, 0) == LAPRDUS_ERROR_LOAD_FAILED);
+        laprdus_destroy(engine);
+    }
+
+    std::remove(compressed_file);
+    std::remove(encrypted_file);
+}
+
+TEST_CASE("C API verifies voice pack checksums", "[api][checksum]") {
+    const char* encrypted_file = "/tmp/laprdus_test_checksum_encrypted.bin";
+    const char* key_hex = "0f1e2d3c4b5a69788796a5b4c3d2e1f000112233445566778899aabbccddeeff";
+    std::string original_file = get_data_dir() + "/Josip.bin";
+    REQUIRE(std::system((get_packer_path() + " --input-pack " + original_file +
+                         " --encrypt --key " + key_hex + " --output " + encrypted_file +
+                         " > /dev/null").c_str()) == 0);
+
+    std::vector<uint8_t> pack = read_file(original_file);
+    std::vector<uint8_t> encrypted = read_file(encrypted_file);
+    REQUIRE(pack.size() > 64);
+    REQUIRE(encrypted.size() == pack.size());
+    uint8_t key[32];
+    for (size_t i = 0; i < sizeof(key); ++i) {
+        key[i] = static_cast<uint8_t>(std::stoi(std::string(key_hex + i * 2, 2), nullptr, 16));
+    }
+
+    SECTION("Intact packs load") {
+        for (int lazy : {0, 1}) {
+            LaprdusHandle engine = laprdus_create();
+            REQUIRE(engine != nullptr);
+            REQUIRE(laprdus_set_checksum_verification(engine, 1) == LAPRDUS_OK);
+            REQUIRE(laprdus_set_lazy_loading(engine, lazy) == LAPRDUS_OK);
+            REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+            REQUIRE(laprdus_init_from_memory(engine, encrypted.data(), encrypted.size(),
+                                             key, sizeof(key)) == LAPRDUS_OK);
+            REQUIRE(!synthesize_samples(engine, "Dobar dan.").empty());
+            laprdus_destroy(engine);
+        }
+    }
+
+    SECTION("Altered audio is rejected only when verifying") {
+        uint32_t data_offset;
+        std::memcpy(&data_offset, pack.data() + 16, sizeof(data_offset));
+        pack[data_offset + (pack.size() - data_offset) / 2] ^= 0x01;
+        encrypted[encrypted.size() - 1] ^= 0x80;
+
+        for (int lazy : {0, 1}) {
+            LaprdusHandle engine = laprdus_create();
+            REQUIRE(engine != nullptr);
+            REQUIRE(laprdus_set_lazy_loading(engine, lazy) == LAPRDUS_OK);
+            REQUIRE(laprdus_init_from_memory(engine, pack.data(), pack.size(), nullptr, 0) ==
+                    LAPRDUS_OK);
+            REQUIRE(laprdus_set_checksum_verification(engine, 1) == LAPRDUS_OK);
+            REQUIRE(laprdus_init_from_memory(engine, pack.data(), pack.size(), nullptr, 0) ==
+                    LAPRDUS_ERROR_LOAD_FAILED);
+            REQUIRE(laprdus_init_from_memory(engine, encrypted.data(), encrypted.size(),
+                                             key, sizeof(key)) == LAPRDUS_ERROR_LOAD_FAILED);
+            laprdus_destroy(engine);
+        }
+    }
+
+    REQUIRE(laprdus_set_checksum_verification(nullptr, 1) == LAPRDUS_ERROR_INVALID_HANDLE);
+    std::remove(encrypted_file);
+}
+
+TEST_CASE("C API reports synthesis statistics", "[api][stats]") {
+    LaprdusHandle engine = laprdus_create();
+    REQUIRE(engine != nullptr);
+
+    REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+
+    int16_t* samples = nullptr;
+    LaprdusAudioFormat format;
+    LaprdusStats stats;
+
+    SECTION("Disabled by default") {
+        int32_t num_samples = laprdus_synthesize(engine, "Dobar dan!", &samples, &format);
+        REQUIRE(num_samples > 0);
+
+        REQUIRE(laprdus_get_last_stats(engine, &stats) == LAPRDUS_OK);
+        REQUIRE(stats.output_samples == 0);
+        REQUIRE(stats.total_ms == 0.0);
+    }
+
+    SECTION("Enabled") {
+        REQUIRE(laprdus_set_stats_enabled(engine, 1) == LAPRDUS_OK);
+
+        int32_t num_samples = laprdus_synthesize(engine, "Dobar dan. Kako ste?", &samples, &format);
+        REQUIRE(num_samples > 0);
+
+        REQUIRE(laprdus_get_last_stats(engine, &stats) == LAPRDUS_OK);
+        REQUIRE(stats.segment_count == 2);
+        REQUIRE(stats.phoneme_count > 0);
+        REQUIRE(stats.output_samples == static_cast<uint64_t>(num_samples));
+        REQUIRE(stats.peak_buffer_bytes >= stats.output_samples * sizeof(int16_t));
+        REQUIRE(stats.total_ms > 0.0);
+        REQUIRE(stats.total_ms >= stats.concatenate_ms + stats.inflection_ms);
+    }
+
+    REQUIRE(laprdus_get_last_stats(engine, nullptr) == LAPRDUS_ERROR_INVALID_PARAMETER);
+
+    laprdus_free_buffer(samples);
+    laprdus_destroy(engine);
+}
+
+TEST_CASE("C API writes trace file", "[api][trace]") {
+    const char* trace_file = "/tmp/laprdus_test_trace.json";
+    std::remove(trace_file);
+
+    REQUIRE(laprdus_set_trace_file(trace_file) == LAPRDUS_OK);
+
+    LaprdusHandle engine = laprdus_create();
+    REQUIRE(engine != nullptr);
+    REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+
+    int16_t* samples = nullptr;
+    LaprdusAudioFormat format;
+    laprdus_trace_begin("test \"host\" event");
+    int32_t num_samples = laprdus_synthesize(engine, "Dobar dan!", &samples, &format);
+    laprdus_trace_end("test \"host\" event");
+    REQUIRE(num_samples > 0);
+
+    laprdus_free_buffer(samples);
+    laprdus_destroy(engine);
+    REQUIRE(laprdus_set_trace_file(nullptr) == LAPRDUS_OK);
+
+    std::ifstream f(trace_file);
+    std::stringstream buffer;
+    buffer << f.rdbuf();
+    std::string trace = buffer.str();
+
+    REQUIRE(trace.rfind("[", 0) == 0);
+    REQUIRE(trace.find("\n]\n") != std::string::npos);
+    REQUIRE(trace.find("\"name\":\"synthesize\",\"cat\":\"engine\"") != std::string::npos);
+    REQUIRE(trace.find("\"cat\":\"inflection\"") != std::string::npos);
+    REQUIRE(trace.find("\"cat\":\"formant\"") != std::string::npos);
+    REQUIRE(trace.find("test \\\"host\\\" event") != std::string::npos);
+
+    // Events are no longer recorded once the trace is closed
+    size_t closed_size = file_size(trace_file);
+    laprdus_trace_begin("after close");
+    laprdus_trace_end("after close");
+    REQUIRE(file_size(trace_file) == closed_size);
+
+    REQUIRE(laprdus_set_trace_file("/nonexistent/dir/trace.json") == LAPRDUS_ERROR_INVALID_PATH);
+
+    std::remove(trace_file);
+}
+
+/* Records sink events; the sink runs on the engine's worker thread */
+struct AsyncRecorder {
+    struct Event {
+        LaprdusEventType type;
+        uint32_t utterance_id;
+        size_t num_samples;
+        LaprdusError status;
+        uint64_t mark_offset;
+        uint64_t submitted_us;
+        uint64_t first_audio_us;
+        uint64_t finished_us;
+    };
+    std::vector<Event> events;
+    std::vector<int16_t> samples;
+    bool stop_first = false;  /* Return 0 from the first utterance's first chunk */
+    std::atomic<size_t> chunks{0};  /* Audio chunks so far, readable from any thread */
+
+    size_t count(LaprdusEventType type, uint32_t id) const {
+        size_t n = 0;
+        for (const Event& e : events) {
+            if (e.type == type && e.utterance_id == id) {
+                ++n;
+            }
+        }
+        return n;
+    }
+
+    LaprdusError end_status(uint32_t id) const {
+        for (const Event& e : events) {
+            if (e.type == LAPRDUS_EVENT_END && e.utterance_id == id) {
+                return e.status;
+            }
+        }
+        return LAPRDUS_OK;
+    }
+
+    /* Position of the first event of a type for an utterance, or SIZE_MAX */
+    size_t index_of(LaprdusEventType type, uint32_t id) const {
+        for (size_t i = 0; i < events.size(); ++i) {
+            if (events[i].type == type && events[i].utterance_id == id) {
+                return i;
+            }
+        }
+        return SIZE_MAX;
+    }
+
+    /* Wait until the worker has delivered some audio */
+    void wait_for_audio() const {
+        for (int i = 0; i < 2000 && chunks.load() == 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    static int LAPRDUS_CALL sink(const LaprdusEvent* event, void* user_data) {
+        auto* self = static_cast<AsyncRecorder*>(user_data);
+        self->events.push_back({event->type, event->utterance_id, event->num_samples,
+                                event->status, event->mark_offset, event->submitted_us,
+                                event->first_audio_us, event->finished_us});
+        if (event->type == LAPRDUS_EVENT_AUDIO) {
+            self->chunks.fetch_add(1);
+            self->samples.insert(self->samples.end(), event->samples,
+                                 event->samples + event->num_samples);
+            bool first = event->utterance_id == self->events.front().utterance_id;
+            return (self->stop_first && first) ? 0 : 1;
+        }
+        return 1;
+    }
+};
+
+TEST_CASE("C API speaks asynchronously", "[api][async]") {
+    LaprdusHandle engine = laprdus_create();
+    REQUIRE(engine != nullptr);
+    REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+
+    const char* text = "Dobar dan. Kako ste?";
+    int16_t* samples = nullptr;
+    LaprdusAudioFormat format;
+    int32_t num_samples = laprdus_synthesize(engine, text, &samples, &format);
+    REQUIRE(num_samples > 0);
+
+    AsyncRecorder recorder;
+    int32_t first = laprdus_speak_async(engine, text, AsyncRecorder::sink, &recorder);
+    int32_t second = laprdus_speak_async(engine, text, AsyncRecorder::sink, &recorder);
+    REQUIRE(first > 0);
+    REQUIRE(second > first);
+    REQUIRE(laprdus_flush(engine) == LAPRDUS_OK);
+
+    // Utterances are spoken in order: BEGIN, AUDIO..., END each
+    REQUIRE(recorder.events.size() >= 6);
+    REQUIRE(recorder.events.front().type == LAPRDUS_EVENT_BEGIN);
+    REQUIRE(recorder.events.front().utterance_id == static_cast<uint32_t>(first));
+    REQUIRE(recorder.events.back().type == LAPRDUS_EVENT_END);
+    REQUIRE(recorder.events.back().utterance_id == static_cast<uint32_t>(second));
+    REQUIRE(recorder.count(LAPRDUS_EVENT_END, first) == 1);
+    REQUIRE(recorder.count(LAPRDUS_EVENT_END, second) == 1);
+    REQUIRE(recorder.end_status(first) == LAPRDUS_OK);
+    REQUIRE(recorder.end_status(second) == LAPRDUS_OK);
+
+    // Streamed audio matches synchronous synthesis exactly
+    std::vector<int16_t> expected(samples, samples + num_samples);
+    expected.insert(expected.end(), samples, samples + num_samples);
+    REQUIRE(recorder.samples == expected);
+
+    // Marks come between the audio chunks, at the samples delivered so far
+    AsyncRecorder marked;
+    int32_t id = laprdus_speak_async(
+        engine, "Dobar " LAPRDUS_MARK_BEGIN "m" LAPRDUS_MARK_END "dan. Kako ste?",
+        AsyncRecorder::sink, &marked);
+    REQUIRE(id > 0);
+    REQUIRE(laprdus_flush(engine) == LAPRDUS_OK);
+    REQUIRE(marked.count(LAPRDUS_EVENT_MARK, id) == 1);
+    uint64_t delivered = 0;
+    size_t chunks_after_mark = 0;
+    bool seen_mark = false;
+    for (const AsyncRecorder::Event& e : marked.events) {
+        if (e.type == LAPRDUS_EVENT_MARK) {
+            REQUIRE(delivered > 0);
+            REQUIRE(e.mark_offset == delivered);
+            seen_mark = true;
+        } else if (e.type == LAPRDUS_EVENT_AUDIO) {
+            delivered += e.num_samples;
+            chunks_after_mark += seen_mark ? 1 : 0;
+        }
+    }
+    REQUIRE(chunks_after_mark > 0);
+    REQUIRE(marked.end_status(id) == LAPRDUS_OK);
+
+    REQUIRE(laprdus_speak_async(engine, nullptr, AsyncRecorder::sink, &recorder) ==
+            LAPRDUS_ERROR_INVALID_PARAMETER);
+    REQUIRE(laprdus_speak_async(nullptr, text, AsyncRecorder::sink, &recorder) ==
+            LAPRDUS_ERROR_INVALID_HANDLE);
+
+    laprdus_free_buffer(samples);
+    laprdus_destroy(engine);
+}
+
+TEST_CASE("C API cancels asynchronous speech", "[api][async]") {
+    LaprdusHandle engine = laprdus_create();
+    REQUIRE(engine != nullptr);
+    REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+
+    const char* text = "Ovo je dulja rečenica. Ona ima nekoliko dijelova, i traje neko vrijeme.";
+
+    SECTION("Cancel discards queued utterances") {
+        AsyncRecorder recorder;
+        std::vector<int32_t> ids;
+        for (int i = 0; i < 4; ++i) {
+            ids.push_back(laprdus_speak_async(engine, text, AsyncRecorder::sink, &recorder));
+            REQUIRE(ids.back() > 0);
+        }
+        laprdus_cancel(engine);
+        REQUIRE(laprdus_flush(engine) == LAPRDUS_OK);
+
+        // Every utterance ends exactly once; the last never started
+        for (int32_t id : ids) {
+            REQUIRE(recorder.count(LAPRDUS_EVENT_END, id) == 1);
+        }
+        REQUIRE(recorder.end_status(ids.back()) == LAPRDUS_ERROR_CANCELLED);
+        REQUIRE(recorder.count(LAPRDUS_EVENT_BEGIN, ids.back()) == 0);
+    }
+
+    SECTION("Sink can stop an utterance") {
+        AsyncRecorder recorder;
+        recorder.stop_first = true;
+        int32_t stopped = laprdus_speak_async(engine, text, AsyncRecorder::sink, &recorder);
+        int32_t next = laprdus_speak_async(engine, "Dobar dan.", AsyncRecorder::sink, &recorder);
+        REQUIRE(laprdus_flush(engine) == LAPRDUS_OK);
+
+        REQUIRE(recorder.end_status(stopped) == LAPRDUS_ERROR_CANCELLED);
+        REQUIRE(recorder.count(LAPRDUS_EVENT_AUDIO, stopped) == 1);
+        REQUIRE(recorder.count(LAPRDUS_EVENT_END, next) == 1);
+        REQUIRE(recorder.end_status(next) == LAPRDUS_OK);
+    }
+
+    laprdus_destroy(engine);
+}
+
+/* Keeps a synchronous call inside its first chunk until released */
+struct HeldSink {
+    std::atomic<bool> started{false};
+    std::atomic<bool> released{false};
+    size_t samples = 0;
+};
+
+static int LAPRDUS_CALL hold_sink(const int16_t*, size_t num_samples, void* user_data) {
+    HeldSink* held = static_cast<HeldSink*>(user_data);
+    held->samples += num_samples;
+    held->started = true;
+    for (int i = 0; i < 2000 && !held->released.load(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return 1;
+}
+
+TEST_CASE("C API interrupts lower-priority speech", "[api][priority]") {
+    LaprdusHandle engine = laprdus_create();
+    REQUIRE(engine != nullptr);
+    REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+
+    std::string long_text;
+    for (int i = 0; i < 40; ++i) {
+        long_text += "Ovo je dulja rečenica, koja se čita neko vrijeme. ";
+    }
+
+    SECTION("Key echo interrupts text and progress") {
+        AsyncRecorder recorder;
+        int32_t text = laprdus_speak_async_with_priority(
+            engine, long_text.c_str(), LAPRDUS_PRIORITY_TEXT, AsyncRecorder::sink, &recorder);
+        int32_t queued_text = laprdus_speak_async_with_priority(
+            engine, "Dobar dan.", LAPRDUS_PRIORITY_TEXT, AsyncRecorder::sink, &recorder);
+        int32_t progress = laprdus_speak_async_with_priority(
+            engine, "Pedeset posto.", LAPRDUS_PRIORITY_PROGRESS, AsyncRecorder::sink, &recorder);
+        int32_t notification = laprdus_speak_async_with_priority(
+            engine, "Nova poruka.", LAPRDUS_PRIORITY_NOTIFICATION, AsyncRecorder::sink, &recorder);
+        REQUIRE(notification > 0);
+
+        recorder.wait_for_audio();
+        int32_t key = laprdus_speak_async_with_priority(
+            engine, "a", LAPRDUS_PRIORITY_KEY, AsyncRecorder::sink, &recorder);
+        REQUIRE(key > 0);
+        REQUIRE(laprdus_flush(engine) == LAPRDUS_OK);
+
+        // The running text stops; queued text and progress are dropped unheard
+        REQUIRE(recorder.end_status(text) == LAPRDUS_ERROR_CANCELLED);
+        REQUIRE(recorder.count(LAPRDUS_EVENT_AUDIO, text) > 0);
+        REQUIRE(recorder.end_status(queued_text) == LAPRDUS_ERROR_CANCELLED);
+        REQUIRE(recorder.count(LAPRDUS_EVENT_BEGIN, queued_text) == 0);
+        REQUIRE(recorder.end_status(progress) == LAPRDUS_ERROR_CANCELLED);
+        REQUIRE(recorder.count(LAPRDUS_EVENT_BEGIN, progress) == 0);
+
+        // The key echo is spoken next; the notification waits, but is kept
+        REQUIRE(recorder.end_status(key) == LAPRDUS_OK);
+        REQUIRE(recorder.end_status(notification) == LAPRDUS_OK);
+        REQUIRE(recorder.index_of(LAPRDUS_EVENT_END, text) <
+                recorder.index_of(LAPRDUS_EVENT_BEGIN, key));
+        REQUIRE(recorder.index_of(LAPRDUS_EVENT_END, key) <
+                recorder.index_of(LAPRDUS_EVENT_BEGIN, notification));
+        for (const AsyncRecorder::Event& e : recorder.events) {
+            if (e.type == LAPRDUS_EVENT_END) {
+                REQUIRE(recorder.count(LAPRDUS_EVENT_END, e.utterance_id) == 1);
+            }
+        }
+
+        // Submitted, first audio and finished times are in order
+        const AsyncRecorder::Event& key_end = recorder.events[recorder.index_of(LAPRDUS_EVENT_END, key)];
+        REQUIRE(key_end.submitted_us > 0);
+        REQUIRE(key_end.first_audio_us >= key_end.submitted_us);
+        REQUIRE(key_end.finished_us >= key_end.first_audio_us);
+        const AsyncRecorder::Event& dropped_end =
+            recorder.events[recorder.index_of(LAPRDUS_EVENT_END, progress)];
+        REQUIRE(dropped_end.first_audio_us == 0);
+        REQUIRE(dropped_end.finished_us >= dropped_end.submitted_us);
+    }
+
+    SECTION("Text interrupts progress, equal and lower classes queue") {
+        AsyncRecorder recorder;
+        int32_t progress = laprdus_speak_async_with_priority(
+            engine, long_text.c_str(), LAPRDUS_PRIORITY_PROGRESS, AsyncRecorder::sink, &recorder);
+        recorder.wait_for_audio();
+        int32_t text = laprdus_speak_async_with_priority(
+            engine, long_text.c_str(), LAPRDUS_PRIORITY_TEXT, AsyncRecorder::sink, &recorder);
+        int32_t next_text = laprdus_speak_async_with_priority(
+            engine, "Dobar dan.", LAPRDUS_PRIORITY_TEXT, AsyncRecorder::sink, &recorder);
+        int32_t late_progress = laprdus_speak_async_with_priority(
+            engine, "Sto posto.", LAPRDUS_PRIORITY_PROGRESS, AsyncRecorder::sink, &recorder);
+        REQUIRE(laprdus_flush(engine) == LAPRDUS_OK);
+
+        REQUIRE(recorder.end_status(progress) == LAPRDUS_ERROR_CANCELLED);
+        REQUIRE(recorder.end_status(text) == LAPRDUS_OK);
+        REQUIRE(recorder.end_status(next_text) == LAPRDUS_OK);
+        REQUIRE(recorder.end_status(late_progress) == LAPRDUS_OK);
+        REQUIRE(recorder.index_of(LAPRDUS_EVENT_END, text) <
+                recorder.index_of(LAPRDUS_EVENT_BEGIN, next_text));
+        REQUIRE(recorder.index_of(LAPRDUS_EVENT_END, next_text) <
+                recorder.index_of(LAPRDUS_EVENT_BEGIN, late_progress));
+    }
+
+    SECTION("Interrupting leaves a synchronous call running") {
+        // The worker takes the text and waits for the engine held by the
+        // synchronous call; the key echo must not cancel that call
+        HeldSink held;
+        AsyncRecorder recorder;
+        int32_t text = 0;
+        int32_t key = 0;
+        std::thread poster([&] {
+            for (int i = 0; i < 2000 && !held.started.load(); ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            text = laprdus_speak_async_with_priority(
+                engine, "Dobar dan.", LAPRDUS_PRIORITY_TEXT, AsyncRecorder::sink, &recorder);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            key = laprdus_speak_async_with_priority(
+                engine, "a", LAPRDUS_PRIORITY_KEY, AsyncRecorder::sink, &recorder);
+            held.released = true;
+        });
+        int32_t written = laprdus_synthesize_to_sink(
+            engine, long_text.c_str(), hold_sink, &held, nullptr);
+        poster.join();
+
+        REQUIRE(written > 0);
+        REQUIRE(static_cast<size_t>(written) == held.samples);
+        REQUIRE(laprdus_flush(engine) == LAPRDUS_OK);
+        REQUIRE(recorder.end_status(text) == LAPRDUS_ERROR_CANCELLED);
+        REQUIRE(recorder.end_status(key) == LAPRDUS_OK);
+    }
+
+    REQUIRE(laprdus_speak_async_with_priority(engine, "a", static_cast<LaprdusPriority>(9),
+                                              AsyncRecorder::sink, nullptr) ==
+            LAPRDUS_ERROR_INVALID_PARAMETER);
+
+    laprdus_destroy(engine);
+}
+
+/* Records sink chunks and posts a parameter after the first one */
+struct LiveRecorder {
+    LaprdusHandle engine = nullptr;
+    LaprdusParam param = LAPRDUS_PARAM_SPEED;
+    float value = 1.0f;
+    std::vector<std::vector<int16_t>> chunks;
+};
+
+static int LAPRDUS_CALL record_live(const int16_t* samples, size_t num_samples, void* user_data) {
+    LiveRecorder* recorder = static_cast<LiveRecorder*>(user_data);
+    recorder->chunks.emplace_back(samples, samples + num_samples);
+    if (recorder->chunks.size() == 1) {
+        REQUIRE(laprdus_post_param(recorder->engine, recorder->param, recorder->value) ==
+                LAPRDUS_OK);
+    }
+    return 1;
+}
+
+TEST_CASE("C API changes parameters mid-utterance", "[api][live]") {
+    const char* text = "Dobar dan. Kako ste? Ja sam dobro, hvala!";
+
+    LaprdusHandle engine = laprdus_create();
+    REQUIRE(engine != nullptr);
+    REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+
+    std::vector<int16_t> normal = synthesize_samples(engine, text);
+    REQUIRE(!normal.empty());
+
+    SECTION("Volume changes at the next phrase") {
+        LiveRecorder recorder;
+        recorder.engine = engine;
+        recorder.param = LAPRDUS_PARAM_VOLUME;
+        recorder.value = 0.0f;
+        REQUIRE(laprdus_synthesize_to_sink(engine, text, record_live, &recorder, nullptr) ==
+                static_cast<int32_t>(normal.size()));
+        REQUIRE(recorder.chunks.size() > 1);
+
+        // The first phrase is unchanged, everything after it is silent
+        const std::vector<int16_t>& first = recorder.chunks[0];
+        REQUIRE(std::equal(first.begin(), first.end(), normal.begin()));
+        for (size_t i = 1; i < recorder.chunks.size(); ++i) {
+            for (int16_t sample : recorder.chunks[i]) {
+                REQUIRE(sample == 0);
+            }
+        }
+
+        LaprdusVoiceParams params;
+        REQUIRE(laprdus_get_voice_params(engine, &params) == LAPRDUS_OK);
+        REQUIRE(params.volume == 0.0f);
+        REQUIRE(laprdus_set_volume(engine, 1.0f) == LAPRDUS_OK);
+    }
+
+    SECTION("Speed changes at the next phrase") {
+        REQUIRE(laprdus_set_speed(engine, 2.0f) == LAPRDUS_OK);
+        std::vector<int16_t> fast = synthesize_samples(engine, text);
+        REQUIRE(laprdus_set_speed(engine, 1.0f) == LAPRDUS_OK);
+
+        LiveRecorder recorder;
+        recorder.engine = engine;
+        recorder.param = LAPRDUS_PARAM_SPEED;
+        recorder.value = 2.0f;
+        int32_t written = laprdus_synthesize_to_sink(engine, text, record_live, &recorder,
+                                                     nullptr);
+        REQUIRE(written < static_cast<int32_t>(normal.size()));
+        REQUIRE(written > static_cast<int32_t>(fast.size()));
+        REQUIRE(std::equal(recorder.chunks[0].begin(), recorder.chunks[0].end(),
+                           normal.begin()));
+
+        // The next utterance uses the posted value throughout
+        REQUIRE(synthesize_samples(engine, text) == fast);
+        REQUIRE(laprdus_set_speed(engine, 1.0f) == LAPRDUS_OK);
+    }
+
+    SECTION("Parallel rendering applies it to the next utterance") {
+        REQUIRE(laprdus_set_render_threads(engine, 3) == LAPRDUS_OK);
+        LiveRecorder recorder;
+        recorder.engine = engine;
+        recorder.param = LAPRDUS_PARAM_VOLUME;
+        recorder.value = 0.0f;
+        REQUIRE(laprdus_synthesize_to_sink(engine, text, record_live, &recorder, nullptr) ==
+                static_cast<int32_t>(normal.size()));
+
+        std::vector<int16_t> written;
+        for (const std::vector<int16_t>& chunk : recorder.chunks) {
+            written.insert(written.end(), chunk.begin(), chunk.end());
+        }
+        REQUIRE(written == normal);
+        REQUIRE(trailing_zeros(synthesize_samples(engine, text)) == normal.size());
+
+        REQUIRE(laprdus_set_render_threads(engine, 1) == LAPRDUS_OK);
+        REQUIRE(laprdus_set_volume(engine, 1.0f) == LAPRDUS_OK);
+    }
+
+    SECTION("A later setter replaces a posted value") {
+        // Posted while idle, so it waits for the next call
+        REQUIRE(laprdus_post_param(engine, LAPRDUS_PARAM_SPEED, 2.0f) == LAPRDUS_OK);
+        REQUIRE(laprdus_set_speed(engine, 1.0f) == LAPRDUS_OK);
+        REQUIRE(synthesize_samples(engine, text) == normal);
+
+        REQUIRE(laprdus_post_param(engine, LAPRDUS_PARAM_VOLUME, 0.0f) == LAPRDUS_OK);
+        REQUIRE(laprdus_set_speed(engine, 1.0f) == LAPRDUS_OK);
+        REQUIRE(synthesize_samples(engine, text) == normal);
+    }
+
+    SECTION("Posted values are checked") {
+        REQUIRE(laprdus_post_param(engine, static_cast<LaprdusParam>(7), 1.0f) ==
+                LAPRDUS_ERROR_INVALID_PARAMETER);
+        REQUIRE(laprdus_post_param(nullptr, LAPRDUS_PARAM_SPEED, 1.0f) ==
+                LAPRDUS_ERROR_INVALID_HANDLE);
+
+        // Out-of-range values are clamped like laprdus_set_speed()
+        REQUIRE(laprdus_post_param(engine, LAPRDUS_PARAM_SPEED, 100.0f) == LAPRDUS_OK);
+        synthesize_samples(engine, "Da.");
+        LaprdusVoiceParams params;
+        REQUIRE(laprdus_get_voice_params(engine, &params) == LAPRDUS_OK);
+        REQUIRE(params.speed == 4.0f);
+    }
+
+    laprdus_destroy(engine);
+}
+
 TEST_CASE("C API sets parameters", "[api]") {
     LaprdusHandle engine = laprdus_create();
     REQUIRE(engine != nullptr);
@@ -387,6 +2198,311 @@ TEST_CASE("C API sets parameters", "[api]") {
     laprdus_destroy(engine);
 }
 
+TEST_CASE("C API applies volume once at the output", "[api][volume]") {
+    const char* text = "Dobar dan. Kako ste? Hvala!";
+
+    LaprdusHandle engine = laprdus_create();
+    REQUIRE(engine != nullptr);
+    REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+    REQUIRE(laprdus_set_speed(engine, 1.3f) == LAPRDUS_OK);
+
+    SECTION("Volume scales the finished audio") {
+        std::vector<int16_t> full = synthesize_samples(engine, text);
+        REQUIRE(laprdus_set_volume(engine, 0.5f) == LAPRDUS_OK);
+        std::vector<int16_t> half = synthesize_samples(engine, text);
+
+        REQUIRE(!full.empty());
+        REQUIRE(half.size() == full.size());
+        for (size_t i = 0; i < full.size(); ++i) {
+            REQUIRE(half[i] == static_cast<int16_t>(std::round(full[i] * 0.5f)));
+        }
+    }
+
+    SECTION("User pitch output is quantized with the volume") {
+        REQUIRE(laprdus_set_user_pitch(engine, 1.2f) == LAPRDUS_OK);
+        REQUIRE(laprdus_set_volume(engine, 1.0f) == LAPRDUS_OK);
+        std::vector<int16_t> full = synthesize_samples(engine, text);
+        REQUIRE(laprdus_set_volume(engine, 0.5f) == LAPRDUS_OK);
+        std::vector<int16_t> half = synthesize_samples(engine, text);
+
+        REQUIRE(!full.empty());
+        REQUIRE(half.size() == full.size());
+        for (size_t i = 0; i < full.size(); ++i) {
+            // Both round the same float once; saturated samples lost their value
+            if (full[i] > -32768 && full[i] < 32767) {
+                REQUIRE(std::abs(half[i] - full[i] * 0.5f) <= 1.0f);
+            }
+        }
+    }
+
+    laprdus_destroy(engine);
+}
+
+TEST_CASE("C API converts to the output rate", "[api][rate]") {
+    const char* text = "Dobar dan. Kako ste? Ja sam dobro, hvala!";
+
+    LaprdusHandle engine = laprdus_create();
+    REQUIRE(engine != nullptr);
+    REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+
+    REQUIRE(laprdus_get_output_rate(engine) == 22050);
+    std::vector<int16_t> native = synthesize_samples(engine, text);
+    REQUIRE(!native.empty());
+
+    SECTION("Unsupported rates are rejected") {
+        REQUIRE(laprdus_set_output_rate(engine, 12345) == LAPRDUS_ERROR_INVALID_PARAMETER);
+        REQUIRE(laprdus_set_output_rate(engine, 96000) == LAPRDUS_ERROR_INVALID_PARAMETER);
+        REQUIRE(laprdus_get_output_rate(engine) == 22050);
+        REQUIRE(laprdus_set_output_rate(nullptr, 48000) == LAPRDUS_ERROR_INVALID_HANDLE);
+        REQUIRE(laprdus_get_output_rate(nullptr) == 0);
+    }
+
+    SECTION("Synthesis reports the rate and scales the length") {
+        REQUIRE(laprdus_set_output_rate(engine, 48000) == LAPRDUS_OK);
+
+        int16_t* samples = nullptr;
+        LaprdusAudioFormat format;
+        int32_t count = laprdus_synthesize(engine, text, &samples, &format);
+        REQUIRE(format.sample_rate == 48000);
+        REQUIRE(count == static_cast<int32_t>((native.size() * 48000 + 22049) / 22050));
+
+        // Sink and streaming output match, rendered serially or in parallel
+        for (uint32_t threads : {1u, 3u}) {
+            REQUIRE(laprdus_set_render_threads(engine, threads) == LAPRDUS_OK);
+            SinkRecorder recorder;
+            LaprdusAudioFormat sink_format;
+            REQUIRE(laprdus_synthesize_to_sink(engine, text, record_sink, &recorder,
+                                               &sink_format) == count);
+            REQUIRE(sink_format.sample_rate == 48000);
+            REQUIRE(recorder.samples.size() == static_cast<size_t>(count));
+            REQUIRE(std::memcmp(recorder.samples.data(), samples,
+                                count * sizeof(int16_t)) == 0);
+        }
+        REQUIRE(laprdus_set_render_threads(engine, 1) == LAPRDUS_OK);
+        laprdus_free_buffer(samples);
+
+        // Voice parameters do not include the rate, so setting them keeps it
+        LaprdusVoiceParams params = {1.0f, 1.0f, 1.0f};
+        REQUIRE(laprdus_set_voice_params(engine, &params) == LAPRDUS_OK);
+        REQUIRE(laprdus_get_output_rate(engine) == 48000);
+    }
+
+    SECTION("Batch and spelled output use the rate") {
+        REQUIRE(laprdus_set_output_rate(engine, 16000) == LAPRDUS_OK);
+        std::vector<int16_t> expected = synthesize_samples(engine, text);
+
+        const char* texts[] = {text, text};
+        BatchRecorder recorder;
+        recorder.audio.resize(2);
+        recorder.status.resize(2);
+        LaprdusAudioFormat format;
+        REQUIRE(laprdus_set_render_threads(engine, 2) == LAPRDUS_OK);
+        REQUIRE(laprdus_synthesize_batch(engine, texts, 2, record_batch, &recorder,
+                                         &format) == LAPRDUS_OK);
+        REQUIRE(laprdus_set_render_threads(engine, 1) == LAPRDUS_OK);
+        REQUIRE(format.sample_rate == 16000);
+        REQUIRE(recorder.audio[0] == expected);
+        REQUIRE(recorder.audio[1] == expected);
+
+        int16_t* spelled = nullptr;
+        REQUIRE(laprdus_synthesize_spelled(engine, "AB", &spelled, &format) > 0);
+        REQUIRE(format.sample_rate == 16000);
+        laprdus_free_buffer(spelled);
+    }
+
+    laprdus_destroy(engine);
+}
+
+/* Reference G.711 and IMA-ADPCM decoders for the encoded output */
+static int16_t decode_mulaw(uint8_t code) {
+    code = ~code;
+    int magnitude = (((code & 0x0F) << 3) + 0x84) << ((code & 0x70) >> 4);
+    return static_cast<int16_t>((code & 0x80) ? 0x84 - magnitude : magnitude - 0x84);
+}
+
+static int16_t decode_alaw(uint8_t code) {
+    code ^= 0x55;
+    int magnitude = (code & 0x0F) << 4;
+    int segment = (code & 0x70) >> 4;
+    magnitude += segment == 0 ? 8 : 0x108;
+    if (segment > 1) {
+        magnitude <<= segment - 1;
+    }
+    return static_cast<int16_t>((code & 0x80) ? magnitude : -magnitude);
+}
+
+static std::vector<int16_t> decode_ima_adpcm(const std::vector<uint8_t>& data) {
+    static const int steps[89] = {
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+        50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+        253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+        1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+        3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+        11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+        32767};
+    static const int index_step[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+    std::vector<int16_t> samples;
+    for (size_t block = 0; block + LAPRDUS_IMA_ADPCM_BLOCK_BYTES <= data.size();
+         block += LAPRDUS_IMA_ADPCM_BLOCK_BYTES) {
+        const uint8_t* b = data.data() + block;
+        int predictor = static_cast<int16_t>(b[0] | (b[1] << 8));
+        int index = b[2];
+        samples.push_back(static_cast<int16_t>(predictor));
+        for (size_t i = 4; i < LAPRDUS_IMA_ADPCM_BLOCK_BYTES; ++i) {
+            for (int code : {b[i] & 0x0F, b[i] >> 4}) {
+                int step = steps[index];
+                int delta = step >> 3;
+                if (code & 4) delta += step;
+                if (code & 2) delta += step >> 1;
+                if (code & 1) delta += step >> 2;
+                predictor += (code & 8) ? -delta : delta;
+                predictor = std::max(-32768, std::min(32767, predictor));
+                index = std::max(0, std::min(88, index + index_step[code & 7]));
+                samples.push_back(static_cast<int16_t>(predictor));
+            }
+        }
+    }
+    return samples;
+}
+
+/* Signal-to-noise ratio of decoded audio against the original, in dB */
+static double snr_db(const std::vector<int16_t>& original, const std::vector<int16_t>& decoded) {
+    double signal = 0.0;
+    double noise = 0.0;
+    for (size_t i = 0; i < original.size(); ++i) {
+        double error = static_cast<double>(decoded[i]) - original[i];
+        signal += static_cast<double>(original[i]) * original[i];
+        noise += error * error;
+    }
+    return 10.0 * std::log10(signal / std::max(noise, 1.0));
+}
+
+/* Appends encoded sink output; stops after max_calls writes when non-zero */
+struct ByteRecorder {
+    std::vector<uint8_t> bytes;
+    size_t calls = 0;
+    size_t max_calls = 0;
+};
+
+static int LAPRDUS_CALL record_bytes(const uint8_t* data, size_t size, void* user_data) {
+    ByteRecorder* recorder = static_cast<ByteRecorder*>(user_data);
+    recorder->bytes.insert(recorder->bytes.end(), data, data + size);
+    ++recorder->calls;
+    return recorder->max_calls == 0 || recorder->calls < recorder->max_calls;
+}
+
+TEST_CASE("C API encodes compact output", "[api][encoding]") {
+    const char* text = "Dobar dan. Kako ste? Ja sam dobro, hvala!";
+
+    LaprdusHandle engine = laprdus_create();
+    REQUIRE(engine != nullptr);
+    REQUIRE(laprdus_set_voice(engine, "josip", get_data_dir().c_str()) == LAPRDUS_OK);
+
+    std::vector<int16_t> pcm = synthesize_samples(engine, text);
+    REQUIRE(!pcm.empty());
+    const int32_t count = static_cast<int32_t>(pcm.size());
+
+    SECTION("PCM16 bytes equal the samples") {
+        uint8_t* data = nullptr;
+        size_t size = 0;
+        LaprdusAudioFormat format;
+        REQUIRE(laprdus_synthesize_encoded(engine, text, LAPRDUS_ENCODING_PCM16, &data, &size,
+                                           &format) == count);
+        REQUIRE(format.bits_per_sample == 16);
+        REQUIRE(size == pcm.size() * 2);
+        REQUIRE(std::memcmp(data, pcm.data(), size) == 0);
+        laprdus_free_encoded(data);
+    }
+
+    SECTION("G.711 decodes close to the samples") {
+        for (LaprdusEncoding encoding : {LAPRDUS_ENCODING_MULAW, LAPRDUS_ENCODING_ALAW}) {
+            uint8_t* data = nullptr;
+            size_t size = 0;
+            LaprdusAudioFormat format;
+            REQUIRE(laprdus_synthesize_encoded(engine, text, encoding, &data, &size,
+                                               &format) == count);
+            REQUIRE(format.bits_per_sample == 8);
+            REQUIRE(format.sample_rate == 22050);
+            REQUIRE(size == pcm.size());
+
+            std::vector<int16_t> decoded(size);
+            for (size_t i = 0; i < size; ++i) {
+                decoded[i] = encoding == LAPRDUS_ENCODING_MULAW ? decode_mulaw(data[i])
+                                                                : decode_alaw(data[i]);
+            }
+            REQUIRE(snr_db(pcm, decoded) > 30.0);
+            laprdus_free_encoded(data);
+        }
+    }
+
+    SECTION("IMA-ADPCM is written in whole blocks") {
+        uint8_t* data = nullptr;
+        size_t size = 0;
+        LaprdusAudioFormat format;
+        REQUIRE(laprdus_synthesize_encoded(engine, text, LAPRDUS_ENCODING_IMA_ADPCM, &data,
+                                           &size, &format) == count);
+        REQUIRE(format.bits_per_sample == 4);
+        size_t blocks = (pcm.size() + LAPRDUS_IMA_ADPCM_BLOCK_SAMPLES - 1) /
+                        LAPRDUS_IMA_ADPCM_BLOCK_SAMPLES;
+        REQUIRE(size == blocks * LAPRDUS_IMA_ADPCM_BLOCK_BYTES);
+
+        std::vector<int16_t> decoded = decode_ima_adpcm(std::vector<uint8_t>(data, data + size));
+        REQUIRE(decoded.size() == blocks * LAPRDUS_IMA_ADPCM_BLOCK_SAMPLES);
+        for (size_t i = 0; i < pcm.size(); i += LAPRDUS_IMA_ADPCM_BLOCK_SAMPLES) {
+            REQUIRE(decoded[i] == pcm[i]);  // Block headers hold the sample exactly
+        }
+        decoded.resize(pcm.size());
+        REQUIRE(snr_db(pcm, decoded) > 20.0);
+        laprdus_free_encoded(data);
+    }
+
+    SECTION("Sink output matches the whole buffer") {
+        for (LaprdusEncoding encoding : {LAPRDUS_ENCODING_MULAW, LAPRDUS_ENCODING_IMA_ADPCM}) {
+            uint8_t* data = nullptr;
+            size_t size = 0;
+            REQUIRE(laprdus_synthesize_encoded(engine, text, encoding, &data, &size,
+                                               nullptr) == count);
+
+            for (uint32_t threads : {1u, 3u}) {
+                REQUIRE(laprdus_set_render_threads(engine, threads) == LAPRDUS_OK);
+                ByteRecorder recorder;
+                REQUIRE(laprdus_synthesize_encoded_to_sink(engine, text, encoding, record_bytes,
+                                                           &recorder, nullptr) == count);
+                REQUIRE(recorder.bytes.size() == size);
+                REQUIRE(std::memcmp(recorder.bytes.data(), data, size) == 0);
+                if (encoding == LAPRDUS_ENCODING_MULAW) {
+                    REQUIRE(recorder.calls > 1);  // Encoded segment by segment
+                }
+            }
+            REQUIRE(laprdus_set_render_threads(engine, 1) == LAPRDUS_OK);
+            laprdus_free_encoded(data);
+        }
+    }
+
+    SECTION("Returning zero stops synthesis") {
+        ByteRecorder recorder;
+        recorder.max_calls = 1;
+        REQUIRE(laprdus_synthesize_encoded_to_sink(engine, text, LAPRDUS_ENCODING_ALAW,
+                                                   record_bytes, &recorder, nullptr) ==
+                LAPRDUS_ERROR_CANCELLED);
+        REQUIRE(recorder.calls == 1);
+    }
+
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    REQUIRE(laprdus_synthesize_encoded(engine, text, static_cast<LaprdusEncoding>(9), &data,
+                                       &size, nullptr) == LAPRDUS_ERROR_INVALID_PARAMETER);
+    REQUIRE(laprdus_synthesize_encoded_to_sink(engine, text, LAPRDUS_ENCODING_MULAW, nullptr,
+                                               nullptr, nullptr) ==
+            LAPRDUS_ERROR_INVALID_PARAMETER);
+    REQUIRE(laprdus_synthesize_encoded_to_sink(nullptr, text, LAPRDUS_ENCODING_MULAW,
+                                               record_bytes, nullptr, nullptr) ==
+            LAPRDUS_ERROR_INVALID_HANDLE);
+
+    laprdus_destroy(engine);
+}
+
 TEST_CASE("C API handles errors gracefully", "[api][error]") {
     SECTION("NULL handle") {
         REQUIRE(laprdus_set_speed(nullptr, 1.0f) == LAPRDUS_ERROR_INVALID_HANDLE);
@@ -0,0 +1,303 @@
+/*
+ * test_inflection.cpp - Tests for the streaming pitch contour
+ *
+ * Streams synthetic tones through sonic::PitchEnvelopeProcessor and
+ * InflectionProcessor and checks that the output keeps the input length,
+ * that untouched leading samples pass through unchanged, that the audio
+ * stays continuous while the pitch changes every block (no resampler
+ * phase jumps), and that the contour is applied over the whole buffer
+ * without timing drift. A synthetic vowel checks that the inflection
+ * contour raises the pitch without moving the formant.
+ *
+ * Build: scons --platform=linux test-inflection
+ * Run:   ./build/linux-x64-release/test_inflection
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include "audio/formant_pitch.hpp"
+#include "audio/sonic_processor.hpp"
+#include "core/inflection.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+using laprdus::AudioBuffer;
+using laprdus::AudioSample;
+using laprdus::InflectionProcessor;
+using laprdus::InflectionType;
+using laprdus::formant::PitchShifter;
+using laprdus::sonic::PitchEnvelopeProcessor;
+
+namespace {
+
+constexpr uint32_t SAMPLE_RATE = 22050;
+constexpr double TONE_HZ = 180.0;
+constexpr double AMPLITUDE = 8000.0;
+constexpr double PI = 3.14159265358979323846;
+
+AudioBuffer make_tone(size_t num_samples) {
+    AudioBuffer buffer;
+    buffer.sample_rate = SAMPLE_RATE;
+    buffer.channels = 1;
+    buffer.bits_per_sample = 16;
+    buffer.samples.resize(num_samples);
+    for (size_t i = 0; i < num_samples; ++i) {
+        double t = static_cast<double>(i) / SAMPLE_RATE;
+        buffer.samples[i] = static_cast<AudioSample>(
+            std::lround(AMPLITUDE * std::sin(2.0 * PI * TONE_HZ * t)));
+    }
+    return buffer;
+}
+
+// Harmonics of f0 under a single formant peak at FORMANT_HZ
+constexpr double FORMANT_HZ = 1200.0;
+
+AudioBuffer make_vowel(size_t num_samples, double f0) {
+    AudioBuffer buffer = make_tone(num_samples);
+    for (size_t i = 0; i < num_samples; ++i) {
+        double t = static_cast<double>(i) / SAMPLE_RATE;
+        double sum = 0.0;
+        for (double f = f0; f < 5000.0; f += f0) {
+            double distance = (f - FORMANT_HZ) / 300.0;
+            sum += (std::exp(-distance * distance) + 0.05) * std::sin(2.0 * PI * f * t);
+        }
+        buffer.samples[i] = static_cast<AudioSample>(std::lround(3000.0 * sum));
+    }
+    return buffer;
+}
+
+// Power-weighted mean frequency of a Hann-windowed block, below 4 kHz
+double spectral_centroid(const std::vector<AudioSample>& samples, size_t from, size_t count) {
+    double weighted = 0.0;
+    double total = 0.0;
+    for (double f = 50.0; f < 4000.0; f += 10.0) {
+        double re = 0.0;
+        double im = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            double w = 0.5 - 0.5 * std::cos(2.0 * PI * i / count);
+            double phase = 2.0 * PI * f * i / SAMPLE_RATE;
+            re += w * samples[from + i] * std::cos(phase);
+            im += w * samples[from + i] * std::sin(phase);
+        }
+        double power = re * re + im * im;
+        weighted += f * power;
+        total += power;
+    }
+    return weighted / total;
+}
+
+// Flat at 1.0 until `start`, then a linear ramp to `end_pitch`
+std::vector<float> make_ramp(size_t num_samples, size_t start, float end_pitch) {
+    std::vector<float> envelope(num_samples, 1.0f);
+    for (size_t i = start; i < num_samples; ++i) {
+        float t = static_cast<float>(i - start) / static_cast<float>(num_samples - start);
+        envelope[i] = 1.0f + (end_pitch - 1.0f) * t;
+    }
+    return envelope;
+}
+
+// Largest second difference, which a click shows up in
+int max_second_difference(const std::vector<AudioSample>& samples, size_t from, size_t to) {
+    int largest = 0;
+    for (size_t i = std::max<size_t>(from, 2); i < to; ++i) {
+        int d = samples[i] - 2 * samples[i - 1] + samples[i - 2];
+        largest = std::max(largest, std::abs(d));
+    }
+    return largest;
+}
+
+size_t count_rising_zero_crossings(const std::vector<AudioSample>& samples, size_t from, size_t to) {
+    size_t count = 0;
+    for (size_t i = std::max<size_t>(from, 1); i < to; ++i) {
+        if (samples[i - 1] < 0 && samples[i] >= 0) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+} // anonymous namespace
+
+// =============================================================================
+// Pitch Envelope
+// =============================================================================
+
+TEST_CASE("Pitch envelope keeps the input length", "[envelope]") {
+    PitchEnvelopeProcessor processor;
+    const size_t lengths[] = {1, 127, 128, 129, 1000, 4410, SAMPLE_RATE};
+
+    for (size_t length : lengths) {
+        CAPTURE(length);
+        AudioBuffer input = make_tone(length);
+        AudioBuffer output;
+
+        processor.process(input, std::vector<float>(length, 1.25f), output);
+        REQUIRE(output.samples.size() == length);
+
+        processor.process(input, std::vector<float>(length, 0.8f), output);
+        REQUIRE(output.samples.size() == length);
+
+        processor.process(input, make_ramp(length, length / 3, 1.3f), output);
+        REQUIRE(output.samples.size() == length);
+        REQUIRE(output.sample_rate == SAMPLE_RATE);
+    }
+}
+
+TEST_CASE("Pitch envelope passes flat audio through", "[envelope]") {
+    PitchEnvelopeProcessor processor;
+    AudioBuffer input = make_tone(SAMPLE_RATE / 2);
+    AudioBuffer output;
+
+    processor.process(input, std::vector<float>(input.samples.size(), 1.0f), output);
+    REQUIRE(output.samples == input.samples);
+
+    // Leading samples before the contour starts (rounded down to a block)
+    // are copied unchanged
+    const size_t start = 4410;
+    processor.process(input, make_ramp(input.samples.size(), start, 1.3f), output);
+    const size_t bypassed = start - start % 128;
+    REQUIRE(std::equal(input.samples.begin(), input.samples.begin() + bypassed,
+                       output.samples.begin()));
+}
+
+TEST_CASE("Pitch envelope output is continuous", "[envelope]") {
+    PitchEnvelopeProcessor processor;
+    const size_t length = SAMPLE_RATE;
+    AudioBuffer input = make_tone(length);
+    AudioBuffer output;
+
+    // The pitch changes every block; with the resampler phase reset on each
+    // change this produced jumps of several hundred
+    processor.process(input, make_ramp(length, length / 5, 1.3f), output);
+    REQUIRE(output.samples.size() == length);
+
+    // A sine's second difference is at most A * w^2 (about 36 here at 1.3x)
+    const int input_curvature = max_second_difference(input.samples, 0, length);
+    const int output_curvature = max_second_difference(output.samples, 0, length - 512);
+    CAPTURE(output_curvature);
+    REQUIRE(input_curvature < 30);
+    REQUIRE(output_curvature < 80);
+
+    // Falling contour
+    processor.process(input, make_ramp(length, length / 5, 0.8f), output);
+    REQUIRE(max_second_difference(output.samples, 0, length - 512) < 80);
+
+    // A contour that returns to exactly 1.0 keeps the resampler running
+    // instead of dropping the samples it holds
+    std::vector<float> envelope = make_ramp(length, length / 5, 1.3f);
+    std::fill(envelope.begin() + length / 2, envelope.end(), 1.0f);
+    processor.process(input, envelope, output);
+    REQUIRE(max_second_difference(output.samples, 0, length - 512) < 80);
+}
+
+TEST_CASE("Pitch envelope follows the contour without drift", "[envelope]") {
+    PitchEnvelopeProcessor processor;
+    const size_t length = SAMPLE_RATE;
+    AudioBuffer input = make_tone(length);
+    std::vector<float> envelope = make_ramp(length, length / 5, 1.3f);
+    AudioBuffer output;
+    processor.process(input, envelope, output);
+
+    // Periods heard up to a point follow the integral of the contour
+    const size_t checkpoints[] = {length / 2, length * 3 / 4, length - 512};
+    for (size_t end : checkpoints) {
+        double expected = 0.0;
+        for (size_t i = 0; i < end; ++i) {
+            expected += TONE_HZ * envelope[i] / SAMPLE_RATE;
+        }
+        double counted = static_cast<double>(count_rising_zero_crossings(output.samples, 0, end));
+        CAPTURE(end);
+        REQUIRE(std::abs(counted - expected) <= 2.0);
+    }
+}
+
+TEST_CASE("Pitch envelope gives the same output on reuse", "[envelope]") {
+    PitchEnvelopeProcessor processor;
+    AudioBuffer input = make_tone(SAMPLE_RATE / 2);
+    std::vector<float> envelope = make_ramp(input.samples.size(), 0, 1.2f);
+
+    AudioBuffer first;
+    AudioBuffer second;
+    processor.process(input, envelope, first);
+    processor.process(make_tone(1000), std::vector<float>(1000, 0.7f), second);
+    processor.process(input, envelope, second);
+    REQUIRE(first.samples == second.samples);
+}
+
+// =============================================================================
+// Inflection
+// =============================================================================
+
+TEST_CASE("Inflection keeps the segment length", "[inflection]") {
+    InflectionProcessor inflection;
+    const InflectionType types[] = {
+        InflectionType::NEUTRAL, InflectionType::COMMA_CONTINUATION,
+        InflectionType::PERIOD_FINALITY, InflectionType::QUESTION_RISING,
+        InflectionType::EXCLAMATION_EMPHATIC,
+    };
+    const size_t lengths[] = {64, 2000, 11025};
+
+    for (InflectionType type : types) {
+        for (size_t length : lengths) {
+            CAPTURE(length);
+            AudioBuffer input = make_tone(length);
+            AudioBuffer output;
+            inflection.apply_contour(input, type, output);
+            REQUIRE(output.samples.size() == length);
+
+            AudioBuffer emphasized = inflection.apply_inflection(input, type, 5);
+            REQUIRE(emphasized.samples.size() == length);
+        }
+    }
+}
+
+TEST_CASE("Inflection contour is continuous", "[inflection]") {
+    InflectionProcessor inflection;
+    const size_t length = SAMPLE_RATE / 2;
+    AudioBuffer input = make_tone(length);
+    AudioBuffer output;
+
+    inflection.apply_contour(input, InflectionType::QUESTION_RISING, output);
+    REQUIRE(output.samples.size() == length);
+    REQUIRE(max_second_difference(output.samples, 0, length - 512) < 80);
+
+    inflection.apply_contour(input, InflectionType::PERIOD_FINALITY, output);
+    REQUIRE(max_second_difference(output.samples, 0, length - 512) < 80);
+}
+
+TEST_CASE("Inflection contour keeps the formants", "[inflection]") {
+    PitchShifter shifter;
+    const size_t length = SAMPLE_RATE;
+    std::vector<float> envelope = make_ramp(length, length / 2, 1.3f);
+    AudioBuffer output;
+
+    // The pitch follows the contour
+    AudioBuffer tone = make_tone(length);
+    shifter.process(tone, envelope, output);
+    REQUIRE(output.samples.size() == length);
+    REQUIRE(std::equal(tone.samples.begin(), tone.samples.begin() + length / 4,
+                       output.samples.begin()));
+    double expected = 0.0;
+    for (size_t i = length * 3 / 4; i < length - 512; ++i) {
+        expected += TONE_HZ * envelope[i] / SAMPLE_RATE;
+    }
+    double counted = static_cast<double>(
+        count_rising_zero_crossings(output.samples, length * 3 / 4, length - 512));
+    REQUIRE(std::abs(counted - expected) <= 2.0);
+
+    // The spectral envelope does not move with it (Sonic alone moves the
+    // centroid up with the pitch, by about 25% here)
+    AudioBuffer vowel = make_vowel(length, 150.0);
+    shifter.process(vowel, envelope, output);
+    const size_t block = 2048;
+    const size_t from = length - block - 512;
+    double before = spectral_centroid(vowel.samples, from, block);
+    double after = spectral_centroid(output.samples, from, block);
+    CAPTURE(after);
+    REQUIRE(std::abs(after / before - 1.0) < 0.05);
+}
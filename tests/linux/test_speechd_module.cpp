@@ -6,7 +6,8 @@
  *
  * Requirements:
  * - speech-dispatcher installed and running
- * - laprdus module installed
+ * - laprdus module installed (or LAPRDUS_SPEECHD_MODULE set to the module
+ *   binary, for the protocol tests)
  *
  * Build: g++ -std=c++17 -I../../include test_speechd_module.cpp -o test_speechd_module -llaprdus -lpthread
  * Run: ./test_speechd_module
@@ -18,11 +19,16 @@
 #include <algorithm>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <string>
 #include <array>
+#include <vector>
 #include <thread>
 #include <chrono>
 
+#include <sys/wait.h>
+#include <unistd.h>
+
 /* LaprdusTTS C API for parameter mapping verification */
 #include <laprdus/laprdus_api.h>
 
@@ -276,6 +282,259 @@ TEST_CASE("Speech Dispatcher language selection", "[speechd][integration]") {
     }
 }
 
+// =============================================================================
+// Module Protocol Tests (run the module binary directly, no speechd required)
+// =============================================================================
+
+/* Path of the module binary: LAPRDUS_SPEECHD_MODULE or an installed copy */
+static std::string find_module_binary() {
+    const char* env = std::getenv("LAPRDUS_SPEECHD_MODULE");
+    if (env && *env) {
+        return env;
+    }
+    for (const char* path : {"/usr/lib/speech-dispatcher-modules/sd_laprdus",
+                             "/usr/lib/x86_64-linux-gnu/speech-dispatcher-modules/sd_laprdus",
+                             "/usr/lib64/speech-dispatcher-modules/sd_laprdus",
+                             "/usr/libexec/speech-dispatcher-modules/sd_laprdus"}) {
+        if (access(path, X_OK) == 0) {
+            return path;
+        }
+    }
+    return "";
+}
+
+/* Result of one SPEAK: the final event, index marks and audio */
+struct ModuleSpeech {
+    std::string event;              // "702 END", "703 STOP" or "704 PAUSE"
+    std::vector<std::string> marks;
+    std::vector<int16_t> audio;
+    double begin_ms = 0.0;          // From sending the message to "701 BEGIN"
+};
+
+/* Runs the module and talks to it the way Speech Dispatcher does */
+class ModuleProcess {
+public:
+    explicit ModuleProcess(const std::string& path) {
+        int to_module[2];
+        int from_module[2];
+        if (pipe(to_module) != 0 || pipe(from_module) != 0) {
+            return;
+        }
+        m_pid = fork();
+        if (m_pid == 0) {
+            dup2(to_module[0], STDIN_FILENO);
+            dup2(from_module[1], STDOUT_FILENO);
+            close(to_module[1]);
+            close(from_module[0]);
+            execl(path.c_str(), path.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        close(to_module[0]);
+        close(from_module[1]);
+        m_in = fdopen(to_module[1], "w");
+        m_out = fdopen(from_module[0], "r");
+    }
+
+    ~ModuleProcess() {
+        if (m_in) {
+            send("QUIT\n");
+            fclose(m_in);
+        }
+        if (m_out) {
+            fclose(m_out);
+        }
+        if (m_pid > 0) {
+            waitpid(m_pid, nullptr, 0);
+        }
+    }
+
+    bool init() {
+        send("INIT\n");
+        return wait_for("299 OK LOADED SUCCESSFULLY") && !m_failed;
+    }
+
+    void set(const std::string& name, const std::string& value) {
+        send("SET\n" + name + "=" + value + "\n.\n");
+        wait_for("203 OK SETTINGS RECEIVED");
+    }
+
+    /* Speak a message; with pause, PAUSE follows it at once, or once
+     * pause_after samples of audio have arrived */
+    ModuleSpeech speak(const std::string& text, bool pause = false, size_t pause_after = 0) {
+        ModuleSpeech speech;
+        send("SPEAK\n");
+        wait_for("202 OK RECEIVING MESSAGE");
+        auto sent = std::chrono::steady_clock::now();
+        send(text + "\n.\n" + (pause && pause_after == 0 ? "PAUSE\n" : ""));
+
+        std::string line;
+        while (read_line(line)) {
+            if (line == "701 BEGIN") {
+                speech.begin_ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - sent).count();
+            } else if (line.compare(0, 4, "700-") == 0) {
+                speech.marks.push_back(line.substr(4));
+            } else if (line.compare(0, 10, std::string("705-AUDIO\0", 10)) == 0) {
+                append_audio(line.substr(10), speech.audio);
+                if (pause && pause_after > 0 && speech.audio.size() >= pause_after) {
+                    send("PAUSE\n");
+                    pause = false;
+                }
+            } else if (line == "702 END" || line == "703 STOP" || line == "704 PAUSE") {
+                speech.event = line;
+                break;
+            }
+        }
+        return speech;
+    }
+
+private:
+    void send(const std::string& text) {
+        fputs(text.c_str(), m_in);
+        fflush(m_in);
+    }
+
+    bool read_line(std::string& line) {
+        line.clear();
+        int c;
+        while ((c = fgetc(m_out)) != EOF && c != '\n') {
+            line.push_back(static_cast<char>(c));
+        }
+        m_failed = m_failed || c == EOF;
+        return c != EOF;
+    }
+
+    bool wait_for(const std::string& reply) {
+        std::string line;
+        while (read_line(line)) {
+            if (line == reply) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /* Undo the HDLC-style escaping of audio lines */
+    static void append_audio(const std::string& data, std::vector<int16_t>& audio) {
+        std::string bytes;
+        for (size_t i = 0; i < data.size(); ++i) {
+            bytes.push_back(data[i] == 0x7d && i + 1 < data.size() ? data[++i] ^ 0x20 : data[i]);
+        }
+        size_t start = audio.size();
+        audio.resize(start + bytes.size() / sizeof(int16_t));
+        std::memcpy(audio.data() + start, bytes.data(), (audio.size() - start) * sizeof(int16_t));
+    }
+
+    pid_t m_pid = -1;
+    FILE* m_in = nullptr;
+    FILE* m_out = nullptr;
+    bool m_failed = false;
+};
+
+TEST_CASE("Module resumes a paused message without synthesizing it again",
+          "[speechd][pause]") {
+    std::string path = find_module_binary();
+    if (path.empty()) {
+        SKIP("Laprdus module binary not found (set LAPRDUS_SPEECHD_MODULE)");
+    }
+
+    ModuleProcess module(path);
+    REQUIRE(module.init());
+
+    // The part after m1 is long enough that synthesizing it takes clearly
+    // longer than resuming
+    std::string rest = " Druga rečenica.<mark name=\"m2\"/>";
+    for (int i = 0; i < 6; ++i) {
+        rest += " Ovo je treća rečenica, koja je namjerno prilično duga.";
+    }
+    const std::string message = "<speak>Prva rečenica.<mark name=\"m1\"/>" + rest + "</speak>";
+    const std::string resent = "<speak>" + rest + "</speak>";
+
+    ModuleSpeech full = module.speak(message);
+    REQUIRE(full.event == "702 END");
+    REQUIRE(full.marks == std::vector<std::string>({"m1", "m2"}));
+    REQUIRE(!full.audio.empty());
+
+    SECTION("Pause keeps the audio and resume continues after the mark") {
+        ModuleSpeech paused = module.speak(message, true);
+        REQUIRE(paused.event == "704 PAUSE");
+        REQUIRE(paused.audio.empty());
+
+        // Speech Dispatcher resends the text after the last mark it heard
+        ModuleSpeech resumed = module.speak(resent);
+        REQUIRE(resumed.event == "702 END");
+        REQUIRE(resumed.marks == std::vector<std::string>({"m2"}));
+        REQUIRE(!resumed.audio.empty());
+        REQUIRE(resumed.audio.size() < full.audio.size());
+        REQUIRE(std::equal(resumed.audio.begin(), resumed.audio.end(),
+                           full.audio.end() - resumed.audio.size()));
+
+        // Nothing is synthesized, so the audio starts much sooner
+        CAPTURE(full.begin_ms);
+        CAPTURE(resumed.begin_ms);
+        REQUIRE(resumed.begin_ms < full.begin_ms / 2);
+    }
+
+    SECTION("Resuming the whole message starts from the beginning") {
+        REQUIRE(module.speak(message, true).event == "704 PAUSE");
+        ModuleSpeech resumed = module.speak(message);
+        REQUIRE(resumed.event == "702 END");
+        REQUIRE(resumed.audio == full.audio);
+        REQUIRE(resumed.begin_ms < full.begin_ms / 2);
+    }
+
+    SECTION("Changed settings discard the paused audio") {
+        REQUIRE(module.speak(message, true).event == "704 PAUSE");
+        module.set("rate", "50");
+        ModuleSpeech faster = module.speak(resent);
+        REQUIRE(faster.event == "702 END");
+        module.set("rate", "0");
+
+        // Synthesized at the new rate, so shorter than the retained audio
+        ModuleSpeech fresh = module.speak(resent);
+        REQUIRE(fresh.event == "702 END");
+        REQUIRE(faster.audio.size() < fresh.audio.size());
+    }
+}
+
+TEST_CASE("Module pauses a message without marks inside it", "[speechd][pause]") {
+    std::string path = find_module_binary();
+    if (path.empty()) {
+        SKIP("Laprdus module binary not found (set LAPRDUS_SPEECHD_MODULE)");
+    }
+
+    ModuleProcess module(path);
+    REQUIRE(module.init());
+
+    // Several seconds of speech: more than the pipe holds, so the pause
+    // arrives while the message is still being sent
+    std::string message = "<speak>";
+    for (int i = 0; i < 8; ++i) {
+        message += " Ovo je rečenica bez oznaka, koja je namjerno prilično duga.";
+    }
+    message += "</speak>";
+
+    ModuleSpeech full = module.speak(message);
+    REQUIRE(full.event == "702 END");
+    REQUIRE(full.marks.empty());
+
+    // Pause once a second of audio has arrived
+    ModuleSpeech paused = module.speak(message, true, 22050);
+    REQUIRE(paused.event == "704 PAUSE");
+    REQUIRE(paused.audio.size() >= 22050);
+    REQUIRE(paused.audio.size() < full.audio.size());
+    REQUIRE(std::equal(paused.audio.begin(), paused.audio.end(), full.audio.begin()));
+
+    // Without marks Speech Dispatcher resends the whole message; the audio
+    // continues at the chunk the pause cut short, so nothing is lost
+    ModuleSpeech resumed = module.speak(message);
+    REQUIRE(resumed.event == "702 END");
+    REQUIRE(resumed.audio.size() < full.audio.size());
+    REQUIRE(paused.audio.size() + resumed.audio.size() >= full.audio.size());
+    REQUIRE(std::equal(resumed.audio.begin(), resumed.audio.end(),
+                       full.audio.end() - resumed.audio.size()));
+}
+
 // =============================================================================
 // Voice Definition Tests (Unit tests using C API)
 // =============================================================================
@@ -1,6 +1,7 @@
 // -*- coding: utf-8 -*-
 // packer.cpp - Phoneme WAV to BIN packer tool
-// Combines WAV files into a single packed binary with optional encryption
+// Combines WAV files into a single packed binary with optional compression
+// and encryption
 
 #define _CRT_SECURE_NO_WARNINGS  // Suppress sscanf warning
 
@@ -14,6 +15,9 @@
 #include <iomanip>
 #include <random>
 #include <chrono>
+#include <iterator>
+
+#include "audio/phoneme_codec.hpp"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -33,6 +37,7 @@ constexpr uint32_t PHONEME_FILE_MAGIC = 0x4C505244;  // "LPRD"
 constexpr uint16_t PHONEME_FILE_VERSION = 1;
 
 constexpr uint16_t PACKED_FLAG_ENCRYPTED = 0x0001;
+constexpr uint16_t PACKED_FLAG_COMPRESSED = 0x0002;
 constexpr uint16_t PHONEME_FLAG_TRUNCATED = 0x0004;
 
 #pragma pack(push, 1)
@@ -140,6 +145,15 @@ std::vector<PhonemeInfo> get_phoneme_list() {
     };
 }
 
+// Audio of one phoneme, ready to be packed
+struct PhonemeAudio {
+    uint32_t id;
+    std::string name;
+    uint32_t name_hash;
+    uint16_t flags;
+    std::vector<uint8_t> samples;  // 16-bit little-endian PCM
+};
+
 // =============================================================================
 // Utility Functions
 // =============================================================================
@@ -278,24 +292,14 @@ bool parse_hex_key(const std::string& hex, uint8_t* key, size_t key_len) {
 }
 
 // =============================================================================
-// Main Packer Function
+// Phoneme Sources
 // =============================================================================
 
-int pack_phonemes(const std::string& input_dir,
-                  const std::string& output_file,
-                  bool encrypt,
-                  const std::string& key_hex) {
-
+bool read_wav_phonemes(const std::string& input_dir, std::vector<PhonemeAudio>& phonemes) {
     std::vector<PhonemeInfo> phoneme_list = get_phoneme_list();
-    std::vector<PhonemeIndexEntry> index;
-    std::vector<uint8_t> audio_data;
-
     uint32_t expected_sample_rate = 22050;
-    uint16_t expected_bits = 16;
-    uint16_t expected_channels = 1;
 
     std::cout << "Packing phonemes from: " << input_dir << std::endl;
-    std::cout << "Output file: " << output_file << std::endl;
 
     // Process each phoneme
     for (const auto& phoneme : phoneme_list) {
@@ -320,32 +324,145 @@ int pack_phonemes(const std::string& input_dir,
             samples.resize(phoneme.max_bytes);
         }
 
+        PhonemeAudio audio;
+        audio.id = phoneme.id;
+        audio.name = phoneme.name;
+        audio.name_hash = fnv1a_hash(phoneme.name);
+        audio.flags = phoneme.truncate ? PHONEME_FLAG_TRUNCATED : 0;
+        audio.samples = std::move(samples);
+        phonemes.push_back(std::move(audio));
+    }
+
+    return true;
+}
+
+// Re-read the phonemes of an existing unencrypted pack, so shipped voices
+// can be compressed (or expanded again) without their source WAV files
+bool read_packed_phonemes(const std::string& input_pack, std::vector<PhonemeAudio>& phonemes) {
+    std::ifstream file(input_pack, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error: Cannot open " << input_pack << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)),
+                              std::istreambuf_iterator<char>());
+
+    PackedFileHeader header;
+    if (data.size() < sizeof(header)) {
+        std::cerr << "Error: " << input_pack << " is too small" << std::endl;
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    if (header.magic != PHONEME_FILE_MAGIC || header.version != PHONEME_FILE_VERSION ||
+        header.data_offset > data.size() || header.index_offset > data.size() ||
+        header.phoneme_count > (data.size() - header.index_offset) / sizeof(PhonemeIndexEntry)) {
+        std::cerr << "Error: Invalid pack header in " << input_pack << std::endl;
+        return false;
+    }
+    if (header.flags & PACKED_FLAG_ENCRYPTED) {
+        std::cerr << "Error: " << input_pack << " is encrypted" << std::endl;
+        return false;
+    }
+
+    std::cout << "Repacking phonemes from: " << input_pack << std::endl;
+
+    bool compressed = (header.flags & PACKED_FLAG_COMPRESSED) != 0;
+    size_t audio_size = data.size() - header.data_offset;
+    const uint8_t* audio = data.data() + header.data_offset;
+
+    for (uint32_t i = 0; i < header.phoneme_count; ++i) {
+        PhonemeIndexEntry entry;
+        std::memcpy(&entry, data.data() + header.index_offset + i * sizeof(entry), sizeof(entry));
+
+        uint32_t stored_size = compressed ? entry.compressed_size : entry.original_size;
+        if (static_cast<uint64_t>(entry.data_offset) + stored_size > audio_size) {
+            std::cerr << "Error: Phoneme " << entry.phoneme_id << " lies outside the pack" << std::endl;
+            return false;
+        }
+
+        PhonemeAudio phoneme;
+        phoneme.id = entry.phoneme_id;
+        phoneme.name = "#" + std::to_string(entry.phoneme_id);
+        phoneme.name_hash = entry.name_hash;
+        phoneme.flags = entry.flags;
+        phoneme.samples.resize(entry.original_size);
+
+        const uint8_t* stored = audio + entry.data_offset;
+        if (!compressed) {
+            std::memcpy(phoneme.samples.data(), stored, entry.original_size);
+        } else {
+            std::vector<laprdus::AudioSample> samples(entry.original_size / sizeof(laprdus::AudioSample));
+            if (!laprdus::decompress_phoneme(stored, stored_size, samples.data(), samples.size())) {
+                std::cerr << "Error: Phoneme " << entry.phoneme_id << " is corrupt" << std::endl;
+                return false;
+            }
+            std::memcpy(phoneme.samples.data(), samples.data(), samples.size() * sizeof(samples[0]));
+        }
+        phonemes.push_back(std::move(phoneme));
+    }
+
+    return true;
+}
+
+// =============================================================================
+// Main Packer Function
+// =============================================================================
+
+int pack_phonemes(std::vector<PhonemeAudio>& phonemes,
+                  const std::string& output_file,
+                  bool compress,
+                  bool encrypt,
+                  const std::string& key_hex) {
+
+    std::vector<PhonemeIndexEntry> index;
+    std::vector<uint8_t> audio_data;
+    size_t original_total = 0;
+
+    uint32_t expected_sample_rate = 22050;
+    uint16_t expected_bits = 16;
+    uint16_t expected_channels = 1;
+
+    std::cout << "Output file: " << output_file << std::endl;
+
+    for (auto& phoneme : phonemes) {
+        std::vector<uint8_t> stored;
+        if (compress) {
+            // Lossless: linear prediction + Rice coding (see phoneme_codec.hpp)
+            std::vector<laprdus::AudioSample> samples(phoneme.samples.size() / sizeof(laprdus::AudioSample));
+            std::memcpy(samples.data(), phoneme.samples.data(), samples.size() * sizeof(samples[0]));
+            stored = laprdus::compress_phoneme(samples.data(), samples.size());
+        } else {
+            stored = phoneme.samples;
+        }
+
         // Create index entry
         PhonemeIndexEntry entry{};
         entry.phoneme_id = phoneme.id;
-        entry.name_hash = fnv1a_hash(phoneme.name);
+        entry.name_hash = phoneme.name_hash;
         entry.data_offset = static_cast<uint32_t>(audio_data.size());
-        entry.original_size = static_cast<uint32_t>(samples.size());
-        entry.compressed_size = entry.original_size;  // No compression
-        entry.duration_samples = static_cast<uint32_t>(samples.size() / (expected_bits / 8) / expected_channels);
-        entry.flags = 0;
-
-        if (phoneme.truncate) {
-            entry.flags |= PHONEME_FLAG_TRUNCATED;
-        }
+        entry.original_size = static_cast<uint32_t>(phoneme.samples.size());
+        entry.compressed_size = static_cast<uint32_t>(stored.size());
+        entry.duration_samples = static_cast<uint32_t>(phoneme.samples.size() / (expected_bits / 8) / expected_channels);
+        entry.flags = phoneme.flags;
 
         // Append audio data
-        audio_data.insert(audio_data.end(), samples.begin(), samples.end());
+        audio_data.insert(audio_data.end(), stored.begin(), stored.end());
         index.push_back(entry);
+        original_total += phoneme.samples.size();
 
         std::cout << "  Packed: " << phoneme.name
-                  << " (" << samples.size() << " bytes)" << std::endl;
+                  << " (" << phoneme.samples.size() << " bytes";
+        if (compress) {
+            std::cout << ", " << stored.size() << " compressed";
+        }
+        std::cout << ")" << std::endl;
     }
 
     // Encryption
     uint8_t encryption_key[32] = {0};
     uint8_t encryption_iv[16] = {0};
-    uint16_t header_flags = 0;
+    uint16_t header_flags = compress ? PACKED_FLAG_COMPRESSED : 0;
 
     if (encrypt) {
         header_flags |= PACKED_FLAG_ENCRYPTED;
@@ -362,7 +479,7 @@ int pack_phonemes(const std::string& input_dir,
 
         generate_random_bytes(encryption_iv, 16);
 
-        // Apply XOR encryption
+        // Apply XOR encryption (to the compressed bytes when compressing)
         xor_encrypt(audio_data, encryption_key, 32);
 
         std::cout << "Encryption key: ";
@@ -409,6 +526,10 @@ int pack_phonemes(const std::string& input_dir,
 
     std::cout << "\nSuccessfully packed " << index.size() << " phonemes" << std::endl;
     std::cout << "Total size: " << total_size << " bytes" << std::endl;
+    if (compress) {
+        std::cout << "Audio: " << original_total << " bytes, compressed to "
+                  << audio_data.size() << std::endl;
+    }
 
     return 0;
 }
@@ -423,18 +544,23 @@ void print_usage(const char* prog) {
     std::cout << std::endl;
     std::cout << "Options:" << std::endl;
     std::cout << "  --input-dir PATH    Input directory containing WAV files" << std::endl;
+    std::cout << "  --input-pack PATH   Repack an existing unencrypted .bin instead" << std::endl;
     std::cout << "  --output PATH       Output binary file path" << std::endl;
+    std::cout << "  --compress          Compress phoneme audio losslessly" << std::endl;
     std::cout << "  --encrypt           Enable XOR encryption" << std::endl;
     std::cout << "  --key HEXSTRING     Encryption key (64 hex chars, or auto-generate)" << std::endl;
     std::cout << "  --help              Show this help" << std::endl;
     std::cout << std::endl;
     std::cout << "Example:" << std::endl;
     std::cout << "  " << prog << " --input-dir phonemes --output phonemes.bin" << std::endl;
+    std::cout << "  " << prog << " --input-pack Josip.bin --compress --output Josip-compressed.bin" << std::endl;
 }
 
 int main(int argc, char* argv[]) {
     std::string input_dir;
+    std::string input_pack;
     std::string output_file;
+    bool compress = false;
     bool encrypt = false;
     std::string key;
 
@@ -446,8 +572,12 @@ int main(int argc, char* argv[]) {
             return 0;
         } else if (arg == "--input-dir" && i + 1 < argc) {
             input_dir = argv[++i];
+        } else if (arg == "--input-pack" && i + 1 < argc) {
+            input_pack = argv[++i];
         } else if (arg == "--output" && i + 1 < argc) {
             output_file = argv[++i];
+        } else if (arg == "--compress") {
+            compress = true;
         } else if (arg == "--encrypt") {
             encrypt = true;
         } else if (arg == "--key" && i + 1 < argc) {
@@ -459,11 +589,18 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    if (input_dir.empty() || output_file.empty()) {
-        std::cerr << "Error: --input-dir and --output are required" << std::endl;
+    if (input_dir.empty() == input_pack.empty() || output_file.empty()) {
+        std::cerr << "Error: --output and one of --input-dir or --input-pack are required" << std::endl;
         print_usage(argv[0]);
         return 1;
     }
 
-    return pack_phonemes(input_dir, output_file, encrypt, key);
+    std::vector<PhonemeAudio> phonemes;
+    bool read = input_pack.empty() ? read_wav_phonemes(input_dir, phonemes)
+                                   : read_packed_phonemes(input_pack, phonemes);
+    if (!read) {
+        return 1;
+    }
+
+    return pack_phonemes(phonemes, output_file, compress, encrypt, key);
 }